@@ -32,12 +32,12 @@ namespace syi
 		VkDescriptorPoolCreateInfo poolCI{};
 		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolCI.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-		poolCI.maxSets = k_descriptor_sets_pool_size;
+		poolCI.maxSets = k_descriptor_sets_max_count;
 		poolCI.poolSizeCount = static_cast<uint32_t>(ARRAYSIZE(pool_sizes));
 		poolCI.pPoolSizes = pool_sizes;
 		RASSERT(vkCreateDescriptorPool(device->vulkan_device, &poolCI, device->vulkan_allocation_callbacks, &vk_descriptor_pool) == VK_SUCCESS);
 
-		descriptor_sets.init(device->allocator, k_descriptor_sets_pool_size, sizeof(DescriptorSet));
+		descriptor_sets.init(device->allocator, k_descriptor_sets_pool_size, sizeof(DescriptorSet), k_descriptor_sets_max_count);
 
 		reset();
 	}
@@ -494,15 +494,20 @@ namespace syi
 
 		vkResetDescriptorPool(device->vulkan_device, vk_descriptor_pool, 0);
 
-		auto resourceCount = descriptor_sets.free_indices_head;
-		for(u32 i=0; i<resourceCount; ++i)
+		if (descriptor_sets.used_indices.load() == 0)
 		{
-			DescriptorSet* set = static_cast<DescriptorSet*>(descriptor_sets.access_resource(i));
+			return;
+		}
+
+		for(u32 i=0; i<descriptor_sets.pool_size; ++i)
+		{
+			DescriptorSet* set = static_cast<DescriptorSet*>(descriptor_sets.access_resource(descriptor_sets.get_used_handle(i)));
 			if(set )
 			{
 				rfree(set->resources, device->allocator);
 			}
-			descriptor_sets.release_resource(i);
 		}
+		// Bumps the generation of all the sets: handles from the previous recording become stale.
+		descriptor_sets.free_all_resources();
 	}
 }
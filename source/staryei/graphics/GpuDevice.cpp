@@ -4,6 +4,7 @@
 
 #include "foundation/memory.hpp"
 #include "foundation/hash_map.hpp"
+#include "foundation/concurrent_hash_map.hpp"
 #include "foundation/process.hpp"
 #include "foundation/file.hpp"
 
@@ -47,7 +48,7 @@ constexpr const T& syi_max(const T& a, const T& b) {
 // SDL and Vulkan headers
 #include <SDL.h>
 #include <SDL_vulkan.h>
-#include <unordered_map>
+#include <mutex>
 
 namespace syi
 {
@@ -128,10 +129,120 @@ static const char* s_requested_layers[] = {
     PFN_vkCmdBeginDebugUtilsLabelEXT    pfnCmdBeginDebugUtilsLabelEXT;
     PFN_vkCmdEndDebugUtilsLabelEXT      pfnCmdEndDebugUtilsLabelEXT;
 
-    static std::unordered_map<u64, VkRenderPass> render_pass_cache;
+    // Looked up while recording command buffers on worker threads.
+    // Use get_render_pass_cache(): the first caller initializes it, once the memory service is running.
+    static ConcurrentFlatHashMap<u64, VkRenderPass> render_pass_cache;
+    static std::once_flag render_pass_cache_once;
     static CommandBufferManager command_buffer_ring;
 
+    static ConcurrentFlatHashMap<u64, VkRenderPass>& get_render_pass_cache() {
+        std::call_once(render_pass_cache_once, [] {
+            render_pass_cache.init(&MemoryService::instance()->system_allocator, 16);
+        });
+        return render_pass_cache;
+    }
+
     static const u32        k_bindless_texture_binding = 10;
     static const u32        k_max_bindless_resources = 1024;
 
+    // Only the attachments in use are hashed: the arrays past num_color_formats are not always reset.
+    static u64 hash_render_pass_output(const RenderPassOutput& output) {
+        u64 hash = hash_calculate(output.num_color_formats);
+        for (u32 i = 0; i < output.num_color_formats; ++i) {
+            hash = hash_calculate(output.color_formats[i], hash);
+            hash = hash_calculate(output.color_final_layouts[i], hash);
+            hash = hash_calculate(output.color_operations[i], hash);
+        }
+        hash = hash_calculate(output.depth_stencil_format, hash);
+        if (output.depth_stencil_format != VK_FORMAT_UNDEFINED) {
+            hash = hash_calculate(output.depth_stencil_final_layout, hash);
+            hash = hash_calculate(output.depth_operation, hash);
+            hash = hash_calculate(output.stencil_operation, hash);
+        }
+        return hash;
+    }
+
+    static VkRenderPass vulkan_create_render_pass(GpuDevice& gpu, const RenderPassOutput& output, const std::string& name) {
+        VkAttachmentDescription attachments[k_max_image_outputs + 1];
+        VkAttachmentReference color_attachments_ref[k_max_image_outputs];
+
+        u32 attachment_count = 0;
+        for (; attachment_count < output.num_color_formats; ++attachment_count) {
+            const VkAttachmentLoadOp load_op = output.color_operations[attachment_count];
+
+            VkAttachmentDescription& color_attachment = attachments[attachment_count];
+            color_attachment = {};
+            color_attachment.format = output.color_formats[attachment_count];
+            color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            color_attachment.loadOp = load_op;
+            color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // Loaded contents are already in the attachment layout.
+            color_attachment.initialLayout = load_op == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+            color_attachment.finalLayout = output.color_final_layouts[attachment_count];
+
+            color_attachments_ref[attachment_count] = { attachment_count, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        }
+
+        VkAttachmentReference depth_attachment_ref = { attachment_count, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        const bool has_depth = output.depth_stencil_format != VK_FORMAT_UNDEFINED;
+        if (has_depth) {
+            const bool loaded = output.depth_operation == VK_ATTACHMENT_LOAD_OP_LOAD || output.stencil_operation == VK_ATTACHMENT_LOAD_OP_LOAD;
+
+            VkAttachmentDescription& depth_attachment = attachments[attachment_count++];
+            depth_attachment = {};
+            depth_attachment.format = output.depth_stencil_format;
+            depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            depth_attachment.loadOp = output.depth_operation;
+            depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            depth_attachment.stencilLoadOp = output.stencil_operation;
+            depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depth_attachment.initialLayout = loaded ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+            depth_attachment.finalLayout = output.depth_stencil_final_layout;
+        }
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = output.num_color_formats;
+        subpass.pColorAttachments = color_attachments_ref;
+        subpass.pDepthStencilAttachment = has_depth ? &depth_attachment_ref : nullptr;
+
+        VkRenderPassCreateInfo render_pass_info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+        render_pass_info.attachmentCount = attachment_count;
+        render_pass_info.pAttachments = attachments;
+        render_pass_info.subpassCount = 1;
+        render_pass_info.pSubpasses = &subpass;
+
+        VkRenderPass vulkan_render_pass;
+        VkResult result = vkCreateRenderPass(gpu.vulkan_device, &render_pass_info, gpu.vulkan_allocation_callbacks, &vulkan_render_pass);
+        check(result);
+
+        gpu.set_resource_name(VK_OBJECT_TYPE_RENDER_PASS, (u64)vulkan_render_pass, name);
+        return vulkan_render_pass;
+    }
+
+    // Passes with the same outputs are compatible, so pipelines and framebuffers share them.
+    VkRenderPass GpuDevice::get_vulkan_render_pass(const RenderPassOutput& output, const std::string& name) {
+        ConcurrentFlatHashMap<u64, VkRenderPass>& cache = get_render_pass_cache();
+
+        const u64 hashed_memory = hash_render_pass_output(output);
+        VkRenderPass vulkan_render_pass = cache.get(hashed_memory);
+        if (vulkan_render_pass) {
+            return vulkan_render_pass;
+        }
+
+        // Another thread can create the same pass meanwhile: the first one inserted is kept.
+        vulkan_render_pass = vulkan_create_render_pass(*this, output, name);
+        if (!cache.insert(hashed_memory, vulkan_render_pass)) {
+            vkDestroyRenderPass(vulkan_device, vulkan_render_pass, vulkan_allocation_callbacks);
+            vulkan_render_pass = cache.get(hashed_memory);
+        }
+        return vulkan_render_pass;
+    }
+
+    void GpuDevice::reclaim_render_pass_cache() {
+        get_render_pass_cache().reclaim_retired_tables();
+    }
+
 }
@@ -169,6 +169,7 @@ namespace syi
 		const RenderPassOutput&			get_swapchain_output() const { return swapchain_output; }
 
 		VkRenderPass                    get_vulkan_render_pass(const RenderPassOutput& output, const std::string& name);
+		void                            reclaim_render_pass_cache();                    // Frees the cache tables replaced as it grew. No render pass lookup must be running.
 
 		// Names and markers /////////////////////////////////////////////////
 		void                            set_resource_name(VkObjectType object_type, uint64_t handle, const std::string& name);
@@ -82,15 +82,20 @@ namespace syi {
 
 	static const uint32_t                    k_invalid_index = 0xffffffff;
 
-	static const uint32_t k_buffers_pool_size = 16384;
-	static const uint32_t k_textures_pool_size = 512;
-	static const uint32_t k_render_passes_pool_size = 256;
-	static const uint32_t k_descriptor_set_layouts_pool_size = 128;
-	static const uint32_t k_pipelines_pool_size = 128;
-	static const uint32_t k_shaders_pool_size = 128;
-	static const uint32_t k_descriptor_sets_pool_size = 4096;
+	// Resource pools grow in chunks of these sizes, up to the handle index limit.
+	static const uint32_t k_buffers_pool_size = 1024;
+	static const uint32_t k_textures_pool_size = 256;
+	static const uint32_t k_render_passes_pool_size = 64;
+	static const uint32_t k_descriptor_set_layouts_pool_size = 64;
+	static const uint32_t k_pipelines_pool_size = 64;
+	static const uint32_t k_shaders_pool_size = 64;
+	static const uint32_t k_descriptor_sets_pool_size = 1024;
 	static const uint32_t k_samplers_pool_size = 32;
 
+	// Descriptor sets a command buffer's VkDescriptorPool holds, and so the most its pool may grow to.
+	static const uint32_t k_descriptor_sets_max_count = 4096;
+
+	// Generational handle from a ResourcePool: slot index and generation, not a plain index.
 	struct ResourceHandle {
 		uint32_t index;
 	};
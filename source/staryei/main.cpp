@@ -26,9 +26,13 @@
 #include "external/json.hpp"
 
 #include "foundation/file.hpp"
+#include "foundation/frame_arena.hpp"
 #include "foundation/numerics.hpp"
 #include "foundation/time.hpp"
 #include "foundation/resource_manager.hpp"
+#include "foundation/gltf_blob.hpp"
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/texture_compiler.hpp"
 
 #include "external/imgui/imgui.h"
 #include "external/stb_image.h"
@@ -89,7 +93,10 @@ int main( int argc, char** argv ) {
     using namespace syi;
     // Init services
     MemoryServiceConfiguration memory_configuration;
-    memory_configuration.maximum_dynamic_size = rgiga( 2ull );
+    memory_configuration.maximum_dynamic_size = rgiga( 16ull );
+    memory_configuration.heap_pool_size = rmega( 64 );
+    memory_configuration.growable_heap = true;
+    memory_configuration.thread_safe_heap = true;
 
     MemoryService::instance()->init( &memory_configuration );
     Allocator* allocator = &MemoryService::instance()->system_allocator;
@@ -106,6 +113,14 @@ int main( int argc, char** argv ) {
 
     task_scheduler.Initialize( config );
 
+    // Per-thread transient memory, recycled when the GPU retires the frame.
+    FrameArenaServiceConfiguration frame_arena_configuration;
+    frame_arena_configuration.frames_in_flight = GpuDevice::k_max_frames;
+    frame_arena_configuration.thread_count = task_scheduler.GetNumTaskThreads();
+    frame_arena_configuration.arena_size = rmega( 2 );
+    FrameArenaService* frame_arenas = FrameArenaService::instance();
+    frame_arenas->init( &frame_arena_configuration );
+
     // window
     WindowConfiguration wconf{ 1280, 800, "syi Chapter 4", &MemoryService::instance()->system_allocator};
     syi::Window window;
@@ -124,8 +139,21 @@ int main( int argc, char** argv ) {
     GpuDevice gpu;
     gpu.init( dc );
 
+    // Compiled glTF, meshes and textures are cached by content, shared by all the runs.
+    GltfBlobCompiler gltf_blob_compiler;
+    gltf_blob_compiler.init( &task_scheduler );
+
+    MeshResourceCompiler mesh_compiler;
+    mesh_compiler.init( MeshOptimizerOptions{ }, &task_scheduler );
+
+    TextureResourceCompiler texture_compiler;
+    texture_compiler.init( TextureCompileOptions{ }, allocator, &task_scheduler );
+
     ResourceManager rm;
-    rm.init( allocator, nullptr );
+    rm.init( allocator, nullptr, syi_WORKING_FOLDER "/cache" );
+    rm.set_compiler( GltfBlobCompiler::k_type, &gltf_blob_compiler );
+    rm.set_compiler( MeshResourceCompiler::k_type, &mesh_compiler );
+    rm.set_compiler( TextureResourceCompiler::k_type, &texture_compiler );
 
     GPUProfiler gpu_profiler;
     gpu_profiler.init( allocator, 100 );
@@ -210,8 +238,14 @@ int main( int argc, char** argv ) {
 
     char* file_extension = file_extension_from_path( file_name );
 
-    if ( strcmp( file_extension, "gltf" ) == 0 ) {
+    if ( strcmp( file_extension, "gltf" ) == 0 || strcmp( file_extension, "glb" ) == 0 ) {
         scene = new glTFScene;
+
+        // Optimized meshes, meshlets and LODs, compiled on the first import of this content.
+        char meshes_path[ 512 ];
+        if ( rm.get_cached_path( hash_calculate( MeshResourceCompiler::k_type ), file_name, meshes_path, 512 ) ) {
+            rprint( "Compiled meshes %s\n", meshes_path );
+        }
     } else if ( strcmp( file_extension, "obj" ) == 0 ) {
         scene = new ObjScene;
     }
@@ -224,6 +258,9 @@ int main( int argc, char** argv ) {
     scene->register_render_passes( &frame_graph );
     scene->prepare_draws( &renderer, &scratch_allocator, &scene_graph );
 
+    // Loaders and compilers are all registered: free the tables they outgrew, before loading tasks start.
+    rm.reclaim_retired_tables();
+
     // Start multithreading IO
     // Create IO threads at the end
     RunPinnedTaskLoopTask run_pinned_task;
@@ -250,8 +287,11 @@ int main( int argc, char** argv ) {
         ZoneScopedN("RenderLoop");
 
         // New frame
+        MemoryService::instance()->new_frame();
+
         if ( !window.minimized ) {
             gpu.new_frame();
+            frame_arenas->new_frame( gpu.current_frame );
 
             static bool checksz = true;
             if ( async_loader.file_load_requests.size == 0 && checksz ) {
@@ -318,6 +358,8 @@ int main( int argc, char** argv ) {
             }
             ImGui::End();
 
+            frame_arenas->imgui_draw();
+
         }
         {
             ZoneScopedN( "SceneGraphUpdate" );
@@ -348,6 +390,9 @@ int main( int argc, char** argv ) {
             scene->submit_draw_task( imgui, &gpu_profiler, &task_scheduler );
 
             gpu.present();
+
+            // The draw task waited for its recording tasks: no render pass lookup is in flight.
+            gpu.reclaim_render_pass_cache();
         } else {
             ImGui::Render();
         }
@@ -384,6 +429,7 @@ int main( int argc, char** argv ) {
     window.unregister_os_messages_callback( input_os_messages_callback );
     window.shutdown();
 
+    frame_arenas->shutdown();
     scratch_allocator.shutdown();
     MemoryService::instance()->shutdown();
 
@@ -0,0 +1,34 @@
+#if defined(VERTEX)
+
+layout ( std140, set = MATERIAL_SET, binding = 0 ) uniform LocalConstants {
+    mat4        view_projection;
+    vec4        eye;
+    vec4        light;
+    float       light_range;
+    float       light_intensity;
+};
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec4 tangent;
+layout(location=2) in vec4 normal;
+layout(location=3) in vec2 texCoord0;
+
+layout (location = 0) out vec2 vTexcoord0;
+layout (location = 1) out vec3 vNormal;
+layout (location = 2) out vec3 vTangent;
+layout (location = 3) out vec3 vBiTangent;
+layout (location = 4) out vec3 vPosition;
+
+void main() {
+    vec3 object_position = position_decode(position);
+    gl_Position = view_projection * model * vec4(object_position, 1.0);
+
+    vec4 worldPosition = model * vec4(object_position, 1.0);
+    vPosition = worldPosition.xyz / worldPosition.w;
+    vTexcoord0 = texCoord0;
+    vNormal = normalize( mat3(model_inverse) * oct_decode(normal) );
+    vTangent = normalize( mat3(model) * oct_decode(tangent) );
+    vBiTangent = cross( vNormal, vTangent ) * tangent.w;
+}
+
+#endif // VERTEX
@@ -0,0 +1,24 @@
+
+// Decoding of the packed vertex streams of the compiled meshes.
+
+// Bound by the quantized pipelines only, the Mesh uniform keeps its layout.
+// Matches GpuMeshDequantization, filled by vertex_dequantization_to_gpu.
+layout ( std140, set = MATERIAL_SET, binding = 2 ) uniform MeshDequantization {
+
+    vec4        position_offset;
+    vec4        position_scale;
+};
+
+// Octahedral vector in snorm8: uv scaled by z, the encoded one, and w.
+vec3 oct_decode( vec4 encoded ) {
+    vec2 uv = encoded.xy / max( encoded.z, 1.0 / 127.0 );
+    vec3 n = vec3( uv, 1.0 - abs( uv.x ) - abs( uv.y ) );
+    float t = max( -n.z, 0.0 );
+    n.xy += vec2( n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t );
+    return normalize( n );
+}
+
+// Unorm16 position on the bounding box of the mesh.
+vec3 position_decode( vec4 encoded ) {
+    return position_offset.xyz + position_scale.xyz * encoded.xyz;
+}
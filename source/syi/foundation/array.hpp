@@ -3,11 +3,24 @@
 #include "foundation/memory.hpp"
 #include "foundation/assert.hpp"
 
+#include <new>
+#include <type_traits>
+#include <utility>
+
 namespace syi {
 
     // Data structures ////////////////////////////////////////////////////
 
+    //
+    // Types that can be moved with a memcpy, without calling constructors and destructors.
+    // Specialize it for types that are not trivially copyable but can still be relocated bitwise.
+    template <typename T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+
     // ArrayAligned ///////////////////////////////////////////////////////
+    //
+    // Dynamic array. Trivial types are left uninitialized and relocated with a memcpy,
+    // or grown in place by the allocator; other types are constructed, moved and destroyed.
     template <typename T>
     struct Array {
 
@@ -18,8 +31,12 @@ namespace syi {
         void                        shutdown();
 
         void                        push( const T& element );
+        void                        push( T&& element );
         T&                          push_use();                 // Grow the size and return T to be filled.
 
+        template <typename... Args>
+        T&                          emplace( Args&&... args );  // Construct in place at the end.
+
         void                        pop();
         void                        delete_swap( u32 index );
 
@@ -29,7 +46,12 @@ namespace syi {
         void                        clear();
         void                        set_size( u32 new_size );
         void                        set_capacity( u32 new_capacity );
-        void                        grow( u32 new_capacity );
+        void                        reserve_exact( u32 new_capacity );  // Capacity is exactly new_capacity, if bigger.
+        void                        grow( u32 new_capacity );           // Capacity is at least doubled.
+
+        void                        resize_storage( u32 new_capacity );
+        void                        construct_range( u32 begin, u32 end );
+        void                        destroy_range( u32 begin, u32 end );
 
         T&                          back();
         const T&                    back() const;
@@ -81,17 +103,22 @@ namespace syi {
     template<typename T>
     inline void Array<T>::init( Allocator* allocator_, u32 initial_capacity, u32 initial_size ) {
         data = nullptr;
-        size = initial_size;
+        size = 0;
         capacity = 0;
         allocator = allocator_;
 
-        if ( initial_capacity > 0 ) {
-            grow( initial_capacity );
+        if ( initial_capacity > 0 || initial_size > 0 ) {
+            reserve_exact( initial_capacity > initial_size ? initial_capacity : initial_size );
         }
+
+        construct_range( 0, initial_size );
+        size = initial_size;
     }
 
     template<typename T>
     inline void Array<T>::shutdown() {
+        destroy_range( 0, size );
+
         if ( capacity > 0 ) {
             allocator->deallocate( data );
         }
@@ -102,10 +129,30 @@ namespace syi {
     template<typename T>
     inline void Array<T>::push( const T& element ) {
         if ( size >= capacity ) {
+            // Element could live in this array: copy it before the storage moves.
+            T copy( element );
+            grow( capacity + 1 );
+            new ( data + size ) T( std::move( copy ) );
+            ++size;
+            return;
+        }
+
+        new ( data + size ) T( element );
+        ++size;
+    }
+
+    template<typename T>
+    inline void Array<T>::push( T&& element ) {
+        if ( size >= capacity ) {
+            T moved( std::move( element ) );
             grow( capacity + 1 );
+            new ( data + size ) T( std::move( moved ) );
+            ++size;
+            return;
         }
 
-        data[ size++ ] = element;
+        new ( data + size ) T( std::move( element ) );
+        ++size;
     }
 
     template<typename T>
@@ -113,21 +160,39 @@ namespace syi {
         if ( size >= capacity ) {
             grow( capacity + 1 );
         }
+        construct_range( size, size + 1 );
         ++size;
 
         return back();
     }
 
+    template<typename T>
+    template<typename... Args>
+    inline T& Array<T>::emplace( Args&&... args ) {
+        if ( size >= capacity ) {
+            grow( capacity + 1 );
+        }
+
+        T* element = new ( data + size ) T( std::forward<Args>( args )... );
+        ++size;
+        return *element;
+    }
+
     template<typename T>
     inline void Array<T>::pop() {
         RASSERT( size > 0 );
         --size;
+        destroy_range( size, size + 1 );
     }
 
     template<typename T>
     inline void Array<T>::delete_swap( u32 index ) {
         RASSERT( size > 0 && index < size );
-        data[ index ] = data[ --size ];
+        --size;
+        if ( index != size ) {
+            data[ index ] = std::move( data[ size ] );
+        }
+        destroy_range( size, size + 1 );
     }
 
     template<typename T>
@@ -144,6 +209,7 @@ namespace syi {
 
     template<typename T>
     inline void Array<T>::clear() {
+        destroy_range( 0, size );
         size = 0;
     }
 
@@ -152,6 +218,12 @@ namespace syi {
         if ( new_size > capacity ) {
             grow( new_size );
         }
+
+        if ( new_size > size ) {
+            construct_range( size, new_size );
+        } else {
+            destroy_range( new_size, size );
+        }
         size = new_size;
     }
 
@@ -162,25 +234,74 @@ namespace syi {
         }
     }
 
+    template<typename T>
+    inline void Array<T>::reserve_exact( u32 new_capacity ) {
+        if ( new_capacity > capacity ) {
+            resize_storage( new_capacity );
+        }
+    }
+
     template<typename T>
     inline void Array<T>::grow( u32 new_capacity ) {
+        // Geometric growth keeps push amortized O(1).
         if ( new_capacity < capacity * 2 ) {
             new_capacity = capacity * 2;
-        } else if ( new_capacity < 4 ) {
+        }
+        if ( new_capacity < 4 ) {
             new_capacity = 4;
         }
 
-        T* new_data = ( T* )allocator->allocate( new_capacity * sizeof( T ), alignof( T ) );
-        if ( capacity ) {
-            memory_copy( new_data, data, capacity * sizeof( T ) );
+        resize_storage( new_capacity );
+    }
 
-            allocator->deallocate( data );
+    template<typename T>
+    inline void Array<T>::resize_storage( u32 new_capacity ) {
+        RASSERT( new_capacity >= size );
+
+        if constexpr ( is_trivially_relocatable<T>::value ) {
+            // The allocator can extend the block in place, otherwise it copies only the used part.
+            T* new_data = capacity ? ( T* )allocator->reallocate( data, size * sizeof( T ), new_capacity * sizeof( T ), alignof( T ) )
+                                   : ( T* )allocator->allocate( new_capacity * sizeof( T ), alignof( T ) );
+            RASSERT( new_data );
+
+            data = new_data;
+        } else {
+            T* new_data = ( T* )allocator->allocate( new_capacity * sizeof( T ), alignof( T ) );
+            RASSERT( new_data );
+
+            for ( u32 i = 0; i < size; ++i ) {
+                new ( new_data + i ) T( std::move( data[ i ] ) );
+                data[ i ].~T();
+            }
+
+            if ( capacity ) {
+                allocator->deallocate( data );
+            }
+            data = new_data;
         }
 
-        data = new_data;
         capacity = new_capacity;
     }
 
+    template<typename T>
+    inline void Array<T>::construct_range( u32 begin, u32 end ) {
+        // Trivial types are left uninitialized, as they are filled by the caller.
+        if constexpr ( !std::is_trivially_default_constructible<T>::value ) {
+            for ( u32 i = begin; i < end; ++i ) {
+                new ( data + i ) T();
+            }
+        }
+    }
+
+    template<typename T>
+    inline void Array<T>::destroy_range( u32 begin, u32 end ) {
+        if constexpr ( !std::is_trivially_destructible<T>::value ) {
+            for ( u32 i = begin; i < end; ++i ) {
+                data[ i ].~T();
+            }
+        }
+    }
+
     template<typename T>
     inline T& Array<T>::back() {
         RASSERT( size );
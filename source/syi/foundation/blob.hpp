@@ -12,13 +12,13 @@ namespace syi {
 // offset to track where to allocate memory from when writing, so that Relative structures
 // like pointers and arrays can be serialized.
 //
-// TODO: when finalized and when reading, if data version matches between the one written in
-// the file and the root structure is marked as 'relative only', memory mappable is doable and
-// thus serialization is automatic.
+// When reading, if data version matches between the one written in the file and the blob
+// is marked as mappable (only Relative structures were written), the file can be memory mapped
+// and used as is, without any serialization.
 //
 struct BlobHeader {
     u32                 version;
-    u32                 mappable;
+    u32                 mappable;       // 1 if the blob contains only relative data.
 }; // struct BlobHeader
 
 //
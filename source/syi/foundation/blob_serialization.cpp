@@ -22,7 +22,8 @@ void BlobSerializer::write_common( Allocator* allocator_, u32 serializer_version
     // This will be written into the blob
     data_version = serializer_version_;
     is_reading = 0;
-    is_mappable = 0;
+    // Until non relative data is written.
+    is_mappable = 1;
 
     // Write header
     BlobHeader* header = ( BlobHeader* )allocate_static( sizeof( BlobHeader ) );
@@ -34,6 +35,12 @@ void BlobSerializer::write_common( Allocator* allocator_, u32 serializer_version
 
 void BlobSerializer::shutdown() {
 
+    if ( mapping.data ) {
+        // Mapped blob: the root data pointed into the file.
+        file_unmap( &mapping );
+        blob_memory = nullptr;
+    }
+
     if ( is_reading ) {
         // When reading and serializing, we can free blob memory after read.
         // Otherwise we will free the pointer when done.
@@ -214,6 +221,9 @@ void BlobSerializer::serialize_memory_block( void** data, u32* size ) {
         }
     } else {
         // Data --> Blob
+        // The block is read back through an absolute pointer.
+        set_not_mappable();
+
         // Data will be copied at the end of the current blob
         i32 data_offset = allocated_offset - serialized_offset;
         serialize( &data_offset );
@@ -349,6 +359,13 @@ void BlobSerializer::allocate_and_set( RelativeString& string, char* text, u32 l
     string.set( destination_memory + cached_offset, length );
 }
 
+void BlobSerializer::set_not_mappable() {
+    is_mappable = 0;
+
+    BlobHeader* header = ( BlobHeader* )blob_memory;
+    header->mappable = 0;
+}
+
 i32 BlobSerializer::get_relative_data_offset( void* data ) {
     // data_memory points to the newly allocated data structure to be used at runtime.
     const i32 data_offset_from_start = ( i32 )( ( char* )data - data_memory );
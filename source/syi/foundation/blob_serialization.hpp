@@ -5,6 +5,7 @@
 #include "foundation/assert.hpp"
 #include "foundation/array.hpp"
 #include "foundation/relative_data_structures.hpp"
+#include "foundation/file.hpp"
 
 #include "foundation/blob.hpp"
 
@@ -35,6 +36,12 @@ struct BlobSerializer {
     template <typename T>
     T*                  read( Allocator* allocator, u32 serializer_version, sizet size, char* blob_memory, bool force_serialization = false );
 
+    // Memory map the file. If the blob is mappable and at the serializer version the root
+    // points straight into the read only mapping, kept alive until shutdown.
+    // Otherwise the blob is serialized into memory from allocator and the file is unmapped.
+    template <typename T>
+    T*                  read_mapped( Allocator* allocator, u32 serializer_version, cstring filename, bool force_serialization = false );
+
     void                shutdown();
 
     // Methods used both for reading and writing.
@@ -87,6 +94,9 @@ struct BlobSerializer {
 
     i32                 get_relative_data_offset( void* data );
 
+    // Called when writing data that contains absolute pointers.
+    void                set_not_mappable();
+
     char*               blob_memory         = nullptr;
     char*               data_memory         = nullptr;
 
@@ -103,7 +113,9 @@ struct BlobSerializer {
     u32                 is_mappable         = 0;
 
     u32                 has_allocated_memory = 0;
-    
+
+    FileMapping         mapping;
+
 }; // struct BlobSerializer
 
 // Implementations/////////////////////////////////////////////////////////
@@ -160,9 +172,8 @@ T* BlobSerializer::read( Allocator* allocator_, u32 serializer_version_, sizet s
     data_version = header->version;
     is_mappable = header->mappable;
 
-    // If serializer and data are at the same version, no need to serialize.
-    // TODO: is mappable should be taken in consideration.
-    if ( serializer_version == data_version && !force_serialization ) {
+    // If serializer and data are at the same version and the data is only relative, no need to serialize.
+    if ( serializer_version == data_version && is_mappable && !force_serialization ) {
         return ( T* )( blob_memory );
     }
 
@@ -182,6 +193,30 @@ T* BlobSerializer::read( Allocator* allocator_, u32 serializer_version_, sizet s
     return destination_data;
 }
 
+template<typename T>
+T* BlobSerializer::read_mapped( Allocator* allocator_, u32 serializer_version_, cstring filename, bool force_serialization ) {
+
+    if ( !file_map_read_only( filename, &mapping ) ) {
+        rprint( "Blob: cannot map file %s\n", filename );
+        return nullptr;
+    }
+
+    if ( mapping.size < sizeof( T ) ) {
+        rprint( "Blob: file %s is too small, %llu bytes\n", filename, mapping.size );
+        file_unmap( &mapping );
+        return nullptr;
+    }
+
+    T* root = read<T>( allocator_, serializer_version_, mapping.size, mapping.data, force_serialization );
+    if ( has_allocated_memory ) {
+        // Serialized data does not reference the blob, so the file can be released now.
+        file_unmap( &mapping );
+        blob_memory = nullptr;
+    }
+
+    return root;
+}
+
 template<typename T>
 inline void BlobSerializer::allocate_and_set( RelativePointer<T>& data, void* source_data ) {
     char* destination_memory = allocate_static( sizeof( T ) );
@@ -358,6 +393,9 @@ inline void BlobSerializer::serialize( Array<T>* data ) {
 
     } else {
         // Data --> Blob
+        // Array holds an absolute pointer, that must be patched when reading.
+        set_not_mappable();
+
         serialize( &data->size );
         // Add serialization pads so that we serialize all bytes of the struct Array.
         u64 serialization_pad = 0;
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "foundation/hash_map.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+namespace syi {
+
+    // Concurrent Hash Map //////////////////////////////////////////////////////
+
+    static const u32                k_concurrent_hash_map_shard_bits    = 4;
+    static const u32                k_concurrent_hash_map_shard_count   = 1 << k_concurrent_hash_map_shard_bits;
+
+    //
+    // Swiss table split in shards, selected by the top bits of the hash.
+    // Lookups never lock nor write shared memory: they probe with GroupSse2Impl like FlatHashMap.
+    // Writers of a shard are serialized by its mutex.
+    //
+    // To keep lookups safe without locks:
+    // - an entry is published by writing the slot first and its control byte last,
+    // - values are never overwritten in place: insert fails if the key is already present, and
+    //   insert_or_assign publishes a new slot before deleting the old one,
+    // - deleted slots are not reused until the table is rehashed,
+    // - a rehash publishes a new table and retires the old one, as readers could still probe it.
+    //   Retired tables are freed by reclaim_retired_tables() and shutdown(), to be called
+    //   when no lookup is in flight (for example between frames).
+    template <typename K, typename V>
+    struct ConcurrentFlatHashMap {
+
+        static_assert( std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value, "Entries are read while other threads insert" );
+
+        struct KeyValue {
+            K                       key;
+            V                       value;
+        }; // struct KeyValue
+
+        //
+        // Single allocation: header, control bytes and slots.
+        struct Table {
+            u64                     capacity;       // Power of 2 minus 1.
+            u64                     growth_left;    // Empty slots that can still be filled. Deleted ones are not counted.
+            i8*                     control_bytes;
+            KeyValue*               slots;
+            Table*                  retired_next;
+        }; // struct Table
+
+        //
+        //
+        struct alignas( 64 ) Shard {
+            std::atomic<Table*>     table;
+            std::atomic<u64>        size;
+            Table*                  retired;        // Tables that could still be read by a lookup.
+            std::mutex              mutex;
+        }; // struct Shard
+
+        void                        init( Allocator* allocator, u64 initial_capacity );
+        void                        shutdown();
+
+        // Wait free, can be called from any thread.
+        bool                        find( const K& key, V& out_value ) const;
+        V                           get( const K& key ) const;      // Default value if not found.
+
+        // Returns false if the key was already present; the existing value is kept.
+        bool                        insert( const K& key, const V& value );
+        // Returns false if the key was already present and its value replaced.
+        bool                        insert_or_assign( const K& key, const V& value );
+        u32                         remove( const K& key );
+
+        // Locks one shard at a time: entries inserted meanwhile in other shards could be missed.
+        template <typename Function>
+        void                        for_each( Function&& function );
+
+        void                        set_default_value( const V& value );
+        u64                         get_size() const;
+
+        // Frees the tables replaced by a rehash. No lookup must be running.
+        void                        reclaim_retired_tables();
+
+        // Internal methods
+        Table*                      allocate_table( u64 capacity );
+        void                        rehash( Shard& shard, Table* table );
+        static bool                 find_in_table( const Table* table, const K& key, u64 hash, V* out_value, u64* out_index );
+        static u64                  find_first_empty( Table* table, u64 hash );
+        static void                 publish_slot( Table* table, const K& key, const V& value, u64 hash );
+        static void                 set_ctrl( Table* table, u64 i, i8 h );
+
+        Shard&                      get_shard( u64 hash )       { return shards[ hash >> ( 64 - k_concurrent_hash_map_shard_bits ) ]; }
+        const Shard&                get_shard( u64 hash ) const { return shards[ hash >> ( 64 - k_concurrent_hash_map_shard_bits ) ]; }
+
+        Shard                       shards[ k_concurrent_hash_map_shard_count ];
+
+        Allocator*                  allocator       = nullptr;
+        V                           default_value   = {};
+
+    }; // struct ConcurrentFlatHashMap
+
+    // Implementation /////////////////////////////////////////////////////
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::init( Allocator* allocator_, u64 initial_capacity ) {
+        allocator = allocator_;
+
+        // Each shard starts with at least one full group.
+        const u64 shard_capacity = capacity_normalize( initial_capacity / k_concurrent_hash_map_shard_count > GroupSse2Impl::kWidth ? initial_capacity / k_concurrent_hash_map_shard_count : GroupSse2Impl::kWidth - 1 );
+
+        for ( u32 i = 0; i < k_concurrent_hash_map_shard_count; ++i ) {
+            Shard& shard = shards[ i ];
+            shard.table.store( allocate_table( shard_capacity ), std::memory_order_relaxed );
+            shard.size.store( 0, std::memory_order_relaxed );
+            shard.retired = nullptr;
+        }
+        std::atomic_thread_fence( std::memory_order_release );
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::shutdown() {
+        reclaim_retired_tables();
+
+        for ( u32 i = 0; i < k_concurrent_hash_map_shard_count; ++i ) {
+            Table* table = shards[ i ].table.exchange( nullptr, std::memory_order_relaxed );
+            if ( table ) {
+                allocator->deallocate( table );
+            }
+            shards[ i ].size.store( 0, std::memory_order_relaxed );
+        }
+    }
+
+    template <typename K, typename V>
+    bool ConcurrentFlatHashMap<K, V>::find( const K& key, V& out_value ) const {
+        const u64 hash = hash_calculate( key );
+        const Table* table = get_shard( hash ).table.load( std::memory_order_acquire );
+        return find_in_table( table, key, hash, &out_value, nullptr );
+    }
+
+    template <typename K, typename V>
+    V ConcurrentFlatHashMap<K, V>::get( const K& key ) const {
+        V value;
+        return find( key, value ) ? value : default_value;
+    }
+
+    template <typename K, typename V>
+    bool ConcurrentFlatHashMap<K, V>::insert( const K& key, const V& value ) {
+        const u64 hash = hash_calculate( key );
+        Shard& shard = get_shard( hash );
+
+        std::lock_guard<std::mutex> guard( shard.mutex );
+
+        Table* table = shard.table.load( std::memory_order_relaxed );
+        if ( find_in_table( table, key, hash, nullptr, nullptr ) ) {
+            return false;
+        }
+
+        if ( table->growth_left == 0 ) {
+            rehash( shard, table );
+            table = shard.table.load( std::memory_order_relaxed );
+        }
+
+        publish_slot( table, key, value, hash );
+        shard.size.fetch_add( 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    template <typename K, typename V>
+    bool ConcurrentFlatHashMap<K, V>::insert_or_assign( const K& key, const V& value ) {
+        const u64 hash = hash_calculate( key );
+        Shard& shard = get_shard( hash );
+
+        std::lock_guard<std::mutex> guard( shard.mutex );
+
+        // Rehash first, so that the old index is found in the table the new slot goes to.
+        Table* table = shard.table.load( std::memory_order_relaxed );
+        if ( table->growth_left == 0 ) {
+            rehash( shard, table );
+            table = shard.table.load( std::memory_order_relaxed );
+        }
+
+        u64 old_index;
+        const bool found = find_in_table( table, key, hash, nullptr, &old_index );
+
+        // A lookup sees the old or the new entry until the old one is deleted, both whole.
+        publish_slot( table, key, value, hash );
+        if ( found ) {
+            set_ctrl( table, old_index, k_control_bitmask_deleted );
+            return false;
+        }
+
+        shard.size.fetch_add( 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    template <typename K, typename V>
+    u32 ConcurrentFlatHashMap<K, V>::remove( const K& key ) {
+        const u64 hash = hash_calculate( key );
+        Shard& shard = get_shard( hash );
+
+        std::lock_guard<std::mutex> guard( shard.mutex );
+
+        Table* table = shard.table.load( std::memory_order_relaxed );
+        u64 index;
+        if ( !find_in_table( table, key, hash, nullptr, &index ) ) {
+            return 0;
+        }
+
+        // The slot content stays untouched, a concurrent lookup could be reading it.
+        set_ctrl( table, index, k_control_bitmask_deleted );
+        shard.size.fetch_sub( 1, std::memory_order_relaxed );
+        return 1;
+    }
+
+    template <typename K, typename V>
+    template <typename Function>
+    void ConcurrentFlatHashMap<K, V>::for_each( Function&& function ) {
+        for ( u32 s = 0; s < k_concurrent_hash_map_shard_count; ++s ) {
+            Shard& shard = shards[ s ];
+            std::lock_guard<std::mutex> guard( shard.mutex );
+
+            Table* table = shard.table.load( std::memory_order_relaxed );
+            for ( u64 i = 0; i < table->capacity; ++i ) {
+                if ( control_is_full( table->control_bytes[ i ] ) ) {
+                    function( table->slots[ i ].key, table->slots[ i ].value );
+                }
+            }
+        }
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::set_default_value( const V& value ) {
+        default_value = value;
+    }
+
+    template <typename K, typename V>
+    u64 ConcurrentFlatHashMap<K, V>::get_size() const {
+        u64 size = 0;
+        for ( u32 i = 0; i < k_concurrent_hash_map_shard_count; ++i ) {
+            size += shards[ i ].size.load( std::memory_order_relaxed );
+        }
+        return size;
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::reclaim_retired_tables() {
+        for ( u32 i = 0; i < k_concurrent_hash_map_shard_count; ++i ) {
+            Shard& shard = shards[ i ];
+            std::lock_guard<std::mutex> guard( shard.mutex );
+
+            Table* table = shard.retired;
+            while ( table ) {
+                Table* next = table->retired_next;
+                allocator->deallocate( table );
+                table = next;
+            }
+            shard.retired = nullptr;
+        }
+    }
+
+    template <typename K, typename V>
+    typename ConcurrentFlatHashMap<K, V>::Table* ConcurrentFlatHashMap<K, V>::allocate_table( u64 capacity ) {
+        const sizet control_offset = memory_align( sizeof( Table ), alignof( KeyValue ) > 16 ? alignof( KeyValue ) : 16 );
+        const sizet slots_offset = memory_align( control_offset + capacity + GroupSse2Impl::kWidth, alignof( KeyValue ) );
+        const sizet table_size = slots_offset + sizeof( KeyValue ) * capacity;
+
+        u8* memory = ( u8* )allocator->allocate( table_size, 64 );
+        RASSERT( memory );
+
+        Table* table = ( Table* )memory;
+        table->capacity = capacity;
+        table->growth_left = capacity_to_growth( capacity );
+        table->control_bytes = ( i8* )( memory + control_offset );
+        table->slots = ( KeyValue* )( memory + slots_offset );
+        table->retired_next = nullptr;
+
+        memset( table->control_bytes, k_control_bitmask_empty, capacity + GroupSse2Impl::kWidth );
+        table->control_bytes[ capacity ] = k_control_bitmask_sentinel;
+        return table;
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::rehash( Shard& shard, Table* table ) {
+        // Keep the capacity if it is mostly filled by deleted slots.
+        const u64 size = shard.size.load( std::memory_order_relaxed );
+        const u64 new_capacity = size <= capacity_to_growth( table->capacity ) / 2 ? table->capacity : table->capacity * 2 + 1;
+
+        Table* new_table = allocate_table( new_capacity );
+        for ( u64 i = 0; i < table->capacity; ++i ) {
+            if ( control_is_full( table->control_bytes[ i ] ) ) {
+                const KeyValue& key_value = table->slots[ i ];
+                const u64 hash = hash_calculate( key_value.key );
+                const u64 new_index = find_first_empty( new_table, hash );
+
+                new_table->slots[ new_index ] = key_value;
+                set_ctrl( new_table, new_index, hash_2( hash ) );
+                --new_table->growth_left;
+            }
+        }
+
+        // Lookups that loaded the old table keep probing it, until it is reclaimed.
+        shard.table.store( new_table, std::memory_order_release );
+        table->retired_next = shard.retired;
+        shard.retired = table;
+    }
+
+    template <typename K, typename V>
+    bool ConcurrentFlatHashMap<K, V>::find_in_table( const Table* table, const K& key, u64 hash, V* out_value, u64* out_index ) {
+        ProbeSequence sequence( hash_1( hash, table->control_bytes ), table->capacity );
+        const i8 hash2 = hash_2( hash );
+        while ( true ) {
+            // Control bytes are written one at a time: the group can mix old and new states,
+            // both are valid for a lookup.
+            const GroupSse2Impl group{ table->control_bytes + sequence.get_offset() };
+            std::atomic_thread_fence( std::memory_order_acquire );
+
+            for ( int i : group.Match( hash2 ) ) {
+                const u64 index = sequence.get_offset( i );
+                const KeyValue& key_value = table->slots[ index ];
+                if ( key_value.key == key ) {
+                    if ( out_value ) {
+                        *out_value = key_value.value;
+                    }
+                    if ( out_index ) {
+                        *out_index = index;
+                    }
+                    return true;
+                }
+            }
+
+            // Slots are never emptied, so the probe always stops at the first empty one.
+            if ( group.MatchEmpty() ) {
+                return false;
+            }
+            sequence.next();
+        }
+    }
+
+    template <typename K, typename V>
+    u64 ConcurrentFlatHashMap<K, V>::find_first_empty( Table* table, u64 hash ) {
+        ProbeSequence sequence( hash_1( hash, table->control_bytes ), table->capacity );
+        while ( true ) {
+            const GroupSse2Impl group{ table->control_bytes + sequence.get_offset() };
+            auto mask = group.MatchEmpty();
+            if ( mask ) {
+                return sequence.get_offset( mask.LowestBitSet() );
+            }
+            sequence.next();
+        }
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::publish_slot( Table* table, const K& key, const V& value, u64 hash ) {
+        const u64 index = find_first_empty( table, hash );
+        table->slots[ index ].key = key;
+        table->slots[ index ].value = value;
+        // The slot must be visible before the control byte that publishes it.
+        std::atomic_thread_fence( std::memory_order_release );
+        set_ctrl( table, index, hash_2( hash ) );
+
+        --table->growth_left;
+    }
+
+    template <typename K, typename V>
+    void ConcurrentFlatHashMap<K, V>::set_ctrl( Table* table, u64 i, i8 h ) {
+        constexpr size_t kClonedBytes = GroupSse2Impl::kWidth - 1;
+        table->control_bytes[ i ] = h;
+        table->control_bytes[ ( ( i - kClonedBytes ) & table->capacity ) + ( kClonedBytes & table->capacity ) ] = h;
+    }
+
+} // namespace syi
@@ -1,6 +1,7 @@
 #include "foundation/data_structures.hpp"
 
 #include <string.h>
+#include <new>
 
 namespace syi {
 
@@ -8,83 +9,231 @@ namespace syi {
 
 // Resource Pool ////////////////////////////////////////////////////////////////
 
-void ResourcePool::init( Allocator* allocator_, u32 pool_size_, u32 resource_size_ ) {
+static const u32                        k_slot_alive_bit = 1u << 31;
+
+static u64 free_list_pack( u32 tag, u32 index ) {
+    return ( ( u64 )tag << 32 ) | index;
+}
+
+static u32 handle_from_state( u32 index, u32 state ) {
+    return ( ( state & k_resource_handle_generation_mask ) << k_resource_handle_index_bits ) | index;
+}
+
+void ResourcePool::init( Allocator* allocator_, u32 chunk_size_, u32 resource_size_, u32 max_size_ ) {
+
+    RASSERT( chunk_size_ > 0 && max_size_ > 0 );
 
     allocator = allocator_;
-    pool_size = pool_size_;
     resource_size = resource_size_;
+    max_size = max_size_ < k_resource_pool_max_size ? max_size_ : k_resource_pool_max_size;
 
-    // Group allocate ( resource size + u32 )
-    sizet allocation_size = pool_size * (resource_size + sizeof(u32));
-    memory = (u8*)allocator->allocate( allocation_size, 1 );
-    memset( memory, 0, allocation_size );
-
-    // Allocate and add free indices
-    free_indices = ( u32* )( memory + pool_size * resource_size );
-    free_indices_head = 0;
+    // Power of two chunks, so that a slot is found with a shift and a mask.
+    chunk_shift = 0;
+    while ( ( 1u << chunk_shift ) < chunk_size_ && chunk_shift < k_resource_handle_index_bits ) {
+        ++chunk_shift;
+    }
+    chunk_size = 1u << chunk_shift;
+    chunk_resources_size = ( u32 )memory_align( chunk_size * resource_size, alignof( std::atomic<u32> ) );
 
-    for ( u32 i = 0; i < pool_size; ++i ) {
-        free_indices[i] = i;
+    max_chunks = ( max_size + chunk_size - 1 ) >> chunk_shift;
+    chunks = ( std::atomic<u8*>* )allocator->allocate( sizeof( std::atomic<u8*> ) * max_chunks, alignof( std::atomic<u8*> ) );
+    for ( u32 c = 0; c < max_chunks; ++c ) {
+        new ( &chunks[ c ] ) std::atomic<u8*>( nullptr );
     }
+    chunk_count = 0;
+
+    pool_size.store( 0, std::memory_order_relaxed );
+    used_indices.store( 0, std::memory_order_relaxed );
+    peak_used_indices.store( 0, std::memory_order_relaxed );
+    failed_obtains.store( 0, std::memory_order_relaxed );
+    free_list_head.store( free_list_pack( 0, k_invalid_index ), std::memory_order_relaxed );
 
-    used_indices = 0;
+    add_chunk();
 }
 
 void ResourcePool::shutdown() {
 
-    if ( free_indices_head != 0 ) {
+    if ( used_indices.load() != 0 ) {
         rprint( "Resource pool has unfreed resources.\n" );
 
-        for ( u32 i = 0; i < free_indices_head; ++i ) {
-            rprint( "\tResource %u\n", free_indices[ i ] );
+        for ( u32 i = 0; i < pool_size; ++i ) {
+            const u32 handle = get_used_handle( i );
+            if ( handle != k_invalid_index ) {
+                rprint( "\tResource %u\n", handle );
+            }
         }
     }
 
-    RASSERT( used_indices == 0 );
+    RASSERT( used_indices.load() == 0 );
 
-    allocator->deallocate( memory );
+    for ( u32 c = 0; c < chunk_count; ++c ) {
+        allocator->deallocate( chunks[ c ].load( std::memory_order_relaxed ) );
+    }
+    allocator->deallocate( chunks );
+    chunks = nullptr;
+    chunk_count = 0;
 }
 
-void ResourcePool::free_all_resources() {
-    free_indices_head = 0;
-    used_indices = 0;
+std::atomic<u32>& ResourcePool::next_index( u32 index ) const {
+    u8* chunk = chunks[ index >> chunk_shift ].load( std::memory_order_acquire );
+    return ( ( std::atomic<u32>* )( chunk + chunk_resources_size ) )[ index & ( chunk_size - 1 ) ];
+}
+
+std::atomic<u32>& ResourcePool::slot_state( u32 index ) const {
+    u8* chunk = chunks[ index >> chunk_shift ].load( std::memory_order_acquire );
+    return ( ( std::atomic<u32>* )( chunk + chunk_resources_size ) )[ chunk_size + ( index & ( chunk_size - 1 ) ) ];
+}
+
+bool ResourcePool::add_chunk() {
+    // Lock must be held by the caller, or the pool not shared yet.
+    if ( chunk_count == max_chunks ) {
+        return false;
+    }
+
+    // Group allocate ( resources + next indices + slot states )
+    const sizet allocation_size = chunk_resources_size + chunk_size * sizeof( std::atomic<u32> ) * 2;
+    u8* chunk = ( u8* )allocator->allocate( allocation_size, 64 );
+    if ( !chunk ) {
+        return false;
+    }
+    memset( chunk, 0, allocation_size );
+
+    const u32 first_index = chunk_count << chunk_shift;
+    // Last chunk can be partial, to never hand out the index reserved for invalid handles.
+    const u32 last_index = ( first_index + chunk_size < max_size ? first_index + chunk_size : max_size ) - 1;
+
+    chunks[ chunk_count ].store( chunk, std::memory_order_release );
+    ++chunk_count;
+
+    for ( u32 i = first_index; i < last_index; ++i ) {
+        next_index( i ).store( i + 1, std::memory_order_relaxed );
+    }
+
+    // Publish the new slots and push them on the free list as a single chain.
+    pool_size.store( last_index + 1, std::memory_order_release );
+
+    u64 head = free_list_head.load( std::memory_order_relaxed );
+    do {
+        next_index( last_index ).store( ( u32 )head, std::memory_order_relaxed );
+    } while ( !free_list_head.compare_exchange_weak( head, free_list_pack( ( u32 )( head >> 32 ) + 1, first_index ), std::memory_order_release, std::memory_order_relaxed ) );
 
-    for ( uint32_t i = 0; i < pool_size; ++i ) {
-        free_indices[i] = i;
+    return true;
+}
+
+void ResourcePool::free_all_resources() {
+    // Not thread safe: no other thread can access the pool.
+    const u32 size = pool_size.load( std::memory_order_relaxed );
+    for ( u32 i = 0; i < size; ++i ) {
+        next_index( i ).store( i + 1 < size ? i + 1 : k_invalid_index, std::memory_order_relaxed );
+
+        // Alive resources get a new generation, so that their handles become stale.
+        std::atomic<u32>& state = slot_state( i );
+        const u32 current_state = state.load( std::memory_order_relaxed );
+        const u32 generation = current_state & k_slot_alive_bit ? current_state + 1 : current_state;
+        state.store( generation & k_resource_handle_generation_mask, std::memory_order_relaxed );
     }
+
+    used_indices.store( 0, std::memory_order_relaxed );
+    free_list_head.store( free_list_pack( 0, size ? 0 : k_invalid_index ), std::memory_order_release );
 }
 
 u32 ResourcePool::obtain_resource() {
-    // TODO: add bits for checking if resource is alive and use bitmasks.
-    if ( free_indices_head < pool_size ) {
-        const u32 free_index = free_indices[free_indices_head++];
-        ++used_indices;
-        return free_index;
+    u64 head = free_list_head.load( std::memory_order_acquire );
+    u32 free_index;
+    for ( ;; ) {
+        free_index = ( u32 )head;
+        if ( free_index == k_invalid_index ) {
+            std::lock_guard<std::mutex> guard( grow_mutex );
+            // Another thread could have grown the pool or released a resource meanwhile.
+            head = free_list_head.load( std::memory_order_acquire );
+            if ( ( u32 )head == k_invalid_index ) {
+                if ( !add_chunk() ) {
+                    failed_obtains.fetch_add( 1, std::memory_order_relaxed );
+                    rprint( "Resource pool full, capacity %u\n", pool_size.load() );
+                    return k_invalid_index;
+                }
+                head = free_list_head.load( std::memory_order_acquire );
+            }
+            continue;
+        }
+
+        // The link can be stale if another thread popped the index, the tag makes the exchange fail then.
+        const u32 next = next_index( free_index ).load( std::memory_order_relaxed );
+        if ( free_list_head.compare_exchange_weak( head, free_list_pack( ( u32 )( head >> 32 ) + 1, next ), std::memory_order_acquire, std::memory_order_acquire ) ) {
+            break;
+        }
+    }
+
+    std::atomic<u32>& state = slot_state( free_index );
+    const u32 current_state = state.load( std::memory_order_relaxed );
+    state.store( current_state | k_slot_alive_bit, std::memory_order_relaxed );
+
+    const u32 used = used_indices.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    u32 peak = peak_used_indices.load( std::memory_order_relaxed );
+    while ( peak < used && !peak_used_indices.compare_exchange_weak( peak, used, std::memory_order_relaxed ) ) {
     }
-    // Error: no more resources left!
-    RASSERT( false );
-    return k_invalid_index;
+
+    return handle_from_state( free_index, current_state );
 }
 
 void ResourcePool::release_resource( u32 handle ) {
-    // TODO: add bits for checking if resource is alive and use bitmasks.
-    free_indices[--free_indices_head] = handle;
-    --used_indices;
+    const u32 index = handle & k_resource_handle_index_mask;
+    RASSERT( index < pool_size.load( std::memory_order_relaxed ) );
+
+    std::atomic<u32>& state = slot_state( index );
+    const u32 current_state = state.load( std::memory_order_relaxed );
+    RASSERTM( ( current_state & k_slot_alive_bit ) && handle_from_state( index, current_state ) == handle, "Releasing stale resource handle %u", handle );
+
+    // New generation: all outstanding handles to this slot become stale.
+    state.store( ( current_state + 1 ) & k_resource_handle_generation_mask, std::memory_order_relaxed );
+    used_indices.fetch_sub( 1, std::memory_order_relaxed );
+
+    u64 head = free_list_head.load( std::memory_order_relaxed );
+    do {
+        next_index( index ).store( ( u32 )head, std::memory_order_relaxed );
+    } while ( !free_list_head.compare_exchange_weak( head, free_list_pack( ( u32 )( head >> 32 ) + 1, index ), std::memory_order_release, std::memory_order_relaxed ) );
 }
 
 void* ResourcePool::access_resource( u32 handle ) {
-    if ( handle != k_invalid_index ) {
-        return &memory[handle * resource_size];
-    }
-    return nullptr;
+    return const_cast< void* >( static_cast< const ResourcePool* >( this )->access_resource( handle ) );
 }
 
 const void* ResourcePool::access_resource( u32 handle ) const {
-    if ( handle != k_invalid_index ) {
-        return &memory[handle * resource_size];
+    const u32 index = handle & k_resource_handle_index_mask;
+    const u32 chunk_index = index >> chunk_shift;
+    if ( handle == k_invalid_index || chunk_index >= max_chunks ) {
+        return nullptr;
+    }
+
+    u8* chunk = chunks[ chunk_index ].load( std::memory_order_acquire );
+    if ( !chunk ) {
+        return nullptr;
+    }
+
+    const u32 slot = index & ( chunk_size - 1 );
+    const u32 state = ( ( std::atomic<u32>* )( chunk + chunk_resources_size ) )[ chunk_size + slot ].load( std::memory_order_acquire );
+    if ( ( state & k_slot_alive_bit ) && handle_from_state( index, state ) == handle ) {
+        return &chunk[ slot * resource_size ];
     }
     return nullptr;
 }
 
+u32 ResourcePool::get_used_handle( u32 index ) const {
+    const u32 state = slot_state( index ).load( std::memory_order_acquire );
+    return state & k_slot_alive_bit ? handle_from_state( index, state ) : k_invalid_index;
+}
+
+ResourcePoolStatistics ResourcePool::get_statistics() const {
+    ResourcePoolStatistics statistics;
+    statistics.used_count = used_indices.load( std::memory_order_relaxed );
+    statistics.peak_used_count = peak_used_indices.load( std::memory_order_relaxed );
+    statistics.capacity = pool_size.load( std::memory_order_relaxed );
+    statistics.max_capacity = max_size;
+    statistics.chunk_count = chunk_count;
+    statistics.failed_obtain_count = failed_obtains.load( std::memory_order_relaxed );
+    statistics.memory_size = ( sizet )chunk_count * ( chunk_resources_size + chunk_size * sizeof( std::atomic<u32> ) * 2 ) + sizeof( std::atomic<u8*> ) * max_chunks;
+    return statistics;
+}
+
 
 } // namespace syi
@@ -3,30 +3,72 @@
 #include "foundation/memory.hpp"
 #include "foundation/assert.hpp"
 
+#include <atomic>
+#include <mutex>
+
 namespace syi {
 
+    // Handles are 32 bits: slot index in the low bits, slot generation in the high bits.
+    // The last index is never used, so a valid handle can't be 0xffffffff.
+    static const u32                    k_resource_handle_index_bits        = 20;
+    static const u32                    k_resource_handle_index_mask        = ( 1u << k_resource_handle_index_bits ) - 1;
+    static const u32                    k_resource_handle_generation_mask   = 0xfff;
+    static const u32                    k_resource_pool_max_size            = k_resource_handle_index_mask;
+
     //
+    // Occupancy of a ResourcePool, to size the pools from real scenes.
+    struct ResourcePoolStatistics {
+        u32                             used_count;
+        u32                             peak_used_count;
+        u32                             capacity;
+        u32                             max_capacity;
+        u32                             chunk_count;
+        u32                             failed_obtain_count;    // Obtains refused because the hard cap was hit.
+        sizet                           memory_size;
+    }; // struct ResourcePoolStatistics
+
     //
+    // Pool of resources addressed by generational handles, growing in chunks up to an optional cap.
+    // Chunks are never moved, so pointers and handles stay valid while the pool grows.
+    // obtain and release are lock free, access detects stale handles in O(1). Growing takes a lock.
     struct ResourcePool {
 
-        void                            init( Allocator* allocator, u32 pool_size, u32 resource_size );
+        void                            init( Allocator* allocator, u32 chunk_size, u32 resource_size, u32 max_size = k_resource_pool_max_size );
         void                            shutdown();
 
-        u32                             obtain_resource();      // Returns an index to the resource
-        void                            release_resource( u32 index );
+        u32                             obtain_resource();      // Returns a handle to the resource
+        void                            release_resource( u32 handle );
         void                            free_all_resources();
 
-        void*                           access_resource( u32 index );
-        const void*                     access_resource( u32 index ) const;
+        void*                           access_resource( u32 handle );
+        const void*                     access_resource( u32 handle ) const;
+
+        // Handle of the resource in slot index if alive, u32_max otherwise. Used for iteration up to pool_size.
+        u32                             get_used_handle( u32 index ) const;
+
+        ResourcePoolStatistics          get_statistics() const;
+
+        bool                            add_chunk();
+        std::atomic<u32>&               next_index( u32 index ) const;
+        std::atomic<u32>&               slot_state( u32 index ) const;
 
-        u8*                             memory          = nullptr;
-        u32*                            free_indices    = nullptr;
+        std::atomic<u8*>*               chunks          = nullptr;  // Fixed table of max_chunks entries.
         Allocator*                      allocator       = nullptr;
 
-        u32                             free_indices_head   = 0;
-        u32                             pool_size           = 16;
+        std::atomic<u64>                free_list_head;             // Tag in the high 32 bits against ABA, index in the low ones.
+        std::atomic<u32>                used_indices;
+        std::atomic<u32>                peak_used_indices;
+        std::atomic<u32>                failed_obtains;
+        std::atomic<u32>                pool_size;                  // Slots in the allocated chunks.
+        std::mutex                      grow_mutex;
+
+        u32                             chunk_size          = 16;   // Power of two.
+        u32                             chunk_shift         = 4;
+        u32                             chunk_resources_size = 0;   // Bytes of the resources in a chunk, aligned.
+        u32                             chunk_count         = 0;
+        u32                             max_chunks          = 0;
+        u32                             max_size            = 0;
         u32                             resource_size       = 4;
-        u32                             used_indices        = 0;
 
     }; // struct ResourcePool
 
@@ -35,7 +77,7 @@ namespace syi {
     template <typename T>
     struct ResourcePoolTyped : public ResourcePool {
 
-        void                            init( Allocator* allocator, u32 pool_size );
+        void                            init( Allocator* allocator, u32 chunk_size, u32 max_size = k_resource_pool_max_size );
         void                            shutdown();
 
         T*                              obtain();
@@ -47,17 +89,20 @@ namespace syi {
     }; // struct ResourcePoolTyped
 
     template<typename T>
-    inline void ResourcePoolTyped<T>::init( Allocator* allocator_, u32 pool_size_ ) {
-        ResourcePool::init( allocator_, pool_size_, sizeof( T ) );
+    inline void ResourcePoolTyped<T>::init( Allocator* allocator_, u32 chunk_size_, u32 max_size_ ) {
+        ResourcePool::init( allocator_, chunk_size_, sizeof( T ), max_size_ );
     }
 
     template<typename T>
     inline void ResourcePoolTyped<T>::shutdown() {
-        if ( free_indices_head != 0 ) {
+        if ( used_indices.load() != 0 ) {
             rprint( "Resource pool has unfreed resources.\n" );
 
-            for ( u32 i = 0; i < free_indices_head; ++i ) {
-                rprint( "\tResource %u, %s\n", free_indices[ i ], get( free_indices[ i ] )->name );
+            for ( u32 i = 0; i < pool_size; ++i ) {
+                const u32 handle = get_used_handle( i );
+                if ( handle != u32_max ) {
+                    rprint( "\tResource %u, %s\n", handle, get( handle )->name );
+                }
             }
         }
         ResourcePool::shutdown();
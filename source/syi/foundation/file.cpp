@@ -10,6 +10,8 @@
 #define MAX_PATH 65536
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
@@ -117,6 +119,24 @@ bool file_exists( cstring path ) {
 #endif // _WIN64
 }
 
+bool file_is_newer( cstring path, cstring other_path ) {
+#if defined(_WIN64)
+    FileTime time = file_last_write_time( path );
+    FileTime other_time = file_last_write_time( other_path );
+    return CompareFileTime( ( const ::FILETIME* )&time, ( const ::FILETIME* )&other_time ) > 0;
+#else
+    struct stat path_stat, other_stat;
+    if ( stat( path, &path_stat ) != 0 || stat( other_path, &other_stat ) != 0 ) {
+        return false;
+    }
+
+    if ( path_stat.st_mtim.tv_sec != other_stat.st_mtim.tv_sec ) {
+        return path_stat.st_mtim.tv_sec > other_stat.st_mtim.tv_sec;
+    }
+    return path_stat.st_mtim.tv_nsec > other_stat.st_mtim.tv_nsec;
+#endif // _WIN64
+}
+
 bool file_delete( cstring path ) {
 #if defined(_WIN64)
     int result = remove( path );
@@ -436,6 +456,80 @@ void file_write_binary( cstring filename, void* memory, sizet size ) {
     fclose( file );
 }
 
+bool file_map_read_only( cstring filename, FileMapping* out_mapping ) {
+    *out_mapping = FileMapping{};
+
+#if defined(_WIN64)
+    HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr );
+    if ( file == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if ( !GetFileSizeEx( file, &file_size ) || file_size.QuadPart == 0 ) {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( !mapping ) {
+        CloseHandle( file );
+        return false;
+    }
+
+    void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( !data ) {
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return false;
+    }
+
+    out_mapping->data = ( char* )data;
+    out_mapping->size = ( sizet )file_size.QuadPart;
+    out_mapping->file_handle = file;
+    out_mapping->mapping_handle = mapping;
+#else
+    int file = open( filename, O_RDONLY );
+    if ( file < 0 ) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if ( fstat( file, &file_stat ) != 0 || file_stat.st_size == 0 ) {
+        close( file );
+        return false;
+    }
+
+    void* data = mmap( nullptr, ( sizet )file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    // The mapping keeps its own reference to the file.
+    close( file );
+    if ( data == MAP_FAILED ) {
+        return false;
+    }
+
+    out_mapping->data = ( char* )data;
+    out_mapping->size = ( sizet )file_stat.st_size;
+#endif // _WIN64
+
+    return true;
+}
+
+void file_unmap( FileMapping* mapping ) {
+    if ( !mapping->data ) {
+        return;
+    }
+
+#if defined(_WIN64)
+    UnmapViewOfFile( mapping->data );
+    CloseHandle( ( HANDLE )mapping->mapping_handle );
+    CloseHandle( ( HANDLE )mapping->file_handle );
+#else
+    munmap( mapping->data, mapping->size );
+#endif // _WIN64
+
+    *mapping = FileMapping{};
+}
+
 // Scoped file //////////////////////////////////////////////////////////////////
 ScopedFile::ScopedFile( cstring filename, cstring mode ) {
     file_open( filename, mode, &file );
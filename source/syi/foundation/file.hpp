@@ -38,6 +38,18 @@ namespace syi {
         sizet                       size;
     };
 
+    //
+    // Read only view of a whole file. Pages are loaded by the OS when first touched.
+    struct FileMapping {
+        char*                       data            = nullptr;
+        sizet                       size            = 0;
+
+#if defined (_WIN64)
+        void*                       file_handle     = nullptr;
+        void*                       mapping_handle  = nullptr;
+#endif
+    }; // struct FileMapping
+
     // Read file and allocate memory from allocator.
     // User is responsible for freeing the memory.
     char*                           file_read_binary( cstring filename, Allocator* allocator, sizet* size );
@@ -48,7 +60,12 @@ namespace syi {
 
     void                            file_write_binary( cstring filename, void* memory, sizet size );
 
+    // Map the file read only. Returns false if the file can't be opened or is empty.
+    bool                            file_map_read_only( cstring filename, FileMapping* out_mapping );
+    void                            file_unmap( FileMapping* mapping );
+
     bool                            file_exists( cstring path );
+    bool                            file_is_newer( cstring path, cstring other_path );  // True if path was written after other_path.
     void                            file_open( cstring filename, cstring mode, FileHandle* file );
     void                            file_close( FileHandle file );
     sizet                           file_write( uint8_t* memory, u32 element_size, u32 count, FileHandle file );
@@ -0,0 +1,110 @@
+#include "frame_arena.hpp"
+#include "assert.hpp"
+
+#if defined syi_IMGUI
+#include "external/imgui/imgui.h"
+#endif // syi_IMGUI
+
+namespace syi {
+
+// FrameArenaService //////////////////////////////////////////////////////
+static FrameArenaService    s_frame_arena_service;
+
+FrameArenaService* FrameArenaService::instance() {
+    return &s_frame_arena_service;
+}
+
+void FrameArenaService::init( void* configuration ) {
+    FrameArenaServiceConfiguration default_configuration;
+    FrameArenaServiceConfiguration* arena_configuration = configuration ? static_cast< FrameArenaServiceConfiguration* >( configuration ) : &default_configuration;
+
+    frames_in_flight = arena_configuration->frames_in_flight;
+    thread_count = arena_configuration->thread_count;
+    arena_size = arena_configuration->arena_size;
+    current_frame = 0;
+
+    RASSERTM( frames_in_flight <= k_frame_arena_max_frames, "FrameArenaService: too many frames in flight %u, max %u", frames_in_flight, k_frame_arena_max_frames );
+    RASSERTM( thread_count <= k_frame_arena_max_threads, "FrameArenaService: too many threads %u, max %u", thread_count, k_frame_arena_max_threads );
+
+    for ( u32 f = 0; f < frames_in_flight; ++f ) {
+        frame_high_water_marks[ f ] = 0;
+
+        for ( u32 t = 0; t < thread_count; ++t ) {
+            FrameArena& arena = arenas[ f ][ t ];
+            arena.allocator.init( arena_size );
+            arena.high_water_mark = 0;
+        }
+    }
+
+    rprint( "FrameArenaService: %u frames, %u threads, %zu bytes per arena\n", frames_in_flight, thread_count, arena_size );
+}
+
+void FrameArenaService::shutdown() {
+    for ( u32 f = 0; f < frames_in_flight; ++f ) {
+        for ( u32 t = 0; t < thread_count; ++t ) {
+            arenas[ f ][ t ].allocator.shutdown();
+        }
+    }
+
+    frames_in_flight = 0;
+    thread_count = 0;
+}
+
+void FrameArenaService::new_frame( u32 frame_index ) {
+    current_frame = frame_index % frames_in_flight;
+
+    // The frame is retired, sample and reset its arenas.
+    sizet frame_size = 0;
+    for ( u32 t = 0; t < thread_count; ++t ) {
+        FrameArena& arena = arenas[ current_frame ][ t ];
+        const sizet allocated_size = arena.allocator.allocated_size;
+        arena.high_water_mark = allocated_size > arena.high_water_mark ? allocated_size : arena.high_water_mark;
+        frame_size += allocated_size;
+
+        arena.allocator.clear();
+    }
+
+    sizet& frame_high_water_mark = frame_high_water_marks[ current_frame ];
+    frame_high_water_mark = frame_size > frame_high_water_mark ? frame_size : frame_high_water_mark;
+}
+
+LinearAllocator* FrameArenaService::get_allocator( u32 thread_index ) {
+    RASSERT( thread_index < thread_count );
+    return &arenas[ current_frame ][ thread_index ].allocator;
+}
+
+sizet FrameArenaService::get_thread_high_water_mark( u32 thread_index ) const {
+    sizet high_water_mark = 0;
+    for ( u32 f = 0; f < frames_in_flight; ++f ) {
+        const sizet arena_mark = arenas[ f ][ thread_index ].high_water_mark;
+        high_water_mark = arena_mark > high_water_mark ? arena_mark : high_water_mark;
+    }
+    return high_water_mark;
+}
+
+sizet FrameArenaService::get_frame_high_water_mark( u32 frame_index ) const {
+    return frame_high_water_marks[ frame_index ];
+}
+
+#if defined syi_IMGUI
+void FrameArenaService::imgui_draw() {
+
+    if ( ImGui::Begin( "Frame Arenas" ) ) {
+        ImGui::Text( "%u frames in flight, %u threads, %zu kb per arena", frames_in_flight, thread_count, arena_size / 1024 );
+        ImGui::Separator();
+
+        for ( u32 f = 0; f < frames_in_flight; ++f ) {
+            ImGui::Text( "Frame %u%s: high water mark %zu kb", f, f == current_frame ? " (current)" : "", get_frame_high_water_mark( f ) / 1024 );
+        }
+        ImGui::Separator();
+
+        for ( u32 t = 0; t < thread_count; ++t ) {
+            const sizet used = arenas[ current_frame ][ t ].allocator.allocated_size;
+            ImGui::Text( "Thread %u: used %zu kb, high water mark %zu kb", t, used / 1024, get_thread_high_water_mark( t ) / 1024 );
+        }
+    }
+    ImGui::End();
+}
+#endif // syi_IMGUI
+
+} // namespace syi
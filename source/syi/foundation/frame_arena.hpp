@@ -0,0 +1,66 @@
+#pragma once
+
+#include "foundation/memory.hpp"
+
+namespace syi {
+
+    static const u32                k_frame_arena_max_frames    = 4;
+    static const u32                k_frame_arena_max_threads   = 64;
+
+    //
+    // Bump allocator owned by a single thread for a single frame in flight.
+    // Padded to a cache line so that threads don't share the allocation offsets.
+    struct alignas( 64 ) FrameArena {
+
+        LinearAllocator             allocator;
+        sizet                       high_water_mark = 0;    // Peak usage, sampled when the arena is reset.
+
+    }; // struct FrameArena
+
+    //
+    //
+    struct FrameArenaServiceConfiguration {
+
+        u32                         frames_in_flight    = 3;
+        u32                         thread_count        = 1;            // Usually the number of task threads.
+        sizet                       arena_size          = 2 * 1024 * 1024;
+
+    }; // struct FrameArenaServiceConfiguration
+
+    //
+    // Per-thread transient memory, one arena set per frame in flight.
+    // Memory allocated during a frame stays valid until the same frame index comes back,
+    // that is when the GPU is done with it, so no free is ever needed.
+    struct FrameArenaService : public Service {
+
+        syi_DECLARE_SERVICE( FrameArenaService );
+
+        void                        init( void* configuration );
+        void                        shutdown();
+
+        // Call once the fence of frame_index is signaled: resets all the arenas of that frame.
+        void                        new_frame( u32 frame_index );
+
+        // Allocator of the calling thread for the current frame. Only the owning thread can use it.
+        LinearAllocator*            get_allocator( u32 thread_index );
+
+        sizet                       get_thread_high_water_mark( u32 thread_index ) const;
+        sizet                       get_frame_high_water_mark( u32 frame_index ) const;
+
+#if defined syi_IMGUI
+        void                        imgui_draw();
+#endif // syi_IMGUI
+
+        FrameArena                  arenas[ k_frame_arena_max_frames ][ k_frame_arena_max_threads ];
+        sizet                       frame_high_water_marks[ k_frame_arena_max_frames ];
+
+        u32                         frames_in_flight    = 0;
+        u32                         thread_count        = 0;
+        u32                         current_frame       = 0;
+        sizet                       arena_size          = 0;
+
+        static constexpr cstring    k_name = "syi_frame_arena_service";
+
+    }; // struct FrameArenaService
+
+} // namespace syi
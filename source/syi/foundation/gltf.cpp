@@ -1,4 +1,5 @@
 #include "gltf.hpp"
+#include "gltf_blob.hpp"
 
 #include "external/json.hpp"
 
@@ -219,20 +220,14 @@ static void load_nodes( json& json_data, glTF::glTF& gltf_data, Allocator* alloc
     }
 }
 
-static void load_mesh_primitive( json& json_data, glTF::MeshPrimitive& mesh_primitive, Allocator* allocator ) {
-    try_load_int( json_data, "indices", mesh_primitive.indices );
-    try_load_int( json_data, "material", mesh_primitive.material );
-    try_load_int( json_data, "mode", mesh_primitive.mode );
-
-    json attributes = json_data[ "attributes" ];
-
-    mesh_primitive.attributes = ( glTF::MeshPrimitive::Attribute* )allocate_and_zero( allocator, sizeof( glTF::MeshPrimitive::Attribute ) * attributes.size() );
-    mesh_primitive.attribute_count = attributes.size();
+static void load_attributes( json& attributes, u32& attribute_count, glTF::MeshPrimitive::Attribute** out_attributes, Allocator* allocator ) {
+    *out_attributes = ( glTF::MeshPrimitive::Attribute* )allocate_and_zero( allocator, sizeof( glTF::MeshPrimitive::Attribute ) * attributes.size() );
+    attribute_count = attributes.size();
 
     u32 index = 0;
     for ( auto json_attribute : attributes.items() ) {
         std::string key = json_attribute.key();
-        glTF::MeshPrimitive::Attribute& attribute = mesh_primitive.attributes[ index ];
+        glTF::MeshPrimitive::Attribute& attribute = ( *out_attributes )[ index ];
 
         attribute.key.init( key.size() + 1, allocator );
         attribute.key.append( key.c_str() );
@@ -243,6 +238,31 @@ static void load_mesh_primitive( json& json_data, glTF::MeshPrimitive& mesh_prim
     }
 }
 
+static void load_mesh_primitive( json& json_data, glTF::MeshPrimitive& mesh_primitive, Allocator* allocator ) {
+    try_load_int( json_data, "indices", mesh_primitive.indices );
+    try_load_int( json_data, "material", mesh_primitive.material );
+    try_load_int( json_data, "mode", mesh_primitive.mode );
+
+    json attributes = json_data[ "attributes" ];
+    load_attributes( attributes, mesh_primitive.attribute_count, &mesh_primitive.attributes, allocator );
+
+    auto targets = json_data.find( "targets" );
+    if ( targets == json_data.end() ) {
+        mesh_primitive.targets_count = 0;
+        mesh_primitive.targets = nullptr;
+        return;
+    }
+
+    sizet targets_count = targets->size();
+    mesh_primitive.targets = ( glTF::MeshPrimitive::Target* )allocate_and_zero( allocator, sizeof( glTF::MeshPrimitive::Target ) * targets_count );
+    mesh_primitive.targets_count = targets_count;
+
+    for ( sizet i = 0; i < targets_count; ++i ) {
+        glTF::MeshPrimitive::Target& target = mesh_primitive.targets[ i ];
+        load_attributes( ( *targets )[ i ], target.attribute_count, &target.attributes, allocator );
+    }
+}
+
 static void load_mesh_primitives( json& json_data, glTF::Mesh& mesh, Allocator* allocator ) {
     json array = json_data[ "primitives" ];
 
@@ -273,12 +293,35 @@ static void load_meshes( json& json_data, glTF::glTF& gltf_data, Allocator* allo
     }
 }
 
+static void try_load_AccessorSparse( json& json_data, cstring key, glTF::AccessorSparse** sparse, Allocator* allocator ) {
+    auto it = json_data.find( key );
+    if ( it == json_data.end() ) {
+        *sparse = nullptr;
+        return;
+    }
+
+    glTF::AccessorSparse* s = ( glTF::AccessorSparse* ) allocator->allocate( sizeof( glTF::AccessorSparse ), 64 );
+
+    try_load_int( *it, "count", s->count );
+
+    json indices = ( *it )[ "indices" ];
+    try_load_int( indices, "bufferView", s->indices.buffer_view );
+    try_load_int( indices, "byteOffset", s->indices.byte_offset );
+    try_load_int( indices, "componentType", s->indices.component_type );
+
+    json values = ( *it )[ "values" ];
+    try_load_int( values, "bufferView", s->values.buffer_view );
+    try_load_int( values, "byteOffset", s->values.byte_offset );
+
+    *sparse = s;
+}
+
 static void load_accessor( json& json_data, glTF::Accessor& accessor, Allocator* allocator ) {
     try_load_int( json_data, "bufferView", accessor.buffer_view );
     try_load_int( json_data, "byteOffset", accessor.byte_offset );
     try_load_int( json_data, "componentType", accessor.component_type );
     try_load_int( json_data, "count", accessor.count );
-    try_load_int( json_data, "sparse", accessor.sparse );
+    try_load_AccessorSparse( json_data, "sparse", &accessor.sparse, allocator );
     try_load_float_array( json_data, "max", accessor.max_count, &accessor.max, allocator );
     try_load_float_array( json_data, "min", accessor.min_count, &accessor.min, allocator );
     try_load_bool( json_data, "normalized", accessor.normalized );
@@ -546,7 +589,7 @@ static void load_animations( json& json_data, glTF::glTF& gltf_data, Allocator*
     }
 }
 
-glTF::glTF gltf_load_file( cstring file_path ) {
+glTF::glTF gltf_load_file_dom( cstring file_path ) {
     glTF::glTF result{ };
 
     if ( !file_exists( file_path ) ) {
@@ -600,8 +643,202 @@ glTF::glTF gltf_load_file( cstring file_path ) {
     return result;
 }
 
+// GLB ////////////////////////////////////////////////////////////////////
+
+static const u32 k_glb_magic            = 0x46546C67;   // "glTF"
+static const u32 k_glb_version          = 2;
+static const u32 k_glb_chunk_json       = 0x4E4F534A;   // "JSON"
+static const u32 k_glb_chunk_binary     = 0x004E4942;   // "BIN\0"
+
+//
+//
+struct GlbHeader {
+    u32                             magic;
+    u32                             version;
+    u32                             length;
+}; // struct GlbHeader
+
+//
+//
+struct GlbChunkHeader {
+    u32                             length;
+    u32                             type;
+}; // struct GlbChunkHeader
+
+static bool gltf_is_glb( cstring file_path ) {
+    const sizet length = strlen( file_path );
+    return length > 4 && strcmp( file_path + length - 4, ".glb" ) == 0;
+}
+
+// Finds the json and the optional binary chunk inside a mapped .glb.
+static bool glb_get_chunks( const FileMapping& mapping, const char** out_json, u32* out_json_size, u8** out_binary, u32* out_binary_size ) {
+    if ( mapping.size < sizeof( GlbHeader ) + sizeof( GlbChunkHeader ) ) {
+        return false;
+    }
+
+    const GlbHeader* header = ( const GlbHeader* )mapping.data;
+    if ( header->magic != k_glb_magic || header->version != k_glb_version || header->length > mapping.size ) {
+        return false;
+    }
+
+    const GlbChunkHeader* json_chunk = ( const GlbChunkHeader* )( header + 1 );
+    const sizet json_offset = sizeof( GlbHeader ) + sizeof( GlbChunkHeader );
+    if ( json_chunk->type != k_glb_chunk_json || json_offset + json_chunk->length > header->length ) {
+        return false;
+    }
+
+    *out_json = mapping.data + json_offset;
+    *out_json_size = json_chunk->length;
+    *out_binary = nullptr;
+    *out_binary_size = 0;
+
+    // Chunks are 4 bytes aligned, the binary one is optional.
+    const sizet binary_offset = json_offset + json_chunk->length;
+    if ( binary_offset + sizeof( GlbChunkHeader ) <= header->length ) {
+        const GlbChunkHeader* binary_chunk = ( const GlbChunkHeader* )( mapping.data + binary_offset );
+        if ( binary_chunk->type == k_glb_chunk_binary ) {
+            if ( binary_offset + sizeof( GlbChunkHeader ) + binary_chunk->length > header->length ) {
+                return false;
+            }
+
+            *out_binary = ( u8* )mapping.data + binary_offset + sizeof( GlbChunkHeader );
+            *out_binary_size = binary_chunk->length;
+        }
+    }
+
+    return true;
+}
+
+// Maps blob_path if not null, otherwise or if it does not load parses the file, and then compiles it to compile_path if not null.
+static glTF::glTF gltf_load( cstring file_path, cstring blob_path, cstring compile_path, enki::TaskScheduler* task_scheduler ) {
+    glTF::glTF result{ };
+
+    if ( !file_exists( file_path ) ) {
+        rprint( "Error: file %s does not exists.\n", file_path );
+        return result;
+    }
+
+    // Parse straight from the mapped file: no copy of the text and no json document.
+    // A .glb stays mapped, buffer views of its binary chunk are used in place.
+    FileMapping mapping;
+    if ( !file_map_read_only( file_path, &mapping ) ) {
+        rprint( "Error: could not map file %s.\n", file_path );
+        return result;
+    }
+
+    const char* json_text = mapping.data;
+    u32 json_size = ( u32 )mapping.size;
+    u8* binary_chunk = nullptr;
+    u32 binary_chunk_size = 0;
+
+    const bool is_glb = gltf_is_glb( file_path );
+    if ( is_glb && !glb_get_chunks( mapping, &json_text, &json_size, &binary_chunk, &binary_chunk_size ) ) {
+        rprint( "Error: invalid glb file %s.\n", file_path );
+        file_unmap( &mapping );
+        return result;
+    }
+
+    bool loaded = blob_path && gltf_load_blob( blob_path, result );
+    bool compile_blob = false;
+
+    if ( !loaded ) {
+        loaded = gltf_parse_sax( json_text, json_size, result, task_scheduler );
+        compile_blob = loaded && compile_path;
+
+        if ( !loaded ) {
+            rprint( "Error: could not parse glTF %s.\n", file_path );
+        }
+    }
+
+    if ( loaded && is_glb ) {
+        result.file_mapping = mapping;
+        result.binary_chunk = binary_chunk;
+        result.binary_chunk_size = binary_chunk_size;
+    } else {
+        file_unmap( &mapping );
+    }
+
+    if ( compile_blob ) {
+        gltf_compile_blob( result, compile_path );
+    }
+
+    return result;
+}
+
+glTF::glTF gltf_load_file( cstring file_path, bool use_compiled_blob, enki::TaskScheduler* task_scheduler ) {
+    if ( !use_compiled_blob ) {
+        return gltf_load( file_path, nullptr, nullptr, task_scheduler );
+    }
+
+    char blob_path[ k_max_path ];
+    gltf_blob_path( file_path, blob_path, k_max_path );
+    const bool blob_valid = file_exists( blob_path ) && !file_is_newer( file_path, blob_path );
+    return gltf_load( file_path, blob_valid ? blob_path : nullptr, blob_path, task_scheduler );
+}
+
+glTF::glTF gltf_load_cached( cstring file_path, ResourceManager& resource_manager, enki::TaskScheduler* task_scheduler ) {
+    const u64 blob_type_hash = hash_calculate( GltfBlobCompiler::k_type );
+    char blob_path[ k_max_path ];
+    cstring cached_path = resource_manager.is_cached( blob_type_hash ) ? resource_manager.get_cached_path( blob_type_hash, file_path, blob_path, k_max_path ) : nullptr;
+    return gltf_load( file_path, cached_path, nullptr, task_scheduler );
+}
+
 void gltf_free( glTF::glTF& scene ) {
     scene.allocator.shutdown();
+    file_unmap( &scene.blob_mapping );
+    file_unmap( &scene.file_mapping );
+    scene.binary_chunk = nullptr;
+    scene.binary_chunk_size = 0;
+}
+
+u8* gltf_get_buffer_view_data( const glTF::glTF& gltf, i32 buffer_view_index, u32* out_size ) {
+    if ( buffer_view_index < 0 || buffer_view_index >= ( i32 )gltf.buffer_views_count ) {
+        return nullptr;
+    }
+
+    const glTF::BufferView& buffer_view = gltf.buffer_views[ buffer_view_index ];
+    if ( buffer_view.buffer < 0 || buffer_view.buffer >= ( i32 )gltf.buffers_count ) {
+        return nullptr;
+    }
+
+    // Only the buffer without uri of a .glb is mapped, the others are loaded by the caller.
+    const glTF::Buffer& buffer = gltf.buffers[ buffer_view.buffer ];
+    const bool has_uri = buffer.uri.data != nullptr && buffer.uri.data[ 0 ] != 0;
+    if ( has_uri || gltf.binary_chunk == nullptr ) {
+        return nullptr;
+    }
+
+    // Offsets and lengths come from the file: compare in 64 bits so that they can't wrap.
+    const i32 offset = glTF::get_data_offset( glTF::INVALID_INT_VALUE, buffer_view.byte_offset );
+    if ( offset < 0 || buffer_view.byte_length < 0 || ( u64 )offset + ( u64 )buffer_view.byte_length > gltf.binary_chunk_size ) {
+        rprint( "Error: buffer view %d is outside the binary chunk.\n", buffer_view_index );
+        return nullptr;
+    }
+
+    if ( out_size ) {
+        *out_size = buffer_view.byte_length;
+    }
+    return gltf.binary_chunk + offset;
+}
+
+u8* gltf_get_accessor_data( const glTF::glTF& gltf, i32 accessor_index ) {
+    if ( accessor_index < 0 || accessor_index >= ( i32 )gltf.accessors_count ) {
+        return nullptr;
+    }
+
+    const glTF::Accessor& accessor = gltf.accessors[ accessor_index ];
+    u32 buffer_view_size = 0;
+    u8* buffer_view_data = gltf_get_buffer_view_data( gltf, accessor.buffer_view, &buffer_view_size );
+    if ( buffer_view_data == nullptr ) {
+        return nullptr;
+    }
+
+    const i32 offset = glTF::get_data_offset( accessor.byte_offset, glTF::INVALID_INT_VALUE );
+    if ( offset < 0 || ( u32 )offset >= buffer_view_size ) {
+        rprint( "Error: accessor %d starts outside its buffer view.\n", accessor_index );
+        return nullptr;
+    }
+    return buffer_view_data + offset;
 }
 
 i32 gltf_get_attribute_accessor_index( glTF::MeshPrimitive::Attribute* attributes, u32 attribute_count, cstring attribute_name ) {
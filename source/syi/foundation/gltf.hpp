@@ -3,6 +3,11 @@
 #include "memory.hpp"
 #include "platform.hpp"
 #include "string.hpp"
+#include "file.hpp"
+
+namespace enki {
+    class TaskScheduler;
+}
 
 static const char* kDefault3DModel = "../deps/src/glTF-Sample-Models/2.0/Sponza/glTF/Sponza.gltf";
 
@@ -18,6 +23,8 @@ static const char* kDefault3DModel = "../deps/src/glTF-Sample-Models/2.0/Sponza/
 
 namespace syi {
 
+struct ResourceManager;
+
 namespace glTF {
     static const i32 INVALID_INT_VALUE = 2147483647;
     static_assert( INVALID_INT_VALUE == i32_max, "Mismatch between invalid int and i32 max" );
@@ -37,12 +44,6 @@ namespace glTF {
         f32                         znear;
     };
 
-    struct AccessorSparse {
-        i32                         count;
-        i32                         indices;
-        i32                         values;
-    };
-
     struct Camera {
         i32                         orthographic;
         i32                         perspective;
@@ -142,6 +143,12 @@ namespace glTF {
             i32                     accessor_index;
         };
 
+        // Morph target: attributes (POSITION, NORMAL, TANGENT) are accessors of per vertex deltas.
+        struct Target {
+            u32                     attribute_count;
+            Attribute*              attributes;
+        };
+
         u32                         attribute_count;
         Attribute*                  attributes;
         i32                         indices;
@@ -154,8 +161,8 @@ namespace glTF {
         // 5 TRIANGLE_STRIP
         // 6 TRIANGLE_FAN
         i32                         mode;
-        // u32 targets_count;
-        // object* targets; // TODO(marco): this is a json object
+        u32                         targets_count;
+        Target*                     targets;
     };
 
     struct AccessorSparseIndices {
@@ -167,6 +174,18 @@ namespace glTF {
         i32                         component_type;
     };
 
+    struct AccessorSparseValues {
+        i32                         buffer_view;
+        i32                         byte_offset;
+    };
+
+    // count elements of the accessor, at indices, are replaced by values.
+    struct AccessorSparse {
+        i32                         count;
+        AccessorSparseIndices       indices;
+        AccessorSparseValues        values;
+    };
+
     struct Accessor {
         enum ComponentType {
             BYTE = 5120, UNSIGNED_BYTE = 5121, SHORT = 5122, UNSIGNED_SHORT = 5123, UNSIGNED_INT = 5125, FLOAT = 5126
@@ -186,7 +205,7 @@ namespace glTF {
         u32                         min_count;
         f32*                        min;
         bool                        normalized;
-        i32                         sparse;
+        AccessorSparse*             sparse;         // nullptr if the accessor is dense.
         Type                        type;
     };
 
@@ -252,11 +271,6 @@ namespace glTF {
         AnimationSampler*           samplers;
     };
 
-    struct AccessorSparseValues {
-        i32                         bufferView;
-        i32                         byteOffset;
-    };
-
     struct Scene {
         u32                         nodes_count;
         i32*                        nodes;
@@ -312,16 +326,41 @@ namespace glTF {
         Texture*                    textures;
 
         LinearAllocator             allocator;
+        FileMapping                 blob_mapping;   // Compiled blob the data points into, if loaded from it.
+        FileMapping                 file_mapping;   // .glb file, mapped until gltf_free.
+        u8*                         binary_chunk;   // Data of the buffer without uri in a .glb.
+        u32                         binary_chunk_size;
     };
 
     i32                             get_data_offset( i32 accessor_offset, i32 buffer_view_offset );
 
 } // namespace glTF
 
-    glTF::glTF                      gltf_load_file( cstring file_path );
+    // Loads .gltf and .glb files. A .glb stays mapped for its binary chunk.
+    // With a task scheduler the root arrays (nodes, accessors, meshes...) are parsed in parallel.
+    // Deprecated: use_compiled_blob keeps a blob next to the glTF file ("scene.gltf.blob", see gltf_blob.hpp),
+    // loaded if newer than the file and compiled otherwise. gltf_load_cached keeps it in the resource cache instead.
+    glTF::glTF                      gltf_load_file( cstring file_path, bool use_compiled_blob = false, enki::TaskScheduler* task_scheduler = nullptr );
+
+    // Loads the blob GltfBlobCompiler compiled in the cache of the resource manager, compiled first on a miss.
+    // The file is parsed if the manager has no cache or no GltfBlobCompiler, or if the blob does not load.
+    glTF::glTF                      gltf_load_cached( cstring file_path, ResourceManager& resource_manager, enki::TaskScheduler* task_scheduler = nullptr );
+
+    // Reference loader: builds the whole json document before converting it.
+    glTF::glTF                      gltf_load_file_dom( cstring file_path );
+
+    // Streaming parser (gltf_sax.cpp): a first pass over the text sizes the arena and every array,
+    // then the values are written straight into out_gltf. Returns false on malformed json.
+    // With a task scheduler, chunks of elements of the root arrays are parsed by tasks.
+    bool                            gltf_parse_sax( const char* text, sizet size, glTF::glTF& out_gltf, enki::TaskScheduler* task_scheduler = nullptr );
 
     void                            gltf_free( glTF::glTF& scene );
 
+    // Data of a buffer view or accessor inside the binary chunk of a .glb, used in place.
+    // Returns nullptr for buffers with an uri, that are loaded by the caller.
+    u8*                             gltf_get_buffer_view_data( const glTF::glTF& gltf, i32 buffer_view_index, u32* out_size );
+    u8*                             gltf_get_accessor_data( const glTF::glTF& gltf, i32 accessor_index );
+
     i32                             gltf_get_attribute_accessor_index( glTF::MeshPrimitive::Attribute* attributes, u32 attribute_count, cstring attribute_name );
 
 } // namespace syi
@@ -0,0 +1,459 @@
+#include "gltf_accessor.hpp"
+#include "foundation/log.hpp"
+
+#include "external/cglm/common.h"     // SSE2 and AVX detection, with the intrinsics headers.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif // __AVX2__
+
+#include <string.h>
+
+namespace syi {
+
+// AccessorView ///////////////////////////////////////////////////////////
+
+u32 gltf_component_count( glTF::Accessor::Type type ) {
+    static const u32 k_component_counts[] = { 1, 2, 3, 4, 4, 9, 16 };
+    return k_component_counts[ type ];
+}
+
+u32 gltf_component_size( i32 component_type ) {
+    switch ( component_type ) {
+        case glTF::Accessor::BYTE:
+        case glTF::Accessor::UNSIGNED_BYTE:
+            return 1;
+        case glTF::Accessor::SHORT:
+        case glTF::Accessor::UNSIGNED_SHORT:
+            return 2;
+        case glTF::Accessor::UNSIGNED_INT:
+        case glTF::Accessor::FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static bool valid_buffer_view( const glTF::glTF& gltf, i32 buffer_view_index ) {
+    return buffer_view_index >= 0 && buffer_view_index < ( i32 )gltf.buffer_views_count;
+}
+
+// Data at byte_offset inside a buffer view, from the caller buffers or from the .glb binary chunk.
+// Null if the size bytes from there are not all inside the view, and the view inside its buffer.
+static u8* buffer_view_data( const glTF::glTF& gltf, i32 buffer_view_index, i32 byte_offset, u64 size, u8* const* buffers_data ) {
+    const glTF::BufferView& buffer_view = gltf.buffer_views[ buffer_view_index ];
+    const i32 offset = byte_offset == glTF::INVALID_INT_VALUE ? 0 : byte_offset;
+    if ( offset < 0 || buffer_view.byte_length < 0 || ( u64 )offset + size > ( u64 )buffer_view.byte_length ) {
+        return nullptr;
+    }
+
+    if ( buffer_view.buffer < 0 || buffer_view.buffer >= ( i32 )gltf.buffers_count ) {
+        return nullptr;
+    }
+
+    u8* buffer_data = buffers_data ? buffers_data[ buffer_view.buffer ] : nullptr;
+    if ( buffer_data ) {
+        const i32 view_offset = glTF::get_data_offset( glTF::INVALID_INT_VALUE, buffer_view.byte_offset );
+        const glTF::Buffer& buffer = gltf.buffers[ buffer_view.buffer ];
+        if ( view_offset < 0 || ( u64 )view_offset + ( u64 )buffer_view.byte_length > ( u64 )buffer.byte_length ) {
+            return nullptr;
+        }
+        return buffer_data + view_offset + offset;
+    }
+
+    u32 view_size = 0;
+    u8* data = gltf_get_buffer_view_data( gltf, buffer_view_index, &view_size );
+    return data ? data + offset : nullptr;
+}
+
+static f32 read_component( const u8* source, i32 component_type, bool normalized ) {
+    switch ( component_type ) {
+        case glTF::Accessor::FLOAT:
+        {
+            f32 value;
+            memcpy( &value, source, sizeof( f32 ) );
+            return value;
+        }
+        case glTF::Accessor::UNSIGNED_BYTE:
+            return normalized ? *source * ( 1.0f / 255.0f ) : ( f32 )*source;
+        case glTF::Accessor::BYTE:
+        {
+            const f32 value = ( f32 )*( const i8* )source;
+            return normalized ? ( value / 127.0f < -1.0f ? -1.0f : value / 127.0f ) : value;
+        }
+        case glTF::Accessor::UNSIGNED_SHORT:
+        {
+            u16 value;
+            memcpy( &value, source, sizeof( u16 ) );
+            return normalized ? value * ( 1.0f / 65535.0f ) : ( f32 )value;
+        }
+        case glTF::Accessor::SHORT:
+        {
+            i16 value;
+            memcpy( &value, source, sizeof( i16 ) );
+            return normalized ? ( value / 32767.0f < -1.0f ? -1.0f : value / 32767.0f ) : ( f32 )value;
+        }
+        case glTF::Accessor::UNSIGNED_INT:
+        {
+            u32 value;
+            memcpy( &value, source, sizeof( u32 ) );
+            return ( f32 )value;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+static u32 read_unsigned( const u8* source, i32 component_type ) {
+    switch ( component_type ) {
+        case glTF::Accessor::UNSIGNED_BYTE:
+            return *source;
+        case glTF::Accessor::UNSIGNED_SHORT:
+        {
+            u16 value;
+            memcpy( &value, source, sizeof( u16 ) );
+            return value;
+        }
+        case glTF::Accessor::UNSIGNED_INT:
+        {
+            u32 value;
+            memcpy( &value, source, sizeof( u32 ) );
+            return value;
+        }
+        default:
+            RASSERTM( false, "Index accessors must be unsigned" );
+            return 0;
+    }
+}
+
+bool AccessorView::init( const glTF::glTF& gltf, i32 accessor_index, u8* const* buffers_data ) {
+    *this = AccessorView{ };
+
+    if ( accessor_index < 0 || accessor_index >= ( i32 )gltf.accessors_count ) {
+        return false;
+    }
+
+    const glTF::Accessor& accessor = gltf.accessors[ accessor_index ];
+
+    count = accessor.count == glTF::INVALID_INT_VALUE ? 0 : accessor.count;
+    component_type = accessor.component_type;
+    component_size = gltf_component_size( accessor.component_type );
+    component_count = gltf_component_count( accessor.type );
+    element_size = component_size * component_count;
+    stride = element_size;
+    normalized = accessor.normalized;
+
+    if ( component_size == 0 || accessor.count < 0 ) {
+        return false;
+    }
+
+    const glTF::AccessorSparse* sparse = accessor.sparse;
+    if ( sparse && sparse->count > 0 ) {
+        if ( !valid_buffer_view( gltf, sparse->indices.buffer_view ) || !valid_buffer_view( gltf, sparse->values.buffer_view ) ) {
+            return false;
+        }
+
+        sparse_count = sparse->count;
+        sparse_index_type = sparse->indices.component_type;
+        const u32 sparse_index_size = gltf_component_size( sparse_index_type );
+        sparse_indices = buffer_view_data( gltf, sparse->indices.buffer_view, sparse->indices.byte_offset, ( u64 )sparse_index_size * sparse_count, buffers_data );
+        sparse_values = buffer_view_data( gltf, sparse->values.buffer_view, sparse->values.byte_offset, ( u64 )element_size * sparse_count, buffers_data );
+        if ( sparse_index_size == 0 || sparse_indices == nullptr || sparse_values == nullptr ) {
+            rprint( "Error: sparse data of accessor %d is outside its buffer views.\n", accessor_index );
+            return false;
+        }
+    }
+
+    // Accessors without a buffer view are all zeros, or only sparse.
+    if ( !valid_buffer_view( gltf, accessor.buffer_view ) ) {
+        return sparse != nullptr;
+    }
+
+    const glTF::BufferView& buffer_view = gltf.buffer_views[ accessor.buffer_view ];
+    if ( buffer_view.byte_stride != glTF::INVALID_INT_VALUE && buffer_view.byte_stride != 0 ) {
+        stride = buffer_view.byte_stride;
+    }
+
+    // The last element ends element_size bytes after its start, not stride.
+    const u64 byte_size = count ? ( u64 )stride * ( count - 1 ) + element_size : 0;
+    data = buffer_view_data( gltf, accessor.buffer_view, accessor.byte_offset, byte_size, buffers_data );
+    if ( data == nullptr ) {
+        rprint( "Error: accessor %d is outside its buffer view.\n", accessor_index );
+        return false;
+    }
+
+    return true;
+}
+
+f32 AccessorView::read_float( u32 element, u32 component ) const {
+    RASSERT( element < count && component < component_count && data );
+    return read_component( data + ( sizet )stride * element + component_size * component, component_type, normalized );
+}
+
+u32 AccessorView::read_index( u32 element ) const {
+    RASSERT( element < count && data );
+    return read_unsigned( data + ( sizet )stride * element, component_type );
+}
+
+u32 AccessorView::read_sparse_index( u32 i ) const {
+    RASSERT( i < sparse_count );
+    return read_unsigned( sparse_indices + gltf_component_size( sparse_index_type ) * i, sparse_index_type );
+}
+
+f32 AccessorView::read_sparse_float( u32 i, u32 component ) const {
+    RASSERT( i < sparse_count && component < component_count );
+    return read_component( sparse_values + ( sizet )element_size * i + component_size * component, component_type, normalized );
+}
+
+void AccessorView::read_floats( f32* destination ) const {
+    read_dense_floats( destination );
+
+    for ( u32 i = 0; i < sparse_count; ++i ) {
+        const u32 element = read_sparse_index( i );
+        RASSERT( element < count );
+        for ( u32 c = 0; c < component_count; ++c ) {
+            destination[ ( sizet )element * component_count + c ] = read_sparse_float( i, c );
+        }
+    }
+}
+
+void AccessorView::read_dense_floats( f32* destination ) const {
+    const u32 total_components = count * component_count;
+
+    if ( data == nullptr ) {
+        memset( destination, 0, ( sizet )total_components * sizeof( f32 ) );
+        return;
+    }
+
+    if ( component_type == glTF::Accessor::FLOAT ) {
+        if ( is_packed() ) {
+            memcpy( destination, data, ( sizet )total_components * sizeof( f32 ) );
+        } else {
+            deinterleave( data, stride, ( u8* )destination, element_size, count );
+        }
+        return;
+    }
+
+    if ( normalized && ( component_type == glTF::Accessor::UNSIGNED_BYTE || component_type == glTF::Accessor::UNSIGNED_SHORT ) ) {
+        const bool is_byte = component_type == glTF::Accessor::UNSIGNED_BYTE;
+        // Packed data is converted in one go, interleaved one element at a time.
+        const u32 run_count = is_packed() ? 1 : count;
+        const u32 run_components = is_packed() ? total_components : component_count;
+
+        for ( u32 r = 0; r < run_count; ++r ) {
+            const u8* source = data + ( sizet )stride * r;
+            f32* run_destination = destination + ( sizet )run_components * r;
+            if ( is_byte ) {
+                convert_unorm8_to_f32( source, run_destination, run_components );
+            } else {
+                convert_unorm16_to_f32( ( const u16* )source, run_destination, run_components );
+            }
+        }
+        return;
+    }
+
+    for ( u32 e = 0; e < count; ++e ) {
+        for ( u32 c = 0; c < component_count; ++c ) {
+            *destination++ = read_float( e, c );
+        }
+    }
+}
+
+void AccessorView::read_indices( u32* destination ) const {
+    read_dense_indices( destination );
+
+    for ( u32 i = 0; i < sparse_count; ++i ) {
+        const u32 element = read_sparse_index( i );
+        RASSERT( element < count );
+        destination[ element ] = read_unsigned( sparse_values + ( sizet )element_size * i, component_type );
+    }
+}
+
+void AccessorView::read_dense_indices( u32* destination ) const {
+    RASSERT( component_count == 1 );
+
+    if ( data == nullptr ) {
+        memset( destination, 0, ( sizet )count * sizeof( u32 ) );
+        return;
+    }
+
+    if ( is_packed() ) {
+        switch ( component_type ) {
+            case glTF::Accessor::UNSIGNED_BYTE:
+                convert_u8_to_u32( data, destination, count );
+                return;
+            case glTF::Accessor::UNSIGNED_SHORT:
+                convert_u16_to_u32( ( const u16* )data, destination, count );
+                return;
+            case glTF::Accessor::UNSIGNED_INT:
+                memcpy( destination, data, ( sizet )count * sizeof( u32 ) );
+                return;
+            default:
+                break;
+        }
+    }
+
+    for ( u32 e = 0; e < count; ++e ) {
+        destination[ e ] = read_index( e );
+    }
+}
+
+// Conversion kernels /////////////////////////////////////////////////////
+
+void convert_unorm8_to_f32( const u8* source, f32* destination, u32 count ) {
+    const f32 k_scale = 1.0f / 255.0f;
+    u32 i = 0;
+
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps( k_scale );
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m256i integers = _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( source + i ) ) );
+        _mm256_storeu_ps( destination + i, _mm256_mul_ps( _mm256_cvtepi32_ps( integers ), scale ) );
+    }
+#elif defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps( k_scale );
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 16 <= count; i += 16 ) {
+        const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+        const __m128i low = _mm_unpacklo_epi8( bytes, zero );
+        const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+        _mm_storeu_ps( destination + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( low, zero ) ), scale ) );
+        _mm_storeu_ps( destination + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( low, zero ) ), scale ) );
+        _mm_storeu_ps( destination + i + 8, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( high, zero ) ), scale ) );
+        _mm_storeu_ps( destination + i + 12, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( high, zero ) ), scale ) );
+    }
+#endif // __AVX2__
+
+    for ( ; i < count; ++i ) {
+        destination[ i ] = source[ i ] * k_scale;
+    }
+}
+
+void convert_unorm16_to_f32( const u16* source, f32* destination, u32 count ) {
+    const f32 k_scale = 1.0f / 65535.0f;
+    u32 i = 0;
+
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps( k_scale );
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m256i integers = _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i* )( source + i ) ) );
+        _mm256_storeu_ps( destination + i, _mm256_mul_ps( _mm256_cvtepi32_ps( integers ), scale ) );
+    }
+#elif defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps( k_scale );
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m128i shorts = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+        _mm_storeu_ps( destination + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( shorts, zero ) ), scale ) );
+        _mm_storeu_ps( destination + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( shorts, zero ) ), scale ) );
+    }
+#endif // __AVX2__
+
+    for ( ; i < count; ++i ) {
+        u16 value;
+        memcpy( &value, source + i, sizeof( u16 ) );
+        destination[ i ] = value * k_scale;
+    }
+}
+
+void convert_u8_to_u32( const u8* source, u32* destination, u32 count ) {
+    u32 i = 0;
+
+#if defined(__AVX2__)
+    for ( ; i + 8 <= count; i += 8 ) {
+        _mm256_storeu_si256( ( __m256i* )( destination + i ), _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( source + i ) ) ) );
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 16 <= count; i += 16 ) {
+        const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+        const __m128i low = _mm_unpacklo_epi8( bytes, zero );
+        const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+        _mm_storeu_si128( ( __m128i* )( destination + i ), _mm_unpacklo_epi16( low, zero ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i + 4 ), _mm_unpackhi_epi16( low, zero ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i + 8 ), _mm_unpacklo_epi16( high, zero ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i + 12 ), _mm_unpackhi_epi16( high, zero ) );
+    }
+#endif // __AVX2__
+
+    for ( ; i < count; ++i ) {
+        destination[ i ] = source[ i ];
+    }
+}
+
+void convert_u16_to_u32( const u16* source, u32* destination, u32 count ) {
+    u32 i = 0;
+
+#if defined(__AVX2__)
+    for ( ; i + 8 <= count; i += 8 ) {
+        _mm256_storeu_si256( ( __m256i* )( destination + i ), _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i* )( source + i ) ) ) );
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m128i shorts = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i ), _mm_unpacklo_epi16( shorts, zero ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i + 4 ), _mm_unpackhi_epi16( shorts, zero ) );
+    }
+#endif // __AVX2__
+
+    for ( ; i < count; ++i ) {
+        u16 value;
+        memcpy( &value, source + i, sizeof( u16 ) );
+        destination[ i ] = value;
+    }
+}
+
+// Fixed element sizes let the compiler turn the copy into a few moves.
+template <u32 ElementSize>
+static void copy_strided( const u8* source, u32 source_stride, u8* destination, u32 destination_stride, u32 count ) {
+    for ( u32 i = 0; i < count; ++i ) {
+        memcpy( destination, source, ElementSize );
+        source += source_stride;
+        destination += destination_stride;
+    }
+}
+
+static void copy_strided( const u8* source, u32 source_stride, u8* destination, u32 destination_stride, u32 element_size, u32 count ) {
+    switch ( element_size ) {
+        case 4:     copy_strided<4>( source, source_stride, destination, destination_stride, count ); break;
+        case 8:     copy_strided<8>( source, source_stride, destination, destination_stride, count ); break;
+        case 12:    copy_strided<12>( source, source_stride, destination, destination_stride, count ); break;
+        case 16:
+        {
+#if defined(__SSE2__)
+            for ( u32 i = 0; i < count; ++i ) {
+                _mm_storeu_si128( ( __m128i* )( destination + ( sizet )destination_stride * i ), _mm_loadu_si128( ( const __m128i* )( source + ( sizet )source_stride * i ) ) );
+            }
+#else
+            copy_strided<16>( source, source_stride, destination, destination_stride, count );
+#endif // __SSE2__
+            break;
+        }
+        default:
+        {
+            for ( u32 i = 0; i < count; ++i ) {
+                memcpy( destination + ( sizet )destination_stride * i, source + ( sizet )source_stride * i, element_size );
+            }
+            break;
+        }
+    }
+}
+
+void deinterleave( const u8* source, u32 source_stride, u8* destination, u32 element_size, u32 count ) {
+    if ( source_stride == element_size ) {
+        memcpy( destination, source, ( sizet )element_size * count );
+        return;
+    }
+    copy_strided( source, source_stride, destination, element_size, element_size, count );
+}
+
+void interleave( const u8* source, u8* destination, u32 destination_stride, u32 element_size, u32 count ) {
+    if ( destination_stride == element_size ) {
+        memcpy( destination, source, ( sizet )element_size * count );
+        return;
+    }
+    copy_strided( source, element_size, destination, destination_stride, element_size, count );
+}
+
+} // namespace syi
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+#include "foundation/assert.hpp"
+
+namespace syi {
+
+    // StridedRange ///////////////////////////////////////////////////////
+    //
+    // Elements of type T that are stride bytes apart, like an attribute of interleaved vertices.
+    template <typename T>
+    struct StridedIterator {
+
+        T&                          operator*() const                               { return *( T* )pointer; }
+        StridedIterator&            operator++()                                    { pointer += stride; return *this; }
+        bool                        operator!=( const StridedIterator& other ) const { return pointer != other.pointer; }
+
+        u8*                         pointer;
+        u32                         stride;
+
+    }; // struct StridedIterator
+
+    template <typename T>
+    struct StridedRange {
+
+        StridedIterator<T>          begin() const                   { return { data, stride }; }
+        StridedIterator<T>          end() const                     { return { data + ( sizet )stride * count, stride }; }
+
+        T&                          operator[]( u32 index ) const   { return *( T* )( data + ( sizet )stride * index ); }
+
+        u8*                         data;
+        u32                         stride;
+        u32                         count;
+
+    }; // struct StridedRange
+
+    // AccessorView ///////////////////////////////////////////////////////
+    //
+    // Typed view of the data of an accessor. The data is used in place: inside the
+    // binary chunk of a .glb, or inside buffers loaded by the caller.
+    // Sparse substitution is applied by the bulk reads; as, read_float and read_index see the dense data only.
+    // A sparse accessor without buffer view has a null data, its dense elements are zeros.
+    //
+    // Usage:
+    //   AccessorView positions;
+    //   positions.init( gltf, position_accessor_index, buffers_data );
+    //   for ( vec3s& position : positions.as<vec3s>() ) { ... }
+    struct AccessorView {
+
+        // buffers_data holds the memory of each glTF buffer, entries can be null for the binary chunk of a .glb.
+        bool                        init( const glTF::glTF& gltf, i32 accessor_index, u8* const* buffers_data = nullptr );
+
+        template <typename T>
+        StridedRange<T>             as() const;
+
+        // Normalized components are converted to [0, 1] or [-1, 1], as in the glTF specification.
+        f32                         read_float( u32 element, u32 component ) const;
+        u32                         read_index( u32 element ) const;
+
+        // Bulk conversions to packed engine formats: count * component_count floats, or count indices.
+        void                        read_floats( f32* destination ) const;
+        void                        read_indices( u32* destination ) const;
+
+        // Sparse elements, i < sparse_count: index of the replaced element and its value.
+        u32                         read_sparse_index( u32 i ) const;
+        f32                         read_sparse_float( u32 i, u32 component ) const;
+
+        bool                        is_packed() const               { return stride == element_size; }
+        bool                        is_sparse() const               { return sparse_count != 0; }
+
+        void                        read_dense_floats( f32* destination ) const;
+        void                        read_dense_indices( u32* destination ) const;
+
+        u8*                         data            = nullptr;
+        u32                         count           = 0;
+        u32                         stride          = 0;    // Bytes between two elements.
+        u32                         element_size    = 0;
+        u32                         component_count = 0;
+        u32                         component_size  = 0;
+        i32                         component_type  = 0;    // glTF::Accessor::ComponentType
+        bool                        normalized      = false;
+
+        u32                         sparse_count    = 0;
+        i32                         sparse_index_type = 0;  // UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT.
+        u8*                         sparse_indices  = nullptr;  // Increasing element indices.
+        u8*                         sparse_values   = nullptr;  // Packed elements.
+
+    }; // struct AccessorView
+
+    u32                             gltf_component_count( glTF::Accessor::Type type );
+    u32                             gltf_component_size( i32 component_type );
+
+    // Conversion kernels /////////////////////////////////////////////////
+    //
+    // AVX2 or SSE2 when the compiler targets them, scalar otherwise. No alignment required.
+    void                            convert_unorm8_to_f32( const u8* source, f32* destination, u32 count );
+    void                            convert_unorm16_to_f32( const u16* source, f32* destination, u32 count );
+    void                            convert_u8_to_u32( const u8* source, u32* destination, u32 count );
+    void                            convert_u16_to_u32( const u16* source, u32* destination, u32 count );
+
+    // Interleaved to planar: count elements of element_size bytes, source_stride apart, packed into destination.
+    void                            deinterleave( const u8* source, u32 source_stride, u8* destination, u32 element_size, u32 count );
+    // Planar to interleaved: count packed elements of element_size bytes, written destination_stride apart.
+    void                            interleave( const u8* source, u8* destination, u32 destination_stride, u32 element_size, u32 count );
+
+    // Implementation /////////////////////////////////////////////////////
+
+    template <typename T>
+    inline StridedRange<T> AccessorView::as() const {
+        RASSERT( sizeof( T ) <= stride || count <= 1 );
+        return { data, stride, count };
+    }
+
+} // namespace syi
@@ -0,0 +1,616 @@
+#include "gltf_animation.hpp"
+#include "gltf_accessor.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/log.hpp"
+#include "foundation/numerics.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/affine.h"
+#include "external/cglm/mat4.h"     // With SSE2 detection and the intrinsics headers.
+
+#include <math.h>
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_animation_lanes = 4;                     // Tracks sampled together.
+static const u32 k_animation_instances_per_task = 8;
+
+// Tracks of the same kind are sampled together: weights, rotations, then interpolation.
+static u32 animation_track_kind( const AnimationTrack& track ) {
+    return ( track.target_type == glTF::AnimationChannel::Weights ? 8 : 0 ) |
+           ( track.target_type == glTF::AnimationChannel::Rotation ? 4 : 0 ) | track.interpolation;
+}
+static const u32 k_animation_track_kinds = 16;
+
+// AnimationClip //////////////////////////////////////////////////////////
+
+// Morph weights of a node: both weights arrays are optional, the targets of the mesh are not.
+static u32 animation_node_weights_count( const glTF::glTF& gltf, const glTF::Node& node ) {
+    if ( node.weights_count ) {
+        return node.weights_count;
+    }
+    if ( node.mesh < 0 || node.mesh >= ( i32 )gltf.meshes_count ) {
+        return 0;
+    }
+
+    const glTF::Mesh& mesh = gltf.meshes[ node.mesh ];
+    if ( mesh.weights_count ) {
+        return mesh.weights_count;
+    }
+    u32 targets_count = 0;
+    for ( u32 p = 0; p < mesh.primitives_count; ++p ) {
+        targets_count = max( targets_count, mesh.primitives[ p ].targets_count );
+    }
+    return targets_count;
+}
+
+bool AnimationClip::init( const glTF::glTF& gltf, u32 animation_index, u8* const* buffers_data, Allocator* allocator_ ) {
+    *this = AnimationClip{ };
+    allocator = allocator_;
+
+    if ( animation_index >= gltf.animations_count ) {
+        return false;
+    }
+
+    const glTF::Animation& animation = gltf.animations[ animation_index ];
+    const u32 channels_count = animation.channels_count;
+
+    // Views of the input and output of each channel, and where the times of each input accessor go.
+    AccessorView* views = ( AccessorView* )allocator->allocate( sizeof( AccessorView ) * 2 * channels_count + 1, 64 );
+    u32* input_times = ( u32* )allocator->allocate( sizeof( u32 ) * gltf.accessors_count + 1, 64 );
+    memset( input_times, 0xff, sizeof( u32 ) * gltf.accessors_count );
+
+    u32 times_count = 0;
+    u32 values_count = 0;
+    for ( u32 c = 0; c < channels_count; ++c ) {
+        const glTF::AnimationChannel& channel = animation.channels[ c ];
+        AccessorView& input = views[ c * 2 ];
+        AccessorView& output = views[ c * 2 + 1 ];
+        input = AccessorView{ };
+
+        if ( channel.target_node < 0 || channel.target_node >= ( i32 )gltf.nodes_count ||
+             channel.sampler < 0 || channel.sampler >= ( i32 )animation.samplers_count ) {
+            // Targets defined by extensions.
+            continue;
+        }
+
+        const glTF::AnimationSampler& sampler = animation.samplers[ channel.sampler ];
+        if ( !input.init( gltf, sampler.input_keyframe_buffer_index, buffers_data ) || !output.init( gltf, sampler.output_keyframe_buffer_index, buffers_data ) ||
+             input.component_count != 1 || input.count == 0 ) {
+            rprint( "Animation %u: cannot read the keyframes of channel %u\n", animation_index, c );
+            input.count = 0;
+            continue;
+        }
+
+        if ( input_times[ sampler.input_keyframe_buffer_index ] == u32_max ) {
+            input_times[ sampler.input_keyframe_buffer_index ] = u32_max - 1;
+            times_count += input.count;
+        }
+        values_count += output.count * output.component_count;
+    }
+
+    sizet size = memory_align( sizeof( AnimationTrack ) * channels_count, 64 ) + memory_align( sizeof( f32 ) * times_count, 64 ) + sizeof( f32 ) * values_count;
+    u8* memory = ( u8* )allocator->allocate( size + 1, 64 );
+    RASSERT( memory );
+    tracks = ( AnimationTrack* )memory;
+    times = ( f32* )( memory + memory_align( sizeof( AnimationTrack ) * channels_count, 64 ) );
+    values = times + memory_align( sizeof( f32 ) * times_count, 64 ) / sizeof( f32 );
+
+    // Tracks in channel order, then sorted by kind.
+    AnimationTrack* unsorted = ( AnimationTrack* )allocator->allocate( sizeof( AnimationTrack ) * channels_count + 1, 64 );
+    u32 kind_counts[ k_animation_track_kinds ] = { };
+
+    u32 times_offset = 0;
+    u32 values_offset = 0;
+    for ( u32 c = 0; c < channels_count; ++c ) {
+        const AccessorView& input = views[ c * 2 ];
+        const AccessorView& output = views[ c * 2 + 1 ];
+        if ( input.count == 0 ) {
+            continue;
+        }
+
+        const glTF::AnimationChannel& channel = animation.channels[ c ];
+        const glTF::AnimationSampler& sampler = animation.samplers[ channel.sampler ];
+        const u32 elements_per_key = sampler.interpolation == glTF::AnimationSampler::CubicSpline ? 3 : 1;
+
+        AnimationTrack& track = unsorted[ tracks_count ];
+        track.key_count = input.count;
+        track.target_node = channel.target_node;
+        track.target_type = ( u8 )channel.target_type;
+        track.interpolation = ( u8 )sampler.interpolation;
+        track.component_count = ( u16 )( output.count * output.component_count / ( input.count * elements_per_key ) );
+
+        // Weights must fill the weights of the pose node exactly, and need a mesh to morph.
+        const glTF::Node& target = gltf.nodes[ track.target_node ];
+        if ( track.target_type == glTF::AnimationChannel::Weights ) {
+            const bool has_mesh = target.mesh >= 0 && target.mesh < ( i32 )gltf.meshes_count;
+            const u32 node_weights_count = animation_node_weights_count( gltf, target );
+            if ( !has_mesh || track.component_count == 0 || track.component_count != node_weights_count ) {
+                rprint( "Animation %u: channel %u animates %u weights of node %u, which has %s mesh and %u weights\n", animation_index, c,
+                        track.component_count, track.target_node, has_mesh ? "a" : "no", node_weights_count );
+                continue;
+            }
+        }
+        const bool valid = track.target_type == glTF::AnimationChannel::Weights ||
+                           track.component_count == ( track.target_type == glTF::AnimationChannel::Rotation ? 4 : 3 );
+        if ( !valid || output.count * output.component_count != ( u32 )track.component_count * input.count * elements_per_key ) {
+            rprint( "Animation %u: channel %u has %u outputs for %u keyframes\n", animation_index, c, output.count, input.count );
+            continue;
+        }
+
+        u32& input_offset = input_times[ sampler.input_keyframe_buffer_index ];
+        if ( input_offset == u32_max - 1 ) {
+            input_offset = times_offset;
+            input.read_floats( times + times_offset );
+            times_offset += input.count;
+        }
+        track.times_offset = input_offset;
+        duration = max( duration, times[ track.times_offset + track.key_count - 1 ] );
+
+        track.values_offset = values_offset;
+        output.read_floats( values + values_offset );
+        values_offset += output.count * output.component_count;
+
+        ++kind_counts[ animation_track_kind( track ) ];
+        ++tracks_count;
+    }
+
+    u32 kind_offsets[ k_animation_track_kinds ];
+    u32 offset = 0;
+    for ( u32 k = 0; k < k_animation_track_kinds; ++k ) {
+        kind_offsets[ k ] = offset;
+        offset += kind_counts[ k ];
+    }
+    for ( u32 t = 0; t < tracks_count; ++t ) {
+        tracks[ kind_offsets[ animation_track_kind( unsorted[ t ] ) ]++ ] = unsorted[ t ];
+    }
+
+    allocator->deallocate( unsorted );
+    allocator->deallocate( input_times );
+    allocator->deallocate( views );
+
+    return true;
+}
+
+void AnimationClip::shutdown() {
+    if ( tracks ) {
+        allocator->deallocate( tracks );
+    }
+
+    tracks = nullptr;
+    tracks_count = 0;
+}
+
+// AnimationPose //////////////////////////////////////////////////////////
+
+void AnimationPose::init( const glTF::glTF& gltf, Allocator* allocator_ ) {
+    allocator = allocator_;
+    nodes_count = gltf.nodes_count;
+
+    u32 weights_count = 0;
+    for ( u32 n = 0; n < nodes_count; ++n ) {
+        weights_count += animation_node_weights_count( gltf, gltf.nodes[ n ] );
+    }
+
+    const sizet transforms_size = ( sizeof( vec3s ) * 2 + sizeof( versors ) + sizeof( u32 ) ) * nodes_count;
+    u8* memory = ( u8* )allocator->allocate( transforms_size + sizeof( f32 ) * weights_count + 16, 16 );
+    RASSERT( memory );
+    rotations = ( versors* )memory;
+    translations = ( vec3s* )( rotations + nodes_count );
+    scales = translations + nodes_count;
+    weights_offsets = ( u32* )( scales + nodes_count );
+    weights = ( f32* )( weights_offsets + nodes_count );
+    memset( weights, 0, sizeof( f32 ) * weights_count );
+
+    u32 weights_offset = 0;
+    for ( u32 n = 0; n < nodes_count; ++n ) {
+        const glTF::Node& node = gltf.nodes[ n ];
+
+        translations[ n ] = vec3s{ { 0.0f, 0.0f, 0.0f } };
+        rotations[ n ] = versors{ { 0.0f, 0.0f, 0.0f, 1.0f } };
+        scales[ n ] = vec3s{ { 1.0f, 1.0f, 1.0f } };
+
+        if ( node.matrix_count == 16 ) {
+            mat4 matrix, rotation;
+            vec4 translation;
+            memcpy( matrix, node.matrix, sizeof( mat4 ) );
+            glm_decompose( matrix, translation, rotation, scales[ n ].raw );
+            glm_mat4_quat( rotation, rotations[ n ].raw );
+            memcpy( translations[ n ].raw, translation, sizeof( vec3 ) );
+        }
+        if ( node.translation_count == 3 ) {
+            memcpy( translations[ n ].raw, node.translation, sizeof( vec3 ) );
+        }
+        if ( node.rotation_count == 4 ) {
+            memcpy( rotations[ n ].raw, node.rotation, sizeof( versor ) );
+        }
+        if ( node.scale_count == 3 ) {
+            memcpy( scales[ n ].raw, node.scale, sizeof( vec3 ) );
+        }
+
+        // Default weights from the node, else from the mesh, else 0.
+        weights_offsets[ n ] = weights_offset;
+        if ( node.weights_count ) {
+            memcpy( weights + weights_offset, node.weights, sizeof( f32 ) * node.weights_count );
+        } else if ( node.mesh >= 0 && node.mesh < ( i32 )gltf.meshes_count ) {
+            const glTF::Mesh& mesh = gltf.meshes[ node.mesh ];
+            memcpy( weights + weights_offset, mesh.weights, sizeof( f32 ) * mesh.weights_count );
+        }
+        weights_offset += animation_node_weights_count( gltf, node );
+    }
+}
+
+void AnimationPose::shutdown() {
+    if ( rotations ) {
+        allocator->deallocate( rotations );
+    }
+
+    rotations = nullptr;
+    nodes_count = 0;
+}
+
+// AnimationInstance //////////////////////////////////////////////////////
+
+void AnimationInstance::init( const AnimationClip* clip_, AnimationPose* pose_, Allocator* allocator_ ) {
+    clip = clip_;
+    pose = pose_;
+    allocator = allocator_;
+    time = 0.0f;
+
+    cursors = ( u32* )allocator->allocate( sizeof( u32 ) * clip->tracks_count + 1, 4 );
+    memset( cursors, 0, sizeof( u32 ) * clip->tracks_count );
+}
+
+void AnimationInstance::shutdown() {
+    if ( cursors ) {
+        allocator->deallocate( cursors );
+    }
+
+    cursors = nullptr;
+}
+
+// Keyframe key with times[ key ] <= time < times[ key + 1 ], clamped to the first and last segments.
+// Tries the cached key and the next one before searching.
+static u32 animation_find_key( const f32* times, u32 key_count, f32 time, u32& cursor ) {
+    if ( key_count < 2 ) {
+        return 0;
+    }
+
+    const u32 last_segment = key_count - 2;
+    u32 key = cursor;
+    if ( key <= last_segment && times[ key ] <= time ) {
+        if ( time < times[ key + 1 ] || key == last_segment ) {
+            return key;
+        }
+        if ( time < times[ key + 2 ] || key + 1 == last_segment ) {
+            cursor = key + 1;
+            return key + 1;
+        }
+    }
+
+    // Last key not greater than time.
+    u32 first = 0;
+    u32 count = key_count;
+    while ( count > 0 ) {
+        const u32 half = count / 2;
+        if ( times[ first + half ] <= time ) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    key = first == 0 ? 0 : min( first - 1, last_segment );
+    cursor = key;
+    return key;
+}
+
+//
+// Keyframes of up to four tracks, component major: one lane per track.
+struct alignas( 16 ) AnimationLanes {
+    f32                             a[ 4 ][ k_animation_lanes ];        // Value at the key.
+    f32                             b[ 4 ][ k_animation_lanes ];        // Value at the next key.
+    f32                             out_a[ 4 ][ k_animation_lanes ];    // Cubic spline tangents, scaled by the key duration.
+    f32                             in_b[ 4 ][ k_animation_lanes ];
+    f32                             t[ k_animation_lanes ];             // Position between the keys, [0, 1].
+    f32                             result[ 4 ][ k_animation_lanes ];
+}; // struct AnimationLanes
+
+static void animation_gather( const AnimationClip& clip, u32* cursors, u32 track_index, u32 lane, f32 time, AnimationLanes& lanes ) {
+    const AnimationTrack& track = clip.tracks[ track_index ];
+    const f32* times = clip.times + track.times_offset;
+    const f32* values = clip.values + track.values_offset;
+    const u32 component_count = track.component_count;
+    const bool cubic = track.interpolation == glTF::AnimationSampler::CubicSpline;
+
+    const u32 key = animation_find_key( times, track.key_count, time, cursors[ track_index ] );
+    const u32 next_key = min( key + 1, track.key_count - 1 );
+    const f32 key_duration = times[ next_key ] - times[ key ];
+    f32 t = key_duration > 0.0f ? ( time - times[ key ] ) / key_duration : 0.0f;
+    t = clamp( t, 0.0f, 1.0f );
+
+    // Cubic splines store in tangent, value and out tangent for each key.
+    const u32 stride = cubic ? component_count * 3 : component_count;
+    const f32* value_a = values + stride * key + ( cubic ? component_count : 0 );
+    const f32* value_b = values + stride * next_key + ( cubic ? component_count : 0 );
+
+    if ( track.interpolation == glTF::AnimationSampler::Step ) {
+        value_a = t >= 1.0f ? value_b : value_a;
+        value_b = value_a;
+        t = 0.0f;
+    }
+
+    lanes.t[ lane ] = t;
+    for ( u32 c = 0; c < 4; ++c ) {
+        lanes.a[ c ][ lane ] = c < component_count ? value_a[ c ] : 0.0f;
+        lanes.b[ c ][ lane ] = c < component_count ? value_b[ c ] : 0.0f;
+    }
+
+    if ( cubic ) {
+        const f32* out_tangent = values + stride * key + component_count * 2;
+        const f32* in_tangent = values + stride * next_key;
+        for ( u32 c = 0; c < 4; ++c ) {
+            lanes.out_a[ c ][ lane ] = c < component_count ? out_tangent[ c ] * key_duration : 0.0f;
+            lanes.in_b[ c ][ lane ] = c < component_count ? in_tangent[ c ] * key_duration : 0.0f;
+        }
+    }
+}
+
+static void animation_copy_lane( AnimationLanes& lanes, u32 source, u32 destination ) {
+    lanes.t[ destination ] = lanes.t[ source ];
+    for ( u32 c = 0; c < 4; ++c ) {
+        lanes.a[ c ][ destination ] = lanes.a[ c ][ source ];
+        lanes.b[ c ][ destination ] = lanes.b[ c ][ source ];
+        lanes.out_a[ c ][ destination ] = lanes.out_a[ c ][ source ];
+        lanes.in_b[ c ][ destination ] = lanes.in_b[ c ][ source ];
+    }
+}
+
+// Slerp is approximated by a normalized lerp with a corrected t: the correction is a polynomial in
+// the cosine of the angle between the quaternions, no trigonometry, components within 1e-3 of slerp.
+#if defined(__SSE2__)
+
+static void animation_interpolate( AnimationLanes& lanes, u32 interpolation, bool rotation ) {
+    const __m128 t = _mm_load_ps( lanes.t );
+    __m128 a[ 4 ], b[ 4 ];
+    for ( u32 c = 0; c < 4; ++c ) {
+        a[ c ] = _mm_load_ps( lanes.a[ c ] );
+        b[ c ] = _mm_load_ps( lanes.b[ c ] );
+    }
+
+    __m128 result[ 4 ];
+    if ( interpolation == glTF::AnimationSampler::CubicSpline ) {
+        // Hermite basis.
+        const __m128 t2 = _mm_mul_ps( t, t );
+        const __m128 t3 = _mm_mul_ps( t2, t );
+        const __m128 two = _mm_set1_ps( 2.0f ), three = _mm_set1_ps( 3.0f );
+        const __m128 h01 = _mm_sub_ps( _mm_mul_ps( three, t2 ), _mm_mul_ps( two, t3 ) );
+        const __m128 h00 = _mm_sub_ps( _mm_set1_ps( 1.0f ), h01 );
+        const __m128 h10 = _mm_add_ps( _mm_sub_ps( t3, _mm_mul_ps( two, t2 ) ), t );
+        const __m128 h11 = _mm_sub_ps( t3, t2 );
+        for ( u32 c = 0; c < 4; ++c ) {
+            result[ c ] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( h00, a[ c ] ), _mm_mul_ps( h10, _mm_load_ps( lanes.out_a[ c ] ) ) ),
+                                      _mm_add_ps( _mm_mul_ps( h01, b[ c ] ), _mm_mul_ps( h11, _mm_load_ps( lanes.in_b[ c ] ) ) ) );
+        }
+    } else if ( rotation && interpolation == glTF::AnimationSampler::Linear ) {
+        // Shortest path, then the corrected normalized lerp.
+        __m128 cosine = _mm_mul_ps( a[ 0 ], b[ 0 ] );
+        for ( u32 c = 1; c < 4; ++c ) {
+            cosine = _mm_add_ps( cosine, _mm_mul_ps( a[ c ], b[ c ] ) );
+        }
+        const __m128 sign = _mm_and_ps( cosine, _mm_set1_ps( -0.0f ) );
+        const __m128 d = _mm_andnot_ps( _mm_set1_ps( -0.0f ), cosine );
+
+        const __m128 half = _mm_set1_ps( 0.5f );
+        const __m128 ka = _mm_add_ps( _mm_set1_ps( 1.0904f ), _mm_mul_ps( d, _mm_add_ps( _mm_set1_ps( -3.2452f ), _mm_mul_ps( d, _mm_sub_ps( _mm_set1_ps( 3.55645f ), _mm_mul_ps( d, _mm_set1_ps( 1.43519f ) ) ) ) ) ) );
+        const __m128 kb = _mm_add_ps( _mm_set1_ps( 0.848013f ), _mm_mul_ps( d, _mm_add_ps( _mm_set1_ps( -1.06021f ), _mm_mul_ps( d, _mm_set1_ps( 0.215638f ) ) ) ) );
+        const __m128 centered = _mm_sub_ps( t, half );
+        const __m128 k = _mm_add_ps( _mm_mul_ps( ka, _mm_mul_ps( centered, centered ) ), kb );
+        const __m128 corrected = _mm_add_ps( t, _mm_mul_ps( _mm_mul_ps( t, centered ), _mm_mul_ps( _mm_sub_ps( t, _mm_set1_ps( 1.0f ) ), k ) ) );
+
+        for ( u32 c = 0; c < 4; ++c ) {
+            const __m128 signed_b = _mm_xor_ps( b[ c ], sign );
+            result[ c ] = _mm_add_ps( a[ c ], _mm_mul_ps( _mm_sub_ps( signed_b, a[ c ] ), corrected ) );
+        }
+    } else {
+        for ( u32 c = 0; c < 4; ++c ) {
+            result[ c ] = _mm_add_ps( a[ c ], _mm_mul_ps( _mm_sub_ps( b[ c ], a[ c ] ), t ) );
+        }
+    }
+
+    if ( rotation && interpolation != glTF::AnimationSampler::Step ) {
+        __m128 length_squared = _mm_mul_ps( result[ 0 ], result[ 0 ] );
+        for ( u32 c = 1; c < 4; ++c ) {
+            length_squared = _mm_add_ps( length_squared, _mm_mul_ps( result[ c ], result[ c ] ) );
+        }
+        const __m128 inverse_length = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_max_ps( _mm_sqrt_ps( length_squared ), _mm_set1_ps( 1e-30f ) ) );
+        for ( u32 c = 0; c < 4; ++c ) {
+            result[ c ] = _mm_mul_ps( result[ c ], inverse_length );
+        }
+    }
+
+    for ( u32 c = 0; c < 4; ++c ) {
+        _mm_store_ps( lanes.result[ c ], result[ c ] );
+    }
+}
+
+#else
+
+static f32 animation_slerp_t( f32 t, f32 cosine ) {
+    const f32 d = fabsf( cosine );
+    const f32 a = 1.0904f + d * ( -3.2452f + d * ( 3.55645f - d * 1.43519f ) );
+    const f32 b = 0.848013f + d * ( -1.06021f + d * 0.215638f );
+    const f32 k = a * ( t - 0.5f ) * ( t - 0.5f ) + b;
+    return t + t * ( t - 0.5f ) * ( t - 1.0f ) * k;
+}
+
+static void animation_interpolate( AnimationLanes& lanes, u32 interpolation, bool rotation ) {
+    for ( u32 l = 0; l < k_animation_lanes; ++l ) {
+        const f32 t = lanes.t[ l ];
+        f32 blend_t = t;
+        f32 sign = 1.0f;
+        if ( rotation && interpolation == glTF::AnimationSampler::Linear ) {
+            f32 cosine = 0.0f;
+            for ( u32 c = 0; c < 4; ++c ) {
+                cosine += lanes.a[ c ][ l ] * lanes.b[ c ][ l ];
+            }
+            sign = cosine < 0.0f ? -1.0f : 1.0f;
+            blend_t = animation_slerp_t( t, cosine );
+        }
+
+        const f32 t2 = t * t, t3 = t2 * t;
+        f32 length_squared = 0.0f;
+        for ( u32 c = 0; c < 4; ++c ) {
+            const f32 a = lanes.a[ c ][ l ], b = lanes.b[ c ][ l ] * sign;
+            f32 value;
+            if ( interpolation == glTF::AnimationSampler::CubicSpline ) {
+                const f32 h01 = 3.0f * t2 - 2.0f * t3;
+                value = ( 1.0f - h01 ) * a + ( t3 - 2.0f * t2 + t ) * lanes.out_a[ c ][ l ] + h01 * b + ( t3 - t2 ) * lanes.in_b[ c ][ l ];
+            } else {
+                value = a + ( b - a ) * blend_t;
+            }
+            lanes.result[ c ][ l ] = value;
+            length_squared += value * value;
+        }
+
+        if ( rotation && interpolation != glTF::AnimationSampler::Step ) {
+            const f32 inverse_length = 1.0f / max( sqrtf( length_squared ), 1e-30f );
+            for ( u32 c = 0; c < 4; ++c ) {
+                lanes.result[ c ][ l ] *= inverse_length;
+            }
+        }
+    }
+}
+
+#endif // __SSE2__
+
+static void animation_scatter( const AnimationTrack& track, const AnimationLanes& lanes, u32 lane, AnimationPose& pose ) {
+    f32* destination = nullptr;
+    switch ( track.target_type ) {
+        case glTF::AnimationChannel::Translation:
+            destination = pose.translations[ track.target_node ].raw;
+            break;
+        case glTF::AnimationChannel::Rotation:
+            destination = pose.rotations[ track.target_node ].raw;
+            break;
+        case glTF::AnimationChannel::Scale:
+            destination = pose.scales[ track.target_node ].raw;
+            break;
+        default:
+            return;
+    }
+
+    for ( u32 c = 0; c < track.component_count; ++c ) {
+        destination[ c ] = lanes.result[ c ][ lane ];
+    }
+}
+
+// Morph weights have any number of components: sampled one track at a time, without SIMD.
+static void animation_sample_weights( const AnimationClip& clip, u32* cursors, u32 track_index, f32 time, AnimationPose& pose ) {
+    const AnimationTrack& track = clip.tracks[ track_index ];
+    const f32* times = clip.times + track.times_offset;
+    const f32* values = clip.values + track.values_offset;
+    const u32 component_count = track.component_count;
+    const bool cubic = track.interpolation == glTF::AnimationSampler::CubicSpline;
+
+    const u32 key = animation_find_key( times, track.key_count, time, cursors[ track_index ] );
+    const u32 next_key = min( key + 1, track.key_count - 1 );
+    const f32 key_duration = times[ next_key ] - times[ key ];
+    const f32 t = clamp( key_duration > 0.0f ? ( time - times[ key ] ) / key_duration : 0.0f, 0.0f, 1.0f );
+
+    const u32 stride = cubic ? component_count * 3 : component_count;
+    const f32* value_a = values + stride * key + ( cubic ? component_count : 0 );
+    const f32* value_b = values + stride * next_key + ( cubic ? component_count : 0 );
+    f32* destination = pose.weights + pose.weights_offsets[ track.target_node ];
+
+    for ( u32 c = 0; c < component_count; ++c ) {
+        if ( track.interpolation == glTF::AnimationSampler::Step ) {
+            destination[ c ] = t >= 1.0f ? value_b[ c ] : value_a[ c ];
+        } else if ( cubic ) {
+            const f32 t2 = t * t, t3 = t2 * t;
+            const f32 h01 = 3.0f * t2 - 2.0f * t3;
+            const f32 out_tangent = values[ stride * key + component_count * 2 + c ] * key_duration;
+            const f32 in_tangent = values[ stride * next_key + c ] * key_duration;
+            destination[ c ] = ( 1.0f - h01 ) * value_a[ c ] + ( t3 - 2.0f * t2 + t ) * out_tangent + h01 * value_b[ c ] + ( t3 - t2 ) * in_tangent;
+        } else {
+            destination[ c ] = value_a[ c ] + ( value_b[ c ] - value_a[ c ] ) * t;
+        }
+    }
+}
+
+void AnimationInstance::sample( f32 sample_time ) {
+    time = sample_time;
+    if ( loop && clip->duration > 0.0f ) {
+        time = fmodf( time, clip->duration );
+        time = time < 0.0f ? time + clip->duration : time;
+    }
+
+    AnimationLanes lanes;
+    u32 t = 0;
+    while ( t < clip->tracks_count ) {
+        const AnimationTrack& first = clip->tracks[ t ];
+        if ( first.target_type == glTF::AnimationChannel::Weights ) {
+            animation_sample_weights( *clip, cursors, t, time, *pose );
+            ++t;
+            continue;
+        }
+
+        // Up to four tracks of the same kind.
+        const u32 kind = animation_track_kind( first );
+        u32 lane_count = 1;
+        while ( lane_count < k_animation_lanes && t + lane_count < clip->tracks_count && animation_track_kind( clip->tracks[ t + lane_count ] ) == kind ) {
+            ++lane_count;
+        }
+
+        for ( u32 l = 0; l < lane_count; ++l ) {
+            animation_gather( *clip, cursors, t + l, l, time, lanes );
+        }
+        for ( u32 l = lane_count; l < k_animation_lanes; ++l ) {
+            animation_copy_lane( lanes, 0, l );
+        }
+
+        animation_interpolate( lanes, first.interpolation, first.target_type == glTF::AnimationChannel::Rotation );
+
+        for ( u32 l = 0; l < lane_count; ++l ) {
+            animation_scatter( clip->tracks[ t + l ], lanes, l, *pose );
+        }
+        t += lane_count;
+    }
+}
+
+//
+//
+struct AnimationSampleTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    AnimationInstance*              instances       = nullptr;
+}; // struct AnimationSampleTask
+
+void AnimationSampleTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    for ( u32 i = range.start; i < range.end; ++i ) {
+        instances[ i ].sample( instances[ i ].time );
+    }
+}
+
+void animation_sample_instances( AnimationInstance* instances, u32 count, enki::TaskScheduler* task_scheduler ) {
+    if ( task_scheduler == nullptr || count <= k_animation_instances_per_task ) {
+        for ( u32 i = 0; i < count; ++i ) {
+            instances[ i ].sample( instances[ i ].time );
+        }
+        return;
+    }
+
+    AnimationSampleTask sample_task;
+    sample_task.m_SetSize = count;
+    sample_task.m_MinRange = k_animation_instances_per_task;
+    sample_task.instances = instances;
+
+    task_scheduler->AddTaskSetToPipe( &sample_task );
+    task_scheduler->WaitforTask( &sample_task );
+}
+
+} // namespace syi
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace syi {
+
+    struct Allocator;
+
+    // AnimationClip //////////////////////////////////////////////////////
+    //
+    // One channel of a glTF animation, repacked: keyframe times and values are separate
+    // contiguous streams of the clip. Channels sharing an input accessor share their times.
+    struct AnimationTrack {
+        u32                         key_count;
+        u32                         times_offset;   // Into AnimationClip::times.
+        u32                         values_offset;  // Into AnimationClip::values. Cubic splines store in tangent, value and out tangent per key.
+        u32                         target_node;
+        u16                         component_count; // 3, 4 for rotations, or the morph weights of the node.
+        u8                          target_type;    // glTF::AnimationChannel::TargetType
+        u8                          interpolation;  // glTF::AnimationSampler::Interpolation
+    }; // struct AnimationTrack
+
+    //
+    // Tracks are sorted by kind, so that consecutive tracks with the same interpolation
+    // are sampled four at a time, one track per SIMD lane.
+    struct AnimationClip {
+
+        bool                        init( const glTF::glTF& gltf, u32 animation_index, u8* const* buffers_data, Allocator* allocator );
+        void                        shutdown();
+
+        AnimationTrack*             tracks          = nullptr;
+        u32                         tracks_count    = 0;
+        f32*                        times           = nullptr;
+        f32*                        values          = nullptr;
+        f32                         duration        = 0.0f;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct AnimationClip
+
+    // AnimationPose //////////////////////////////////////////////////////
+    //
+    // Local transforms of all the nodes of a glTF, in separate arrays indexed by node.
+    // Starts from the rest pose of the nodes, animated channels overwrite their targets.
+    struct AnimationPose {
+
+        void                        init( const glTF::glTF& gltf, Allocator* allocator );
+        void                        shutdown();
+
+        u32                         nodes_count     = 0;
+        vec3s*                      translations    = nullptr;
+        versors*                    rotations       = nullptr;
+        vec3s*                      scales          = nullptr;
+
+        // Morph weights of a node are weights[ weights_offsets[ node ] ], from the node or its mesh.
+        u32*                        weights_offsets = nullptr;
+        f32*                        weights         = nullptr;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct AnimationPose
+
+    // AnimationInstance //////////////////////////////////////////////////
+    //
+    // Playback of a clip into a pose. Each track remembers its last keyframe, so that
+    // sequential playback finds the next key in constant time.
+    struct AnimationInstance {
+
+        void                        init( const AnimationClip* clip, AnimationPose* pose, Allocator* allocator );
+        void                        shutdown();
+
+        // Samples the clip at time, wrapped around the clip duration if looping.
+        void                        sample( f32 time );
+
+        const AnimationClip*        clip            = nullptr;
+        AnimationPose*              pose            = nullptr;
+        u32*                        cursors         = nullptr;  // Last keyframe of each track.
+        f32                         time            = 0.0f;
+        bool                        loop            = true;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct AnimationInstance
+
+    // Samples every instance at its own time. With a task scheduler instances are sampled in parallel,
+    // the instances of a task set must write to different poses.
+    void                            animation_sample_instances( AnimationInstance* instances, u32 count, enki::TaskScheduler* task_scheduler = nullptr );
+
+} // namespace syi
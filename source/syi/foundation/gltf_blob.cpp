@@ -0,0 +1,656 @@
+#include "gltf_blob.hpp"
+
+#include "foundation/blob_serialization.hpp"
+#include "foundation/hash_map.hpp"
+#include "foundation/array.hpp"
+#include "foundation/file.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace syi {
+
+// Compilation ////////////////////////////////////////////////////////////
+
+//
+// Strings are written after all the structures, so that every structure stays 4 bytes aligned.
+struct glTFBlobStringFixup {
+    RelativeString*                 string;
+    cstring                         text;
+    u32                             length;
+}; // struct glTFBlobStringFixup
+
+//
+//
+struct glTFBlobWriter {
+
+    void                            set_string( RelativeString& destination, const StringBuffer& source );
+    void                            intern_strings( Allocator* allocator );
+
+    template <typename T>
+    T*                              set_array( RelativeArray<T>& destination, u32 count, const void* source = nullptr );
+    template <typename T>
+    void                            set_pointer( RelativePointer<T>& destination, const T* source );
+
+    BlobSerializer                  serializer;
+    Array<glTFBlobStringFixup>      strings;
+
+}; // struct glTFBlobWriter
+
+void glTFBlobWriter::set_string( RelativeString& destination, const StringBuffer& source ) {
+    if ( !source.data ) {
+        destination.set_empty();
+        return;
+    }
+
+    strings.push( { &destination, source.data, ( u32 )strlen( source.data ) } );
+}
+
+void glTFBlobWriter::intern_strings( Allocator* allocator ) {
+    // Blob offset of the first copy of each string.
+    FlatHashMap<u64, u32> interned;
+    interned.init( allocator, strings.size );
+    interned.set_default_value( u32_max );
+
+    for ( u32 i = 0; i < strings.size; ++i ) {
+        glTFBlobStringFixup& fixup = strings[ i ];
+        const u64 hash = hash_bytes( ( void* )fixup.text, fixup.length );
+
+        const u32 offset = interned.get( hash );
+        char* interned_string = offset != u32_max ? serializer.blob_memory + offset : nullptr;
+        if ( !interned_string || strcmp( interned_string, fixup.text ) != 0 ) {
+            const u32 new_offset = serializer.allocated_offset;
+            interned_string = serializer.allocate_static( fixup.length + 1 );
+            memcpy( interned_string, fixup.text, fixup.length + 1 );
+
+            if ( offset == u32_max ) {
+                interned.insert( hash, new_offset );
+            }
+        }
+
+        fixup.string->set( interned_string, fixup.length );
+    }
+
+    interned.shutdown();
+}
+
+template <typename T>
+T* glTFBlobWriter::set_array( RelativeArray<T>& destination, u32 count, const void* source ) {
+    if ( count == 0 ) {
+        destination.set_empty();
+        return nullptr;
+    }
+
+    serializer.allocate_and_set( destination, count, ( void* )source );
+    return destination.get();
+}
+
+template <typename T>
+void glTFBlobWriter::set_pointer( RelativePointer<T>& destination, const T* source ) {
+    if ( !source ) {
+        destination.set_null();
+        return;
+    }
+
+    serializer.allocate_and_set( destination, ( void* )source );
+}
+
+static sizet string_blob_size( const StringBuffer& string ) {
+    return string.data ? strlen( string.data ) + 1 : 0;
+}
+
+// Upper bound of the blob size, as if no string was shared.
+static sizet gltf_blob_size( const glTF::glTF& gltf ) {
+    sizet size = sizeof( glTF::glTFBlob );
+
+    size += string_blob_size( gltf.asset.copyright ) + string_blob_size( gltf.asset.generator ) +
+            string_blob_size( gltf.asset.minVersion ) + string_blob_size( gltf.asset.version );
+
+    size += sizeof( glTF::AccessorBlob ) * gltf.accessors_count;
+    for ( u32 i = 0; i < gltf.accessors_count; ++i ) {
+        size += sizeof( f32 ) * ( gltf.accessors[ i ].max_count + gltf.accessors[ i ].min_count );
+        size += gltf.accessors[ i ].sparse ? sizeof( glTF::AccessorSparse ) : 0;
+    }
+
+    size += sizeof( glTF::AnimationBlob ) * gltf.animations_count;
+    for ( u32 i = 0; i < gltf.animations_count; ++i ) {
+        size += sizeof( glTF::AnimationChannel ) * gltf.animations[ i ].channels_count;
+        size += sizeof( glTF::AnimationSampler ) * gltf.animations[ i ].samplers_count;
+    }
+
+    size += sizeof( glTF::BufferViewBlob ) * gltf.buffer_views_count;
+    for ( u32 i = 0; i < gltf.buffer_views_count; ++i ) {
+        size += string_blob_size( gltf.buffer_views[ i ].name );
+    }
+
+    size += sizeof( glTF::BufferBlob ) * gltf.buffers_count;
+    for ( u32 i = 0; i < gltf.buffers_count; ++i ) {
+        size += string_blob_size( gltf.buffers[ i ].uri ) + string_blob_size( gltf.buffers[ i ].name );
+    }
+
+    size += sizeof( glTF::ImageBlob ) * gltf.images_count;
+    for ( u32 i = 0; i < gltf.images_count; ++i ) {
+        size += string_blob_size( gltf.images[ i ].mime_type ) + string_blob_size( gltf.images[ i ].uri );
+    }
+
+    size += sizeof( glTF::MaterialBlob ) * gltf.materials_count;
+    for ( u32 i = 0; i < gltf.materials_count; ++i ) {
+        const glTF::Material& material = gltf.materials[ i ];
+        size += sizeof( f32 ) * material.emissive_factor_count;
+        size += material.emissive_texture ? sizeof( glTF::TextureInfo ) : 0;
+        size += material.normal_texture ? sizeof( glTF::MaterialNormalTextureInfo ) : 0;
+        size += material.occlusion_texture ? sizeof( glTF::MaterialOcclusionTextureInfo ) : 0;
+        if ( material.pbr_metallic_roughness ) {
+            const glTF::MaterialPBRMetallicRoughness& pbr = *material.pbr_metallic_roughness;
+            size += sizeof( glTF::MaterialPBRMetallicRoughnessBlob ) + sizeof( f32 ) * pbr.base_color_factor_count;
+            size += pbr.base_color_texture ? sizeof( glTF::TextureInfo ) : 0;
+            size += pbr.metallic_roughness_texture ? sizeof( glTF::TextureInfo ) : 0;
+        }
+        size += string_blob_size( material.alpha_mode ) + string_blob_size( material.name );
+    }
+
+    size += sizeof( glTF::MeshBlob ) * gltf.meshes_count;
+    for ( u32 i = 0; i < gltf.meshes_count; ++i ) {
+        const glTF::Mesh& mesh = gltf.meshes[ i ];
+        size += sizeof( glTF::MeshPrimitiveBlob ) * mesh.primitives_count + sizeof( f32 ) * mesh.weights_count;
+        for ( u32 p = 0; p < mesh.primitives_count; ++p ) {
+            const glTF::MeshPrimitive& primitive = mesh.primitives[ p ];
+            size += sizeof( glTF::MeshPrimitiveAttributeBlob ) * primitive.attribute_count;
+            for ( u32 a = 0; a < primitive.attribute_count; ++a ) {
+                size += string_blob_size( primitive.attributes[ a ].key );
+            }
+            size += sizeof( glTF::MeshPrimitiveTargetBlob ) * primitive.targets_count;
+            for ( u32 t = 0; t < primitive.targets_count; ++t ) {
+                const glTF::MeshPrimitive::Target& target = primitive.targets[ t ];
+                size += sizeof( glTF::MeshPrimitiveAttributeBlob ) * target.attribute_count;
+                for ( u32 a = 0; a < target.attribute_count; ++a ) {
+                    size += string_blob_size( target.attributes[ a ].key );
+                }
+            }
+        }
+        size += string_blob_size( mesh.name );
+    }
+
+    size += sizeof( glTF::NodeBlob ) * gltf.nodes_count;
+    for ( u32 i = 0; i < gltf.nodes_count; ++i ) {
+        const glTF::Node& node = gltf.nodes[ i ];
+        size += sizeof( i32 ) * node.children_count;
+        size += sizeof( f32 ) * ( node.matrix_count + node.rotation_count + node.scale_count + node.translation_count + node.weights_count );
+        size += string_blob_size( node.name );
+    }
+
+    size += sizeof( glTF::Sampler ) * gltf.samplers_count;
+
+    size += sizeof( glTF::SceneBlob ) * gltf.scenes_count;
+    for ( u32 i = 0; i < gltf.scenes_count; ++i ) {
+        size += sizeof( i32 ) * gltf.scenes[ i ].nodes_count;
+    }
+
+    size += sizeof( glTF::SkinBlob ) * gltf.skins_count;
+    for ( u32 i = 0; i < gltf.skins_count; ++i ) {
+        size += sizeof( i32 ) * gltf.skins[ i ].joints_count;
+    }
+
+    size += sizeof( glTF::TextureBlob ) * gltf.textures_count;
+    for ( u32 i = 0; i < gltf.textures_count; ++i ) {
+        size += string_blob_size( gltf.textures[ i ].name );
+    }
+
+    return size;
+}
+
+void gltf_blob_path( cstring gltf_path, char* out_path, u32 max_size ) {
+    snprintf( out_path, max_size, "%s.blob", gltf_path );
+}
+
+bool gltf_compile_blob( const glTF::glTF& gltf, cstring blob_path ) {
+    Allocator* allocator = &MemoryService::instance()->system_allocator;
+
+    const sizet blob_size = gltf_blob_size( gltf );
+
+    glTFBlobWriter writer;
+    writer.strings.init( allocator, 256 );
+
+    glTF::glTFBlob* blob = writer.serializer.write_and_prepare<glTF::glTFBlob>( allocator, glTF::k_blob_version, blob_size );
+    memset( writer.serializer.blob_memory + sizeof( BlobHeader ), 0, blob_size );
+
+    writer.set_string( blob->asset.copyright, gltf.asset.copyright );
+    writer.set_string( blob->asset.generator, gltf.asset.generator );
+    writer.set_string( blob->asset.min_version, gltf.asset.minVersion );
+    writer.set_string( blob->asset.version, gltf.asset.version );
+    blob->scene = gltf.scene;
+
+    glTF::AccessorBlob* accessors = writer.set_array( blob->accessors, gltf.accessors_count );
+    for ( u32 i = 0; i < gltf.accessors_count; ++i ) {
+        const glTF::Accessor& source = gltf.accessors[ i ];
+        glTF::AccessorBlob& accessor = accessors[ i ];
+        accessor.buffer_view = source.buffer_view;
+        accessor.byte_offset = source.byte_offset;
+        accessor.component_type = source.component_type;
+        accessor.count = source.count;
+        writer.set_pointer( accessor.sparse, source.sparse );
+        accessor.normalized = source.normalized ? 1 : 0;
+        accessor.type = source.type;
+        writer.set_array( accessor.max, source.max_count, source.max );
+        writer.set_array( accessor.min, source.min_count, source.min );
+    }
+
+    glTF::AnimationBlob* animations = writer.set_array( blob->animations, gltf.animations_count );
+    for ( u32 i = 0; i < gltf.animations_count; ++i ) {
+        const glTF::Animation& source = gltf.animations[ i ];
+        writer.set_array( animations[ i ].channels, source.channels_count, source.channels );
+        writer.set_array( animations[ i ].samplers, source.samplers_count, source.samplers );
+    }
+
+    glTF::BufferViewBlob* buffer_views = writer.set_array( blob->buffer_views, gltf.buffer_views_count );
+    for ( u32 i = 0; i < gltf.buffer_views_count; ++i ) {
+        const glTF::BufferView& source = gltf.buffer_views[ i ];
+        glTF::BufferViewBlob& buffer_view = buffer_views[ i ];
+        buffer_view.buffer = source.buffer;
+        buffer_view.byte_length = source.byte_length;
+        buffer_view.byte_offset = source.byte_offset;
+        buffer_view.byte_stride = source.byte_stride;
+        buffer_view.target = source.target;
+        writer.set_string( buffer_view.name, source.name );
+    }
+
+    glTF::BufferBlob* buffers = writer.set_array( blob->buffers, gltf.buffers_count );
+    for ( u32 i = 0; i < gltf.buffers_count; ++i ) {
+        buffers[ i ].byte_length = gltf.buffers[ i ].byte_length;
+        writer.set_string( buffers[ i ].uri, gltf.buffers[ i ].uri );
+        writer.set_string( buffers[ i ].name, gltf.buffers[ i ].name );
+    }
+
+    glTF::ImageBlob* images = writer.set_array( blob->images, gltf.images_count );
+    for ( u32 i = 0; i < gltf.images_count; ++i ) {
+        images[ i ].buffer_view = gltf.images[ i ].buffer_view;
+        writer.set_string( images[ i ].mime_type, gltf.images[ i ].mime_type );
+        writer.set_string( images[ i ].uri, gltf.images[ i ].uri );
+    }
+
+    glTF::MaterialBlob* materials = writer.set_array( blob->materials, gltf.materials_count );
+    for ( u32 i = 0; i < gltf.materials_count; ++i ) {
+        const glTF::Material& source = gltf.materials[ i ];
+        glTF::MaterialBlob& material = materials[ i ];
+        material.alpha_cutoff = source.alpha_cutoff;
+        material.double_sided = source.double_sided ? 1 : 0;
+        writer.set_array( material.emissive_factor, source.emissive_factor_count, source.emissive_factor );
+        writer.set_pointer( material.emissive_texture, source.emissive_texture );
+        writer.set_pointer( material.normal_texture, source.normal_texture );
+        writer.set_pointer( material.occlusion_texture, source.occlusion_texture );
+
+        if ( source.pbr_metallic_roughness ) {
+            const glTF::MaterialPBRMetallicRoughness& source_pbr = *source.pbr_metallic_roughness;
+            writer.serializer.allocate_and_set( material.pbr_metallic_roughness );
+
+            glTF::MaterialPBRMetallicRoughnessBlob& pbr = *material.pbr_metallic_roughness;
+            writer.set_array( pbr.base_color_factor, source_pbr.base_color_factor_count, source_pbr.base_color_factor );
+            writer.set_pointer( pbr.base_color_texture, source_pbr.base_color_texture );
+            pbr.metallic_factor = source_pbr.metallic_factor;
+            writer.set_pointer( pbr.metallic_roughness_texture, source_pbr.metallic_roughness_texture );
+            pbr.roughness_factor = source_pbr.roughness_factor;
+        } else {
+            material.pbr_metallic_roughness.set_null();
+        }
+
+        writer.set_string( material.alpha_mode, source.alpha_mode );
+        writer.set_string( material.name, source.name );
+    }
+
+    glTF::MeshBlob* meshes = writer.set_array( blob->meshes, gltf.meshes_count );
+    for ( u32 i = 0; i < gltf.meshes_count; ++i ) {
+        const glTF::Mesh& source = gltf.meshes[ i ];
+        glTF::MeshBlob& mesh = meshes[ i ];
+
+        glTF::MeshPrimitiveBlob* primitives = writer.set_array( mesh.primitives, source.primitives_count );
+        for ( u32 p = 0; p < source.primitives_count; ++p ) {
+            const glTF::MeshPrimitive& source_primitive = source.primitives[ p ];
+            glTF::MeshPrimitiveBlob& primitive = primitives[ p ];
+            primitive.indices = source_primitive.indices;
+            primitive.material = source_primitive.material;
+            primitive.mode = source_primitive.mode;
+
+            glTF::MeshPrimitiveAttributeBlob* attributes = writer.set_array( primitive.attributes, source_primitive.attribute_count );
+            for ( u32 a = 0; a < source_primitive.attribute_count; ++a ) {
+                attributes[ a ].accessor_index = source_primitive.attributes[ a ].accessor_index;
+                writer.set_string( attributes[ a ].key, source_primitive.attributes[ a ].key );
+            }
+
+            glTF::MeshPrimitiveTargetBlob* targets = writer.set_array( primitive.targets, source_primitive.targets_count );
+            for ( u32 t = 0; t < source_primitive.targets_count; ++t ) {
+                const glTF::MeshPrimitive::Target& source_target = source_primitive.targets[ t ];
+                glTF::MeshPrimitiveAttributeBlob* target_attributes = writer.set_array( targets[ t ].attributes, source_target.attribute_count );
+                for ( u32 a = 0; a < source_target.attribute_count; ++a ) {
+                    target_attributes[ a ].accessor_index = source_target.attributes[ a ].accessor_index;
+                    writer.set_string( target_attributes[ a ].key, source_target.attributes[ a ].key );
+                }
+            }
+        }
+
+        writer.set_array( mesh.weights, source.weights_count, source.weights );
+        writer.set_string( mesh.name, source.name );
+    }
+
+    glTF::NodeBlob* nodes = writer.set_array( blob->nodes, gltf.nodes_count );
+    for ( u32 i = 0; i < gltf.nodes_count; ++i ) {
+        const glTF::Node& source = gltf.nodes[ i ];
+        glTF::NodeBlob& node = nodes[ i ];
+        node.camera = source.camera;
+        node.mesh = source.mesh;
+        node.skin = source.skin;
+        writer.set_array( node.children, source.children_count, source.children );
+        writer.set_array( node.matrix, source.matrix_count, source.matrix );
+        writer.set_array( node.rotation, source.rotation_count, source.rotation );
+        writer.set_array( node.scale, source.scale_count, source.scale );
+        writer.set_array( node.translation, source.translation_count, source.translation );
+        writer.set_array( node.weights, source.weights_count, source.weights );
+        writer.set_string( node.name, source.name );
+    }
+
+    writer.set_array( blob->samplers, gltf.samplers_count, gltf.samplers );
+
+    glTF::SceneBlob* scenes = writer.set_array( blob->scenes, gltf.scenes_count );
+    for ( u32 i = 0; i < gltf.scenes_count; ++i ) {
+        writer.set_array( scenes[ i ].nodes, gltf.scenes[ i ].nodes_count, gltf.scenes[ i ].nodes );
+    }
+
+    glTF::SkinBlob* skins = writer.set_array( blob->skins, gltf.skins_count );
+    for ( u32 i = 0; i < gltf.skins_count; ++i ) {
+        skins[ i ].inverse_bind_matrices_buffer_index = gltf.skins[ i ].inverse_bind_matrices_buffer_index;
+        skins[ i ].skeleton_root_node_index = gltf.skins[ i ].skeleton_root_node_index;
+        writer.set_array( skins[ i ].joints, gltf.skins[ i ].joints_count, gltf.skins[ i ].joints );
+    }
+
+    glTF::TextureBlob* textures = writer.set_array( blob->textures, gltf.textures_count );
+    for ( u32 i = 0; i < gltf.textures_count; ++i ) {
+        textures[ i ].sampler = gltf.textures[ i ].sampler;
+        textures[ i ].source = gltf.textures[ i ].source;
+        writer.set_string( textures[ i ].name, gltf.textures[ i ].name );
+    }
+
+    writer.intern_strings( allocator );
+
+    bool written = false;
+    FileHandle file;
+    file_open( blob_path, "wb", &file );
+    if ( file ) {
+        written = file_write( ( u8* )writer.serializer.blob_memory, 1, writer.serializer.allocated_offset, file ) == writer.serializer.allocated_offset;
+        file_close( file );
+    }
+
+    if ( !written ) {
+        rprint( "Error: cannot write compiled glTF %s\n", blob_path );
+    }
+
+    writer.strings.shutdown();
+    writer.serializer.shutdown();
+
+    return written;
+}
+
+// Loading ////////////////////////////////////////////////////////////////
+
+static void string_from_blob( const RelativeString& string, StringBuffer& out_string ) {
+    // Points into the mapping: never initialized nor shut down.
+    out_string.data = ( char* )string.c_str();
+    out_string.buffer_size = string.size + 1;
+    out_string.current_size = string.size;
+    out_string.allocator = nullptr;
+}
+
+template <typename T>
+static T* array_from_blob( const RelativeArray<T>& array, u32& out_count ) {
+    out_count = array.size;
+    return ( T* )array.get();
+}
+
+template <typename T>
+static T* allocate_array( Allocator* allocator, u32 count ) {
+    if ( count == 0 ) {
+        return nullptr;
+    }
+
+    // All zeros rather than value initialized, as the loaders leave them: null strings with a 0 buffer size.
+    T* array = ( T* )allocator->allocate( sizeof( T ) * count, 64 );
+    memset( ( void* )array, 0, sizeof( T ) * count );
+    return array;
+}
+
+// Memory needed by the structures that can't point into the blob.
+static sizet gltf_runtime_size( const glTF::glTFBlob& blob ) {
+    const sizet k_padding = 64;
+
+    sizet size = ( sizeof( glTF::Accessor ) * blob.accessors.size ) + ( sizeof( glTF::Animation ) * blob.animations.size ) +
+                 ( sizeof( glTF::BufferView ) * blob.buffer_views.size ) + ( sizeof( glTF::Buffer ) * blob.buffers.size ) +
+                 ( sizeof( glTF::Image ) * blob.images.size ) + ( sizeof( glTF::Material ) * blob.materials.size ) +
+                 ( sizeof( glTF::Mesh ) * blob.meshes.size ) + ( sizeof( glTF::Node ) * blob.nodes.size ) +
+                 ( sizeof( glTF::Scene ) * blob.scenes.size ) + ( sizeof( glTF::Skin ) * blob.skins.size ) +
+                 ( sizeof( glTF::Texture ) * blob.textures.size ) + k_padding * 11;
+
+    for ( u32 i = 0; i < blob.materials.size; ++i ) {
+        size += blob.materials[ i ].pbr_metallic_roughness.is_not_null() ? sizeof( glTF::MaterialPBRMetallicRoughness ) + k_padding : 0;
+    }
+
+    for ( u32 i = 0; i < blob.meshes.size; ++i ) {
+        const glTF::MeshBlob& mesh = blob.meshes[ i ];
+        size += sizeof( glTF::MeshPrimitive ) * mesh.primitives.size + k_padding;
+        for ( u32 p = 0; p < mesh.primitives.size; ++p ) {
+            const glTF::MeshPrimitiveBlob& primitive = mesh.primitives[ p ];
+            size += sizeof( glTF::MeshPrimitive::Attribute ) * primitive.attributes.size + k_padding;
+            size += primitive.targets.size ? sizeof( glTF::MeshPrimitive::Target ) * primitive.targets.size + k_padding : 0;
+            for ( u32 t = 0; t < primitive.targets.size; ++t ) {
+                size += sizeof( glTF::MeshPrimitive::Attribute ) * primitive.targets[ t ].attributes.size + k_padding;
+            }
+        }
+    }
+
+    return size;
+}
+
+bool gltf_load_blob( cstring blob_path, glTF::glTF& out_gltf ) {
+    FileMapping mapping;
+    if ( !file_map_read_only( blob_path, &mapping ) ) {
+        return false;
+    }
+
+    const glTF::glTFBlob& blob = *( const glTF::glTFBlob* )mapping.data;
+    if ( mapping.size < sizeof( glTF::glTFBlob ) || blob.header.version != glTF::k_blob_version || !blob.header.mappable ) {
+        rprint( "Compiled glTF %s is outdated, ignoring it\n", blob_path );
+        file_unmap( &mapping );
+        return false;
+    }
+
+    glTF::glTF& gltf = out_gltf;
+    gltf = glTF::glTF{};
+    gltf.blob_mapping = mapping;
+
+    gltf.allocator.init( gltf_runtime_size( blob ) );
+    Allocator* allocator = &gltf.allocator;
+
+    string_from_blob( blob.asset.copyright, gltf.asset.copyright );
+    string_from_blob( blob.asset.generator, gltf.asset.generator );
+    string_from_blob( blob.asset.min_version, gltf.asset.minVersion );
+    string_from_blob( blob.asset.version, gltf.asset.version );
+    gltf.scene = blob.scene;
+
+    gltf.accessors_count = blob.accessors.size;
+    gltf.accessors = allocate_array<glTF::Accessor>( allocator, gltf.accessors_count );
+    for ( u32 i = 0; i < gltf.accessors_count; ++i ) {
+        const glTF::AccessorBlob& source = blob.accessors[ i ];
+        glTF::Accessor& accessor = gltf.accessors[ i ];
+        accessor.buffer_view = source.buffer_view;
+        accessor.byte_offset = source.byte_offset;
+        accessor.component_type = source.component_type;
+        accessor.count = source.count;
+        accessor.sparse = source.sparse.get();
+        accessor.normalized = source.normalized != 0;
+        accessor.type = ( glTF::Accessor::Type )source.type;
+        accessor.max = array_from_blob( source.max, accessor.max_count );
+        accessor.min = array_from_blob( source.min, accessor.min_count );
+    }
+
+    gltf.animations_count = blob.animations.size;
+    gltf.animations = allocate_array<glTF::Animation>( allocator, gltf.animations_count );
+    for ( u32 i = 0; i < gltf.animations_count; ++i ) {
+        glTF::Animation& animation = gltf.animations[ i ];
+        animation.channels = array_from_blob( blob.animations[ i ].channels, animation.channels_count );
+        animation.samplers = array_from_blob( blob.animations[ i ].samplers, animation.samplers_count );
+    }
+
+    gltf.buffer_views_count = blob.buffer_views.size;
+    gltf.buffer_views = allocate_array<glTF::BufferView>( allocator, gltf.buffer_views_count );
+    for ( u32 i = 0; i < gltf.buffer_views_count; ++i ) {
+        const glTF::BufferViewBlob& source = blob.buffer_views[ i ];
+        glTF::BufferView& buffer_view = gltf.buffer_views[ i ];
+        buffer_view.buffer = source.buffer;
+        buffer_view.byte_length = source.byte_length;
+        buffer_view.byte_offset = source.byte_offset;
+        buffer_view.byte_stride = source.byte_stride;
+        buffer_view.target = source.target;
+        string_from_blob( source.name, buffer_view.name );
+    }
+
+    gltf.buffers_count = blob.buffers.size;
+    gltf.buffers = allocate_array<glTF::Buffer>( allocator, gltf.buffers_count );
+    for ( u32 i = 0; i < gltf.buffers_count; ++i ) {
+        gltf.buffers[ i ].byte_length = blob.buffers[ i ].byte_length;
+        string_from_blob( blob.buffers[ i ].uri, gltf.buffers[ i ].uri );
+        string_from_blob( blob.buffers[ i ].name, gltf.buffers[ i ].name );
+    }
+
+    gltf.images_count = blob.images.size;
+    gltf.images = allocate_array<glTF::Image>( allocator, gltf.images_count );
+    for ( u32 i = 0; i < gltf.images_count; ++i ) {
+        gltf.images[ i ].buffer_view = blob.images[ i ].buffer_view;
+        string_from_blob( blob.images[ i ].mime_type, gltf.images[ i ].mime_type );
+        string_from_blob( blob.images[ i ].uri, gltf.images[ i ].uri );
+    }
+
+    gltf.materials_count = blob.materials.size;
+    gltf.materials = allocate_array<glTF::Material>( allocator, gltf.materials_count );
+    for ( u32 i = 0; i < gltf.materials_count; ++i ) {
+        const glTF::MaterialBlob& source = blob.materials[ i ];
+        glTF::Material& material = gltf.materials[ i ];
+        material.alpha_cutoff = source.alpha_cutoff;
+        material.double_sided = source.double_sided != 0;
+        material.emissive_factor = array_from_blob( source.emissive_factor, material.emissive_factor_count );
+        material.emissive_texture = source.emissive_texture.get();
+        material.normal_texture = source.normal_texture.get();
+        material.occlusion_texture = source.occlusion_texture.get();
+
+        if ( source.pbr_metallic_roughness.is_not_null() ) {
+            const glTF::MaterialPBRMetallicRoughnessBlob& source_pbr = *source.pbr_metallic_roughness;
+            glTF::MaterialPBRMetallicRoughness* pbr = allocate_array<glTF::MaterialPBRMetallicRoughness>( allocator, 1 );
+            pbr->base_color_factor = array_from_blob( source_pbr.base_color_factor, pbr->base_color_factor_count );
+            pbr->base_color_texture = source_pbr.base_color_texture.get();
+            pbr->metallic_factor = source_pbr.metallic_factor;
+            pbr->metallic_roughness_texture = source_pbr.metallic_roughness_texture.get();
+            pbr->roughness_factor = source_pbr.roughness_factor;
+            material.pbr_metallic_roughness = pbr;
+        }
+
+        string_from_blob( source.alpha_mode, material.alpha_mode );
+        string_from_blob( source.name, material.name );
+    }
+
+    gltf.meshes_count = blob.meshes.size;
+    gltf.meshes = allocate_array<glTF::Mesh>( allocator, gltf.meshes_count );
+    for ( u32 i = 0; i < gltf.meshes_count; ++i ) {
+        const glTF::MeshBlob& source = blob.meshes[ i ];
+        glTF::Mesh& mesh = gltf.meshes[ i ];
+
+        mesh.primitives_count = source.primitives.size;
+        mesh.primitives = allocate_array<glTF::MeshPrimitive>( allocator, mesh.primitives_count );
+        for ( u32 p = 0; p < mesh.primitives_count; ++p ) {
+            const glTF::MeshPrimitiveBlob& source_primitive = source.primitives[ p ];
+            glTF::MeshPrimitive& primitive = mesh.primitives[ p ];
+            primitive.indices = source_primitive.indices;
+            primitive.material = source_primitive.material;
+            primitive.mode = source_primitive.mode;
+
+            primitive.attribute_count = source_primitive.attributes.size;
+            primitive.attributes = allocate_array<glTF::MeshPrimitive::Attribute>( allocator, primitive.attribute_count );
+            for ( u32 a = 0; a < primitive.attribute_count; ++a ) {
+                primitive.attributes[ a ].accessor_index = source_primitive.attributes[ a ].accessor_index;
+                string_from_blob( source_primitive.attributes[ a ].key, primitive.attributes[ a ].key );
+            }
+
+            primitive.targets_count = source_primitive.targets.size;
+            primitive.targets = allocate_array<glTF::MeshPrimitive::Target>( allocator, primitive.targets_count );
+            for ( u32 t = 0; t < primitive.targets_count; ++t ) {
+                const glTF::MeshPrimitiveTargetBlob& source_target = source_primitive.targets[ t ];
+                glTF::MeshPrimitive::Target& target = primitive.targets[ t ];
+                target.attribute_count = source_target.attributes.size;
+                target.attributes = allocate_array<glTF::MeshPrimitive::Attribute>( allocator, target.attribute_count );
+                for ( u32 a = 0; a < target.attribute_count; ++a ) {
+                    target.attributes[ a ].accessor_index = source_target.attributes[ a ].accessor_index;
+                    string_from_blob( source_target.attributes[ a ].key, target.attributes[ a ].key );
+                }
+            }
+        }
+
+        mesh.weights = array_from_blob( source.weights, mesh.weights_count );
+        string_from_blob( source.name, mesh.name );
+    }
+
+    gltf.nodes_count = blob.nodes.size;
+    gltf.nodes = allocate_array<glTF::Node>( allocator, gltf.nodes_count );
+    for ( u32 i = 0; i < gltf.nodes_count; ++i ) {
+        const glTF::NodeBlob& source = blob.nodes[ i ];
+        glTF::Node& node = gltf.nodes[ i ];
+        node.camera = source.camera;
+        node.mesh = source.mesh;
+        node.skin = source.skin;
+        node.children = array_from_blob( source.children, node.children_count );
+        node.matrix = array_from_blob( source.matrix, node.matrix_count );
+        node.rotation = array_from_blob( source.rotation, node.rotation_count );
+        node.scale = array_from_blob( source.scale, node.scale_count );
+        node.translation = array_from_blob( source.translation, node.translation_count );
+        node.weights = array_from_blob( source.weights, node.weights_count );
+        string_from_blob( source.name, node.name );
+    }
+
+    gltf.samplers = array_from_blob( blob.samplers, gltf.samplers_count );
+
+    gltf.scenes_count = blob.scenes.size;
+    gltf.scenes = allocate_array<glTF::Scene>( allocator, gltf.scenes_count );
+    for ( u32 i = 0; i < gltf.scenes_count; ++i ) {
+        gltf.scenes[ i ].nodes = array_from_blob( blob.scenes[ i ].nodes, gltf.scenes[ i ].nodes_count );
+    }
+
+    gltf.skins_count = blob.skins.size;
+    gltf.skins = allocate_array<glTF::Skin>( allocator, gltf.skins_count );
+    for ( u32 i = 0; i < gltf.skins_count; ++i ) {
+        gltf.skins[ i ].inverse_bind_matrices_buffer_index = blob.skins[ i ].inverse_bind_matrices_buffer_index;
+        gltf.skins[ i ].skeleton_root_node_index = blob.skins[ i ].skeleton_root_node_index;
+        gltf.skins[ i ].joints = array_from_blob( blob.skins[ i ].joints, gltf.skins[ i ].joints_count );
+    }
+
+    gltf.textures_count = blob.textures.size;
+    gltf.textures = allocate_array<glTF::Texture>( allocator, gltf.textures_count );
+    for ( u32 i = 0; i < gltf.textures_count; ++i ) {
+        gltf.textures[ i ].sampler = blob.textures[ i ].sampler;
+        gltf.textures[ i ].source = blob.textures[ i ].source;
+        string_from_blob( blob.textures[ i ].name, gltf.textures[ i ].name );
+    }
+
+    return true;
+}
+
+// GltfBlobCompiler ///////////////////////////////////////////////////////
+
+void GltfBlobCompiler::init( enki::TaskScheduler* task_scheduler_ ) {
+    task_scheduler = task_scheduler_;
+    version = glTF::k_blob_version;
+    extension = "blob";
+}
+
+bool GltfBlobCompiler::compile( cstring source_path, cstring output_path ) {
+    glTF::glTF gltf = gltf_load_file( source_path, false, task_scheduler );
+    // Every glTF has an asset version, it is missing only when the file did not load.
+    const bool compiled = gltf.asset.version.data != nullptr && gltf_compile_blob( gltf, output_path );
+    gltf_free( gltf );
+    return compiled;
+}
+
+} // namespace syi
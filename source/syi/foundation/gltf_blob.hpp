@@ -0,0 +1,184 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+#include "foundation/blob.hpp"
+#include "foundation/relative_data_structures.hpp"
+#include "foundation/resource_manager.hpp"
+
+namespace syi {
+
+namespace glTF {
+
+    // Compiled glTF //////////////////////////////////////////////////////
+    //
+    // Relocatable version of the parsed glTF: only Relative structures, so the file
+    // is memory mapped and used in place. Strings are interned at the end of the blob.
+    // Bump the version whenever one of these structures changes.
+    static const u32                k_blob_version = 2;
+
+    struct AssetBlob {
+        RelativeString              copyright;
+        RelativeString              generator;
+        RelativeString              min_version;
+        RelativeString              version;
+    };
+
+    struct BufferBlob {
+        i32                         byte_length;
+        RelativeString              uri;
+        RelativeString              name;
+    };
+
+    struct BufferViewBlob {
+        i32                         buffer;
+        i32                         byte_length;
+        i32                         byte_offset;
+        i32                         byte_stride;
+        i32                         target;
+        RelativeString              name;
+    };
+
+    struct NodeBlob {
+        i32                         camera;
+        i32                         mesh;
+        i32                         skin;
+        RelativeArray<i32>          children;
+        RelativeArray<f32>          matrix;
+        RelativeArray<f32>          rotation;
+        RelativeArray<f32>          scale;
+        RelativeArray<f32>          translation;
+        RelativeArray<f32>          weights;
+        RelativeString              name;
+    };
+
+    struct MeshPrimitiveAttributeBlob {
+        RelativeString              key;
+        i32                         accessor_index;
+    };
+
+    struct MeshPrimitiveTargetBlob {
+        RelativeArray<MeshPrimitiveAttributeBlob> attributes;
+    };
+
+    struct MeshPrimitiveBlob {
+        RelativeArray<MeshPrimitiveAttributeBlob> attributes;
+        RelativeArray<MeshPrimitiveTargetBlob> targets;
+        i32                         indices;
+        i32                         material;
+        i32                         mode;
+    };
+
+    struct MeshBlob {
+        RelativeArray<MeshPrimitiveBlob> primitives;
+        RelativeArray<f32>          weights;
+        RelativeString              name;
+    };
+
+    struct AccessorBlob {
+        i32                         buffer_view;
+        i32                         byte_offset;
+        i32                         component_type;
+        i32                         count;
+        RelativePointer<AccessorSparse> sparse;
+        u32                         normalized;
+        u32                         type;           // Accessor::Type
+        RelativeArray<f32>          max;
+        RelativeArray<f32>          min;
+    };
+
+    struct MaterialPBRMetallicRoughnessBlob {
+        RelativeArray<f32>          base_color_factor;
+        RelativePointer<TextureInfo> base_color_texture;
+        f32                         metallic_factor;
+        RelativePointer<TextureInfo> metallic_roughness_texture;
+        f32                         roughness_factor;
+    };
+
+    struct MaterialBlob {
+        f32                         alpha_cutoff;
+        RelativeString              alpha_mode;
+        u32                         double_sided;
+        RelativeArray<f32>          emissive_factor;
+        RelativePointer<TextureInfo> emissive_texture;
+        RelativePointer<MaterialNormalTextureInfo> normal_texture;
+        RelativePointer<MaterialOcclusionTextureInfo> occlusion_texture;
+        RelativePointer<MaterialPBRMetallicRoughnessBlob> pbr_metallic_roughness;
+        RelativeString              name;
+    };
+
+    struct TextureBlob {
+        i32                         sampler;
+        i32                         source;
+        RelativeString              name;
+    };
+
+    struct ImageBlob {
+        i32                         buffer_view;
+        RelativeString              mime_type;
+        RelativeString              uri;
+    };
+
+    struct SceneBlob {
+        RelativeArray<i32>          nodes;
+    };
+
+    struct SkinBlob {
+        i32                         inverse_bind_matrices_buffer_index;
+        i32                         skeleton_root_node_index;
+        RelativeArray<i32>          joints;
+    };
+
+    struct AnimationBlob {
+        RelativeArray<AnimationChannel> channels;
+        RelativeArray<AnimationSampler> samplers;
+    };
+
+    //
+    //
+    struct glTFBlob : public Blob {
+        AssetBlob                   asset;
+        i32                         scene;
+
+        RelativeArray<AccessorBlob> accessors;
+        RelativeArray<AnimationBlob> animations;
+        RelativeArray<BufferViewBlob> buffer_views;
+        RelativeArray<BufferBlob>   buffers;
+        RelativeArray<ImageBlob>    images;
+        RelativeArray<MaterialBlob> materials;
+        RelativeArray<MeshBlob>     meshes;
+        RelativeArray<NodeBlob>     nodes;
+        RelativeArray<Sampler>      samplers;
+        RelativeArray<SceneBlob>    scenes;
+        RelativeArray<SkinBlob>     skins;
+        RelativeArray<TextureBlob>  textures;
+    }; // struct glTFBlob
+
+} // namespace glTF
+
+    // Path of the compiled blob next to the glTF file: "scene.gltf" -> "scene.gltf.blob". Only for the deprecated use_compiled_blob of gltf_load_file.
+    void                            gltf_blob_path( cstring gltf_path, char* out_path, u32 max_size );
+
+    // Converts a parsed glTF into a blob file. Returns false if the file could not be written.
+    bool                            gltf_compile_blob( const glTF::glTF& gltf, cstring blob_path );
+
+    // Maps a compiled blob. Arrays and strings of out_gltf point into the read only mapping,
+    // that stays alive until gltf_free. Returns false if the blob is missing or from another version.
+    bool                            gltf_load_blob( cstring blob_path, glTF::glTF& out_gltf );
+
+    // GltfBlobCompiler ///////////////////////////////////////////////////
+    //
+    // glTF to blob behind the cache of the ResourceManager. The blob holds the structure of the
+    // scene only, so the glTF file is the whole key.
+    struct GltfBlobCompiler : public ResourceCompiler {
+
+        static constexpr cstring    k_type          = "syi_gltf_blob_type";
+
+        void                        init( enki::TaskScheduler* task_scheduler );
+
+        bool                        compile( cstring source_path, cstring output_path ) override;
+
+        enki::TaskScheduler*        task_scheduler  = nullptr;
+
+    }; // struct GltfBlobCompiler
+
+} // namespace syi
@@ -0,0 +1,171 @@
+#include "gltf_mesh_lod.hpp"
+
+#include "foundation/camera.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/assert.hpp"
+#include "foundation/log.hpp"
+
+#include "external/meshoptimizer/meshoptimizer.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace syi {
+
+static const f32 k_mesh_lod_min_reduction = 0.85f;      // A LOD keeping more of the previous indices ends the chain.
+
+// Mesh LODs //////////////////////////////////////////////////////////////
+
+static void mesh_lod_bounding_sphere( const f32* positions, u32 vertex_count, MeshLodChain& chain ) {
+    f32 minimum[ 3 ] = { positions[ 0 ], positions[ 1 ], positions[ 2 ] };
+    f32 maximum[ 3 ] = { positions[ 0 ], positions[ 1 ], positions[ 2 ] };
+    for ( u32 v = 1; v < vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            minimum[ c ] = min( minimum[ c ], positions[ v * 3 + c ] );
+            maximum[ c ] = max( maximum[ c ], positions[ v * 3 + c ] );
+        }
+    }
+
+    for ( u32 c = 0; c < 3; ++c ) {
+        chain.center[ c ] = ( minimum[ c ] + maximum[ c ] ) * 0.5f;
+    }
+
+    f32 radius_squared = 0.0f;
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        const f32 x = positions[ v * 3 ] - chain.center[ 0 ];
+        const f32 y = positions[ v * 3 + 1 ] - chain.center[ 1 ];
+        const f32 z = positions[ v * 3 + 2 ] - chain.center[ 2 ];
+        radius_squared = max( radius_squared, x * x + y * y + z * z );
+    }
+    chain.radius = sqrtf( radius_squared );
+}
+
+// Grows the index buffer of the chain to hold count more indices.
+static void mesh_lod_reserve( MeshLodChain& chain, u32& capacity, u32 count ) {
+    if ( chain.index_count + count <= capacity ) {
+        return;
+    }
+
+    capacity = max( capacity * 2, chain.index_count + count );
+    u32* indices = ( u32* )chain.allocator->allocate( sizeof( u32 ) * capacity, 16 );
+    RASSERT( indices );
+    memcpy( indices, chain.indices, sizeof( u32 ) * chain.index_count );
+    chain.allocator->deallocate( chain.indices );
+    chain.indices = indices;
+}
+
+void mesh_build_lods( const u32* indices, u32 index_count, const f32* positions, u32 vertex_count,
+                      const MeshLodOptions& options, Allocator* allocator, MeshLodChain& out_chain ) {
+    MeshLodChain& chain = out_chain;
+    chain = MeshLodChain{ };
+    chain.allocator = allocator;
+
+    const u32 max_lods = max( options.max_lods, 1u );
+    chain.lods = ( MeshLod* )allocator->allocate( sizeof( MeshLod ) * max_lods, 4 );
+    RASSERT( chain.lods );
+
+    // Enough for halving LODs, grown otherwise.
+    u32 capacity = index_count * 2;
+    chain.indices = ( u32* )allocator->allocate( sizeof( u32 ) * capacity, 16 );
+    RASSERT( chain.indices );
+    memcpy( chain.indices, indices, sizeof( u32 ) * index_count );
+    chain.index_count = index_count;
+    chain.lods[ 0 ] = { 0, index_count, 0.0f };
+    chain.lods_count = 1;
+
+    if ( vertex_count == 0 ) {
+        return;
+    }
+    mesh_lod_bounding_sphere( positions, vertex_count, chain );
+
+    if ( max_lods == 1 ) {
+        return;
+    }
+
+    const f32 error_scale = meshopt_simplifyScale( positions, vertex_count, sizeof( f32 ) * 3 );
+    u32* lod_indices = ( u32* )allocator->allocate( sizeof( u32 ) * index_count, 16 );
+    RASSERT( lod_indices );
+
+    // Every LOD is simplified from lod 0, so that its error is measured against the full surface.
+    f32 target_ratio = 1.0f;
+    for ( u32 l = 1; l < max_lods; ++l ) {
+        const MeshLod& previous = chain.lods[ l - 1 ];
+        target_ratio *= options.ratio;
+        const u32 target_index_count = ( u32 )( index_count * target_ratio ) / 3 * 3;
+
+        f32 error = 0.0f;
+        u32 lod_index_count = ( u32 )meshopt_simplify( lod_indices, indices, index_count, positions, vertex_count, sizeof( f32 ) * 3,
+                                                       target_index_count, options.target_error, &error );
+
+        if ( options.sloppy && lod_index_count > previous.index_count * k_mesh_lod_min_reduction ) {
+            // Any error: it is stored, and the selector keeps the LOD for far enough objects only.
+            lod_index_count = ( u32 )meshopt_simplifySloppy( lod_indices, indices, index_count, positions, vertex_count, sizeof( f32 ) * 3,
+                                                             target_index_count, 1.0f, &error );
+        }
+
+        if ( lod_index_count == 0 || lod_index_count > previous.index_count * k_mesh_lod_min_reduction ) {
+            break;
+        }
+
+        meshopt_optimizeVertexCache( lod_indices, lod_indices, lod_index_count, vertex_count );
+
+        mesh_lod_reserve( chain, capacity, lod_index_count );
+        memcpy( chain.indices + chain.index_count, lod_indices, sizeof( u32 ) * lod_index_count );
+        chain.lods[ l ] = { chain.index_count, lod_index_count, max( error * error_scale, previous.error ) };
+        chain.index_count += lod_index_count;
+        chain.lods_count = l + 1;
+    }
+
+    allocator->deallocate( lod_indices );
+}
+
+void mesh_free_lods( MeshLodChain& chain ) {
+    if ( chain.indices ) {
+        chain.allocator->deallocate( chain.indices );
+    }
+    if ( chain.lods ) {
+        chain.allocator->deallocate( chain.lods );
+    }
+
+    chain.indices = nullptr;
+    chain.lods = nullptr;
+    chain.index_count = chain.lods_count = 0;
+}
+
+// MeshLodSelector ////////////////////////////////////////////////////////
+
+void MeshLodSelector::init( const Camera& camera, f32 threshold_pixels ) {
+    init( camera.view_projection, camera.viewport_height, threshold_pixels );
+}
+
+void MeshLodSelector::init( const mat4s& view_projection, f32 viewport_height, f32 threshold_pixels ) {
+    // Clip y of a world offset is its dot with the y row, divided by w for normalized coordinates.
+    const vec3s y_row = { view_projection.m01, view_projection.m11, view_projection.m21 };
+    pixels_per_unit = 0.5f * viewport_height * sqrtf( y_row.x * y_row.x + y_row.y * y_row.y + y_row.z * y_row.z );
+
+    depth_row = { view_projection.m03, view_projection.m13, view_projection.m23, view_projection.m33 };
+    perspective = depth_row.x != 0.0f || depth_row.y != 0.0f || depth_row.z != 0.0f;
+    threshold = threshold_pixels;
+}
+
+u32 MeshLodSelector::select( const MeshLod* lods, u32 lods_count, const vec3s& center, f32 radius, f32 world_scale ) const {
+    f32 depth = 1.0f;
+    if ( perspective ) {
+        depth = depth_row.x * center.x + depth_row.y * center.y + depth_row.z * center.z + depth_row.w - radius;
+        if ( depth <= 0.0f ) {
+            // The camera is inside the bounds.
+            return 0;
+        }
+    }
+
+    const f32 max_error = threshold * depth / ( pixels_per_unit * world_scale );
+
+    u32 lod = 0;
+    while ( lod + 1 < lods_count && lods[ lod + 1 ].error <= max_error ) {
+        ++lod;
+    }
+    return lod;
+}
+
+} // namespace syi
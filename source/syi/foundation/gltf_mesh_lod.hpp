@@ -0,0 +1,76 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace syi {
+
+    struct Allocator;
+    struct Camera;
+
+    // Mesh LODs //////////////////////////////////////////////////////////
+    //
+    // A range of the shared index buffer of a primitive. error is the largest distance between
+    // the simplified and the full surface, in object units, never decreasing along the chain.
+    struct MeshLod {
+        u32                         index_offset;
+        u32                         index_count;
+        f32                         error;
+    }; // struct MeshLod
+
+    //
+    // All the LODs of a primitive on its single vertex buffer, lod 0 being the source indices.
+    struct MeshLodChain {
+        u32*                        indices         = nullptr;
+        u32                         index_count     = 0;        // Of all the LODs.
+
+        MeshLod*                    lods            = nullptr;
+        u32                         lods_count      = 0;
+
+        f32                         center[ 3 ]     = { };      // Bounding sphere of the vertices, for the selection.
+        f32                         radius          = 0.0f;
+
+        Allocator*                  allocator       = nullptr;
+    }; // struct MeshLodChain
+
+    //
+    //
+    struct MeshLodOptions {
+        u32                         max_lods        = 4;        // Lod 0 included, 1 only copies the source.
+        f32                         ratio           = 0.5f;     // Triangles kept by each LOD from the previous one.
+        f32                         target_error    = 0.02f;    // Relative to the mesh extent, above it meshopt_simplify stops.
+        bool                        sloppy          = true;     // Fall back to meshopt_simplifySloppy when the topology blocks the simplification.
+    }; // struct MeshLodOptions
+
+    // Builds the chain from triangles on 3 float positions, best already optimized for the vertex
+    // cache. The chain stops early when a LOD does not remove enough triangles.
+    void                            mesh_build_lods( const u32* indices, u32 index_count, const f32* positions, u32 vertex_count,
+                                                     const MeshLodOptions& options, Allocator* allocator, MeshLodChain& out_chain );
+    void                            mesh_free_lods( MeshLodChain& chain );
+
+    // MeshLodSelector ////////////////////////////////////////////////////
+    //
+    // Picks the coarsest LOD whose error, projected on the screen from the closest point of
+    // the bounding sphere, stays under a threshold in pixels.
+    //
+    // Usage:
+    //   MeshLodSelector selector;
+    //   selector.init( camera, 1.0f );
+    //   const MeshLod& lod = lods[ selector.select( lods, lods_count, world_center, world_radius, world_scale ) ];
+    struct MeshLodSelector {
+
+        void                        init( const Camera& camera, f32 threshold_pixels );
+        void                        init( const mat4s& view_projection, f32 viewport_height, f32 threshold_pixels );
+
+        // center and radius in world space, world_scale is the largest scale of the world matrix, applied to the errors.
+        u32                         select( const MeshLod* lods, u32 lods_count, const vec3s& center, f32 radius, f32 world_scale = 1.0f ) const;
+
+        vec4s                       depth_row;                  // Row of the view projection giving clip w.
+        f32                         pixels_per_unit = 0.0f;     // Pixels covered by one world unit at a depth of 1.
+        f32                         threshold       = 1.0f;
+        bool                        perspective     = true;
+
+    }; // struct MeshLodSelector
+
+} // namespace syi
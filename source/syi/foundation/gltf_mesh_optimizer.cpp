@@ -0,0 +1,645 @@
+#include "gltf_mesh_optimizer.hpp"
+#include "gltf_accessor.hpp"
+
+#include "foundation/blob_serialization.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/file.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/log.hpp"
+#include "foundation/vertex_quantization.hpp"
+#include "foundation/hash_map.hpp"
+
+#include "external/meshoptimizer/meshoptimizer.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_mesh_cache_size = 16;                // FIFO cache of the statistics, a common size for recent GPUs.
+
+// Mesh optimization //////////////////////////////////////////////////////
+
+static MeshOptimizerStatistics mesh_analyze( const u32* indices, u32 index_count, u32 vertex_count, u32 vertex_size ) {
+    const meshopt_VertexCacheStatistics cache = meshopt_analyzeVertexCache( indices, index_count, vertex_count, k_mesh_cache_size, 0, 0 );
+    const meshopt_VertexFetchStatistics fetch = meshopt_analyzeVertexFetch( indices, index_count, vertex_count, vertex_size );
+    return { cache.acmr, cache.atvr, fetch.overfetch };
+}
+
+static bool mesh_load_stream( OptimizedStream& stream, const glTF::glTF& gltf, i32 accessor_index, u8* const* buffers_data, u32 vertex_count, Allocator* allocator ) {
+    AccessorView view;
+    if ( !view.init( gltf, accessor_index, buffers_data ) || view.count != vertex_count || view.component_count > 16 ) {
+        rprint( "Mesh optimizer: cannot read attribute %s\n", stream.attribute );
+        return false;
+    }
+
+    stream.component_count = view.component_count;
+    stream.data = ( f32* )allocator->allocate( sizeof( f32 ) * stream.component_count * vertex_count, 16 );
+    RASSERT( stream.data );
+    view.read_floats( stream.data );
+    return true;
+}
+
+// Applies a vertex remap to the indices and to all the streams.
+static void mesh_remap( OptimizedPrimitive& primitive, const u32* remap, u32 new_vertex_count ) {
+    meshopt_remapIndexBuffer( primitive.indices, primitive.indices, primitive.index_count, remap );
+
+    for ( u32 s = 0; s < primitive.streams_count; ++s ) {
+        OptimizedStream& stream = primitive.streams[ s ];
+        const sizet vertex_size = sizeof( f32 ) * stream.component_count;
+
+        f32* data = ( f32* )primitive.allocator->allocate( vertex_size * new_vertex_count, 16 );
+        RASSERT( data );
+        meshopt_remapVertexBuffer( data, stream.data, primitive.vertex_count, vertex_size, remap );
+        primitive.allocator->deallocate( stream.data );
+        stream.data = data;
+    }
+
+    primitive.vertex_count = new_vertex_count;
+}
+
+bool mesh_optimize_primitive( const glTF::glTF& gltf, const glTF::MeshPrimitive& primitive, u8* const* buffers_data,
+                              const MeshOptimizerOptions& options, Allocator* allocator, OptimizedPrimitive& out_primitive ) {
+    OptimizedPrimitive& result = out_primitive;
+    result = OptimizedPrimitive{ };
+    result.allocator = allocator;
+
+    if ( primitive.mode != glTF::INVALID_INT_VALUE && primitive.mode != 4 ) {
+        rprint( "Mesh optimizer: mode %d is not a triangle list\n", primitive.mode );
+        return false;
+    }
+
+    AccessorView positions;
+    if ( !positions.init( gltf, gltf_get_attribute_accessor_index( primitive.attributes, primitive.attribute_count, "POSITION" ), buffers_data ) ) {
+        rprint( "Mesh optimizer: cannot read attribute POSITION\n" );
+        return false;
+    }
+    result.vertex_count = positions.count;
+
+    // Indices, generated for non indexed primitives.
+    AccessorView indices;
+    const bool indexed = primitive.indices != glTF::INVALID_INT_VALUE;
+    if ( indexed && !indices.init( gltf, primitive.indices, buffers_data ) ) {
+        rprint( "Mesh optimizer: cannot read indices accessor %d\n", primitive.indices );
+        return false;
+    }
+    result.index_count = indexed ? indices.count : result.vertex_count;
+    if ( result.index_count == 0 || result.index_count % 3 != 0 ) {
+        rprint( "Mesh optimizer: %u indices are not whole triangles\n", result.index_count );
+        return false;
+    }
+
+    result.indices = ( u32* )allocator->allocate( sizeof( u32 ) * result.index_count, 16 );
+    RASSERT( result.indices );
+    if ( indexed ) {
+        indices.read_indices( result.indices );
+    } else {
+        for ( u32 i = 0; i < result.index_count; ++i ) {
+            result.indices[ i ] = i;
+        }
+    }
+
+    // Attributes first, so that POSITION is found by name, then the morph targets.
+    u32 streams_count = primitive.attribute_count;
+    for ( u32 t = 0; t < primitive.targets_count; ++t ) {
+        streams_count += primitive.targets[ t ].attribute_count;
+    }
+
+    result.streams = ( OptimizedStream* )allocator->allocate( sizeof( OptimizedStream ) * streams_count, 64 );
+    RASSERT( result.streams );
+    memset( result.streams, 0, sizeof( OptimizedStream ) * streams_count );
+
+    bool loaded = true;
+    i32 position_stream = -1;
+    for ( u32 a = 0; a < primitive.attribute_count && loaded; ++a ) {
+        OptimizedStream& stream = result.streams[ result.streams_count++ ];
+        snprintf( stream.attribute, sizeof( stream.attribute ), "%s", primitive.attributes[ a ].key.data );
+        loaded = mesh_load_stream( stream, gltf, primitive.attributes[ a ].accessor_index, buffers_data, result.vertex_count, allocator );
+        position_stream = strcmp( stream.attribute, "POSITION" ) == 0 ? ( i32 )a : position_stream;
+    }
+    for ( u32 t = 0; t < primitive.targets_count && loaded; ++t ) {
+        const glTF::MeshPrimitive::Target& target = primitive.targets[ t ];
+        for ( u32 a = 0; a < target.attribute_count && loaded; ++a ) {
+            OptimizedStream& stream = result.streams[ result.streams_count++ ];
+            snprintf( stream.attribute, sizeof( stream.attribute ), "TARGET%u_%s", t, target.attributes[ a ].key.data );
+            loaded = mesh_load_stream( stream, gltf, target.attributes[ a ].accessor_index, buffers_data, result.vertex_count, allocator );
+        }
+    }
+
+    for ( u32 i = 0; i < result.index_count && loaded; ++i ) {
+        loaded = result.indices[ i ] < result.vertex_count;
+        if ( !loaded ) {
+            rprint( "Mesh optimizer: index %u is %u, out of %u vertices\n", i, result.indices[ i ], result.vertex_count );
+        }
+    }
+
+    if ( loaded && result.streams[ position_stream ].component_count != 3 ) {
+        rprint( "Mesh optimizer: POSITION has %u components instead of 3\n", result.streams[ position_stream ].component_count );
+        loaded = false;
+    }
+
+    if ( !loaded ) {
+        mesh_free_optimized_primitive( result );
+        return false;
+    }
+
+    u32 vertex_size = 0;
+    for ( u32 s = 0; s < result.streams_count; ++s ) {
+        vertex_size += sizeof( f32 ) * result.streams[ s ].component_count;
+    }
+    // Deduplication on the bytes of all the streams.
+    meshopt_Stream* meshopt_streams = ( meshopt_Stream* )allocator->allocate( sizeof( meshopt_Stream ) * result.streams_count, 8 );
+    u32* remap = ( u32* )allocator->allocate( sizeof( u32 ) * result.vertex_count, 16 );
+    RASSERT( meshopt_streams && remap );
+    for ( u32 s = 0; s < result.streams_count; ++s ) {
+        const sizet size = sizeof( f32 ) * result.streams[ s ].component_count;
+        meshopt_streams[ s ] = { result.streams[ s ].data, size, size };
+    }
+
+    const u32 unique_vertex_count = ( u32 )meshopt_generateVertexRemapMulti( remap, result.indices, result.index_count, result.vertex_count,
+                                                                              meshopt_streams, result.streams_count );
+    result.source_vertex_count = result.vertex_count;
+    mesh_remap( result, remap, unique_vertex_count );
+
+    // Measured on the unique vertices, so that the ATVR before and after compare.
+    result.before = mesh_analyze( result.indices, result.index_count, result.vertex_count, vertex_size );
+
+    // Triangle order: vertex cache, then overdraw within the allowed cache loss.
+    meshopt_optimizeVertexCache( result.indices, result.indices, result.index_count, result.vertex_count );
+    if ( options.overdraw_threshold > 0.0f ) {
+        meshopt_optimizeOverdraw( result.indices, result.indices, result.index_count, result.streams[ position_stream ].data,
+                                  result.vertex_count, sizeof( f32 ) * 3, options.overdraw_threshold );
+    }
+
+    // Vertex order: first use by the triangles.
+    const u32 fetched_vertex_count = ( u32 )meshopt_optimizeVertexFetchRemap( remap, result.indices, result.index_count, result.vertex_count );
+    mesh_remap( result, remap, fetched_vertex_count );
+
+    allocator->deallocate( remap );
+    allocator->deallocate( meshopt_streams );
+
+    result.after = mesh_analyze( result.indices, result.index_count, result.vertex_count, vertex_size );
+
+    if ( options.meshlet_max_vertices ) {
+        meshlet_build( result.indices, result.index_count, result.streams[ position_stream ].data, result.vertex_count, options.meshlet_max_vertices,
+                       options.meshlet_max_triangles, options.meshlet_cone_weight, allocator, result.meshlets );
+    }
+
+    mesh_build_lods( result.indices, result.index_count, result.streams[ position_stream ].data, result.vertex_count, options.lod, allocator, result.lods );
+    return true;
+}
+
+void mesh_free_optimized_primitive( OptimizedPrimitive& primitive ) {
+    meshlet_free( primitive.meshlets );
+    mesh_free_lods( primitive.lods );
+
+    for ( u32 s = 0; s < primitive.streams_count; ++s ) {
+        if ( primitive.streams[ s ].data ) {
+            primitive.allocator->deallocate( primitive.streams[ s ].data );
+        }
+    }
+
+    if ( primitive.streams ) {
+        primitive.allocator->deallocate( primitive.streams );
+    }
+    if ( primitive.indices ) {
+        primitive.allocator->deallocate( primitive.indices );
+    }
+
+    primitive.streams = nullptr;
+    primitive.indices = nullptr;
+    primitive.streams_count = primitive.index_count = primitive.vertex_count = primitive.source_vertex_count = 0;
+}
+
+// Compilation ////////////////////////////////////////////////////////////
+
+void gltf_meshes_path( cstring gltf_path, char* out_path, u32 max_size ) {
+    snprintf( out_path, max_size, "%s.meshes", gltf_path );
+}
+
+// Encoded data has any size: allocations are padded to keep the following structures 4 bytes aligned.
+template <typename T>
+static void mesh_blob_set_bytes( BlobSerializer& serializer, RelativeArray<T>& destination, const void* source, u32 size ) {
+    if ( size == 0 ) {
+        destination.set_empty();
+        return;
+    }
+
+    char* memory = serializer.allocate_static( ( size + 3 ) & ~3u );
+    RASSERT( memory );
+    memcpy( memory, source, size );
+    destination.set( memory, size / sizeof( T ) );
+}
+
+static u32 mesh_stream_bound( const OptimizedStream& stream, u32 vertex_count ) {
+    const sizet vertex_size = sizeof( f32 ) * stream.component_count;
+    return ( u32 )max( meshopt_encodeVertexBufferBound( vertex_count, vertex_size ), vertex_size * vertex_count );
+}
+
+static u32 mesh_indices_bound( const OptimizedPrimitive& primitive ) {
+    const u32 index_count = primitive.lods.index_count;
+    return ( u32 )max( meshopt_encodeIndexBufferBound( index_count, primitive.vertex_count ), sizeof( u32 ) * index_count );
+}
+
+// Morph target deltas and unknown attributes stay in floats.
+static VertexStreamFormat mesh_stream_format( const OptimizedStream& stream, const MeshOptimizerOptions& options ) {
+    if ( !options.quantize ) {
+        return VertexStreamFormat_Float;
+    }
+
+    if ( strcmp( stream.attribute, "POSITION" ) == 0 && stream.component_count == 3 ) {
+        return options.quantize_positions ? VertexStreamFormat_Position16 : VertexStreamFormat_Float;
+    }
+    if ( ( strcmp( stream.attribute, "NORMAL" ) == 0 && stream.component_count == 3 ) || ( strcmp( stream.attribute, "TANGENT" ) == 0 && stream.component_count == 4 ) ) {
+        return VertexStreamFormat_Octahedral8;
+    }
+    if ( strncmp( stream.attribute, "TEXCOORD_", 9 ) == 0 && stream.component_count == 2 ) {
+        return VertexStreamFormat_Half2;
+    }
+    return VertexStreamFormat_Float;
+}
+
+// Writes the stream in its format into destination, and returns the largest error of the decoded stream.
+static f32 mesh_quantize_stream( const OptimizedStream& stream, u32 vertex_count, VertexStreamFormat format, const VertexDequantization& dequantization,
+                                 Allocator* allocator, u8* destination, f32* decoded ) {
+    switch ( format ) {
+        case VertexStreamFormat_Position16:
+            vertex_quantize_positions( stream.data, vertex_count, dequantization, ( u16* )destination );
+            vertex_dequantize_positions( ( u16* )destination, vertex_count, dequantization, decoded );
+            break;
+        case VertexStreamFormat_Octahedral8:
+            vertex_quantize_octahedral( stream.data, vertex_count, stream.component_count, allocator, ( i8* )destination );
+            vertex_dequantize_octahedral( ( i8* )destination, vertex_count, stream.component_count, decoded );
+            break;
+        case VertexStreamFormat_Half2:
+            vertex_quantize_half2( stream.data, vertex_count, ( u16* )destination );
+            vertex_dequantize_half2( ( u16* )destination, vertex_count, decoded );
+            break;
+        default:
+            memcpy( destination, stream.data, sizeof( f32 ) * stream.component_count * vertex_count );
+            return 0.0f;
+    }
+
+    return vertex_quantization_error( format, stream.data, decoded, vertex_count, stream.component_count );
+}
+
+// Bounding box of the positions of all the primitives of each mesh.
+static void mesh_position_dequantization( const OptimizedPrimitive* primitives, const u32* primitive_meshes, u32 primitives_count,
+                                          VertexDequantization* mesh_dequantization, u32 meshes_count ) {
+    for ( u32 m = 0; m < meshes_count; ++m ) {
+        f32 minimum[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        f32 maximum[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for ( u32 i = 0; i < primitives_count; ++i ) {
+            if ( primitive_meshes[ i * 2 ] != m ) {
+                continue;
+            }
+
+            const OptimizedPrimitive& primitive = primitives[ i ];
+            for ( u32 s = 0; s < primitive.streams_count; ++s ) {
+                if ( strcmp( primitive.streams[ s ].attribute, "POSITION" ) != 0 ) {
+                    continue;
+                }
+                for ( u32 v = 0; v < primitive.vertex_count; ++v ) {
+                    for ( u32 c = 0; c < 3; ++c ) {
+                        minimum[ c ] = min( minimum[ c ], primitive.streams[ s ].data[ v * 3 + c ] );
+                        maximum[ c ] = max( maximum[ c ], primitive.streams[ s ].data[ v * 3 + c ] );
+                    }
+                }
+            }
+        }
+
+        vertex_dequantization_init( mesh_dequantization[ m ], minimum, maximum );
+    }
+}
+
+bool gltf_compile_meshes( const glTF::glTF& gltf, u8* const* buffers_data, cstring path, const MeshOptimizerOptions& options ) {
+    Allocator* allocator = &MemoryService::instance()->system_allocator;
+
+    u32 primitives_count = 0;
+    for ( u32 m = 0; m < gltf.meshes_count; ++m ) {
+        primitives_count += gltf.meshes[ m ].primitives_count;
+    }
+
+    OptimizedPrimitive* primitives = ( OptimizedPrimitive* )allocator->allocate( sizeof( OptimizedPrimitive ) * ( primitives_count + 1 ), 64 );
+    u32* primitive_meshes = ( u32* )allocator->allocate( sizeof( u32 ) * 2 * ( primitives_count + 1 ), 4 );
+    RASSERT( primitives && primitive_meshes );
+
+    // Optimize, and size the blob with the encoder bounds.
+    sizet blob_size = sizeof( glTF::MeshAssetBlob );
+    u32 scratch_size = 0;
+    u32 stream_size = 0;
+    u32 optimized_count = 0;
+    for ( u32 m = 0; m < gltf.meshes_count; ++m ) {
+        for ( u32 p = 0; p < gltf.meshes[ m ].primitives_count; ++p ) {
+            OptimizedPrimitive& primitive = primitives[ optimized_count ];
+            if ( !mesh_optimize_primitive( gltf, gltf.meshes[ m ].primitives[ p ], buffers_data, options, allocator, primitive ) ) {
+                rprint( "Mesh %u primitive %u: skipped\n", m, p );
+                continue;
+            }
+
+            rprint( "Mesh %u primitive %u: %u triangles, vertices %u -> %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overfetch %.3f -> %.3f\n", m, p,
+                    primitive.index_count / 3, primitive.source_vertex_count, primitive.vertex_count,
+                    primitive.before.acmr, primitive.after.acmr, primitive.before.atvr, primitive.after.atvr, primitive.before.overfetch, primitive.after.overfetch );
+            for ( u32 l = 1; l < primitive.lods.lods_count; ++l ) {
+                rprint( "    lod %u: %u triangles, error %g\n", l, primitive.lods.lods[ l ].index_count / 3, primitive.lods.lods[ l ].error );
+            }
+
+            primitive_meshes[ optimized_count * 2 ] = m;
+            primitive_meshes[ optimized_count * 2 + 1 ] = p;
+            ++optimized_count;
+
+            u32 primitive_scratch = mesh_indices_bound( primitive );
+            blob_size += sizeof( glTF::MeshPrimitiveAssetBlob ) + primitive_scratch + 4;
+            for ( u32 s = 0; s < primitive.streams_count; ++s ) {
+                const u32 stream_bound = mesh_stream_bound( primitive.streams[ s ], primitive.vertex_count );
+                primitive_scratch = max( primitive_scratch, stream_bound );
+                stream_size = max( stream_size, ( u32 )sizeof( f32 ) * primitive.streams[ s ].component_count * primitive.vertex_count );
+                blob_size += sizeof( glTF::MeshStreamBlob ) + strlen( primitive.streams[ s ].attribute ) + 1 + stream_bound + 8;
+            }
+
+            const MeshletData& meshlets = primitive.meshlets;
+            blob_size += ( sizeof( Meshlet ) + sizeof( MeshletBounds ) ) * meshlets.meshlets_count + sizeof( u32 ) * meshlets.vertices_count + meshlets.triangles_size;
+            blob_size += sizeof( MeshLod ) * primitive.lods.lods_count;
+            scratch_size = max( scratch_size, primitive_scratch );
+        }
+    }
+
+    // Quantized streams, and their decoding for the error report.
+    u8* scratch = ( u8* )allocator->allocate( scratch_size + stream_size * 2 + 16, 16 );
+    RASSERT( scratch );
+    u8* quantized = scratch + ( ( scratch_size + 15 ) & ~15u );
+    f32* decoded = ( f32* )( quantized + stream_size );
+
+    VertexDequantization* mesh_dequantization = ( VertexDequantization* )allocator->allocate( sizeof( VertexDequantization ) * ( gltf.meshes_count + 1 ), 4 );
+    RASSERT( mesh_dequantization );
+    mesh_position_dequantization( primitives, primitive_meshes, optimized_count, mesh_dequantization, gltf.meshes_count );
+    sizet float_vertex_bytes = 0, quantized_vertex_bytes = 0;
+
+    BlobSerializer serializer;
+    glTF::MeshAssetBlob* blob = serializer.write_and_prepare<glTF::MeshAssetBlob>( allocator, glTF::k_mesh_blob_version, blob_size );
+    memset( serializer.blob_memory + sizeof( BlobHeader ), 0, blob_size );
+
+    if ( optimized_count == 0 ) {
+        blob->primitives.set_empty();
+    } else {
+        serializer.allocate_and_set( blob->primitives, optimized_count );
+    }
+
+    for ( u32 i = 0; i < optimized_count; ++i ) {
+        const OptimizedPrimitive& source = primitives[ i ];
+        glTF::MeshPrimitiveAssetBlob& primitive = blob->primitives[ i ];
+        primitive.mesh = primitive_meshes[ i * 2 ];
+        primitive.primitive = primitive_meshes[ i * 2 + 1 ];
+        primitive.vertex_count = source.vertex_count;
+        primitive.index_count = source.lods.index_count;
+        primitive.encoded = options.encode ? 1 : 0;
+        primitive.before = source.before;
+        primitive.after = source.after;
+        primitive.position_dequantization = mesh_dequantization[ primitive.mesh ];
+
+        serializer.allocate_and_set( primitive.streams, source.streams_count );
+
+        if ( options.encode ) {
+            const u32 size = ( u32 )meshopt_encodeIndexBuffer( scratch, scratch_size, source.lods.indices, source.lods.index_count );
+            mesh_blob_set_bytes( serializer, primitive.indices, scratch, size );
+        } else {
+            mesh_blob_set_bytes( serializer, primitive.indices, source.lods.indices, sizeof( u32 ) * source.lods.index_count );
+        }
+
+        for ( u32 s = 0; s < source.streams_count; ++s ) {
+            const OptimizedStream& source_stream = source.streams[ s ];
+            glTF::MeshStreamBlob& stream = primitive.streams[ s ];
+            const VertexStreamFormat format = mesh_stream_format( source_stream, options );
+            const u32 vertex_size = vertex_format_size( format, source_stream.component_count );
+
+            stream.component_count = source_stream.component_count;
+            stream.format = format;
+            stream.vertex_size = vertex_size;
+            mesh_blob_set_bytes( serializer, stream.attribute, source_stream.attribute, ( u32 )strlen( source_stream.attribute ) + 1 );
+            stream.attribute.size -= 1;
+
+            const f32 error = mesh_quantize_stream( source_stream, source.vertex_count, format, primitive.position_dequantization, allocator, quantized, decoded );
+            if ( format != VertexStreamFormat_Float ) {
+                rprint( "    %s: %u -> %u bytes per vertex, error %g\n", source_stream.attribute, ( u32 )sizeof( f32 ) * stream.component_count, vertex_size, error );
+            }
+            float_vertex_bytes += sizeof( f32 ) * stream.component_count * source.vertex_count;
+            quantized_vertex_bytes += vertex_size * source.vertex_count;
+
+            if ( options.encode ) {
+                const u32 size = ( u32 )meshopt_encodeVertexBuffer( scratch, scratch_size, quantized, source.vertex_count, vertex_size );
+                mesh_blob_set_bytes( serializer, stream.data, scratch, size );
+            } else {
+                mesh_blob_set_bytes( serializer, stream.data, quantized, vertex_size * source.vertex_count );
+            }
+        }
+
+        const MeshletData& meshlets = source.meshlets;
+        mesh_blob_set_bytes( serializer, primitive.meshlets, meshlets.meshlets, sizeof( Meshlet ) * meshlets.meshlets_count );
+        mesh_blob_set_bytes( serializer, primitive.meshlet_bounds, meshlets.bounds, sizeof( MeshletBounds ) * meshlets.meshlets_count );
+        mesh_blob_set_bytes( serializer, primitive.meshlet_vertices, meshlets.vertices, sizeof( u32 ) * meshlets.vertices_count );
+        mesh_blob_set_bytes( serializer, primitive.meshlet_triangles, meshlets.triangles, meshlets.triangles_size );
+
+        mesh_blob_set_bytes( serializer, primitive.lods, source.lods.lods, sizeof( MeshLod ) * source.lods.lods_count );
+        memcpy( primitive.center, source.lods.center, sizeof( primitive.center ) );
+        primitive.radius = source.lods.radius;
+    }
+
+    if ( options.quantize ) {
+        rprint( "Vertex streams: %zu -> %zu bytes\n", float_vertex_bytes, quantized_vertex_bytes );
+    }
+
+    bool written = false;
+    FileHandle file;
+    file_open( path, "wb", &file );
+    if ( file ) {
+        written = file_write( ( u8* )serializer.blob_memory, 1, serializer.allocated_offset, file ) == serializer.allocated_offset;
+        file_close( file );
+    }
+
+    if ( !written ) {
+        rprint( "Error: cannot write compiled meshes %s\n", path );
+    }
+
+    for ( u32 i = 0; i < optimized_count; ++i ) {
+        mesh_free_optimized_primitive( primitives[ i ] );
+    }
+
+    serializer.shutdown();
+    allocator->deallocate( mesh_dequantization );
+    allocator->deallocate( scratch );
+    allocator->deallocate( primitive_meshes );
+    allocator->deallocate( primitives );
+
+    return written;
+}
+
+// Loading ////////////////////////////////////////////////////////////////
+
+const glTF::MeshAssetBlob* gltf_map_meshes( cstring path, FileMapping& out_mapping ) {
+    if ( !file_map_read_only( path, &out_mapping ) ) {
+        return nullptr;
+    }
+
+    const glTF::MeshAssetBlob* blob = ( const glTF::MeshAssetBlob* )out_mapping.data;
+    if ( out_mapping.size < sizeof( glTF::MeshAssetBlob ) || blob->header.version != glTF::k_mesh_blob_version || !blob->header.mappable ) {
+        rprint( "Compiled meshes %s are outdated, ignoring them\n", path );
+        file_unmap( &out_mapping );
+        return nullptr;
+    }
+
+    return blob;
+}
+
+bool mesh_decode_indices( const glTF::MeshPrimitiveAssetBlob& primitive, u32* destination ) {
+    if ( primitive.encoded ) {
+        return meshopt_decodeIndexBuffer( destination, primitive.index_count, sizeof( u32 ), primitive.indices.get(), primitive.indices.size ) == 0;
+    }
+
+    if ( primitive.indices.size != sizeof( u32 ) * primitive.index_count ) {
+        return false;
+    }
+    memcpy( destination, primitive.indices.get(), primitive.indices.size );
+    return true;
+}
+
+bool mesh_decode_stream( const glTF::MeshPrimitiveAssetBlob& primitive, u32 stream_index, void* destination ) {
+    const glTF::MeshStreamBlob& stream = primitive.streams[ stream_index ];
+    const sizet vertex_size = stream.vertex_size;
+
+    if ( primitive.encoded ) {
+        return meshopt_decodeVertexBuffer( destination, primitive.vertex_count, vertex_size, stream.data.get(), stream.data.size ) == 0;
+    }
+
+    if ( stream.data.size != vertex_size * primitive.vertex_count ) {
+        return false;
+    }
+    memcpy( destination, stream.data.get(), stream.data.size );
+    return true;
+}
+
+// MeshResourceCompiler ///////////////////////////////////////////////////
+
+// Buffer uris are relative to the folder of the glTF file.
+static void mesh_buffer_path( cstring gltf_path, cstring uri, char* out_path, u32 max_size ) {
+    cstring separator = strrchr( gltf_path, '/' );
+    cstring back_separator = strrchr( gltf_path, '\\' );
+    if ( back_separator > separator ) {
+        separator = back_separator;
+    }
+
+    const i32 directory_length = separator ? ( i32 )( separator - gltf_path + 1 ) : 0;
+    snprintf( out_path, max_size, "%.*s%s", directory_length, gltf_path, uri );
+}
+
+// Maps the buffers with an uri, the one of a .glb stays null and is read from the binary chunk.
+static bool mesh_map_buffers( const glTF::glTF& gltf, cstring gltf_path, FileMapping* mappings ) {
+    for ( u32 b = 0; b < gltf.buffers_count; ++b ) {
+        const StringBuffer& uri = gltf.buffers[ b ].uri;
+        if ( uri.data == nullptr || uri.data[ 0 ] == 0 ) {
+            continue;
+        }
+
+        if ( strncmp( uri.data, "data:", 5 ) == 0 ) {
+            rprint( "Mesh optimizer: buffer %u is an embedded data uri, not supported\n", b );
+            return false;
+        }
+
+        char buffer_path[ 512 ];
+        mesh_buffer_path( gltf_path, uri.data, buffer_path, sizeof( buffer_path ) );
+        if ( !file_map_read_only( buffer_path, &mappings[ b ] ) ) {
+            rprint( "Mesh optimizer: cannot read buffer %s\n", buffer_path );
+            return false;
+        }
+    }
+    return true;
+}
+
+static void mesh_unmap_buffers( const glTF::glTF& gltf, FileMapping* mappings ) {
+    for ( u32 b = 0; b < gltf.buffers_count; ++b ) {
+        if ( mappings[ b ].data ) {
+            file_unmap( &mappings[ b ] );
+        }
+    }
+}
+
+void MeshResourceCompiler::init( const MeshOptimizerOptions& options_, enki::TaskScheduler* task_scheduler_ ) {
+    options = options_;
+    task_scheduler = task_scheduler_;
+    version = glTF::k_mesh_blob_version;
+    extension = "meshes";
+}
+
+u64 MeshResourceCompiler::hash_inputs( cstring source_path, u64 seed ) {
+    // Field by field, the padding of the options is undefined.
+    u64 key = hash_calculate( options.overdraw_threshold, seed );
+    key = hash_calculate( options.encode, key );
+    key = hash_calculate( options.meshlet_max_vertices, key );
+    key = hash_calculate( options.meshlet_max_triangles, key );
+    key = hash_calculate( options.meshlet_cone_weight, key );
+    key = hash_calculate( options.lod.max_lods, key );
+    key = hash_calculate( options.lod.ratio, key );
+    key = hash_calculate( options.lod.target_error, key );
+    key = hash_calculate( options.lod.sloppy, key );
+    key = hash_calculate( options.quantize, key );
+    key = hash_calculate( options.quantize_positions, key );
+
+    // The glTF is parsed for its buffer uris. When a buffer is missing the key stays as is:
+    // the compilation fails and reports it.
+    glTF::glTF gltf = gltf_load_file( source_path, false, task_scheduler );
+    if ( gltf.buffers_count ) {
+        Allocator* allocator = &MemoryService::instance()->system_allocator;
+        FileMapping* mappings = ( FileMapping* )allocator->allocate( sizeof( FileMapping ) * gltf.buffers_count, 8 );
+        RASSERT( mappings );
+        for ( u32 b = 0; b < gltf.buffers_count; ++b ) {
+            mappings[ b ] = FileMapping{ };
+        }
+
+        if ( mesh_map_buffers( gltf, source_path, mappings ) ) {
+            for ( u32 b = 0; b < gltf.buffers_count; ++b ) {
+                key = mappings[ b ].data ? hash_bytes( mappings[ b ].data, mappings[ b ].size, key ) : key;
+            }
+        }
+
+        mesh_unmap_buffers( gltf, mappings );
+        allocator->deallocate( mappings );
+    }
+    gltf_free( gltf );
+
+    return key;
+}
+
+bool MeshResourceCompiler::compile( cstring source_path, cstring output_path ) {
+    glTF::glTF gltf = gltf_load_file( source_path, false, task_scheduler );
+    // Every glTF has an asset version, it is missing only when the file did not load.
+    if ( gltf.asset.version.data == nullptr ) {
+        gltf_free( gltf );
+        return false;
+    }
+
+    Allocator* allocator = &MemoryService::instance()->system_allocator;
+    const u32 buffers_count = gltf.buffers_count + 1;
+    FileMapping* mappings = ( FileMapping* )allocator->allocate( sizeof( FileMapping ) * buffers_count, 8 );
+    u8** buffers_data = ( u8** )allocator->allocate( sizeof( u8* ) * buffers_count, 8 );
+    RASSERT( mappings && buffers_data );
+    for ( u32 b = 0; b < buffers_count; ++b ) {
+        mappings[ b ] = FileMapping{ };
+    }
+
+    bool compiled = mesh_map_buffers( gltf, source_path, mappings );
+    if ( compiled ) {
+        for ( u32 b = 0; b < gltf.buffers_count; ++b ) {
+            buffers_data[ b ] = ( u8* )mappings[ b ].data;
+        }
+        compiled = gltf_compile_meshes( gltf, buffers_data, output_path, options );
+    }
+
+    mesh_unmap_buffers( gltf, mappings );
+    allocator->deallocate( buffers_data );
+    allocator->deallocate( mappings );
+    gltf_free( gltf );
+    return compiled;
+}
+
+} // namespace syi
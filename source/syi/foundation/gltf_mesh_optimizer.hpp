@@ -0,0 +1,155 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+#include "foundation/blob.hpp"
+#include "foundation/relative_data_structures.hpp"
+#include "foundation/gltf_meshlets.hpp"
+#include "foundation/gltf_mesh_lod.hpp"
+#include "foundation/vertex_quantization.hpp"
+#include "foundation/resource_manager.hpp"
+
+namespace syi {
+
+    struct Allocator;
+    struct FileMapping;
+
+    // Mesh optimization //////////////////////////////////////////////////
+    //
+    // Post transform cache and fetch efficiency of an indexed triangle list.
+    struct MeshOptimizerStatistics {
+        f32                         acmr;           // Vertices transformed per triangle: 3 is the worst, 0.5 the best for regular grids.
+        f32                         atvr;           // Vertices transformed per vertex, 1 is the best.
+        f32                         overfetch;      // Vertex bytes fetched per vertex byte, 1 is the best.
+    }; // struct MeshOptimizerStatistics
+
+    //
+    //
+    struct MeshOptimizerOptions {
+        f32                         overdraw_threshold = 1.05f;     // ACMR increase allowed to reduce overdraw, 0 disables the overdraw step.
+        bool                        encode          = true;         // Compress the compiled streams with the meshoptimizer codecs.
+
+        u32                         meshlet_max_vertices = 64;      // 0 disables the meshlets.
+        u32                         meshlet_max_triangles = 124;
+        f32                         meshlet_cone_weight = 0.25f;    // Tighter normal cones for larger meshlets, from 0 to 1.
+
+        MeshLodOptions              lod;
+
+        bool                        quantize        = true;         // Packed normals, tangents and texture coordinates.
+        bool                        quantize_positions = true;      // 16 bits positions on the bounding box of their mesh.
+    }; // struct MeshOptimizerOptions
+
+    //
+    // One attribute of the optimized vertices, deinterleaved. Morph targets are streams
+    // too, named "TARGET<t>_<attribute>", as they have to follow the vertex remap.
+    struct OptimizedStream {
+        char                        attribute[ 32 ];
+        u32                         component_count;
+        f32*                        data;
+    }; // struct OptimizedStream
+
+    //
+    //
+    struct OptimizedPrimitive {
+        u32*                        indices         = nullptr;
+        u32                         index_count     = 0;
+        u32                         vertex_count    = 0;
+        u32                         source_vertex_count = 0;    // Before the duplicated vertices are removed.
+
+        OptimizedStream*            streams         = nullptr;
+        u32                         streams_count   = 0;
+
+        MeshOptimizerStatistics     before;         // Unique vertices, in the source order.
+        MeshOptimizerStatistics     after;
+
+        MeshletData                 meshlets;       // Of lod 0.
+        MeshLodChain                lods;           // Lod 0 is a copy of indices.
+
+        Allocator*                  allocator       = nullptr;
+    }; // struct OptimizedPrimitive
+
+    // Triangle primitives only: removes duplicated vertices, then reorders triangles for the
+    // vertex cache and overdraw, and vertices for the fetch, then splits the result into meshlets
+    // and simplifies it into LODs. Returns false for other topologies.
+    bool                            mesh_optimize_primitive( const glTF::glTF& gltf, const glTF::MeshPrimitive& primitive, u8* const* buffers_data,
+                                                             const MeshOptimizerOptions& options, Allocator* allocator, OptimizedPrimitive& out_primitive );
+    void                            mesh_free_optimized_primitive( OptimizedPrimitive& primitive );
+
+namespace glTF {
+
+    // Compiled meshes ////////////////////////////////////////////////////
+    //
+    // The optimized primitives of a glTF, next to the compiled glTF. Index and vertex streams
+    // are either raw (u32 indices, f32 components) or encoded with the meshoptimizer codecs.
+    // indices holds all the LODs, lod 0 first. Streams are in a VertexStreamFormat, positions
+    // quantized on the grid of their mesh are decoded with position_dequantization.
+    static const u32                k_mesh_blob_version = 4;
+
+    struct MeshStreamBlob {
+        RelativeString              attribute;
+        u32                         component_count;   // Of the source attribute.
+        u32                         format;             // VertexStreamFormat
+        u32                         vertex_size;
+        RelativeArray<u8>           data;
+    };
+
+    struct MeshPrimitiveAssetBlob {
+        u32                         mesh;
+        u32                         primitive;
+        u32                         vertex_count;
+        u32                         index_count;
+        u32                         encoded;
+        RelativeArray<u8>           indices;
+        RelativeArray<MeshStreamBlob> streams;
+        MeshOptimizerStatistics     before;
+        MeshOptimizerStatistics     after;
+        RelativeArray<Meshlet>      meshlets;
+        RelativeArray<MeshletBounds> meshlet_bounds;
+        RelativeArray<u32>          meshlet_vertices;
+        RelativeArray<u8>           meshlet_triangles;
+        RelativeArray<MeshLod>      lods;
+        f32                         center[ 3 ];
+        f32                         radius;
+        VertexDequantization        position_dequantization;
+    };
+
+    //
+    //
+    struct MeshAssetBlob : public Blob {
+        RelativeArray<MeshPrimitiveAssetBlob> primitives;
+    }; // struct MeshAssetBlob
+
+} // namespace glTF
+
+    // Path of the compiled meshes next to the glTF file: "scene.gltf" -> "scene.gltf.meshes".
+    void                            gltf_meshes_path( cstring gltf_path, char* out_path, u32 max_size );
+
+    // Optimizes every triangle primitive of the glTF and writes them to path, printing the
+    // ACMR and ATVR before and after of each one. Returns false if the file could not be written.
+    bool                            gltf_compile_meshes( const glTF::glTF& gltf, u8* const* buffers_data, cstring path, const MeshOptimizerOptions& options );
+
+    // Maps compiled meshes, null if missing or from another version. Release with file_unmap.
+    const glTF::MeshAssetBlob*      gltf_map_meshes( cstring path, FileMapping& out_mapping );
+
+    // Decodes into index_count indices, or vertex_count * vertex_size bytes, still in the stream format.
+    bool                            mesh_decode_indices( const glTF::MeshPrimitiveAssetBlob& primitive, u32* destination );
+    bool                            mesh_decode_stream( const glTF::MeshPrimitiveAssetBlob& primitive, u32 stream, void* destination );
+
+    // MeshResourceCompiler ///////////////////////////////////////////////
+    //
+    // gltf_compile_meshes behind the cache of the ResourceManager. The key covers the options
+    // and the external buffers, as the vertices live in the .bin files rather than in the glTF.
+    struct MeshResourceCompiler : public ResourceCompiler {
+
+        static constexpr cstring    k_type          = "syi_gltf_meshes_type";
+
+        void                        init( const MeshOptimizerOptions& options, enki::TaskScheduler* task_scheduler );
+
+        u64                         hash_inputs( cstring source_path, u64 seed ) override;
+        bool                        compile( cstring source_path, cstring output_path ) override;
+
+        MeshOptimizerOptions        options;
+        enki::TaskScheduler*        task_scheduler  = nullptr;
+
+    }; // struct MeshResourceCompiler
+
+} // namespace syi
@@ -0,0 +1,314 @@
+#include "gltf_meshlets.hpp"
+#include "gltf_mesh_optimizer.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/log.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/meshoptimizer/meshoptimizer.h"
+#include "external/cglm/frustum.h"     // SSE2 detection, with the intrinsics headers.
+
+#include <math.h>
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_meshlet_cull_chunk = 8192;           // Meshlets culled by a single task, compacted in place.
+
+static_assert( sizeof( Meshlet ) == sizeof( meshopt_Meshlet ), "Meshlet must match meshopt_Meshlet" );
+
+// Meshlets ///////////////////////////////////////////////////////////////
+
+void meshlet_build( const u32* indices, u32 index_count, const f32* positions, u32 vertex_count, u32 max_vertices,
+                    u32 max_triangles, f32 cone_weight, Allocator* allocator, MeshletData& out_data ) {
+    MeshletData& data = out_data;
+    data = MeshletData{ };
+    data.allocator = allocator;
+
+    if ( index_count == 0 ) {
+        return;
+    }
+
+    // Worst case first, then copied into a single allocation of the used size.
+    const u32 max_meshlets = ( u32 )meshopt_buildMeshletsBound( index_count, max_vertices, max_triangles );
+    meshopt_Meshlet* meshlets = ( meshopt_Meshlet* )allocator->allocate( sizeof( meshopt_Meshlet ) * max_meshlets, 16 );
+    u32* vertices = ( u32* )allocator->allocate( sizeof( u32 ) * max_meshlets * max_vertices, 16 );
+    u8* triangles = ( u8* )allocator->allocate( max_meshlets * max_triangles * 3, 16 );
+    RASSERT( meshlets && vertices && triangles );
+
+    data.meshlets_count = ( u32 )meshopt_buildMeshlets( meshlets, vertices, triangles, indices, index_count, positions, vertex_count, sizeof( f32 ) * 3,
+                                                        max_vertices, max_triangles, cone_weight );
+
+    const meshopt_Meshlet& last = meshlets[ data.meshlets_count - 1 ];
+    data.vertices_count = last.vertex_offset + last.vertex_count;
+    data.triangles_size = last.triangle_offset + ( ( last.triangle_count * 3 + 3 ) & ~3u );
+
+    const sizet meshlets_size = sizeof( Meshlet ) * data.meshlets_count;
+    const sizet bounds_size = sizeof( MeshletBounds ) * data.meshlets_count;
+    const sizet vertices_size = sizeof( u32 ) * data.vertices_count;
+    u8* memory = ( u8* )allocator->allocate( meshlets_size + bounds_size + vertices_size + data.triangles_size, 16 );
+    RASSERT( memory );
+    data.meshlets = ( Meshlet* )memory;
+    data.bounds = ( MeshletBounds* )( memory + meshlets_size );
+    data.vertices = ( u32* )( memory + meshlets_size + bounds_size );
+    data.triangles = memory + meshlets_size + bounds_size + vertices_size;
+
+    memcpy( data.meshlets, meshlets, meshlets_size );
+    memcpy( data.vertices, vertices, vertices_size );
+    memcpy( data.triangles, triangles, data.triangles_size );
+
+    for ( u32 m = 0; m < data.meshlets_count; ++m ) {
+        const Meshlet& meshlet = data.meshlets[ m ];
+        const meshopt_Bounds bounds = meshopt_computeMeshletBounds( data.vertices + meshlet.vertex_offset, data.triangles + meshlet.triangle_offset,
+                                                                    meshlet.triangle_count, positions, vertex_count, sizeof( f32 ) * 3 );
+
+        MeshletBounds& destination = data.bounds[ m ];
+        memcpy( destination.center, bounds.center, sizeof( destination.center ) );
+        destination.radius = bounds.radius;
+        memcpy( destination.cone_axis, bounds.cone_axis, sizeof( destination.cone_axis ) );
+        destination.cone_cutoff = bounds.cone_cutoff;
+    }
+
+    allocator->deallocate( triangles );
+    allocator->deallocate( vertices );
+    allocator->deallocate( meshlets );
+}
+
+void meshlet_free( MeshletData& data ) {
+    if ( data.meshlets ) {
+        data.allocator->deallocate( data.meshlets );
+    }
+
+    data.meshlets = nullptr;
+    data.bounds = nullptr;
+    data.vertices = nullptr;
+    data.triangles = nullptr;
+    data.meshlets_count = data.vertices_count = data.triangles_size = 0;
+}
+
+// MeshletScene ///////////////////////////////////////////////////////////
+
+void MeshletScene::init( const glTF::MeshAssetBlob& blob, Allocator* allocator_ ) {
+    allocator = allocator_;
+    primitives_count = blob.primitives.size;
+
+    meshlets_count = vertices_count = triangles_size = 0;
+    for ( u32 p = 0; p < primitives_count; ++p ) {
+        const glTF::MeshPrimitiveAssetBlob& primitive = blob.primitives[ p ];
+        meshlets_count += primitive.meshlets.size;
+        vertices_count += primitive.meshlet_vertices.size;
+        triangles_size += primitive.meshlet_triangles.size;
+    }
+
+    // Transposed bounds first for their alignment, then the flat arrays.
+    const sizet stream_size = sizeof( f32 ) * ( ( meshlets_count + 3 ) & ~3u );
+    const sizet meshlets_size = sizeof( Meshlet ) * meshlets_count;
+    const sizet bounds_size = sizeof( MeshletBounds ) * meshlets_count;
+    const sizet indices_size = sizeof( u32 ) * ( vertices_count + meshlets_count + primitives_count + 1 );
+    u8* memory = ( u8* )allocator->allocate( stream_size * 8 + meshlets_size + bounds_size + indices_size + triangles_size, 64 );
+    RASSERT( memory );
+
+    f32** streams[] = { &center_x, &center_y, &center_z, &radius, &cone_axis_x, &cone_axis_y, &cone_axis_z, &cone_cutoff };
+    for ( u32 s = 0; s < ArraySize( streams ); ++s ) {
+        *streams[ s ] = ( f32* )( memory + stream_size * s );
+    }
+    memory += stream_size * 8;
+
+    meshlets = ( Meshlet* )memory;
+    bounds = ( MeshletBounds* )( memory + meshlets_size );
+    vertices = ( u32* )( memory + meshlets_size + bounds_size );
+    meshlet_primitives = vertices + vertices_count;
+    primitive_offsets = meshlet_primitives + meshlets_count;
+    triangles = ( u8* )( primitive_offsets + primitives_count + 1 );
+
+    u32 meshlet_offset = 0, vertex_offset = 0, triangle_offset = 0;
+    for ( u32 p = 0; p < primitives_count; ++p ) {
+        const glTF::MeshPrimitiveAssetBlob& primitive = blob.primitives[ p ];
+        primitive_offsets[ p ] = meshlet_offset;
+
+        memcpy( vertices + vertex_offset, primitive.meshlet_vertices.get(), sizeof( u32 ) * primitive.meshlet_vertices.size );
+        memcpy( triangles + triangle_offset, primitive.meshlet_triangles.get(), primitive.meshlet_triangles.size );
+        memcpy( bounds + meshlet_offset, primitive.meshlet_bounds.get(), sizeof( MeshletBounds ) * primitive.meshlet_bounds.size );
+
+        for ( u32 m = 0; m < primitive.meshlets.size; ++m ) {
+            const u32 i = meshlet_offset + m;
+            meshlets[ i ] = primitive.meshlets[ m ];
+            meshlets[ i ].vertex_offset += vertex_offset;
+            meshlets[ i ].triangle_offset += triangle_offset;
+            meshlet_primitives[ i ] = p;
+
+            const MeshletBounds& meshlet_bounds = bounds[ i ];
+            center_x[ i ] = meshlet_bounds.center[ 0 ];
+            center_y[ i ] = meshlet_bounds.center[ 1 ];
+            center_z[ i ] = meshlet_bounds.center[ 2 ];
+            radius[ i ] = meshlet_bounds.radius;
+            cone_axis_x[ i ] = meshlet_bounds.cone_axis[ 0 ];
+            cone_axis_y[ i ] = meshlet_bounds.cone_axis[ 1 ];
+            cone_axis_z[ i ] = meshlet_bounds.cone_axis[ 2 ];
+            cone_cutoff[ i ] = meshlet_bounds.cone_cutoff;
+        }
+
+        meshlet_offset += primitive.meshlets.size;
+        vertex_offset += primitive.meshlet_vertices.size;
+        triangle_offset += primitive.meshlet_triangles.size;
+    }
+    primitive_offsets[ primitives_count ] = meshlet_offset;
+}
+
+void MeshletScene::shutdown() {
+    if ( center_x ) {
+        allocator->deallocate( center_x );
+    }
+
+    *this = MeshletScene{ };
+}
+
+// Culling ////////////////////////////////////////////////////////////////
+
+void meshlet_cull_parameters( const mat4s& clip_from_object, const vec3s& camera_position, MeshletCullParameters& out_parameters ) {
+    vec4 planes[ 6 ];
+    glm_frustum_planes( ( vec4* )clip_from_object.raw, planes );
+    for ( u32 p = 0; p < 6; ++p ) {
+        glm_vec4_copy( planes[ p ], out_parameters.planes[ p ].raw );
+    }
+    out_parameters.camera_position = camera_position;
+}
+
+// Sphere in front of all the planes, and normal cone not entirely facing away from the camera:
+// dot( center - camera, axis ) >= cutoff * length( center - camera ) + radius means backfacing.
+static bool meshlet_is_visible( const MeshletScene& scene, const MeshletCullParameters& parameters, u32 i ) {
+    for ( u32 p = 0; p < 6; ++p ) {
+        const vec4s& plane = parameters.planes[ p ];
+        if ( plane.x * scene.center_x[ i ] + plane.y * scene.center_y[ i ] + plane.z * scene.center_z[ i ] + plane.w <= -scene.radius[ i ] ) {
+            return false;
+        }
+    }
+
+    if ( !parameters.cone_culling ) {
+        return true;
+    }
+
+    const f32 x = scene.center_x[ i ] - parameters.camera_position.x;
+    const f32 y = scene.center_y[ i ] - parameters.camera_position.y;
+    const f32 z = scene.center_z[ i ] - parameters.camera_position.z;
+    const f32 cone_dot = x * scene.cone_axis_x[ i ] + y * scene.cone_axis_y[ i ] + z * scene.cone_axis_z[ i ];
+    return cone_dot < scene.cone_cutoff[ i ] * sqrtf( x * x + y * y + z * z ) + scene.radius[ i ];
+}
+
+static u32 meshlet_cull_range( const MeshletScene& scene, const MeshletCullParameters& parameters, u32 begin, u32 end, u32* out_visible ) {
+    u32 visible_count = 0;
+    u32 i = begin;
+
+#if defined(__SSE2__)
+    // Four meshlets at a time, one per lane.
+    __m128 planes[ 6 ][ 4 ];
+    for ( u32 p = 0; p < 6; ++p ) {
+        for ( u32 c = 0; c < 4; ++c ) {
+            planes[ p ][ c ] = _mm_set1_ps( parameters.planes[ p ].raw[ c ] );
+        }
+    }
+    const __m128 camera_x = _mm_set1_ps( parameters.camera_position.x );
+    const __m128 camera_y = _mm_set1_ps( parameters.camera_position.y );
+    const __m128 camera_z = _mm_set1_ps( parameters.camera_position.z );
+    const __m128 zero = _mm_setzero_ps();
+
+    for ( ; i + 4 <= end; i += 4 ) {
+        const __m128 x = _mm_loadu_ps( scene.center_x + i );
+        const __m128 y = _mm_loadu_ps( scene.center_y + i );
+        const __m128 z = _mm_loadu_ps( scene.center_z + i );
+        const __m128 radius = _mm_loadu_ps( scene.radius + i );
+        const __m128 negative_radius = _mm_sub_ps( zero, radius );
+
+        __m128 visible = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+        for ( u32 p = 0; p < 6; ++p ) {
+            const __m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( planes[ p ][ 0 ], x ), _mm_mul_ps( planes[ p ][ 1 ], y ) ),
+                                                _mm_add_ps( _mm_mul_ps( planes[ p ][ 2 ], z ), planes[ p ][ 3 ] ) );
+            visible = _mm_and_ps( visible, _mm_cmpgt_ps( distance, negative_radius ) );
+        }
+
+        if ( parameters.cone_culling ) {
+            const __m128 dx = _mm_sub_ps( x, camera_x );
+            const __m128 dy = _mm_sub_ps( y, camera_y );
+            const __m128 dz = _mm_sub_ps( z, camera_z );
+            const __m128 cone_dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, _mm_loadu_ps( scene.cone_axis_x + i ) ), _mm_mul_ps( dy, _mm_loadu_ps( scene.cone_axis_y + i ) ) ),
+                                                _mm_mul_ps( dz, _mm_loadu_ps( scene.cone_axis_z + i ) ) );
+            const __m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) ) );
+            const __m128 limit = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( scene.cone_cutoff + i ), length ), radius );
+            visible = _mm_and_ps( visible, _mm_cmplt_ps( cone_dot, limit ) );
+        }
+
+        u32 mask = ( u32 )_mm_movemask_ps( visible );
+        while ( mask ) {
+            const u32 lane = ( mask & 1 ) ? 0 : ( mask & 2 ) ? 1 : ( mask & 4 ) ? 2 : 3;
+            out_visible[ visible_count++ ] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+#endif // __SSE2__
+
+    for ( ; i < end; ++i ) {
+        if ( meshlet_is_visible( scene, parameters, i ) ) {
+            out_visible[ visible_count++ ] = i;
+        }
+    }
+
+    return visible_count;
+}
+
+//
+// Each chunk is compacted at its own offset of the output, packed after the tasks.
+struct MeshletCullTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    const MeshletScene*             scene           = nullptr;
+    const MeshletCullParameters*    parameters      = nullptr;
+    u32*                            visible         = nullptr;
+    u32*                            chunk_counts    = nullptr;
+    u32                             first           = 0;
+    u32                             count           = 0;
+}; // struct MeshletCullTask
+
+void MeshletCullTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    for ( u32 c = range.start; c < range.end; ++c ) {
+        const u32 begin = c * k_meshlet_cull_chunk;
+        const u32 end = begin + k_meshlet_cull_chunk < count ? begin + k_meshlet_cull_chunk : count;
+        chunk_counts[ c ] = meshlet_cull_range( *scene, *parameters, first + begin, first + end, visible + begin );
+    }
+}
+
+u32 meshlet_cull( const MeshletScene& scene, const MeshletCullParameters& parameters, u32 first, u32 count,
+                  u32* out_visible, enki::TaskScheduler* task_scheduler ) {
+    RASSERT( first + count <= scene.meshlets_count );
+
+    if ( task_scheduler == nullptr || count <= k_meshlet_cull_chunk ) {
+        return meshlet_cull_range( scene, parameters, first, first + count, out_visible );
+    }
+
+    const u32 chunks_count = ( count + k_meshlet_cull_chunk - 1 ) / k_meshlet_cull_chunk;
+    u32* chunk_counts = ( u32* )scene.allocator->allocate( sizeof( u32 ) * chunks_count, 4 );
+    RASSERT( chunk_counts );
+
+    MeshletCullTask cull_task;
+    cull_task.m_SetSize = chunks_count;
+    cull_task.scene = &scene;
+    cull_task.parameters = &parameters;
+    cull_task.visible = out_visible;
+    cull_task.chunk_counts = chunk_counts;
+    cull_task.first = first;
+    cull_task.count = count;
+
+    task_scheduler->AddTaskSetToPipe( &cull_task );
+    task_scheduler->WaitforTask( &cull_task );
+
+    u32 visible_count = chunk_counts[ 0 ];
+    for ( u32 c = 1; c < chunks_count; ++c ) {
+        memmove( out_visible + visible_count, out_visible + c * k_meshlet_cull_chunk, sizeof( u32 ) * chunk_counts[ c ] );
+        visible_count += chunk_counts[ c ];
+    }
+
+    scene.allocator->deallocate( chunk_counts );
+    return visible_count;
+}
+
+} // namespace syi
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace syi {
+
+    struct Allocator;
+
+namespace glTF {
+    struct MeshAssetBlob;
+}
+
+    // Meshlets ///////////////////////////////////////////////////////////
+    //
+    // Same layout as meshopt_Meshlet: ranges of the meshlet vertices and of the triangle bytes.
+    struct Meshlet {
+        u32                         vertex_offset;
+        u32                         triangle_offset;    // Bytes, 3 local vertex indices per triangle, padded to 4.
+        u32                         vertex_count;
+        u32                         triangle_count;
+    }; // struct Meshlet
+
+    //
+    // Bounding sphere and normal cone of a meshlet, two vec4 for the GPU. The cone apex is not
+    // kept: the backface test uses the bounding sphere instead.
+    struct MeshletBounds {
+        f32                         center[ 3 ];
+        f32                         radius;
+        f32                         cone_axis[ 3 ];
+        f32                         cone_cutoff;        // cos( cone angle / 2 ), 1 when the cone is too wide to cull.
+    }; // struct MeshletBounds
+
+    //
+    // Meshlets of one triangle list. vertices are indices into the vertex buffer of the list.
+    struct MeshletData {
+        Meshlet*                    meshlets        = nullptr;
+        MeshletBounds*              bounds          = nullptr;
+        u32*                        vertices        = nullptr;
+        u8*                         triangles       = nullptr;
+
+        u32                         meshlets_count  = 0;
+        u32                         vertices_count  = 0;
+        u32                         triangles_size  = 0;    // Bytes.
+
+        Allocator*                  allocator       = nullptr;
+    }; // struct MeshletData
+
+    // Splits an indexed triangle list, better if already optimized for the vertex cache.
+    // positions are 3 floats per vertex. max_vertices <= 255 and max_triangles <= 512, a multiple of 4.
+    void                            meshlet_build( const u32* indices, u32 index_count, const f32* positions, u32 vertex_count, u32 max_vertices,
+                                                   u32 max_triangles, f32 cone_weight, Allocator* allocator, MeshletData& out_data );
+    void                            meshlet_free( MeshletData& data );
+
+    // MeshletScene ///////////////////////////////////////////////////////
+    //
+    // All the meshlets of compiled meshes in flat arrays, primitive after primitive. Offsets of
+    // the meshlets are rebased into the flat vertices and triangles, the vertex indices still
+    // address the vertex buffer of their primitive. Bounds are also kept transposed for culling.
+    struct MeshletScene {
+
+        void                        init( const glTF::MeshAssetBlob& blob, Allocator* allocator );
+        void                        shutdown();
+
+        Meshlet*                    meshlets        = nullptr;
+        MeshletBounds*              bounds          = nullptr;
+        u32*                        vertices        = nullptr;
+        u8*                         triangles       = nullptr;
+        u32*                        meshlet_primitives = nullptr;   // Primitive of the blob of each meshlet.
+        u32*                        primitive_offsets = nullptr;    // First meshlet of each primitive, and the total at primitives_count.
+
+        // Bounds, one array per component.
+        f32*                        center_x        = nullptr;
+        f32*                        center_y        = nullptr;
+        f32*                        center_z        = nullptr;
+        f32*                        radius          = nullptr;
+        f32*                        cone_axis_x     = nullptr;
+        f32*                        cone_axis_y     = nullptr;
+        f32*                        cone_axis_z     = nullptr;
+        f32*                        cone_cutoff     = nullptr;
+
+        u32                         meshlets_count  = 0;
+        u32                         primitives_count = 0;
+        u32                         vertices_count  = 0;
+        u32                         triangles_size  = 0;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct MeshletScene
+
+    //
+    // Frustum planes ( xyz normal pointing inside, w distance ) and camera, in the space of the meshlets.
+    struct MeshletCullParameters {
+        vec4s                       planes[ 6 ];
+        vec3s                       camera_position;
+        bool                        cone_culling    = true;
+    }; // struct MeshletCullParameters
+
+    // clip_from_object is view projection * world matrix of the primitive, camera_position is in object space.
+    void                            meshlet_cull_parameters( const mat4s& clip_from_object, const vec3s& camera_position, MeshletCullParameters& out_parameters );
+
+    // Writes the visible meshlets among [ first, first + count ), in order, and returns their number.
+    // out_visible holds count indices. Large ranges are culled in parallel with a task scheduler.
+    u32                             meshlet_cull( const MeshletScene& scene, const MeshletCullParameters& parameters, u32 first, u32 count,
+                                                  u32* out_visible, enki::TaskScheduler* task_scheduler = nullptr );
+
+} // namespace syi
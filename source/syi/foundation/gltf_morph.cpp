@@ -0,0 +1,241 @@
+#include "gltf_morph.hpp"
+#include "gltf_accessor.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/log.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/common.h"     // SSE2 detection, with the intrinsics headers.
+
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_morph_blend_min_vertices = 2048;     // Vertices blended by a single task at least.
+
+// MorphTargetSet /////////////////////////////////////////////////////////
+
+// Deltas first for their alignment, then the vertex indices, in a single allocation.
+static void morph_allocate_deltas( MorphTargetDeltas& target, u32 delta_count, Allocator* allocator ) {
+    target.delta_count = delta_count;
+    if ( delta_count == 0 ) {
+        return;
+    }
+
+    u8* memory = ( u8* )allocator->allocate( ( sizeof( f32 ) * 4 + sizeof( u32 ) ) * delta_count, 16 );
+    RASSERT( memory );
+    target.deltas = ( f32* )memory;
+    target.vertex_indices = ( u32* )( memory + sizeof( f32 ) * 4 * delta_count );
+}
+
+static void morph_set_delta( MorphTargetDeltas& target, u32 d, u32 vertex_index, f32 x, f32 y, f32 z ) {
+    target.vertex_indices[ d ] = vertex_index;
+    f32* delta = target.deltas + ( sizet )d * 4;
+    delta[ 0 ] = x;
+    delta[ 1 ] = y;
+    delta[ 2 ] = z;
+    delta[ 3 ] = 0.0f;
+}
+
+static bool morph_load_target( MorphTargetDeltas& target, const AccessorView& view, Allocator* allocator ) {
+    if ( view.data == nullptr ) {
+        // Only sparse: the substitutions are the deltas.
+        morph_allocate_deltas( target, view.sparse_count, allocator );
+        for ( u32 d = 0; d < view.sparse_count; ++d ) {
+            morph_set_delta( target, d, view.read_sparse_index( d ), view.read_sparse_float( d, 0 ), view.read_sparse_float( d, 1 ), view.read_sparse_float( d, 2 ) );
+            if ( target.vertex_indices[ d ] >= view.count ) {
+                rprint( "Morph target sparse index %u is out of %u vertices\n", target.vertex_indices[ d ], view.count );
+                return false;
+            }
+            if ( d > 0 && target.vertex_indices[ d ] <= target.vertex_indices[ d - 1 ] ) {
+                rprint( "Morph target sparse indices are not increasing\n" );
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Dense: keep the vertices that move.
+    f32* dense = ( f32* )allocator->allocate( sizeof( f32 ) * 3 * view.count, 16 );
+    RASSERT( dense );
+    view.read_floats( dense );
+
+    u32 delta_count = 0;
+    for ( u32 v = 0; v < view.count; ++v ) {
+        const f32* delta = dense + ( sizet )v * 3;
+        delta_count += ( delta[ 0 ] != 0.0f || delta[ 1 ] != 0.0f || delta[ 2 ] != 0.0f ) ? 1 : 0;
+    }
+
+    morph_allocate_deltas( target, delta_count, allocator );
+    u32 d = 0;
+    for ( u32 v = 0; v < view.count; ++v ) {
+        const f32* delta = dense + ( sizet )v * 3;
+        if ( delta[ 0 ] != 0.0f || delta[ 1 ] != 0.0f || delta[ 2 ] != 0.0f ) {
+            morph_set_delta( target, d++, v, delta[ 0 ], delta[ 1 ], delta[ 2 ] );
+        }
+    }
+
+    allocator->deallocate( dense );
+    return true;
+}
+
+bool MorphTargetSet::init( const glTF::glTF& gltf, const glTF::MeshPrimitive& primitive, cstring attribute_name,
+                           u8* const* buffers_data, Allocator* allocator_ ) {
+    *this = MorphTargetSet{ };
+    allocator = allocator_;
+
+    AccessorView base;
+    if ( !base.init( gltf, gltf_get_attribute_accessor_index( primitive.attributes, primitive.attribute_count, attribute_name ), buffers_data ) ) {
+        return false;
+    }
+    if ( base.component_count < 3 || base.component_count > 4 ) {
+        rprint( "Morph target attribute %s must be a VEC3 or VEC4\n", attribute_name );
+        return false;
+    }
+
+    vertex_count = base.count;
+    component_count = base.component_count;
+
+    if ( primitive.targets_count == 0 ) {
+        return true;
+    }
+
+    targets_count = primitive.targets_count;
+    targets = ( MorphTargetDeltas* )allocator->allocate( sizeof( MorphTargetDeltas ) * targets_count, 64 );
+    RASSERT( targets );
+    memset( targets, 0, sizeof( MorphTargetDeltas ) * targets_count );
+
+    for ( u32 t = 0; t < targets_count; ++t ) {
+        const glTF::MeshPrimitive::Target& target = primitive.targets[ t ];
+        const i32 accessor_index = gltf_get_attribute_accessor_index( target.attributes, target.attribute_count, attribute_name );
+        if ( accessor_index < 0 ) {
+            // The target does not move this attribute.
+            continue;
+        }
+
+        AccessorView view;
+        bool loaded = view.init( gltf, accessor_index, buffers_data ) && view.count == vertex_count && view.component_count == 3;
+        loaded = loaded && morph_load_target( targets[ t ], view, allocator );
+        if ( !loaded ) {
+            rprint( "Error loading morph target %u of %s\n", t, attribute_name );
+            shutdown();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MorphTargetSet::shutdown() {
+    for ( u32 t = 0; t < targets_count; ++t ) {
+        if ( targets[ t ].delta_count ) {
+            allocator->deallocate( targets[ t ].deltas );
+        }
+    }
+
+    if ( targets ) {
+        allocator->deallocate( targets );
+    }
+
+    targets = nullptr;
+    targets_count = 0;
+}
+
+sizet MorphTargetSet::get_memory_size() const {
+    sizet size = sizeof( MorphTargetDeltas ) * targets_count;
+    for ( u32 t = 0; t < targets_count; ++t ) {
+        size += ( sizeof( f32 ) * 4 + sizeof( u32 ) ) * targets[ t ].delta_count;
+    }
+    return size;
+}
+
+// First delta of a vertex index not less than vertex_index.
+static u32 morph_lower_bound( const MorphTargetDeltas& target, u32 vertex_index ) {
+    u32 first = 0;
+    u32 count = target.delta_count;
+    while ( count > 0 ) {
+        const u32 half = count / 2;
+        if ( target.vertex_indices[ first + half ] < vertex_index ) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+static void morph_blend_range( const MorphTargetSet& set, const f32* base, const f32* weights, f32* destination, u32 begin, u32 end ) {
+    const u32 component_count = set.component_count;
+    memcpy( destination + ( sizet )begin * component_count, base + ( sizet )begin * component_count, sizeof( f32 ) * component_count * ( end - begin ) );
+
+    for ( u32 t = 0; t < set.targets_count; ++t ) {
+        const MorphTargetDeltas& target = set.targets[ t ];
+        const f32 weight = weights[ t ];
+        if ( weight == 0.0f || target.delta_count == 0 ) {
+            continue;
+        }
+
+#if defined(__SSE2__)
+        const __m128 weight4 = _mm_set1_ps( weight );
+#endif // __SSE2__
+
+        for ( u32 d = morph_lower_bound( target, begin ); d < target.delta_count && target.vertex_indices[ d ] < end; ++d ) {
+            f32* vertex = destination + ( sizet )target.vertex_indices[ d ] * component_count;
+            const f32* delta = target.deltas + ( sizet )d * 4;
+
+#if defined(__SSE2__)
+            const __m128 scaled = _mm_mul_ps( weight4, _mm_load_ps( delta ) );
+            if ( component_count == 4 ) {
+                _mm_storeu_ps( vertex, _mm_add_ps( _mm_loadu_ps( vertex ), scaled ) );
+            } else {
+                // xy as a double and z alone, not to touch the next vertex.
+                const __m128 xy = _mm_castpd_ps( _mm_load_sd( ( const f64* )vertex ) );
+                const __m128 xyz = _mm_add_ps( _mm_movelh_ps( xy, _mm_load_ss( vertex + 2 ) ), scaled );
+                _mm_store_sd( ( f64* )vertex, _mm_castps_pd( xyz ) );
+                _mm_store_ss( vertex + 2, _mm_movehl_ps( xyz, xyz ) );
+            }
+#else
+            vertex[ 0 ] += weight * delta[ 0 ];
+            vertex[ 1 ] += weight * delta[ 1 ];
+            vertex[ 2 ] += weight * delta[ 2 ];
+#endif // __SSE2__
+        }
+    }
+}
+
+//
+//
+struct MorphBlendTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    const MorphTargetSet*           set             = nullptr;
+    const f32*                      base            = nullptr;
+    const f32*                      weights         = nullptr;
+    f32*                            destination     = nullptr;
+}; // struct MorphBlendTask
+
+void MorphBlendTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    morph_blend_range( *set, base, weights, destination, range.start, range.end );
+}
+
+void MorphTargetSet::blend( const f32* base, const f32* weights, f32* destination, enki::TaskScheduler* task_scheduler ) const {
+    if ( task_scheduler == nullptr || vertex_count <= k_morph_blend_min_vertices ) {
+        morph_blend_range( *this, base, weights, destination, 0, vertex_count );
+        return;
+    }
+
+    MorphBlendTask blend_task;
+    blend_task.m_SetSize = vertex_count;
+    blend_task.m_MinRange = k_morph_blend_min_vertices;
+    blend_task.set = this;
+    blend_task.base = base;
+    blend_task.weights = weights;
+    blend_task.destination = destination;
+
+    task_scheduler->AddTaskSetToPipe( &blend_task );
+    task_scheduler->WaitforTask( &blend_task );
+}
+
+} // namespace syi
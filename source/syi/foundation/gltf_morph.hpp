@@ -0,0 +1,52 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace syi {
+
+    struct Allocator;
+
+    // MorphTargetSet /////////////////////////////////////////////////////
+    //
+    // Deltas of one target, only for the vertices it moves.
+    struct MorphTargetDeltas {
+        u32                         delta_count;
+        u32*                        vertex_indices; // Increasing.
+        f32*                        deltas;         // xyz and a zero, 16 bytes aligned.
+    }; // struct MorphTargetDeltas
+
+    //
+    // Morph targets of one attribute (POSITION, NORMAL or TANGENT) of a primitive.
+    // Sparse accessors are read as they are, dense ones keep their non zero deltas.
+    //
+    // Usage:
+    //   MorphTargetSet positions;
+    //   positions.init( gltf, primitive, "POSITION", buffers_data, allocator );
+    //   positions.blend( base_positions, mesh.weights, animated_positions, task_scheduler );
+    struct MorphTargetSet {
+
+        bool                        init( const glTF::glTF& gltf, const glTF::MeshPrimitive& primitive, cstring attribute_name,
+                                          u8* const* buffers_data, Allocator* allocator );
+        void                        shutdown();
+
+        // destination = base + sum of weights[ t ] * deltas of target t. base and destination are packed
+        // streams of vertex_count elements of component_count floats, only xyz are morphed.
+        // Targets with a zero weight are skipped. With a task scheduler vertex ranges are blended in parallel.
+        void                        blend( const f32* base, const f32* weights, f32* destination, enki::TaskScheduler* task_scheduler = nullptr ) const;
+
+        sizet                       get_memory_size() const;
+
+        MorphTargetDeltas*          targets         = nullptr;
+        u32                         targets_count   = 0;
+        u32                         vertex_count    = 0;
+        u32                         component_count = 0;    // 3, or 4 for tangents.
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct MorphTargetSet
+
+} // namespace syi
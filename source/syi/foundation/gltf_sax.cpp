@@ -0,0 +1,1312 @@
+#include "gltf.hpp"
+
+#include "external/json.hpp"
+#include "external/enkiTS/TaskScheduler.h"
+
+#include "assert.hpp"
+#include "array.hpp"
+
+#include <string.h>
+
+namespace syi {
+
+// Pre-scan ///////////////////////////////////////////////////////////////
+
+//
+// What a range of the text can allocate at most.
+struct glTFPreScanCounters {
+
+    sizet                           get_arena_size() const;
+
+    void                            add( const glTFPreScanCounters& other );
+    void                            subtract( const glTFPreScanCounters& other );
+
+    sizet                           root_element_bytes  = 0;        // Objects in root arrays, at the size of their kind.
+    sizet                           objects             = 0;        // Any other object.
+    sizet                           arrays              = 0;
+    sizet                           strings             = 0;
+    sizet                           string_bytes        = 0;
+    sizet                           array_elements      = 0;
+    sizet                           object_members      = 0;
+
+}; // struct glTFPreScanCounters
+
+//
+// Member of the root object, like "nodes": [ ... ].
+struct glTFPreScanMember {
+    sizet                           key_begin;
+    sizet                           key_end;
+    sizet                           value_begin;
+    sizet                           value_end;
+    u32                             container_index;    // u32_max for numbers and strings.
+    u32                             first_element;
+    u32                             element_count;
+}; // struct glTFPreScanMember
+
+//
+// Object or array inside a root member array, like a single node.
+struct glTFPreScanElement {
+    sizet                           begin;
+    sizet                           end;
+    u32                             container_index;
+    glTFPreScanCounters             counters;           // Everything inside the element, the element included.
+}; // struct glTFPreScanElement
+
+//
+// Single pass over the text, without parsing values. Records the element count of
+// every object and array in document order, and an upper bound of the arena size.
+// With record_ranges it also records where root members and their elements are,
+// so they can be parsed independently.
+struct glTFPreScan {
+
+    bool                            scan( const char* text, sizet size, Allocator* allocator, bool record_ranges );
+    void                            shutdown();
+
+    sizet                           get_arena_size() const  { return counters.get_arena_size(); }
+
+    Array<u32>                      container_counts;       // Members or elements, in the order containers are opened.
+    Array<glTFPreScanMember>        members;
+    Array<glTFPreScanElement>       elements;
+
+    glTFPreScanCounters             counters;
+
+}; // struct glTFPreScan
+
+// Objects below the root arrays: primitives, morph targets and their attributes, sparse accessors,
+// material textures, animation samplers and channels. Any of them can be a separate allocation aligned to 64.
+static const sizet k_gltf_nested_object_size = 64 + sizeof( glTF::MaterialPBRMetallicRoughness );
+static_assert( sizeof( glTF::MaterialPBRMetallicRoughness ) >= sizeof( glTF::MeshPrimitive ) &&
+               sizeof( glTF::MaterialPBRMetallicRoughness ) >= sizeof( glTF::MeshPrimitive::Target ) &&
+               sizeof( glTF::MaterialPBRMetallicRoughness ) >= sizeof( glTF::AccessorSparse ), "Update the pre-scan nested object size" );
+
+// Size of the elements of a root array, 0 for the arrays the reader skips.
+static sizet gltf_root_element_size( const char* key, sizet length ) {
+    struct RootArray {
+        cstring                     key;
+        sizet                       element_size;
+    };
+
+    static const RootArray k_root_arrays[] = {
+        { "scenes", sizeof( glTF::Scene ) }, { "buffers", sizeof( glTF::Buffer ) }, { "bufferViews", sizeof( glTF::BufferView ) },
+        { "nodes", sizeof( glTF::Node ) }, { "meshes", sizeof( glTF::Mesh ) }, { "accessors", sizeof( glTF::Accessor ) },
+        { "materials", sizeof( glTF::Material ) }, { "textures", sizeof( glTF::Texture ) }, { "images", sizeof( glTF::Image ) },
+        { "samplers", sizeof( glTF::Sampler ) }, { "skins", sizeof( glTF::Skin ) }, { "animations", sizeof( glTF::Animation ) },
+    };
+
+    for ( const RootArray& root_array : k_root_arrays ) {
+        if ( strlen( root_array.key ) == length && memcmp( root_array.key, key, length ) == 0 ) {
+            return root_array.element_size;
+        }
+    }
+    return 0;
+}
+
+sizet glTFPreScanCounters::get_arena_size() const {
+    // Root arrays are single allocations aligned to 64, like the other arrays.
+    // Arrays of numbers take 4 bytes per element, members of objects can be mesh attributes.
+    return root_element_bytes + objects * k_gltf_nested_object_size + arrays * 64 + array_elements * sizeof( u32 ) +
+           object_members * sizeof( glTF::MeshPrimitive::Attribute ) + string_bytes + strings * 2 + 64;
+}
+
+void glTFPreScanCounters::add( const glTFPreScanCounters& other ) {
+    root_element_bytes += other.root_element_bytes;
+    objects += other.objects;
+    arrays += other.arrays;
+    strings += other.strings;
+    string_bytes += other.string_bytes;
+    array_elements += other.array_elements;
+    object_members += other.object_members;
+}
+
+void glTFPreScanCounters::subtract( const glTFPreScanCounters& other ) {
+    root_element_bytes -= other.root_element_bytes;
+    objects -= other.objects;
+    arrays -= other.arrays;
+    strings -= other.strings;
+    string_bytes -= other.string_bytes;
+    array_elements -= other.array_elements;
+    object_members -= other.object_members;
+}
+
+bool glTFPreScan::scan( const char* text, sizet size, Allocator* allocator, bool record_ranges ) {
+    container_counts.init( allocator, 1024 );
+    members.init( allocator, record_ranges ? 16 : 0 );
+    elements.init( allocator, record_ranges ? 1024 : 0 );
+
+    static const u32 k_max_depth = 256;
+    u32 open_containers[ k_max_depth ];     // Index into container_counts.
+    bool non_empty[ k_max_depth ];
+    bool is_object[ k_max_depth ];
+    u32 depth = 0;
+
+    glTFPreScanMember* member = nullptr;    // Root member being scanned.
+    bool expect_key = false;
+    bool expect_value = false;
+
+    // Root member key, to size the elements of its array.
+    sizet key_begin = 0;
+    sizet key_end = 0;
+    sizet root_element_size = 0;
+
+    bool in_string = false;
+    for ( sizet i = 0; i < size; ++i ) {
+        const char c = text[ i ];
+
+        if ( in_string ) {
+            if ( c == '\\' ) {
+                ++i;
+                ++counters.string_bytes;
+            } else if ( c == '"' ) {
+                in_string = false;
+                if ( key_end == 0 ) {
+                    key_end = i;
+                }
+                if ( member && member->key_end == 0 ) {
+                    member->key_end = i;
+                }
+            } else {
+                ++counters.string_bytes;
+            }
+            continue;
+        }
+
+        if ( c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ':' ) {
+            continue;
+        }
+
+        // The tasked parse reads the root members from the pre-scan: it needs an object root.
+        if ( depth == 0 && c != '{' ) {
+            rprint( "glTF pre-scan: the root is not an object\n" );
+            return false;
+        }
+
+        if ( depth == 1 ) {
+            if ( expect_key && c == '"' ) {
+                key_begin = i + 1;
+                key_end = 0;
+                if ( record_ranges ) {
+                    member = &members.push_use();
+                    *member = { i + 1, 0, 0, 0, u32_max, elements.size, 0 };
+                }
+                expect_key = false;
+                expect_value = true;
+                non_empty[ 0 ] = true;
+                ++counters.strings;
+                in_string = true;
+                continue;
+            }
+            if ( expect_value ) {
+                if ( record_ranges ) {
+                    member->value_begin = i;
+                    if ( c == '{' || c == '[' ) {
+                        member->container_index = container_counts.size;
+                    }
+                }
+                root_element_size = c == '[' ? gltf_root_element_size( text + key_begin, key_end - key_begin ) : 0;
+                expect_value = false;
+            }
+            if ( record_ranges && ( c == ',' || c == '}' ) && member && member->value_end == 0 ) {
+                // Number, string, true, false or null.
+                member->value_end = i;
+            }
+        }
+
+        switch ( c ) {
+            case '{':
+            case '[':
+            {
+                if ( depth ) {
+                    non_empty[ depth - 1 ] = true;
+                }
+                if ( depth == k_max_depth ) {
+                    rprint( "glTF pre-scan: nesting deeper than %u\n", k_max_depth );
+                    return false;
+                }
+
+                if ( record_ranges && depth == 2 && !is_object[ 1 ] ) {
+                    glTFPreScanElement& element = elements.push_use();
+                    element.begin = i;
+                    element.container_index = container_counts.size;
+                    // Counters at the start, the difference is taken when the element closes.
+                    element.counters = counters;
+                    ++member->element_count;
+                }
+
+                open_containers[ depth ] = container_counts.size;
+                non_empty[ depth ] = false;
+                is_object[ depth ] = c == '{';
+                ++depth;
+
+                if ( depth == 1 ) {
+                    expect_key = true;
+                }
+
+                container_counts.push( 0 );
+                if ( c == '[' ) {
+                    ++counters.arrays;
+                } else if ( depth == 3 && !is_object[ 1 ] ) {
+                    counters.root_element_bytes += root_element_size;
+                } else {
+                    ++counters.objects;
+                }
+                break;
+            }
+
+            case '}':
+            case ']':
+            {
+                if ( depth == 0 ) {
+                    return false;
+                }
+                --depth;
+
+                u32& count = container_counts[ open_containers[ depth ] ];
+                // Commas were counted so far.
+                count = non_empty[ depth ] ? count + 1 : 0;
+                // The root, root arrays and their elements hold fields of the structures charged already.
+                // Deeper members can be mesh attributes, deeper elements numbers.
+                const bool root_level = depth <= 1 || ( depth == 2 && !is_object[ 1 ] );
+                if ( !root_level ) {
+                    is_object[ depth ] ? counters.object_members += count : counters.array_elements += count;
+                }
+
+                if ( record_ranges && depth == 2 && !is_object[ 1 ] ) {
+                    glTFPreScanElement& element = elements[ elements.size - 1 ];
+                    element.end = i + 1;
+                    glTFPreScanCounters element_counters = counters;
+                    element_counters.subtract( element.counters );
+                    element.counters = element_counters;
+                }
+                if ( record_ranges && depth == 1 ) {
+                    member->value_end = i + 1;
+                }
+                break;
+            }
+
+            case ',':
+            {
+                if ( depth ) {
+                    ++container_counts[ open_containers[ depth - 1 ] ];
+                }
+                if ( depth == 1 ) {
+                    expect_key = true;
+                }
+                break;
+            }
+
+            case '"':
+            {
+                in_string = true;
+                ++counters.strings;
+                if ( depth ) {
+                    non_empty[ depth - 1 ] = true;
+                }
+                break;
+            }
+
+            default:
+            {
+                // Numbers, true, false and null.
+                if ( depth ) {
+                    non_empty[ depth - 1 ] = true;
+                }
+                break;
+            }
+        }
+    }
+
+    return depth == 0 && !in_string;
+}
+
+void glTFPreScan::shutdown() {
+    container_counts.shutdown();
+    members.shutdown();
+    elements.shutdown();
+}
+
+// SAX reader /////////////////////////////////////////////////////////////
+
+enum glTFSaxObject : u8 {
+    glTFSaxObject_Root, glTFSaxObject_Asset, glTFSaxObject_Scene, glTFSaxObject_Buffer, glTFSaxObject_BufferView, glTFSaxObject_Node,
+    glTFSaxObject_Mesh, glTFSaxObject_MeshPrimitive, glTFSaxObject_Attributes, glTFSaxObject_Accessor, glTFSaxObject_Material,
+    glTFSaxObject_PBRMetallicRoughness, glTFSaxObject_TextureInfo, glTFSaxObject_NormalTextureInfo, glTFSaxObject_OcclusionTextureInfo,
+    glTFSaxObject_Texture, glTFSaxObject_Image, glTFSaxObject_Sampler, glTFSaxObject_Skin, glTFSaxObject_Animation,
+    glTFSaxObject_AnimationSampler, glTFSaxObject_AnimationChannel, glTFSaxObject_ChannelTarget, glTFSaxObject_AccessorSparse,
+    glTFSaxObject_AccessorSparseIndices, glTFSaxObject_AccessorSparseValues, glTFSaxObject_MorphTarget, glTFSaxObject_Count
+};
+
+enum glTFSaxValue : u8 {
+    glTFSaxValue_Skip, glTFSaxValue_Int, glTFSaxValue_Float, glTFSaxValue_Bool, glTFSaxValue_String,
+    glTFSaxValue_AccessorType, glTFSaxValue_Interpolation, glTFSaxValue_TargetPath,
+    glTFSaxValue_IntArray, glTFSaxValue_FloatArray, glTFSaxValue_ObjectArray,
+    glTFSaxValue_Object,            // Struct embedded in its parent.
+    glTFSaxValue_ObjectPointer,     // Struct allocated and referenced by a pointer.
+    glTFSaxValue_Count
+};
+
+//
+// What the next value is written into.
+struct glTFSaxDestination {
+    glTFSaxValue                    type    = glTFSaxValue_Skip;
+    glTFSaxObject                   object  = glTFSaxObject_Count;
+    void*                           data    = nullptr;
+    u32*                            count   = nullptr;
+}; // struct glTFSaxDestination
+
+//
+// Object or array being read.
+struct glTFSaxFrame {
+    glTFSaxValue                    type;
+    glTFSaxObject                   object;
+    u8*                             data;
+    u32                             index;
+}; // struct glTFSaxFrame
+
+static sizet sax_object_size( glTFSaxObject object ) {
+    switch ( object ) {
+        case glTFSaxObject_Scene:                   return sizeof( glTF::Scene );
+        case glTFSaxObject_Buffer:                  return sizeof( glTF::Buffer );
+        case glTFSaxObject_BufferView:              return sizeof( glTF::BufferView );
+        case glTFSaxObject_Node:                    return sizeof( glTF::Node );
+        case glTFSaxObject_Mesh:                    return sizeof( glTF::Mesh );
+        case glTFSaxObject_MeshPrimitive:           return sizeof( glTF::MeshPrimitive );
+        case glTFSaxObject_Accessor:                return sizeof( glTF::Accessor );
+        case glTFSaxObject_Material:                return sizeof( glTF::Material );
+        case glTFSaxObject_PBRMetallicRoughness:    return sizeof( glTF::MaterialPBRMetallicRoughness );
+        case glTFSaxObject_TextureInfo:             return sizeof( glTF::TextureInfo );
+        case glTFSaxObject_NormalTextureInfo:       return sizeof( glTF::MaterialNormalTextureInfo );
+        case glTFSaxObject_OcclusionTextureInfo:    return sizeof( glTF::MaterialOcclusionTextureInfo );
+        case glTFSaxObject_Texture:                 return sizeof( glTF::Texture );
+        case glTFSaxObject_Image:                   return sizeof( glTF::Image );
+        case glTFSaxObject_Sampler:                 return sizeof( glTF::Sampler );
+        case glTFSaxObject_Skin:                    return sizeof( glTF::Skin );
+        case glTFSaxObject_Animation:               return sizeof( glTF::Animation );
+        case glTFSaxObject_AnimationSampler:        return sizeof( glTF::AnimationSampler );
+        case glTFSaxObject_AnimationChannel:        return sizeof( glTF::AnimationChannel );
+        case glTFSaxObject_AccessorSparse:          return sizeof( glTF::AccessorSparse );
+        case glTFSaxObject_MorphTarget:             return sizeof( glTF::MeshPrimitive::Target );
+        default:                                    return 0;
+    }
+}
+
+// Same defaults of the json loader for missing members: invalid int and float values.
+static void sax_object_init( glTFSaxObject object, void* data ) {
+    const i32 k_int = glTF::INVALID_INT_VALUE;
+    const f32 k_float = glTF::INVALID_FLOAT_VALUE;
+
+    switch ( object ) {
+        case glTFSaxObject_Buffer:
+        {
+            ( ( glTF::Buffer* )data )->byte_length = k_int;
+            break;
+        }
+        case glTFSaxObject_BufferView:
+        {
+            glTF::BufferView& buffer_view = *( glTF::BufferView* )data;
+            buffer_view.buffer = buffer_view.byte_length = buffer_view.byte_offset = buffer_view.byte_stride = buffer_view.target = k_int;
+            break;
+        }
+        case glTFSaxObject_Node:
+        {
+            glTF::Node& node = *( glTF::Node* )data;
+            node.camera = node.mesh = node.skin = k_int;
+            break;
+        }
+        case glTFSaxObject_MeshPrimitive:
+        {
+            glTF::MeshPrimitive& primitive = *( glTF::MeshPrimitive* )data;
+            primitive.indices = primitive.material = primitive.mode = k_int;
+            break;
+        }
+        case glTFSaxObject_Accessor:
+        {
+            glTF::Accessor& accessor = *( glTF::Accessor* )data;
+            accessor.buffer_view = accessor.byte_offset = accessor.component_type = accessor.count = k_int;
+            accessor.type = glTF::Accessor::Scalar;
+            break;
+        }
+        case glTFSaxObject_Material:
+        {
+            ( ( glTF::Material* )data )->alpha_cutoff = k_float;
+            break;
+        }
+        case glTFSaxObject_PBRMetallicRoughness:
+        {
+            glTF::MaterialPBRMetallicRoughness& pbr = *( glTF::MaterialPBRMetallicRoughness* )data;
+            pbr.metallic_factor = pbr.roughness_factor = k_float;
+            break;
+        }
+        case glTFSaxObject_TextureInfo:
+        {
+            glTF::TextureInfo& texture_info = *( glTF::TextureInfo* )data;
+            texture_info.index = texture_info.texCoord = k_int;
+            break;
+        }
+        case glTFSaxObject_NormalTextureInfo:
+        {
+            glTF::MaterialNormalTextureInfo& texture_info = *( glTF::MaterialNormalTextureInfo* )data;
+            texture_info.index = texture_info.tex_coord = k_int;
+            texture_info.scale = k_float;
+            break;
+        }
+        case glTFSaxObject_OcclusionTextureInfo:
+        {
+            glTF::MaterialOcclusionTextureInfo& texture_info = *( glTF::MaterialOcclusionTextureInfo* )data;
+            texture_info.index = texture_info.texCoord = k_int;
+            texture_info.strength = k_float;
+            break;
+        }
+        case glTFSaxObject_Texture:
+        {
+            glTF::Texture& texture = *( glTF::Texture* )data;
+            texture.sampler = texture.source = k_int;
+            break;
+        }
+        case glTFSaxObject_Image:
+        {
+            ( ( glTF::Image* )data )->buffer_view = k_int;
+            break;
+        }
+        case glTFSaxObject_Sampler:
+        {
+            glTF::Sampler& sampler = *( glTF::Sampler* )data;
+            sampler.mag_filter = sampler.min_filter = sampler.wrap_s = sampler.wrap_t = k_int;
+            break;
+        }
+        case glTFSaxObject_Skin:
+        {
+            glTF::Skin& skin = *( glTF::Skin* )data;
+            skin.inverse_bind_matrices_buffer_index = skin.skeleton_root_node_index = k_int;
+            break;
+        }
+        case glTFSaxObject_AnimationSampler:
+        {
+            glTF::AnimationSampler& sampler = *( glTF::AnimationSampler* )data;
+            sampler.input_keyframe_buffer_index = sampler.output_keyframe_buffer_index = k_int;
+            sampler.interpolation = glTF::AnimationSampler::Linear;
+            break;
+        }
+        case glTFSaxObject_AnimationChannel:
+        {
+            glTF::AnimationChannel& channel = *( glTF::AnimationChannel* )data;
+            channel.sampler = channel.target_node = k_int;
+            channel.target_type = glTF::AnimationChannel::Count;
+            break;
+        }
+        case glTFSaxObject_AccessorSparse:
+        {
+            glTF::AccessorSparse& sparse = *( glTF::AccessorSparse* )data;
+            sparse.count = k_int;
+            sparse.indices.buffer_view = sparse.indices.byte_offset = sparse.indices.component_type = k_int;
+            sparse.values.buffer_view = sparse.values.byte_offset = k_int;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//
+// nlohmann SAX interface: values are written straight into the glTF structures.
+struct glTFSaxReader {
+
+    using number_integer_t  = nlohmann::json::number_integer_t;
+    using number_unsigned_t = nlohmann::json::number_unsigned_t;
+    using number_float_t    = nlohmann::json::number_float_t;
+    using string_t          = nlohmann::json::string_t;
+    using binary_t          = nlohmann::json::binary_t;
+
+    bool                            null()                                      { return value_number( 0.0 ); }
+    bool                            boolean( bool value );
+    bool                            number_integer( number_integer_t value )    { return value_number( ( f64 )value ); }
+    bool                            number_unsigned( number_unsigned_t value )  { return value_number( ( f64 )value ); }
+    bool                            number_float( number_float_t value, const string_t& ) { return value_number( value ); }
+    bool                            string( string_t& value );
+    bool                            binary( binary_t& )                         { return value_skip(); }
+
+    bool                            start_object( std::size_t );
+    bool                            key( string_t& value );
+    bool                            end_object()                                { return end_container(); }
+
+    bool                            start_array( std::size_t );
+    bool                            end_array()                                 { return end_container(); }
+
+    bool                            parse_error( std::size_t position, const std::string& last_token, const nlohmann::detail::exception& exception );
+
+    bool                            value_number( f64 value );
+    bool                            value_skip();
+    bool                            root_not_object();
+    bool                            end_container();
+
+    void                            push( glTFSaxValue type, glTFSaxObject object, void* data );
+    u32                             next_container_count();
+    void*                           allocate( sizet size );
+    void                            set_string( StringBuffer& string_buffer, const string_t& value );
+
+    void                            key_root( cstring key );
+    void                            key_object( glTFSaxFrame& frame, cstring key );
+
+    // Sets the destination of the next value.
+    void                            expect( glTFSaxValue type, void* data, u32* count = nullptr, glTFSaxObject object = glTFSaxObject_Count );
+
+    static const u32                k_max_depth = 64;
+
+    glTFSaxFrame                    frames[ k_max_depth ];
+    u32                             depth           = 0;
+    u32                             skip_depth      = 0;    // Containers opened inside a skipped value.
+
+    glTFSaxDestination              destination;
+
+    glTF::glTF*                     gltf            = nullptr;
+    Allocator*                      allocator       = nullptr;
+    const glTFPreScan*              pre_scan        = nullptr;
+    u32                             container_index = 0;
+
+}; // struct glTFSaxReader
+
+void glTFSaxReader::expect( glTFSaxValue type, void* data, u32* count, glTFSaxObject object ) {
+    destination.type = type;
+    destination.object = object;
+    destination.data = data;
+    destination.count = count;
+}
+
+u32 glTFSaxReader::next_container_count() {
+    RASSERT( container_index < pre_scan->container_counts.size );
+    return pre_scan->container_counts[ container_index++ ];
+}
+
+void* glTFSaxReader::allocate( sizet size ) {
+    if ( size == 0 ) {
+        return nullptr;
+    }
+
+    void* memory = allocator->allocate( size, 64 );
+    RASSERT( memory );
+    memset( memory, 0, size );
+    return memory;
+}
+
+void glTFSaxReader::set_string( StringBuffer& string_buffer, const string_t& value ) {
+    const u32 length = ( u32 )value.length();
+
+    string_buffer.data = ( char* )allocator->allocate( length + 1, 1 );
+    memcpy( string_buffer.data, value.c_str(), length + 1 );
+    string_buffer.buffer_size = length + 1;
+    string_buffer.current_size = length;
+    // Owned by the glTF arena, allocator can be a slice of it.
+    string_buffer.allocator = &gltf->allocator;
+}
+
+void glTFSaxReader::push( glTFSaxValue type, glTFSaxObject object, void* data ) {
+    RASSERTM( depth < k_max_depth, "glTF nesting too deep" );
+    frames[ depth++ ] = { type, object, ( u8* )data, 0 };
+}
+
+bool glTFSaxReader::value_skip() {
+    destination.type = glTFSaxValue_Skip;
+    return true;
+}
+
+// A glTF is a json object: any other root value fails the parse.
+bool glTFSaxReader::root_not_object() {
+    rprint( "glTF parse error: the root is not an object\n" );
+    return false;
+}
+
+bool glTFSaxReader::end_container() {
+    if ( skip_depth ) {
+        --skip_depth;
+    } else {
+        --depth;
+    }
+    return value_skip();
+}
+
+bool glTFSaxReader::value_number( f64 value ) {
+    if ( skip_depth ) {
+        return true;
+    }
+    if ( depth == 0 ) {
+        return root_not_object();
+    }
+
+    glTFSaxFrame& frame = frames[ depth - 1 ];
+    if ( frame.type == glTFSaxValue_IntArray ) {
+        ( ( i32* )frame.data )[ frame.index++ ] = ( i32 )value;
+        return true;
+    }
+    if ( frame.type == glTFSaxValue_FloatArray ) {
+        ( ( f32* )frame.data )[ frame.index++ ] = ( f32 )value;
+        return true;
+    }
+
+    if ( destination.type == glTFSaxValue_Int ) {
+        *( i32* )destination.data = ( i32 )value;
+    } else if ( destination.type == glTFSaxValue_Float ) {
+        *( f32* )destination.data = ( f32 )value;
+    } else if ( destination.type == glTFSaxValue_Bool ) {
+        *( bool* )destination.data = value != 0.0;
+    }
+
+    return value_skip();
+}
+
+bool glTFSaxReader::boolean( bool value ) {
+    return value_number( value ? 1.0 : 0.0 );
+}
+
+bool glTFSaxReader::string( string_t& value ) {
+    if ( skip_depth ) {
+        return true;
+    }
+    if ( depth == 0 ) {
+        return root_not_object();
+    }
+
+    switch ( destination.type ) {
+        case glTFSaxValue_String:
+        {
+            set_string( *( StringBuffer* )destination.data, value );
+            break;
+        }
+        case glTFSaxValue_AccessorType:
+        {
+            static cstring k_type_names[] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+            glTF::Accessor::Type& type = *( glTF::Accessor::Type* )destination.data;
+            for ( u32 i = 0; i < ArraySize( k_type_names ); ++i ) {
+                if ( value == k_type_names[ i ] ) {
+                    type = ( glTF::Accessor::Type )i;
+                }
+            }
+            break;
+        }
+        case glTFSaxValue_Interpolation:
+        {
+            glTF::AnimationSampler::Interpolation& interpolation = *( glTF::AnimationSampler::Interpolation* )destination.data;
+            interpolation = value == "STEP" ? glTF::AnimationSampler::Step : value == "CUBICSPLINE" ? glTF::AnimationSampler::CubicSpline : glTF::AnimationSampler::Linear;
+            break;
+        }
+        case glTFSaxValue_TargetPath:
+        {
+            static cstring k_path_names[] = { "translation", "rotation", "scale", "weights" };
+            glTF::AnimationChannel::TargetType& target_type = *( glTF::AnimationChannel::TargetType* )destination.data;
+            for ( u32 i = 0; i < ArraySize( k_path_names ); ++i ) {
+                if ( value == k_path_names[ i ] ) {
+                    target_type = ( glTF::AnimationChannel::TargetType )i;
+                }
+            }
+            RASSERTM( target_type != glTF::AnimationChannel::Count, "Error parsing target path %s\n", value.c_str() );
+            break;
+        }
+        default:
+            break;
+    }
+
+    return value_skip();
+}
+
+bool glTFSaxReader::start_object( std::size_t ) {
+    const u32 count = next_container_count();
+
+    if ( skip_depth ) {
+        ++skip_depth;
+        return true;
+    }
+
+    if ( depth == 0 ) {
+        push( glTFSaxValue_Object, glTFSaxObject_Root, gltf );
+        return value_skip();
+    }
+
+    glTFSaxFrame& parent = frames[ depth - 1 ];
+    if ( parent.type == glTFSaxValue_ObjectArray ) {
+        u8* element = parent.data + sax_object_size( parent.object ) * parent.index++;
+        if ( parent.object == glTFSaxObject_MorphTarget ) {
+            // A morph target is an attributes object.
+            glTF::MeshPrimitive::Target& target = *( glTF::MeshPrimitive::Target* )element;
+            target.attribute_count = count;
+            target.attributes = ( glTF::MeshPrimitive::Attribute* )allocate( sizeof( glTF::MeshPrimitive::Attribute ) * count );
+            push( glTFSaxValue_Object, glTFSaxObject_Attributes, target.attributes );
+            return value_skip();
+        }
+        sax_object_init( parent.object, element );
+        push( glTFSaxValue_Object, parent.object, element );
+        return value_skip();
+    }
+
+    switch ( destination.type ) {
+        case glTFSaxValue_Object:
+        {
+            if ( destination.object == glTFSaxObject_Attributes ) {
+                // Keys of the object are the attribute names.
+                glTF::MeshPrimitive::Attribute* attributes = ( glTF::MeshPrimitive::Attribute* )allocate( sizeof( glTF::MeshPrimitive::Attribute ) * count );
+                *( glTF::MeshPrimitive::Attribute** )destination.data = attributes;
+                *destination.count = count;
+                push( glTFSaxValue_Object, glTFSaxObject_Attributes, attributes );
+            } else {
+                push( glTFSaxValue_Object, destination.object, destination.data );
+            }
+            break;
+        }
+        case glTFSaxValue_ObjectPointer:
+        {
+            void* object = allocate( sax_object_size( destination.object ) );
+            sax_object_init( destination.object, object );
+            *( void** )destination.data = object;
+            push( glTFSaxValue_Object, destination.object, object );
+            break;
+        }
+        default:
+        {
+            skip_depth = 1;
+            break;
+        }
+    }
+
+    return value_skip();
+}
+
+bool glTFSaxReader::start_array( std::size_t ) {
+    const u32 count = next_container_count();
+
+    if ( skip_depth ) {
+        ++skip_depth;
+        return true;
+    }
+    if ( depth == 0 ) {
+        return root_not_object();
+    }
+
+    switch ( destination.type ) {
+        case glTFSaxValue_IntArray:
+        case glTFSaxValue_FloatArray:
+        {
+            void* elements = allocate( sizeof( u32 ) * count );
+            *( void** )destination.data = elements;
+            *destination.count = count;
+            push( destination.type, glTFSaxObject_Count, elements );
+            break;
+        }
+        case glTFSaxValue_ObjectArray:
+        {
+            void* elements = allocate( sax_object_size( destination.object ) * count );
+            *( void** )destination.data = elements;
+            *destination.count = count;
+            push( glTFSaxValue_ObjectArray, destination.object, elements );
+            break;
+        }
+        default:
+        {
+            skip_depth = 1;
+            break;
+        }
+    }
+
+    return value_skip();
+}
+
+bool glTFSaxReader::key( string_t& value ) {
+    if ( skip_depth ) {
+        return true;
+    }
+
+    glTFSaxFrame& frame = frames[ depth - 1 ];
+    value_skip();
+
+    if ( frame.object == glTFSaxObject_Root ) {
+        key_root( value.c_str() );
+    } else if ( frame.object == glTFSaxObject_Attributes ) {
+        glTF::MeshPrimitive::Attribute& attribute = ( ( glTF::MeshPrimitive::Attribute* )frame.data )[ frame.index++ ];
+        set_string( attribute.key, value );
+        expect( glTFSaxValue_Int, &attribute.accessor_index );
+    } else {
+        key_object( frame, value.c_str() );
+    }
+
+    return true;
+}
+
+void glTFSaxReader::key_root( cstring key ) {
+    glTF::glTF& data = *gltf;
+
+    if ( strcmp( key, "asset" ) == 0 ) {
+        expect( glTFSaxValue_Object, &data.asset, nullptr, glTFSaxObject_Asset );
+    } else if ( strcmp( key, "scene" ) == 0 ) {
+        expect( glTFSaxValue_Int, &data.scene );
+    } else if ( strcmp( key, "scenes" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.scenes, &data.scenes_count, glTFSaxObject_Scene );
+    } else if ( strcmp( key, "buffers" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.buffers, &data.buffers_count, glTFSaxObject_Buffer );
+    } else if ( strcmp( key, "bufferViews" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.buffer_views, &data.buffer_views_count, glTFSaxObject_BufferView );
+    } else if ( strcmp( key, "nodes" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.nodes, &data.nodes_count, glTFSaxObject_Node );
+    } else if ( strcmp( key, "meshes" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.meshes, &data.meshes_count, glTFSaxObject_Mesh );
+    } else if ( strcmp( key, "accessors" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.accessors, &data.accessors_count, glTFSaxObject_Accessor );
+    } else if ( strcmp( key, "materials" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.materials, &data.materials_count, glTFSaxObject_Material );
+    } else if ( strcmp( key, "textures" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.textures, &data.textures_count, glTFSaxObject_Texture );
+    } else if ( strcmp( key, "images" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.images, &data.images_count, glTFSaxObject_Image );
+    } else if ( strcmp( key, "samplers" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.samplers, &data.samplers_count, glTFSaxObject_Sampler );
+    } else if ( strcmp( key, "skins" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.skins, &data.skins_count, glTFSaxObject_Skin );
+    } else if ( strcmp( key, "animations" ) == 0 ) {
+        expect( glTFSaxValue_ObjectArray, &data.animations, &data.animations_count, glTFSaxObject_Animation );
+    }
+}
+
+void glTFSaxReader::key_object( glTFSaxFrame& frame, cstring key ) {
+    switch ( frame.object ) {
+        case glTFSaxObject_Asset:
+        {
+            glTF::Asset& asset = *( glTF::Asset* )frame.data;
+            if ( strcmp( key, "copyright" ) == 0 )          expect( glTFSaxValue_String, &asset.copyright );
+            else if ( strcmp( key, "generator" ) == 0 )     expect( glTFSaxValue_String, &asset.generator );
+            else if ( strcmp( key, "minVersion" ) == 0 )    expect( glTFSaxValue_String, &asset.minVersion );
+            else if ( strcmp( key, "version" ) == 0 )       expect( glTFSaxValue_String, &asset.version );
+            break;
+        }
+        case glTFSaxObject_Scene:
+        {
+            glTF::Scene& scene = *( glTF::Scene* )frame.data;
+            if ( strcmp( key, "nodes" ) == 0 )              expect( glTFSaxValue_IntArray, &scene.nodes, &scene.nodes_count );
+            break;
+        }
+        case glTFSaxObject_Buffer:
+        {
+            glTF::Buffer& buffer = *( glTF::Buffer* )frame.data;
+            if ( strcmp( key, "uri" ) == 0 )                expect( glTFSaxValue_String, &buffer.uri );
+            else if ( strcmp( key, "byteLength" ) == 0 )    expect( glTFSaxValue_Int, &buffer.byte_length );
+            else if ( strcmp( key, "name" ) == 0 )          expect( glTFSaxValue_String, &buffer.name );
+            break;
+        }
+        case glTFSaxObject_BufferView:
+        {
+            glTF::BufferView& buffer_view = *( glTF::BufferView* )frame.data;
+            if ( strcmp( key, "buffer" ) == 0 )             expect( glTFSaxValue_Int, &buffer_view.buffer );
+            else if ( strcmp( key, "byteLength" ) == 0 )    expect( glTFSaxValue_Int, &buffer_view.byte_length );
+            else if ( strcmp( key, "byteOffset" ) == 0 )    expect( glTFSaxValue_Int, &buffer_view.byte_offset );
+            else if ( strcmp( key, "byteStride" ) == 0 )    expect( glTFSaxValue_Int, &buffer_view.byte_stride );
+            else if ( strcmp( key, "target" ) == 0 )        expect( glTFSaxValue_Int, &buffer_view.target );
+            else if ( strcmp( key, "name" ) == 0 )          expect( glTFSaxValue_String, &buffer_view.name );
+            break;
+        }
+        case glTFSaxObject_Node:
+        {
+            glTF::Node& node = *( glTF::Node* )frame.data;
+            if ( strcmp( key, "camera" ) == 0 )             expect( glTFSaxValue_Int, &node.camera );
+            else if ( strcmp( key, "mesh" ) == 0 )          expect( glTFSaxValue_Int, &node.mesh );
+            else if ( strcmp( key, "skin" ) == 0 )          expect( glTFSaxValue_Int, &node.skin );
+            else if ( strcmp( key, "children" ) == 0 )      expect( glTFSaxValue_IntArray, &node.children, &node.children_count );
+            else if ( strcmp( key, "matrix" ) == 0 )        expect( glTFSaxValue_FloatArray, &node.matrix, &node.matrix_count );
+            else if ( strcmp( key, "rotation" ) == 0 )      expect( glTFSaxValue_FloatArray, &node.rotation, &node.rotation_count );
+            else if ( strcmp( key, "scale" ) == 0 )         expect( glTFSaxValue_FloatArray, &node.scale, &node.scale_count );
+            else if ( strcmp( key, "translation" ) == 0 )   expect( glTFSaxValue_FloatArray, &node.translation, &node.translation_count );
+            else if ( strcmp( key, "weights" ) == 0 )       expect( glTFSaxValue_FloatArray, &node.weights, &node.weights_count );
+            else if ( strcmp( key, "name" ) == 0 )          expect( glTFSaxValue_String, &node.name );
+            break;
+        }
+        case glTFSaxObject_Mesh:
+        {
+            glTF::Mesh& mesh = *( glTF::Mesh* )frame.data;
+            if ( strcmp( key, "primitives" ) == 0 )         expect( glTFSaxValue_ObjectArray, &mesh.primitives, &mesh.primitives_count, glTFSaxObject_MeshPrimitive );
+            else if ( strcmp( key, "weights" ) == 0 )       expect( glTFSaxValue_FloatArray, &mesh.weights, &mesh.weights_count );
+            else if ( strcmp( key, "name" ) == 0 )          expect( glTFSaxValue_String, &mesh.name );
+            break;
+        }
+        case glTFSaxObject_MeshPrimitive:
+        {
+            glTF::MeshPrimitive& primitive = *( glTF::MeshPrimitive* )frame.data;
+            if ( strcmp( key, "indices" ) == 0 )            expect( glTFSaxValue_Int, &primitive.indices );
+            else if ( strcmp( key, "material" ) == 0 )      expect( glTFSaxValue_Int, &primitive.material );
+            else if ( strcmp( key, "mode" ) == 0 )          expect( glTFSaxValue_Int, &primitive.mode );
+            else if ( strcmp( key, "attributes" ) == 0 )    expect( glTFSaxValue_Object, &primitive.attributes, &primitive.attribute_count, glTFSaxObject_Attributes );
+            else if ( strcmp( key, "targets" ) == 0 )       expect( glTFSaxValue_ObjectArray, &primitive.targets, &primitive.targets_count, glTFSaxObject_MorphTarget );
+            break;
+        }
+        case glTFSaxObject_Accessor:
+        {
+            glTF::Accessor& accessor = *( glTF::Accessor* )frame.data;
+            if ( strcmp( key, "bufferView" ) == 0 )         expect( glTFSaxValue_Int, &accessor.buffer_view );
+            else if ( strcmp( key, "byteOffset" ) == 0 )    expect( glTFSaxValue_Int, &accessor.byte_offset );
+            else if ( strcmp( key, "componentType" ) == 0 ) expect( glTFSaxValue_Int, &accessor.component_type );
+            else if ( strcmp( key, "count" ) == 0 )         expect( glTFSaxValue_Int, &accessor.count );
+            else if ( strcmp( key, "max" ) == 0 )           expect( glTFSaxValue_FloatArray, &accessor.max, &accessor.max_count );
+            else if ( strcmp( key, "min" ) == 0 )           expect( glTFSaxValue_FloatArray, &accessor.min, &accessor.min_count );
+            else if ( strcmp( key, "normalized" ) == 0 )    expect( glTFSaxValue_Bool, &accessor.normalized );
+            else if ( strcmp( key, "type" ) == 0 )          expect( glTFSaxValue_AccessorType, &accessor.type );
+            else if ( strcmp( key, "sparse" ) == 0 )        expect( glTFSaxValue_ObjectPointer, &accessor.sparse, nullptr, glTFSaxObject_AccessorSparse );
+            break;
+        }
+        case glTFSaxObject_AccessorSparse:
+        {
+            glTF::AccessorSparse& sparse = *( glTF::AccessorSparse* )frame.data;
+            if ( strcmp( key, "count" ) == 0 )              expect( glTFSaxValue_Int, &sparse.count );
+            else if ( strcmp( key, "indices" ) == 0 )       expect( glTFSaxValue_Object, &sparse.indices, nullptr, glTFSaxObject_AccessorSparseIndices );
+            else if ( strcmp( key, "values" ) == 0 )        expect( glTFSaxValue_Object, &sparse.values, nullptr, glTFSaxObject_AccessorSparseValues );
+            break;
+        }
+        case glTFSaxObject_AccessorSparseIndices:
+        {
+            glTF::AccessorSparseIndices& indices = *( glTF::AccessorSparseIndices* )frame.data;
+            if ( strcmp( key, "bufferView" ) == 0 )         expect( glTFSaxValue_Int, &indices.buffer_view );
+            else if ( strcmp( key, "byteOffset" ) == 0 )    expect( glTFSaxValue_Int, &indices.byte_offset );
+            else if ( strcmp( key, "componentType" ) == 0 ) expect( glTFSaxValue_Int, &indices.component_type );
+            break;
+        }
+        case glTFSaxObject_AccessorSparseValues:
+        {
+            glTF::AccessorSparseValues& values = *( glTF::AccessorSparseValues* )frame.data;
+            if ( strcmp( key, "bufferView" ) == 0 )         expect( glTFSaxValue_Int, &values.buffer_view );
+            else if ( strcmp( key, "byteOffset" ) == 0 )    expect( glTFSaxValue_Int, &values.byte_offset );
+            break;
+        }
+        case glTFSaxObject_Material:
+        {
+            glTF::Material& material = *( glTF::Material* )frame.data;
+            if ( strcmp( key, "emissiveFactor" ) == 0 )             expect( glTFSaxValue_FloatArray, &material.emissive_factor, &material.emissive_factor_count );
+            else if ( strcmp( key, "alphaCutoff" ) == 0 )           expect( glTFSaxValue_Float, &material.alpha_cutoff );
+            else if ( strcmp( key, "alphaMode" ) == 0 )             expect( glTFSaxValue_String, &material.alpha_mode );
+            else if ( strcmp( key, "doubleSided" ) == 0 )           expect( glTFSaxValue_Bool, &material.double_sided );
+            else if ( strcmp( key, "emissiveTexture" ) == 0 )       expect( glTFSaxValue_ObjectPointer, &material.emissive_texture, nullptr, glTFSaxObject_TextureInfo );
+            else if ( strcmp( key, "normalTexture" ) == 0 )         expect( glTFSaxValue_ObjectPointer, &material.normal_texture, nullptr, glTFSaxObject_NormalTextureInfo );
+            else if ( strcmp( key, "occlusionTexture" ) == 0 )      expect( glTFSaxValue_ObjectPointer, &material.occlusion_texture, nullptr, glTFSaxObject_OcclusionTextureInfo );
+            else if ( strcmp( key, "pbrMetallicRoughness" ) == 0 )  expect( glTFSaxValue_ObjectPointer, &material.pbr_metallic_roughness, nullptr, glTFSaxObject_PBRMetallicRoughness );
+            else if ( strcmp( key, "name" ) == 0 )                  expect( glTFSaxValue_String, &material.name );
+            break;
+        }
+        case glTFSaxObject_PBRMetallicRoughness:
+        {
+            glTF::MaterialPBRMetallicRoughness& pbr = *( glTF::MaterialPBRMetallicRoughness* )frame.data;
+            if ( strcmp( key, "baseColorFactor" ) == 0 )                expect( glTFSaxValue_FloatArray, &pbr.base_color_factor, &pbr.base_color_factor_count );
+            else if ( strcmp( key, "baseColorTexture" ) == 0 )          expect( glTFSaxValue_ObjectPointer, &pbr.base_color_texture, nullptr, glTFSaxObject_TextureInfo );
+            else if ( strcmp( key, "metallicFactor" ) == 0 )            expect( glTFSaxValue_Float, &pbr.metallic_factor );
+            else if ( strcmp( key, "metallicRoughnessTexture" ) == 0 )  expect( glTFSaxValue_ObjectPointer, &pbr.metallic_roughness_texture, nullptr, glTFSaxObject_TextureInfo );
+            else if ( strcmp( key, "roughnessFactor" ) == 0 )           expect( glTFSaxValue_Float, &pbr.roughness_factor );
+            break;
+        }
+        case glTFSaxObject_TextureInfo:
+        {
+            glTF::TextureInfo& texture_info = *( glTF::TextureInfo* )frame.data;
+            if ( strcmp( key, "index" ) == 0 )              expect( glTFSaxValue_Int, &texture_info.index );
+            else if ( strcmp( key, "texCoord" ) == 0 )      expect( glTFSaxValue_Int, &texture_info.texCoord );
+            break;
+        }
+        case glTFSaxObject_NormalTextureInfo:
+        {
+            glTF::MaterialNormalTextureInfo& texture_info = *( glTF::MaterialNormalTextureInfo* )frame.data;
+            if ( strcmp( key, "index" ) == 0 )              expect( glTFSaxValue_Int, &texture_info.index );
+            else if ( strcmp( key, "texCoord" ) == 0 )      expect( glTFSaxValue_Int, &texture_info.tex_coord );
+            else if ( strcmp( key, "scale" ) == 0 )         expect( glTFSaxValue_Float, &texture_info.scale );
+            break;
+        }
+        case glTFSaxObject_OcclusionTextureInfo:
+        {
+            glTF::MaterialOcclusionTextureInfo& texture_info = *( glTF::MaterialOcclusionTextureInfo* )frame.data;
+            if ( strcmp( key, "index" ) == 0 )              expect( glTFSaxValue_Int, &texture_info.index );
+            else if ( strcmp( key, "texCoord" ) == 0 )      expect( glTFSaxValue_Int, &texture_info.texCoord );
+            else if ( strcmp( key, "strength" ) == 0 )      expect( glTFSaxValue_Float, &texture_info.strength );
+            break;
+        }
+        case glTFSaxObject_Texture:
+        {
+            glTF::Texture& texture = *( glTF::Texture* )frame.data;
+            if ( strcmp( key, "sampler" ) == 0 )            expect( glTFSaxValue_Int, &texture.sampler );
+            else if ( strcmp( key, "source" ) == 0 )        expect( glTFSaxValue_Int, &texture.source );
+            else if ( strcmp( key, "name" ) == 0 )          expect( glTFSaxValue_String, &texture.name );
+            break;
+        }
+        case glTFSaxObject_Image:
+        {
+            glTF::Image& image = *( glTF::Image* )frame.data;
+            if ( strcmp( key, "bufferView" ) == 0 )         expect( glTFSaxValue_Int, &image.buffer_view );
+            else if ( strcmp( key, "mimeType" ) == 0 )      expect( glTFSaxValue_String, &image.mime_type );
+            else if ( strcmp( key, "uri" ) == 0 )           expect( glTFSaxValue_String, &image.uri );
+            break;
+        }
+        case glTFSaxObject_Sampler:
+        {
+            glTF::Sampler& sampler = *( glTF::Sampler* )frame.data;
+            if ( strcmp( key, "magFilter" ) == 0 )          expect( glTFSaxValue_Int, &sampler.mag_filter );
+            else if ( strcmp( key, "minFilter" ) == 0 )     expect( glTFSaxValue_Int, &sampler.min_filter );
+            else if ( strcmp( key, "wrapS" ) == 0 )         expect( glTFSaxValue_Int, &sampler.wrap_s );
+            else if ( strcmp( key, "wrapT" ) == 0 )         expect( glTFSaxValue_Int, &sampler.wrap_t );
+            break;
+        }
+        case glTFSaxObject_Skin:
+        {
+            glTF::Skin& skin = *( glTF::Skin* )frame.data;
+            if ( strcmp( key, "skeleton" ) == 0 )                   expect( glTFSaxValue_Int, &skin.skeleton_root_node_index );
+            else if ( strcmp( key, "inverseBindMatrices" ) == 0 )   expect( glTFSaxValue_Int, &skin.inverse_bind_matrices_buffer_index );
+            else if ( strcmp( key, "joints" ) == 0 )                expect( glTFSaxValue_IntArray, &skin.joints, &skin.joints_count );
+            break;
+        }
+        case glTFSaxObject_Animation:
+        {
+            glTF::Animation& animation = *( glTF::Animation* )frame.data;
+            if ( strcmp( key, "samplers" ) == 0 )           expect( glTFSaxValue_ObjectArray, &animation.samplers, &animation.samplers_count, glTFSaxObject_AnimationSampler );
+            else if ( strcmp( key, "channels" ) == 0 )      expect( glTFSaxValue_ObjectArray, &animation.channels, &animation.channels_count, glTFSaxObject_AnimationChannel );
+            break;
+        }
+        case glTFSaxObject_AnimationSampler:
+        {
+            glTF::AnimationSampler& sampler = *( glTF::AnimationSampler* )frame.data;
+            if ( strcmp( key, "input" ) == 0 )              expect( glTFSaxValue_Int, &sampler.input_keyframe_buffer_index );
+            else if ( strcmp( key, "output" ) == 0 )        expect( glTFSaxValue_Int, &sampler.output_keyframe_buffer_index );
+            else if ( strcmp( key, "interpolation" ) == 0 ) expect( glTFSaxValue_Interpolation, &sampler.interpolation );
+            break;
+        }
+        case glTFSaxObject_AnimationChannel:
+        {
+            glTF::AnimationChannel& channel = *( glTF::AnimationChannel* )frame.data;
+            if ( strcmp( key, "sampler" ) == 0 )            expect( glTFSaxValue_Int, &channel.sampler );
+            else if ( strcmp( key, "target" ) == 0 )        expect( glTFSaxValue_Object, &channel, nullptr, glTFSaxObject_ChannelTarget );
+            break;
+        }
+        case glTFSaxObject_ChannelTarget:
+        {
+            glTF::AnimationChannel& channel = *( glTF::AnimationChannel* )frame.data;
+            if ( strcmp( key, "node" ) == 0 )               expect( glTFSaxValue_Int, &channel.target_node );
+            else if ( strcmp( key, "path" ) == 0 )          expect( glTFSaxValue_TargetPath, &channel.target_type );
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool glTFSaxReader::parse_error( std::size_t position, const std::string& last_token, const nlohmann::detail::exception& exception ) {
+    rprint( "glTF parse error at byte %llu, token '%s': %s\n", ( u64 )position, last_token.c_str(), exception.what() );
+    return false;
+}
+
+// Parallel parsing ///////////////////////////////////////////////////////
+
+static const sizet k_gltf_chunk_text_size = 16 * 1024;     // Text parsed by a single task.
+
+//
+// Consecutive elements of a root array, parsed by one task into its own slice of the arena.
+struct glTFSaxChunk {
+    glTFSaxObject                   object;
+    u8*                             elements;           // Array of the root member.
+    u32                             member_index;
+    u32                             first_element;
+    u32                             element_count;
+    sizet                           arena_offset;
+    sizet                           arena_size;
+    bool                            parsed;
+}; // struct glTFSaxChunk
+
+//
+//
+struct glTFSaxChunkTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    glTFSaxChunk*                   chunks          = nullptr;
+    const glTFPreScan*              pre_scan        = nullptr;
+    const char*                     text            = nullptr;
+    glTF::glTF*                     gltf            = nullptr;
+}; // struct glTFSaxChunkTask
+
+// Bump allocations into memory owned by the glTF arena, nothing to free.
+static void sax_arena_slice( LinearAllocator& slice, u8* memory, sizet size ) {
+    slice.memory = memory;
+    slice.total_size = size;
+    slice.allocated_size = 0;
+}
+
+void glTFSaxChunkTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    for ( u32 c = range.start; c < range.end; ++c ) {
+        glTFSaxChunk& chunk = chunks[ c ];
+        const glTFPreScanMember& member = pre_scan->members[ chunk.member_index ];
+
+        LinearAllocator arena;
+        sax_arena_slice( arena, gltf->allocator.memory + chunk.arena_offset, chunk.arena_size );
+
+        chunk.parsed = true;
+        for ( u32 e = chunk.first_element; e < chunk.first_element + chunk.element_count; ++e ) {
+            const glTFPreScanElement& element = pre_scan->elements[ e ];
+
+            glTFSaxReader reader;
+            reader.gltf = gltf;
+            reader.allocator = &arena;
+            reader.pre_scan = pre_scan;
+            reader.container_index = element.container_index;
+            // Continue the root array from this element.
+            reader.push( glTFSaxValue_ObjectArray, chunk.object, chunk.elements );
+            reader.frames[ 0 ].index = e - member.first_element;
+
+            if ( !nlohmann::json::sax_parse( text + element.begin, text + element.end, &reader ) ) {
+                chunk.parsed = false;
+                break;
+            }
+        }
+    }
+}
+
+// Root arrays of objects are split in chunks parsed by tasks, the remaining
+// members are parsed on this thread meanwhile. Every chunk gets its slice of the
+// arena, sized by the pre-scan counters of its elements: no locks and nothing to merge.
+static bool gltf_parse_sax_parallel( const char* text, glTF::glTF& out_gltf, const glTFPreScan& pre_scan,
+                                     enki::TaskScheduler* task_scheduler, Allocator* temp_allocator ) {
+
+    glTFSaxReader reader;
+    reader.gltf = &out_gltf;
+    reader.pre_scan = &pre_scan;
+    reader.push( glTFSaxValue_Object, glTFSaxObject_Root, &out_gltf );
+
+    Array<glTFSaxDestination> destinations;
+    destinations.init( temp_allocator, pre_scan.members.size, pre_scan.members.size );
+
+    Array<glTFSaxChunk> chunks;
+    chunks.init( temp_allocator, 64 );
+
+    // Counters of what is parsed on this thread: everything but the chunks.
+    glTFPreScanCounters serial_counters = pre_scan.counters;
+
+    for ( u32 m = 0; m < pre_scan.members.size; ++m ) {
+        const glTFPreScanMember& member = pre_scan.members[ m ];
+
+        char key[ 64 ];
+        const sizet key_length = member.key_end - member.key_begin;
+        if ( key_length >= ArraySize( key ) ) {
+            destinations[ m ] = glTFSaxDestination{ };
+            continue;
+        }
+        memcpy( key, text + member.key_begin, key_length );
+        key[ key_length ] = 0;
+
+        reader.value_skip();
+        reader.key_root( key );
+        destinations[ m ] = reader.destination;
+
+        if ( reader.destination.type != glTFSaxValue_ObjectArray ) {
+            continue;
+        }
+
+        glTFSaxChunk* chunk = nullptr;
+        sizet chunk_begin = 0;
+        for ( u32 e = member.first_element; e < member.first_element + member.element_count; ++e ) {
+            const glTFPreScanElement& element = pre_scan.elements[ e ];
+            if ( !chunk || element.end - chunk_begin > k_gltf_chunk_text_size ) {
+                chunk = &chunks.push_use();
+                *chunk = { reader.destination.object, nullptr, m, e, 0, 0, 0, false };
+                chunk_begin = element.begin;
+            }
+            ++chunk->element_count;
+            // Bounded by the chunk, but the element itself is a slot of the root array, allocated on this thread.
+            glTFPreScanCounters element_counters = element.counters;
+            element_counters.root_element_bytes = 0;
+            chunk->arena_size += element_counters.get_arena_size();
+            serial_counters.subtract( element_counters );
+        }
+    }
+
+    // Arena layout: this thread first, then the chunks.
+    sizet arena_size = memory_align( serial_counters.get_arena_size(), 64 );
+    for ( u32 c = 0; c < chunks.size; ++c ) {
+        chunks[ c ].arena_offset = arena_size;
+        arena_size += memory_align( chunks[ c ].arena_size, 64 );
+    }
+
+    out_gltf.allocator.init( arena_size );
+
+    LinearAllocator serial_arena;
+    sax_arena_slice( serial_arena, out_gltf.allocator.memory, chunks.size ? chunks[ 0 ].arena_offset : arena_size );
+    reader.allocator = &serial_arena;
+
+    // Root arrays must exist before the tasks fill them.
+    for ( u32 m = 0; m < pre_scan.members.size; ++m ) {
+        const glTFSaxDestination& destination = destinations[ m ];
+        if ( destination.type == glTFSaxValue_ObjectArray ) {
+            const u32 count = pre_scan.container_counts[ pre_scan.members[ m ].container_index ];
+            *( void** )destination.data = reader.allocate( sax_object_size( destination.object ) * count );
+            *destination.count = count;
+        }
+    }
+
+    for ( u32 c = 0; c < chunks.size; ++c ) {
+        chunks[ c ].elements = *( u8** )destinations[ chunks[ c ].member_index ].data;
+    }
+
+    glTFSaxChunkTask chunk_task;
+    chunk_task.m_SetSize = chunks.size;
+    chunk_task.chunks = chunks.data;
+    chunk_task.pre_scan = &pre_scan;
+    chunk_task.text = text;
+    chunk_task.gltf = &out_gltf;
+
+    if ( chunks.size ) {
+        task_scheduler->AddTaskSetToPipe( &chunk_task );
+    }
+
+    bool parsed = true;
+    for ( u32 m = 0; m < pre_scan.members.size && parsed; ++m ) {
+        const glTFSaxDestination& destination = destinations[ m ];
+        if ( destination.type == glTFSaxValue_Skip || destination.type == glTFSaxValue_ObjectArray ) {
+            continue;
+        }
+
+        const glTFPreScanMember& member = pre_scan.members[ m ];
+        reader.destination = destination;
+        reader.container_index = member.container_index;
+        parsed = nlohmann::json::sax_parse( text + member.value_begin, text + member.value_end, &reader );
+    }
+
+    if ( chunks.size ) {
+        task_scheduler->WaitforTask( &chunk_task );
+    }
+
+    for ( u32 c = 0; c < chunks.size; ++c ) {
+        parsed = parsed && chunks[ c ].parsed;
+    }
+
+    out_gltf.allocator.allocated_size = arena_size;
+
+    chunks.shutdown();
+    destinations.shutdown();
+
+    return parsed;
+}
+
+bool gltf_parse_sax( const char* text, sizet size, glTF::glTF& out_gltf, enki::TaskScheduler* task_scheduler ) {
+    Allocator* heap_allocator = &MemoryService::instance()->system_allocator;
+
+    glTFPreScan pre_scan;
+    if ( !pre_scan.scan( text, size, heap_allocator, task_scheduler != nullptr ) ) {
+        rprint( "glTF pre-scan failed: malformed json\n" );
+        pre_scan.shutdown();
+        return false;
+    }
+
+    bool parsed = false;
+    if ( task_scheduler ) {
+        parsed = gltf_parse_sax_parallel( text, out_gltf, pre_scan, task_scheduler, heap_allocator );
+    } else {
+        out_gltf.allocator.init( pre_scan.get_arena_size() );
+
+        glTFSaxReader reader;
+        reader.gltf = &out_gltf;
+        reader.allocator = &out_gltf.allocator;
+        reader.pre_scan = &pre_scan;
+
+        parsed = nlohmann::json::sax_parse( text, text + size, &reader );
+    }
+
+    pre_scan.shutdown();
+
+    if ( !parsed ) {
+        out_gltf.allocator.shutdown();
+        out_gltf = glTF::glTF{};
+    }
+    return parsed;
+}
+
+} // namespace syi
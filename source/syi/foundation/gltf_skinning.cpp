@@ -0,0 +1,257 @@
+#include "gltf_skinning.hpp"
+#include "gltf_accessor.hpp"
+#include "gltf_animation.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/log.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/mat4.h"     // SSE2 and AVX paths of the matrix products.
+#include "external/cglm/quat.h"
+
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_skinning_min_vertices = 4096;        // Vertices skinned by a single task at least.
+
+// NodeHierarchy //////////////////////////////////////////////////////////
+
+void NodeHierarchy::init( const glTF::glTF& gltf, Allocator* allocator_ ) {
+    allocator = allocator_;
+    nodes_count = gltf.nodes_count;
+
+    parents = ( i32* )allocator->allocate( ( sizeof( i32 ) + sizeof( u32 ) ) * nodes_count + 1, 4 );
+    RASSERT( parents );
+    order = ( u32* )( parents + nodes_count );
+
+    for ( u32 n = 0; n < nodes_count; ++n ) {
+        parents[ n ] = -1;
+    }
+    for ( u32 n = 0; n < nodes_count; ++n ) {
+        const glTF::Node& node = gltf.nodes[ n ];
+        for ( u32 c = 0; c < node.children_count; ++c ) {
+            parents[ node.children[ c ] ] = n;
+        }
+    }
+
+    // Breadth first from the roots.
+    u32 order_count = 0;
+    for ( u32 n = 0; n < nodes_count; ++n ) {
+        if ( parents[ n ] < 0 ) {
+            order[ order_count++ ] = n;
+        }
+    }
+    for ( u32 i = 0; i < order_count; ++i ) {
+        const glTF::Node& node = gltf.nodes[ order[ i ] ];
+        for ( u32 c = 0; c < node.children_count; ++c ) {
+            order[ order_count++ ] = node.children[ c ];
+        }
+    }
+
+    RASSERTM( order_count == nodes_count, "glTF node hierarchy has cycles" );
+}
+
+void NodeHierarchy::shutdown() {
+    if ( parents ) {
+        allocator->deallocate( parents );
+    }
+
+    parents = nullptr;
+    order = nullptr;
+    nodes_count = 0;
+}
+
+void NodeHierarchy::compute_world_matrices( const AnimationPose& pose, mat4s* world_matrices ) const {
+    RASSERT( pose.nodes_count == nodes_count );
+
+    for ( u32 i = 0; i < nodes_count; ++i ) {
+        const u32 n = order[ i ];
+
+        // T * R * S
+        mat4 local;
+        glm_quat_mat4( pose.rotations[ n ].raw, local );
+        glm_vec4_scale( local[ 0 ], pose.scales[ n ].x, local[ 0 ] );
+        glm_vec4_scale( local[ 1 ], pose.scales[ n ].y, local[ 1 ] );
+        glm_vec4_scale( local[ 2 ], pose.scales[ n ].z, local[ 2 ] );
+        glm_vec4( pose.translations[ n ].raw, 1.0f, local[ 3 ] );
+
+        if ( parents[ n ] < 0 ) {
+            glm_mat4_copy( local, world_matrices[ n ].raw );
+        } else {
+            glm_mat4_mul( world_matrices[ parents[ n ] ].raw, local, world_matrices[ n ].raw );
+        }
+    }
+}
+
+// SkinPalettes ///////////////////////////////////////////////////////////
+
+bool SkinPalettes::init( const glTF::glTF& gltf, u8* const* buffers_data, Allocator* allocator_ ) {
+    allocator = allocator_;
+    skins_count = gltf.skins_count;
+
+    palette_size = 0;
+    for ( u32 s = 0; s < skins_count; ++s ) {
+        palette_size += gltf.skins[ s ].joints_count;
+    }
+
+    const sizet matrices_size = sizeof( mat4s ) * palette_size;
+    u8* memory = ( u8* )allocator->allocate( matrices_size + sizeof( u32 ) * ( palette_size + skins_count + 1 ), 64 );
+    RASSERT( memory );
+    inverse_bind_matrices = ( mat4s* )memory;
+    joints = ( u32* )( memory + matrices_size );
+    palette_offsets = joints + palette_size;
+
+    bool valid = true;
+    u32 offset = 0;
+    for ( u32 s = 0; s < skins_count; ++s ) {
+        const glTF::Skin& skin = gltf.skins[ s ];
+        palette_offsets[ s ] = offset;
+
+        for ( u32 j = 0; j < skin.joints_count; ++j ) {
+            joints[ offset + j ] = skin.joints[ j ];
+            valid = valid && skin.joints[ j ] >= 0 && skin.joints[ j ] < ( i32 )gltf.nodes_count;
+        }
+
+        // Without inverse bind matrices the joints are already in the mesh space.
+        AccessorView view;
+        if ( skin.inverse_bind_matrices_buffer_index != glTF::INVALID_INT_VALUE ) {
+            if ( view.init( gltf, skin.inverse_bind_matrices_buffer_index, buffers_data ) && view.component_count == 16 && view.count == skin.joints_count ) {
+                view.read_floats( inverse_bind_matrices[ offset ].raw[ 0 ] );
+            } else {
+                rprint( "Skin %u: cannot read %u inverse bind matrices\n", s, skin.joints_count );
+                valid = false;
+            }
+        } else {
+            for ( u32 j = 0; j < skin.joints_count; ++j ) {
+                glm_mat4_identity( inverse_bind_matrices[ offset + j ].raw );
+            }
+        }
+
+        offset += skin.joints_count;
+    }
+    palette_offsets[ skins_count ] = offset;
+
+    if ( !valid ) {
+        shutdown();
+    }
+    return valid;
+}
+
+void SkinPalettes::shutdown() {
+    if ( inverse_bind_matrices ) {
+        allocator->deallocate( inverse_bind_matrices );
+    }
+
+    inverse_bind_matrices = nullptr;
+    joints = nullptr;
+    palette_offsets = nullptr;
+    skins_count = palette_size = 0;
+}
+
+static void skin_compute_palette( const SkinPalettes& skins, u32 skin, const mat4s* world_matrices, mat4s* palette ) {
+    for ( u32 i = skins.palette_offsets[ skin ]; i < skins.palette_offsets[ skin + 1 ]; ++i ) {
+        glm_mat4_mul( ( vec4* )world_matrices[ skins.joints[ i ] ].raw, ( vec4* )skins.inverse_bind_matrices[ i ].raw, palette[ i ].raw );
+    }
+}
+
+//
+//
+struct SkinPaletteTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    const SkinPalettes*             skins           = nullptr;
+    const mat4s*                    world_matrices  = nullptr;
+    mat4s*                          palette         = nullptr;
+}; // struct SkinPaletteTask
+
+void SkinPaletteTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    for ( u32 s = range.start; s < range.end; ++s ) {
+        skin_compute_palette( *skins, s, world_matrices, palette );
+    }
+}
+
+void SkinPalettes::compute_palettes( const mat4s* world_matrices, mat4s* palette, enki::TaskScheduler* task_scheduler ) const {
+    if ( task_scheduler == nullptr || skins_count < 2 ) {
+        for ( u32 s = 0; s < skins_count; ++s ) {
+            skin_compute_palette( *this, s, world_matrices, palette );
+        }
+        return;
+    }
+
+    SkinPaletteTask palette_task;
+    palette_task.m_SetSize = skins_count;
+    palette_task.skins = this;
+    palette_task.world_matrices = world_matrices;
+    palette_task.palette = palette;
+
+    task_scheduler->AddTaskSetToPipe( &palette_task );
+    task_scheduler->WaitforTask( &palette_task );
+}
+
+// CPU skinning ///////////////////////////////////////////////////////////
+
+//
+//
+struct SkinVerticesTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override;
+
+    const mat4s*                    palette         = nullptr;
+    const f32*                      positions       = nullptr;
+    const f32*                      normals         = nullptr;
+    const u16*                      joints          = nullptr;
+    const f32*                      weights         = nullptr;
+    f32*                            out_positions   = nullptr;
+    f32*                            out_normals     = nullptr;
+}; // struct SkinVerticesTask
+
+void SkinVerticesTask::ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) {
+    for ( u32 v = range.start; v < range.end; ++v ) {
+        // Blend of the joint matrices, one column at a time.
+        mat4 skin_matrix;
+        glm_mat4_zero( skin_matrix );
+        for ( u32 i = 0; i < 4; ++i ) {
+            const f32 weight = weights[ v * 4 + i ];
+            if ( weight == 0.0f ) {
+                continue;
+            }
+
+            const mat4s& joint_matrix = palette[ joints[ v * 4 + i ] ];
+            for ( u32 c = 0; c < 4; ++c ) {
+                glm_vec4_muladds( ( f32* )joint_matrix.raw[ c ], weight, skin_matrix[ c ] );
+            }
+        }
+
+        glm_mat4_mulv3( skin_matrix, ( f32* )positions + v * 3, 1.0f, out_positions + v * 3 );
+        if ( normals ) {
+            glm_mat4_mulv3( skin_matrix, ( f32* )normals + v * 3, 0.0f, out_normals + v * 3 );
+            glm_vec3_normalize( out_normals + v * 3 );
+        }
+    }
+}
+
+void skin_vertices_cpu( const mat4s* palette, const f32* positions, const f32* normals, const u16* joints, const f32* weights,
+                        u32 vertex_count, f32* out_positions, f32* out_normals, enki::TaskScheduler* task_scheduler ) {
+    SkinVerticesTask skin_task;
+    skin_task.m_SetSize = vertex_count;
+    skin_task.m_MinRange = k_skinning_min_vertices;
+    skin_task.palette = palette;
+    skin_task.positions = positions;
+    skin_task.normals = normals;
+    skin_task.joints = joints;
+    skin_task.weights = weights;
+    skin_task.out_positions = out_positions;
+    skin_task.out_normals = out_normals;
+
+    if ( task_scheduler == nullptr || vertex_count <= k_skinning_min_vertices ) {
+        skin_task.ExecuteRange( { 0, vertex_count }, 0 );
+        return;
+    }
+
+    task_scheduler->AddTaskSetToPipe( &skin_task );
+    task_scheduler->WaitforTask( &skin_task );
+}
+
+} // namespace syi
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace syi {
+
+    struct Allocator;
+    struct AnimationPose;
+
+    // NodeHierarchy //////////////////////////////////////////////////////
+    //
+    // Parents of the glTF nodes and an order where every parent comes before its children.
+    struct NodeHierarchy {
+
+        void                        init( const glTF::glTF& gltf, Allocator* allocator );
+        void                        shutdown();
+
+        // World matrices of all nodes from the local transforms of the pose.
+        void                        compute_world_matrices( const AnimationPose& pose, mat4s* world_matrices ) const;
+
+        i32*                        parents         = nullptr;  // -1 for roots.
+        u32*                        order           = nullptr;
+        u32                         nodes_count     = 0;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct NodeHierarchy
+
+    // SkinPalettes ///////////////////////////////////////////////////////
+    //
+    // Joint matrices of all the skins of a glTF, packed skin after skin in a single
+    // mat4 array, column major, ready to be copied into a storage buffer.
+    // As in the glTF specification, the transform of the skinned mesh node is not applied.
+    //
+    // Usage:
+    //   hierarchy.compute_world_matrices( pose, world_matrices );
+    //   skin_palettes.compute_palettes( world_matrices, palette, task_scheduler );
+    //   // Joints of skin s are palette[ skin_palettes.palette_offsets[ s ] ... ]
+    struct SkinPalettes {
+
+        bool                        init( const glTF::glTF& gltf, u8* const* buffers_data, Allocator* allocator );
+        void                        shutdown();
+
+        // palette[ i ] = world matrix of joint i * its inverse bind matrix. Skins are computed in parallel with a task scheduler.
+        void                        compute_palettes( const mat4s* world_matrices, mat4s* palette, enki::TaskScheduler* task_scheduler = nullptr ) const;
+
+        mat4s*                      inverse_bind_matrices = nullptr;    // Packed like the palette.
+        u32*                        joints          = nullptr;          // Node of each palette entry.
+        u32*                        palette_offsets = nullptr;          // First palette entry of each skin, and the total at skins_count.
+        u32                         skins_count     = 0;
+        u32                         palette_size    = 0;
+
+        Allocator*                  allocator       = nullptr;
+
+    }; // struct SkinPalettes
+
+    // Reference CPU skinning, for tools and headless tests. Each vertex has 4 joints (indices into palette)
+    // and 4 weights. normals and out_normals can be null. With a task scheduler vertex ranges run in parallel.
+    void                            skin_vertices_cpu( const mat4s* palette, const f32* positions, const f32* normals, const u16* joints, const f32* weights,
+                                                       u32 vertex_count, f32* out_positions, f32* out_normals, enki::TaskScheduler* task_scheduler = nullptr );
+
+} // namespace syi
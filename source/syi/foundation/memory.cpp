@@ -1,11 +1,14 @@
 #include "memory.hpp"
 #include "memory_utils.hpp"
+#include "memory_tracker.hpp"
 #include "assert.hpp"
+#include "bit.hpp"
 
 #include "external/tlsf.h"
 
 #include <stdlib.h>
 #include <memory.h>
+#include <atomic>
 
 #if defined syi_IMGUI
 #include "external/imgui/imgui.h"
@@ -21,6 +24,12 @@
 #include "external/StackWalker.h"
 #endif // syi_MEMORY_STACK
 
+#if defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif // _WIN64
+
 namespace syi {
 
 //#define syi_MEMORY_DEBUG
@@ -50,23 +59,58 @@ MemoryService* MemoryService::instance() {
 void MemoryService::init( void* configuration ) {
 
     rprint( "Memory Service Init\n" );
+#if defined (syi_MEMORY_TRACKING)
+    memory_tracker()->init();
+#endif // syi_MEMORY_TRACKING
+
     MemoryServiceConfiguration* memory_configuration = static_cast< MemoryServiceConfiguration* >( configuration );
-    system_allocator.init( memory_configuration ? memory_configuration->maximum_dynamic_size : s_size );
+    if ( memory_configuration && memory_configuration->growable_heap ) {
+        system_allocator.init_growable( memory_configuration->maximum_dynamic_size, memory_configuration->heap_pool_size, memory_configuration->thread_safe_heap );
+    } else if ( memory_configuration ) {
+        system_allocator.init( memory_configuration->maximum_dynamic_size, memory_configuration->thread_safe_heap );
+    } else {
+        system_allocator.init( s_size );
+    }
 }
 
 void MemoryService::shutdown() {
 
+#if defined (syi_MEMORY_TRACKING)
+    memory_tracker()->report_leaks();
+#endif // syi_MEMORY_TRACKING
+
     system_allocator.shutdown();
 
+#if defined (syi_MEMORY_TRACKING)
+    memory_tracker()->shutdown();
+#endif // syi_MEMORY_TRACKING
+
     rprint( "Memory Service Shutdown\n" );
 }
 
+void MemoryService::new_frame() {
+#if defined (syi_MEMORY_TRACKING)
+    memory_tracker()->new_frame();
+#endif // syi_MEMORY_TRACKING
+}
+
 void exit_walker( void* ptr, size_t size, int used, void* user ) {
     MemoryStatistics* stats = ( MemoryStatistics* )user;
     stats->add( used ? size : 0 );
 
-    if ( used )
-        rprint( "Found active allocation %p, %llu\n", ptr, size );
+    if ( !used ) {
+        return;
+    }
+
+#if defined (syi_MEMORY_TRACKING)
+    MemoryCallSite* call_site = memory_tracker()->find_call_site( ptr );
+    if ( call_site ) {
+        rprint( "Found active allocation %p, %llu from %s(%d)\n", ptr, size, call_site->file.load(), call_site->line );
+        return;
+    }
+#endif // syi_MEMORY_TRACKING
+
+    rprint( "Found active allocation %p, %llu\n", ptr, size );
 }
 
 #if defined syi_IMGUI
@@ -94,6 +138,9 @@ void MemoryService::imgui_draw() {
     if ( ImGui::Begin( "Memory Service" ) ) {
 
         system_allocator.debug_ui();
+#if defined (syi_MEMORY_TRACKING)
+        memory_tracker()->debug_ui();
+#endif // syi_MEMORY_TRACKING
     }
     ImGui::End();
 }
@@ -125,27 +172,250 @@ void MemoryService::test() {
 
 // Memory Structs /////////////////////////////////////////////////////////
 
+// Virtual memory /////////////////////////////////////////////////////////
+static void* virtual_reserve( sizet size ) {
+#if defined(_WIN64)
+    return VirtualAlloc( nullptr, size, MEM_RESERVE, PAGE_NOACCESS );
+#else
+    void* address = mmap( nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    return address == MAP_FAILED ? nullptr : address;
+#endif // _WIN64
+}
+
+static bool virtual_commit( void* address, sizet size ) {
+#if defined(_WIN64)
+    return VirtualAlloc( address, size, MEM_COMMIT, PAGE_READWRITE ) != nullptr;
+#else
+    // Pages are backed by physical memory only when touched.
+    return mprotect( address, size, PROT_READ | PROT_WRITE ) == 0;
+#endif // _WIN64
+}
+
+static void virtual_decommit( void* address, sizet size ) {
+#if defined(_WIN64)
+    VirtualFree( address, size, MEM_DECOMMIT );
+#else
+    madvise( address, size, MADV_DONTNEED );
+    mprotect( address, size, PROT_NONE );
+#endif // _WIN64
+}
+
+static void virtual_release( void* address, sizet size ) {
+#if defined(_WIN64)
+    VirtualFree( address, 0, MEM_RELEASE );
+#else
+    munmap( address, size );
+#endif // _WIN64
+}
+
+// Memory with an alignment over the malloc one, released with aligned_free.
+static void* aligned_malloc( sizet size, sizet alignment ) {
+#if defined(_WIN64)
+    return _aligned_malloc( size, alignment );
+#else
+    void* pointer = nullptr;
+    return posix_memalign( &pointer, alignment, size ) == 0 ? pointer : nullptr;
+#endif // _WIN64
+}
+
+static void aligned_free( void* pointer ) {
+#if defined(_WIN64)
+    _aligned_free( pointer );
+#else
+    free( pointer );
+#endif // _WIN64
+}
+
 // HeapAllocator //////////////////////////////////////////////////////////
+
+// Thread cache slots in use, one bit each. A thread takes the first free slot and gives it back
+// when it exits, so that its magazines go to the next thread instead of being lost with it.
+static_assert( k_heap_max_threads <= 64, "Thread cache slots are tracked in a u64" );
+static std::atomic<u64>     s_heap_thread_slots{ 0 };
+
+//
+//
+struct HeapThreadSlot {
+    ~HeapThreadSlot() {
+        if ( index != u32_max ) {
+            // Release: the magazines written by this thread are seen by the next owner.
+            s_heap_thread_slots.fetch_and( ~( 1ull << index ), std::memory_order_release );
+        }
+    }
+
+    u32                         index           = u32_max;
+}; // struct HeapThreadSlot
+
+static thread_local HeapThreadSlot s_heap_thread_slot;
+
+// Size class able to contain size bytes.
+static u32 heap_size_class_from_size( sizet size ) {
+    return ( u32 )( ( size - 1 ) / k_heap_size_class_granularity );
+}
+
+// Biggest size class that a block of block_size bytes can serve, or u32_max if too big.
+static u32 heap_size_class_from_block( sizet block_size ) {
+    const sizet size_class = block_size / k_heap_size_class_granularity;
+    return ( size_class > 0 && size_class <= k_heap_size_class_count ) ? ( u32 )( size_class - 1 ) : u32_max;
+}
+
 HeapAllocator::~HeapAllocator() {
 }
 
-void HeapAllocator::init( sizet size ) {
+void HeapAllocator::init( sizet size, bool thread_safe_ ) {
     // Allocate
     memory = malloc( size );
     max_size = size;
+    committed_size = size;
     allocated_size = 0;
+    growable = false;
 
     tlsf_handle = tlsf_create_with_pool( memory, size );
 
-    rprint( "HeapAllocator of size %llu created\n", size );
+    init_thread_caches( thread_safe_ );
+
+    rprint( "HeapAllocator of size %llu created%s\n", size, thread_safe ? " (thread safe)" : "" );
+}
+
+void HeapAllocator::init_growable( sizet reserved_size, sizet pool_size_, bool thread_safe_ ) {
+    // Reserve a whole number of pools.
+    pool_size = memory_align( pool_size_, rkilo( 64 ) );
+    pool_slot_count = ( u32 )( ( reserved_size + pool_size - 1 ) / pool_size );
+    max_size = ( sizet )pool_slot_count * pool_size;
+
+    memory = virtual_reserve( max_size );
+    RASSERTM( memory, "HeapAllocator: cannot reserve %llu bytes of address space", max_size );
+
+    pool_slots = ( HeapPoolSlot* )malloc( sizeof( HeapPoolSlot ) * pool_slot_count );
+    memset( pool_slots, 0, sizeof( HeapPoolSlot ) * pool_slot_count );
+
+    // First pool holds the TLSF control structure and is never released.
+    virtual_commit( memory, pool_size );
+    committed_size = pool_size;
+    allocated_size = 0;
+    spare_pool_slot = u32_max;
+
+    tlsf_handle = tlsf_create_with_pool( memory, pool_size );
+    pool_slots[ 0 ] = { tlsf_get_pool( tlsf_handle ), 0, 0, 1 };
+
+    // Initialize caches before setting growable, so that it behaves as a normal heap.
+    init_thread_caches( thread_safe_ );
+    growable = true;
+
+    rprint( "HeapAllocator growable, reserved %llu, pool size %llu%s\n", max_size, pool_size, thread_safe ? " (thread safe)" : "" );
+}
+
+// Pool bytes that guarantee TLSF a free block for the request: memalign asks for room to reach
+// the alignment plus a gap header, and the free lists are searched from the next size class up.
+static sizet heap_pool_required_size( sizet size, sizet alignment ) {
+    sizet request = memory_align( size, sizeof( void* ) );
+    if ( alignment > sizeof( void* ) ) {
+        request += alignment + 4 * sizeof( void* );
+    }
+
+    // Classes split each power of two in 32, so rounding up to the next one adds less than request / 32.
+    return request + request / 32 + tlsf_pool_overhead() + tlsf_alloc_overhead();
+}
+
+u32 HeapAllocator::add_pool( sizet size, sizet alignment ) {
+    // Lock must be held by the caller.
+    const sizet required_size = heap_pool_required_size( size, alignment );
+    // TLSF can neither serve nor hold a block over its maximum size, whatever the reserved range.
+    if ( required_size >= tlsf_block_size_max() ) {
+        rprint( "HeapAllocator: requested %llu, over the %llu bytes TLSF maximum block size\n", size, tlsf_block_size_max() );
+        return u32_max;
+    }
+
+    const u32 required_slots = ( u32 )( ( required_size + pool_size - 1 ) / pool_size );
+
+    // Search for enough contiguous free slots.
+    u32 first_free = 0, free_count = 0;
+    for ( u32 i = 1; i < pool_slot_count && free_count < required_slots; ++i ) {
+        if ( pool_slots[ i ].slot_count ) {
+            free_count = 0;
+            continue;
+        }
+
+        first_free = free_count ? first_free : i;
+        ++free_count;
+    }
+
+    if ( free_count < required_slots ) {
+        rprint( "HeapAllocator: reserved memory exhausted, requested %llu\n", size );
+        return u32_max;
+    }
+
+    u8* pool_memory = ( u8* )memory + first_free * pool_size;
+    const sizet pool_bytes = required_slots * pool_size;
+    if ( !virtual_commit( pool_memory, pool_bytes ) ) {
+        rprint( "HeapAllocator: cannot commit %llu bytes\n", pool_bytes );
+        return u32_max;
+    }
+
+    // Rounding up to whole slots can go past the TLSF maximum: the tail stays committed but unused.
+    const sizet tlsf_max_pool_bytes = tlsf_block_size_max() + tlsf_pool_overhead();
+    pool_t pool = tlsf_add_pool( tlsf_handle, pool_memory, pool_bytes < tlsf_max_pool_bytes ? pool_bytes : tlsf_max_pool_bytes );
+    if ( !pool ) {
+        rprint( "HeapAllocator: cannot add a pool of %llu bytes\n", pool_bytes );
+        virtual_decommit( pool_memory, pool_bytes );
+        return u32_max;
+    }
+
+    for ( u32 i = 0; i < required_slots; ++i ) {
+        pool_slots[ first_free + i ] = { i == 0 ? pool : nullptr, 0, first_free, required_slots };
+    }
+
+    committed_size += pool_bytes;
+    return first_free;
+}
+
+void HeapAllocator::release_pool( u32 first_slot ) {
+    // Lock must be held by the caller.
+    HeapPoolSlot& slot = pool_slots[ first_slot ];
+    RASSERT( slot.used_bytes == 0 && first_slot != 0 );
+
+    const u32 slot_count = slot.slot_count;
+    const sizet pool_bytes = slot_count * pool_size;
+
+    tlsf_remove_pool( tlsf_handle, slot.pool );
+    virtual_decommit( ( u8* )memory + first_slot * pool_size, pool_bytes );
+
+    for ( u32 i = 0; i < slot_count; ++i ) {
+        pool_slots[ first_slot + i ] = { nullptr, 0, 0, 0 };
+    }
+
+    committed_size -= pool_bytes;
+}
+
+HeapPoolSlot* HeapAllocator::get_pool_slot( void* pointer ) {
+    const sizet slot_index = ( ( u8* )pointer - ( u8* )memory ) / pool_size;
+    RASSERT( slot_index < pool_slot_count );
+    return &pool_slots[ pool_slots[ slot_index ].first_slot ];
+}
+
+void HeapAllocator::walk_pools( HeapWalkerCallback walker, MemoryStatistics* stats ) {
+    stats->committed_bytes = committed_size;
+    stats->reserved_bytes = max_size;
+
+    if ( !growable ) {
+        tlsf_walk_pool( tlsf_get_pool( tlsf_handle ), walker, stats );
+        return;
+    }
+
+    for ( u32 i = 0; i < pool_slot_count; i += pool_slots[ i ].slot_count ? pool_slots[ i ].slot_count : 1 ) {
+        if ( pool_slots[ i ].slot_count ) {
+            tlsf_walk_pool( pool_slots[ i ].pool, walker, stats );
+        }
+    }
 }
 
 void HeapAllocator::shutdown() {
 
+    flush_thread_caches();
+
     // Check memory at the application exit.
-    MemoryStatistics stats{ 0, max_size };
-    pool_t pool = tlsf_get_pool( tlsf_handle );
-    tlsf_walk_pool( pool, exit_walker, ( void* )&stats );
+    MemoryStatistics stats{ 0, max_size, 0, 0, 0 };
+    walk_pools( exit_walker, &stats );
 
     if ( stats.allocated_bytes ) {
         rprint( "HeapAllocator Shutdown.\n===============\nFAILURE! Allocated memory detected. allocated %llu, total %llu\n===============\n\n", stats.allocated_bytes, stats.total_bytes );
@@ -157,22 +427,110 @@ void HeapAllocator::shutdown() {
 
     tlsf_destroy( tlsf_handle );
 
-    free( memory );
+    if ( growable ) {
+        virtual_release( memory, max_size );
+        free( pool_slots );
+        pool_slots = nullptr;
+        growable = false;
+    } else {
+        free( memory );
+    }
+
+    if ( thread_caches ) {
+        aligned_free( thread_caches );
+        thread_caches = nullptr;
+    }
+}
+
+void HeapAllocator::init_thread_caches( bool thread_safe_ ) {
+    thread_safe = thread_safe_;
+    if ( thread_safe ) {
+        // Thread caches live outside of the pool, so they don't show up in the leak check.
+        const sizet caches_size = sizeof( HeapThreadCache ) * k_heap_max_threads;
+        thread_caches = ( HeapThreadCache* )aligned_malloc( caches_size, alignof( HeapThreadCache ) );
+        RASSERT( thread_caches );
+        memset( thread_caches, 0, caches_size );
+    }
+}
+
+void HeapAllocator::flush_thread_caches() {
+    if ( !thread_caches ) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard( mutex );
+    for ( u32 t = 0; t < k_heap_max_threads; ++t ) {
+        HeapThreadCache& cache = thread_caches[ t ];
+        for ( u32 c = 0; c < k_heap_size_class_count; ++c ) {
+            drain_magazine( cache.magazines[ c ], cache.magazines[ c ].count );
+        }
+    }
+}
+
+HeapThreadCache* HeapAllocator::get_thread_cache() {
+    u32& index = s_heap_thread_slot.index;
+    if ( index == u32_max ) {
+        // Threads over the limit retry on each call, a slot can be freed by an exiting thread.
+        const u64 all_slots = k_heap_max_threads == 64 ? u64_max : ( 1ull << k_heap_max_threads ) - 1;
+        u64 slots = s_heap_thread_slots.load( std::memory_order_relaxed );
+        while ( ( slots & all_slots ) != all_slots ) {
+            const u32 free_index = ( u32 )trailing_zeros_u64( ~slots );
+            if ( s_heap_thread_slots.compare_exchange_weak( slots, slots | ( 1ull << free_index ), std::memory_order_acquire, std::memory_order_relaxed ) ) {
+                index = free_index;
+                break;
+            }
+        }
+
+        if ( index == u32_max ) {
+            return nullptr;
+        }
+    }
+    return &thread_caches[ index ];
+}
+
+void HeapAllocator::refill_magazine( HeapMagazine& magazine, u32 size_class ) {
+    const sizet block_size = ( size_class + 1 ) * k_heap_size_class_granularity;
+
+    std::lock_guard<std::mutex> guard( mutex );
+    // Fill only half of the magazine, to leave room for frees without draining.
+    while ( magazine.count < k_heap_magazine_size / 2 ) {
+        void* block = pool_allocate( block_size, 1 );
+        if ( !block ) {
+            break;
+        }
+        magazine.blocks[ magazine.count++ ] = block;
+    }
+}
+
+void HeapAllocator::drain_magazine( HeapMagazine& magazine, u32 count ) {
+    // Lock must be held by the caller.
+    RASSERT( count <= magazine.count );
+    for ( u32 i = 0; i < count; ++i ) {
+        pool_deallocate( magazine.blocks[ --magazine.count ] );
+    }
 }
 
 #if defined syi_IMGUI
 void HeapAllocator::debug_ui() {
 
     ImGui::Separator();
-    ImGui::Text( "Heap Allocator" );
+    ImGui::Text( "Heap Allocator%s", thread_safe ? " (thread safe)" : "" );
     ImGui::Separator();
-    MemoryStatistics stats{ 0, max_size };
-    pool_t pool = tlsf_get_pool( tlsf_handle );
-    tlsf_walk_pool( pool, imgui_walker, ( void* )&stats );
+    MemoryStatistics stats{ 0, max_size, 0, 0, 0 };
+    {
+        // Blocks cached in thread magazines are reported as used.
+        std::unique_lock<std::mutex> guard( mutex, std::defer_lock );
+        if ( thread_safe ) {
+            guard.lock();
+        }
+        walk_pools( imgui_walker, &stats );
+    }
 
     ImGui::Separator();
     ImGui::Text( "\tAllocation count %d", stats.allocation_count );
-    ImGui::Text( "\tAllocated %llu K, free %llu Mb, total %llu Mb", stats.allocated_bytes / (1024 * 1024), ( max_size - stats.allocated_bytes ) / ( 1024 * 1024 ), max_size / ( 1024 * 1024 ) );
+    // Free is what the committed pools can still hand out, reserved address space costs nothing until committed.
+    ImGui::Text( "\tAllocated %zu Mb, free %zu Mb, total %zu Mb", stats.allocated_bytes / (1024 * 1024), ( stats.committed_bytes - stats.allocated_bytes ) / ( 1024 * 1024 ), max_size / ( 1024 * 1024 ) );
+    ImGui::Text( "\tCommitted %zu Mb, reserved %zu Mb", stats.committed_bytes / ( 1024 * 1024 ), stats.reserved_bytes / ( 1024 * 1024 ) );
 }
 #endif // syi_IMGUI
 
@@ -188,7 +546,7 @@ protected:
     }
 }; // class syiStackWalker
 
-void* HeapAllocator::allocate( sizet size, sizet alignment ) {
+void* HeapAllocator::allocate_block( sizet size, sizet alignment ) {
     
     /*if ( size == 16 ) 
     {
@@ -202,7 +560,115 @@ void* HeapAllocator::allocate( sizet size, sizet alignment ) {
 }
 #else
 
+void* HeapAllocator::allocate_block( sizet size, sizet alignment ) {
+    if ( !thread_safe ) {
+        return pool_allocate( size, alignment );
+    }
+
+    // Small allocations are served from the thread magazines without locking.
+    if ( size && size <= k_heap_size_class_count * k_heap_size_class_granularity && alignment <= tlsf_align_size() ) {
+        HeapThreadCache* cache = get_thread_cache();
+        if ( cache ) {
+            const u32 size_class = heap_size_class_from_size( size );
+            HeapMagazine& magazine = cache->magazines[ size_class ];
+            if ( magazine.count == 0 ) {
+                refill_magazine( magazine, size_class );
+            }
+
+            if ( magazine.count ) {
+                return magazine.blocks[ --magazine.count ];
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> guard( mutex );
+    return pool_allocate( size, alignment );
+}
+#endif // syi_MEMORY_STACK
+
 void* HeapAllocator::allocate( sizet size, sizet alignment ) {
+    return allocate( size, alignment, nullptr, 0 );
+}
+
+void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+    void* pointer = allocate_block( size, alignment );
+    syi_MEMORY_TRACK_ALLOCATION( pointer, size, file, line );
+    return pointer;
+}
+
+void HeapAllocator::deallocate( void* pointer ) {
+    // Untrack first: once freed, the same address can be handed out to another thread.
+    syi_MEMORY_TRACK_DEALLOCATION( pointer );
+    deallocate_block( pointer );
+}
+
+void* HeapAllocator::reallocate( void* pointer, sizet used_size, sizet size, sizet alignment ) {
+    // TLSF keeps only its own alignment when resizing.
+    if ( !pointer || alignment > tlsf_align_size() ) {
+        return Allocator::reallocate( pointer, used_size, size, alignment );
+    }
+
+    std::unique_lock<std::mutex> guard( mutex, std::defer_lock );
+    if ( thread_safe ) {
+        guard.lock();
+    }
+
+    void* new_pointer = pool_reallocate( pointer, size );
+    // Still under lock: the old address can't be handed out before the tracker is updated.
+    syi_MEMORY_TRACK_REALLOCATION( pointer, new_pointer, size );
+    return new_pointer;
+}
+
+void HeapAllocator::deallocate_block( void* pointer ) {
+    if ( !thread_safe || !pointer ) {
+        pool_deallocate( pointer );
+        return;
+    }
+
+    // Cache small blocks in the magazine of their biggest servable size class.
+    const u32 size_class = heap_size_class_from_block( tlsf_block_size( pointer ) );
+    HeapThreadCache* cache = size_class != u32_max ? get_thread_cache() : nullptr;
+    if ( cache ) {
+        HeapMagazine& magazine = cache->magazines[ size_class ];
+        if ( magazine.count == k_heap_magazine_size ) {
+            std::lock_guard<std::mutex> guard( mutex );
+            drain_magazine( magazine, k_heap_magazine_size / 2 );
+        }
+
+        magazine.blocks[ magazine.count++ ] = pointer;
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard( mutex );
+    pool_deallocate( pointer );
+}
+
+void* HeapAllocator::pool_allocate( sizet size, sizet alignment ) {
+    if ( growable ) {
+        void* allocated_memory = alignment == 1 ? tlsf_malloc( tlsf_handle, size ) : tlsf_memalign( tlsf_handle, alignment, size );
+        if ( !allocated_memory ) {
+            const u32 pool_slot = add_pool( size, alignment );
+            if ( pool_slot != u32_max ) {
+                allocated_memory = alignment == 1 ? tlsf_malloc( tlsf_handle, size ) : tlsf_memalign( tlsf_handle, alignment, size );
+                if ( !allocated_memory ) {
+                    release_pool( pool_slot );
+                }
+            }
+        }
+
+        if ( allocated_memory ) {
+            const sizet actual_size = tlsf_block_size( allocated_memory );
+            allocated_size += actual_size;
+
+            HeapPoolSlot* slot = get_pool_slot( allocated_memory );
+            if ( slot->first_slot == spare_pool_slot ) {
+                spare_pool_slot = u32_max;
+            }
+            slot->used_bytes += actual_size;
+        }
+        return allocated_memory;
+    }
+
 #if defined (HEAP_ALLOCATOR_STATS)
     void* allocated_memory = alignment == 1 ? tlsf_malloc( tlsf_handle, size ) : tlsf_memalign( tlsf_handle, alignment, size );
     sizet actual_size = tlsf_block_size( allocated_memory );
@@ -216,13 +682,20 @@ void* HeapAllocator::allocate( sizet size, sizet alignment ) {
     return tlsf_malloc( tlsf_handle, size );
 #endif // HEAP_ALLOCATOR_STATS
 }
-#endif // syi_MEMORY_STACK
 
-void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
-    return allocate( size, alignment );
-}
+void HeapAllocator::pool_deallocate( void* pointer ) {
+    if ( growable && pointer ) {
+        const sizet actual_size = tlsf_block_size( pointer );
+        allocated_size -= actual_size;
+
+        HeapPoolSlot* slot = get_pool_slot( pointer );
+        slot->used_bytes -= actual_size;
+        tlsf_free( tlsf_handle, pointer );
+
+        on_pool_empty( slot );
+        return;
+    }
 
-void HeapAllocator::deallocate( void* pointer ) {
 #if defined (HEAP_ALLOCATOR_STATS)
     sizet actual_size = tlsf_block_size( pointer );
     allocated_size -= actual_size;
@@ -233,6 +706,51 @@ void HeapAllocator::deallocate( void* pointer ) {
 #endif
 }
 
+void* HeapAllocator::pool_reallocate( void* pointer, sizet size ) {
+    const sizet old_size = tlsf_block_size( pointer );
+    HeapPoolSlot* old_slot = growable ? get_pool_slot( pointer ) : nullptr;
+
+    // On failure the block is left untouched, so a new pool can be added and the call retried.
+    void* new_pointer = tlsf_realloc( tlsf_handle, pointer, size );
+    if ( !new_pointer && growable ) {
+        const u32 pool_slot = add_pool( size, 1 );
+        if ( pool_slot != u32_max ) {
+            new_pointer = tlsf_realloc( tlsf_handle, pointer, size );
+            if ( !new_pointer ) {
+                release_pool( pool_slot );
+            }
+        }
+    }
+
+    if ( !new_pointer ) {
+        return nullptr;
+    }
+
+    const sizet new_size = tlsf_block_size( new_pointer );
+    allocated_size = allocated_size - old_size + new_size;
+
+    if ( growable ) {
+        HeapPoolSlot* new_slot = get_pool_slot( new_pointer );
+        if ( new_slot->first_slot == spare_pool_slot ) {
+            spare_pool_slot = u32_max;
+        }
+        new_slot->used_bytes += new_size;
+        old_slot->used_bytes -= old_size;
+        on_pool_empty( old_slot );
+    }
+    return new_pointer;
+}
+
+void HeapAllocator::on_pool_empty( HeapPoolSlot* slot ) {
+    // Keep one empty pool around, release the previous one.
+    if ( slot->used_bytes == 0 && slot->first_slot != 0 ) {
+        if ( spare_pool_slot != u32_max ) {
+            release_pool( spare_pool_slot );
+        }
+        spare_pool_slot = slot->first_slot;
+    }
+}
+
 // LinearAllocator /////////////////////////////////////////////////////////
 
 LinearAllocator::~LinearAllocator() {
@@ -266,6 +784,7 @@ void* LinearAllocator::allocate( sizet size, sizet alignment ) {
 }
 
 void* LinearAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+    syi_MEMORY_TRACK_TRANSIENT( size, file, line );
     return allocate( size, alignment );
 }
 
@@ -277,6 +796,16 @@ void LinearAllocator::clear() {
     allocated_size = 0;
 }
 
+// Allocator //////////////////////////////////////////////////////////////
+void* Allocator::reallocate( void* pointer, sizet used_size, sizet size, sizet alignment ) {
+    void* new_pointer = allocate( size, alignment );
+    if ( new_pointer && pointer ) {
+        memory_copy( new_pointer, pointer, used_size < size ? used_size : size );
+        deallocate( pointer );
+    }
+    return new_pointer;
+}
+
 // Memory Methods /////////////////////////////////////////////////////////
 void memory_copy( void* destination, void* source, sizet size ) {
     memcpy( destination, source, size );
@@ -293,10 +822,13 @@ void* MallocAllocator::allocate( sizet size, sizet alignment ) {
 }
 
 void* MallocAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
-    return malloc( size );
+    void* pointer = malloc( size );
+    syi_MEMORY_TRACK_ALLOCATION( pointer, size, file, line );
+    return pointer;
 }
 
 void MallocAllocator::deallocate( void* pointer ) {
+    syi_MEMORY_TRACK_DEALLOCATION( pointer );
     free( pointer );
 }
 
@@ -327,6 +859,7 @@ void* StackAllocator::allocate( sizet size, sizet alignment ) {
 }
 
 void* StackAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+    syi_MEMORY_TRACK_TRANSIENT( size, file, line );
     return allocate( size, alignment );
 }
 
@@ -3,6 +3,8 @@
 #include "foundation/platform.hpp"
 #include "foundation/service.hpp"
 
+#include <mutex>
+
 #define syi_IMGUI
 
 namespace syi {
@@ -23,6 +25,9 @@ namespace syi {
 
         u32                         allocation_count;
 
+        sizet                       committed_bytes;    // Memory backed by the OS.
+        sizet                       reserved_bytes;     // Address space reserved, committed or not.
+
         void add( sizet a ) {
             if ( a ) {
                 allocated_bytes += a;
@@ -39,16 +44,56 @@ namespace syi {
         virtual void*               allocate( sizet size, sizet alignment, cstring file, i32 line ) = 0;
 
         virtual void                deallocate( void* pointer ) = 0;
+
+        // Resizes a block keeping its first used_size bytes: the default allocates, copies and frees.
+        virtual void*               reallocate( void* pointer, sizet used_size, sizet size, sizet alignment );
     }; // struct Allocator
 
 
+    // Small size classes served by the per-thread magazines of a thread safe HeapAllocator.
+    static const u32                k_heap_size_class_granularity   = 16;
+    static const u32                k_heap_size_class_count         = 16;       // 16 to 256 bytes.
+    static const u32                k_heap_magazine_size            = 32;       // Blocks cached per size class, per thread.
+    static const u32                k_heap_max_threads              = 64;       // Live threads over this limit go straight to the locked pool.
+
+    //
+    // Stack of free blocks of a single size class.
+    struct HeapMagazine {
+        void*                       blocks[ k_heap_magazine_size ];
+        u32                         count;
+    }; // struct HeapMagazine
+
+    //
+    // Per-thread cache, aligned to avoid false sharing between threads.
+    struct alignas( 64 ) HeapThreadCache {
+        HeapMagazine                magazines[ k_heap_size_class_count ];
+    }; // struct HeapThreadCache
+
+    typedef void                    ( *HeapWalkerCallback )( void* pointer, sizet size, int used, void* user );
+
     //
+    // Slot of the reserved address range of a growable HeapAllocator.
+    // Pools can span multiple slots: the first one holds the pool data.
+    struct HeapPoolSlot {
+        void*                       pool;               // TLSF pool, valid on the first slot of a pool.
+        sizet                       used_bytes;         // Bytes allocated from the pool.
+        u32                         first_slot;         // First slot of the owning pool.
+        u32                         slot_count;         // Slots used by the pool, 0 if not committed.
+    }; // struct HeapPoolSlot
+
+    //
+    // TLSF based allocator. When initialized as thread safe, small allocations are served
+    // from per-thread magazines that are refilled from and drained to the TLSF pool in batches,
+    // so the pool lock is taken once every k_heap_magazine_size / 2 operations.
     //
+    // When initialized as growable, the whole size is only reserved as address space and
+    // pools are committed and added to TLSF on demand. Empty pools are given back to the OS.
     struct HeapAllocator : public Allocator {
 
         ~HeapAllocator() override;
 
-        void                        init( sizet size );
+        void                        init( sizet size, bool thread_safe = false );
+        void                        init_growable( sizet reserved_size, sizet pool_size, bool thread_safe = false );
         void                        shutdown();
 
 #if defined syi_IMGUI
@@ -60,10 +105,50 @@ namespace syi {
 
         void                        deallocate( void* pointer ) override;
 
+        // Grows or shrinks in place when the neighbouring block is free.
+        void*                       reallocate( void* pointer, sizet used_size, sizet size, sizet alignment ) override;
+
+        // Return all blocks cached by the threads to the TLSF pool.
+        // Only safe when no other thread is using the allocator.
+        void                        flush_thread_caches();
+
+        // Unsynchronized TLSF access. Callers must hold the lock in thread safe mode.
+        void*                       pool_allocate( sizet size, sizet alignment );
+        void                        pool_deallocate( void* pointer );
+        void*                       pool_reallocate( void* pointer, sizet size );
+        void                        on_pool_empty( HeapPoolSlot* slot );
+
+        void                        refill_magazine( HeapMagazine& magazine, u32 size_class );
+        void                        drain_magazine( HeapMagazine& magazine, u32 count );
+
+        void*                       allocate_block( sizet size, sizet alignment );
+        void                        deallocate_block( void* pointer );
+
+        void                        init_thread_caches( bool thread_safe );
+        HeapThreadCache*            get_thread_cache();
+
+        // Growable mode
+        u32                         add_pool( sizet size, sizet alignment );     // First slot of the new pool, u32_max on failure.
+        void                        release_pool( u32 first_slot );
+        HeapPoolSlot*               get_pool_slot( void* pointer );
+
+        void                        walk_pools( HeapWalkerCallback walker, MemoryStatistics* stats );
+
         void*                       tlsf_handle; // memory allocator 
         void*                       memory;
         sizet                       allocated_size = 0;
         sizet                       max_size = 0;
+
+        HeapPoolSlot*               pool_slots      = nullptr;
+        sizet                       pool_size       = 0;
+        sizet                       committed_size  = 0;
+        u32                         pool_slot_count = 0;
+        u32                         spare_pool_slot = u32_max;  // Empty pool kept committed to avoid thrashing.
+        bool                        growable        = false;
+
+        HeapThreadCache*            thread_caches   = nullptr;
+        std::mutex                  mutex;
+        bool                        thread_safe     = false;
         
     }; // struct HeapAllocator
 
@@ -160,6 +245,9 @@ namespace syi {
     struct MemoryServiceConfiguration {
 
         sizet                       maximum_dynamic_size = 32 * 1024 * 1024;    // Defaults to max 32MB of dynamic memory.
+        bool                        thread_safe_heap     = false;               // Enable when the system allocator is shared between threads.
+        bool                        growable_heap        = false;               // Only reserve maximum_dynamic_size and commit pools on demand.
+        sizet                       heap_pool_size       = 64 * 1024 * 1024;    // Commit granularity of the growable heap.
 
     }; // struct MemoryServiceConfiguration
     //
@@ -171,6 +259,9 @@ namespace syi {
         void                        init( void* configuration );
         void                        shutdown();
 
+        // Resets the per frame statistics of the allocation tracker.
+        void                        new_frame();
+
 #if defined syi_IMGUI
         void                        imgui_draw();
 #endif // syi_IMGUI
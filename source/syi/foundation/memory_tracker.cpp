@@ -0,0 +1,295 @@
+#include "memory_tracker.hpp"
+
+#if defined (syi_MEMORY_TRACKING)
+
+#include "foundation/log.hpp"
+
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined syi_IMGUI
+#include "external/imgui/imgui.h"
+#endif // syi_IMGUI
+
+namespace syi {
+
+static MemoryTracker        s_memory_tracker;
+
+// Bound the probing, so that a table full of deleted entries does not stall allocations.
+static const u32            k_memory_tracker_max_probes = 256;
+
+static const uintptr_t      k_tracked_empty     = 0;
+static const uintptr_t      k_tracked_deleted   = 1;
+
+MemoryTracker* memory_tracker() {
+    return &s_memory_tracker;
+}
+
+static u32 tracked_allocation_index( void* pointer ) {
+    // Fibonacci hashing, low bits are always zero because of alignment.
+    const u64 hash = ( ( u64 )( uintptr_t )pointer >> 3 ) * 0x9E3779B97F4A7C15ull;
+    return ( u32 )( hash >> 32 ) & ( k_memory_tracker_capacity - 1 );
+}
+
+static u64 call_site_key( cstring file, i32 line ) {
+    const u64 key = ( ( u64 )( uintptr_t )file ^ ( ( u64 )line << 48 ) ) * 0x9E3779B97F4A7C15ull;
+    return key ? key : 1;
+}
+
+static void atomic_max( std::atomic<sizet>& target, sizet value ) {
+    sizet current = target.load( std::memory_order_relaxed );
+    while ( current < value && !target.compare_exchange_weak( current, value, std::memory_order_relaxed ) ) {
+    }
+}
+
+void MemoryTracker::init() {
+    allocations = ( MemoryTrackedAllocation* )malloc( sizeof( MemoryTrackedAllocation ) * k_memory_tracker_capacity );
+    memset( allocations, 0, sizeof( MemoryTrackedAllocation ) * k_memory_tracker_capacity );
+
+    call_sites = ( MemoryCallSite* )malloc( sizeof( MemoryCallSite ) * k_memory_call_site_capacity );
+    memset( call_sites, 0, sizeof( MemoryCallSite ) * k_memory_call_site_capacity );
+
+    dropped_count.store( 0 );
+}
+
+void MemoryTracker::shutdown() {
+    if ( dropped_count.load() ) {
+        rprint( "MemoryTracker: %u allocations were not tracked, tables full\n", dropped_count.load() );
+    }
+
+    free( allocations );
+    free( call_sites );
+    allocations = nullptr;
+    call_sites = nullptr;
+}
+
+u32 MemoryTracker::get_call_site( cstring file, i32 line ) {
+    const u64 key = call_site_key( file, line );
+    u32 index = ( u32 )( key >> 32 ) & ( k_memory_call_site_capacity - 1 );
+
+    for ( u32 i = 0; i < k_memory_call_site_capacity; ++i, index = ( index + 1 ) & ( k_memory_call_site_capacity - 1 ) ) {
+        MemoryCallSite& site = call_sites[ index ];
+        u64 current = site.key.load( std::memory_order_acquire );
+        if ( current == key ) {
+            return index;
+        }
+
+        if ( current == 0 && site.key.compare_exchange_strong( current, key, std::memory_order_acq_rel ) ) {
+            site.line = line;
+            site.file.store( file ? file : "unknown", std::memory_order_release );
+            return index;
+        }
+
+        // Another thread could have claimed the slot for the same call site.
+        if ( current == key ) {
+            return index;
+        }
+    }
+
+    return u32_max;
+}
+
+void MemoryTracker::on_allocate( void* pointer, sizet size, cstring file, i32 line ) {
+    if ( !pointer || !allocations ) {
+        return;
+    }
+
+    const u32 site_index = get_call_site( file, line );
+    if ( site_index == u32_max ) {
+        dropped_count.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    u32 index = tracked_allocation_index( pointer );
+    for ( u32 i = 0; i < k_memory_tracker_max_probes; ++i, index = ( index + 1 ) & ( k_memory_tracker_capacity - 1 ) ) {
+        MemoryTrackedAllocation& entry = allocations[ index ];
+        uintptr_t current = entry.pointer.load( std::memory_order_relaxed );
+        if ( current > k_tracked_deleted ) {
+            continue;
+        }
+
+        if ( entry.pointer.compare_exchange_strong( current, ( uintptr_t )pointer, std::memory_order_acquire ) ) {
+            entry.call_site = site_index;
+            entry.size = size;
+
+            MemoryCallSite& site = call_sites[ site_index ];
+            site.live_count.fetch_add( 1, std::memory_order_relaxed );
+            const sizet live_bytes = site.live_bytes.fetch_add( size, std::memory_order_relaxed ) + size;
+            atomic_max( site.peak_bytes, live_bytes );
+            site.frame_count.fetch_add( 1, std::memory_order_relaxed );
+            site.frame_bytes.fetch_add( size, std::memory_order_relaxed );
+
+            TracyAlloc( pointer, size );
+            return;
+        }
+    }
+
+    dropped_count.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void MemoryTracker::on_deallocate( void* pointer ) {
+    if ( !pointer || !allocations ) {
+        return;
+    }
+
+    u32 index = tracked_allocation_index( pointer );
+    for ( u32 i = 0; i < k_memory_tracker_max_probes; ++i, index = ( index + 1 ) & ( k_memory_tracker_capacity - 1 ) ) {
+        MemoryTrackedAllocation& entry = allocations[ index ];
+        const uintptr_t current = entry.pointer.load( std::memory_order_relaxed );
+        if ( current == k_tracked_empty ) {
+            break;
+        }
+
+        if ( current == ( uintptr_t )pointer ) {
+            MemoryCallSite& site = call_sites[ entry.call_site ];
+            site.live_count.fetch_sub( 1, std::memory_order_relaxed );
+            site.live_bytes.fetch_sub( entry.size, std::memory_order_relaxed );
+
+            entry.pointer.store( k_tracked_deleted, std::memory_order_release );
+
+            TracyFree( pointer );
+            return;
+        }
+    }
+    // Not tracked: allocated before the tracker was initialized or dropped.
+}
+
+void MemoryTracker::on_reallocate( void* pointer, void* new_pointer, sizet size ) {
+    if ( !new_pointer ) {
+        return;
+    }
+
+    MemoryCallSite* call_site = find_call_site( pointer );
+    cstring file = call_site ? call_site->file.load( std::memory_order_acquire ) : nullptr;
+    const i32 line = call_site ? call_site->line : 0;
+
+    on_deallocate( pointer );
+    on_allocate( new_pointer, size, file, line );
+}
+
+void MemoryTracker::on_transient_allocate( sizet size, cstring file, i32 line ) {
+    if ( !call_sites ) {
+        return;
+    }
+
+    const u32 site_index = get_call_site( file, line );
+    if ( site_index == u32_max ) {
+        dropped_count.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    MemoryCallSite& site = call_sites[ site_index ];
+    site.frame_count.fetch_add( 1, std::memory_order_relaxed );
+    site.frame_bytes.fetch_add( size, std::memory_order_relaxed );
+}
+
+void MemoryTracker::new_frame() {
+    if ( !call_sites ) {
+        return;
+    }
+
+    for ( u32 i = 0; i < k_memory_call_site_capacity; ++i ) {
+        MemoryCallSite& site = call_sites[ i ];
+        if ( site.key.load( std::memory_order_relaxed ) == 0 ) {
+            continue;
+        }
+
+        site.last_frame_count = site.frame_count.exchange( 0, std::memory_order_relaxed );
+        site.last_frame_bytes = site.frame_bytes.exchange( 0, std::memory_order_relaxed );
+    }
+}
+
+MemoryCallSite* MemoryTracker::find_call_site( void* pointer ) {
+    if ( !allocations ) {
+        return nullptr;
+    }
+
+    u32 index = tracked_allocation_index( pointer );
+    for ( u32 i = 0; i < k_memory_tracker_max_probes; ++i, index = ( index + 1 ) & ( k_memory_tracker_capacity - 1 ) ) {
+        MemoryTrackedAllocation& entry = allocations[ index ];
+        const uintptr_t current = entry.pointer.load( std::memory_order_acquire );
+        if ( current == k_tracked_empty ) {
+            break;
+        }
+
+        if ( current == ( uintptr_t )pointer ) {
+            return &call_sites[ entry.call_site ];
+        }
+    }
+    return nullptr;
+}
+
+void MemoryTracker::report_leaks() {
+    if ( !call_sites ) {
+        return;
+    }
+
+    for ( u32 i = 0; i < k_memory_call_site_capacity; ++i ) {
+        MemoryCallSite& site = call_sites[ i ];
+        const u32 live_count = site.live_count.load();
+        if ( site.key.load() == 0 || live_count == 0 ) {
+            continue;
+        }
+
+        rprint( "Leaked %u allocations, %llu bytes (peak %llu) from %s(%d)\n", live_count, site.live_bytes.load(), site.peak_bytes.load(), site.file.load(), site.line );
+    }
+}
+
+#if defined syi_IMGUI
+void MemoryTracker::debug_ui() {
+
+    ImGui::Separator();
+    ImGui::Text( "Allocation call sites" );
+    if ( dropped_count.load() ) {
+        ImGui::Text( "\t%u allocations not tracked", dropped_count.load() );
+    }
+    ImGui::Separator();
+
+    if ( !call_sites || !ImGui::BeginTable( "call_sites", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable ) ) {
+        return;
+    }
+
+    ImGui::TableSetupColumn( "Call site" );
+    ImGui::TableSetupColumn( "Live" );
+    ImGui::TableSetupColumn( "Live kb" );
+    ImGui::TableSetupColumn( "Peak kb" );
+    ImGui::TableSetupColumn( "Frame allocations" );
+    ImGui::TableSetupColumn( "Frame kb" );
+    ImGui::TableHeadersRow();
+
+    for ( u32 i = 0; i < k_memory_call_site_capacity; ++i ) {
+        MemoryCallSite& site = call_sites[ i ];
+        cstring file = site.file.load( std::memory_order_acquire );
+        if ( !file ) {
+            continue;
+        }
+
+        const u32 live_count = site.live_count.load( std::memory_order_relaxed );
+        if ( live_count == 0 && site.last_frame_count == 0 ) {
+            continue;
+        }
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text( "%s(%d)", file, site.line );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%u", live_count );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%llu", ( u64 )site.live_bytes.load( std::memory_order_relaxed ) / 1024 );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%llu", ( u64 )site.peak_bytes.load( std::memory_order_relaxed ) / 1024 );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%u", site.last_frame_count );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%llu", ( u64 )site.last_frame_bytes / 1024 );
+    }
+
+    ImGui::EndTable();
+}
+#endif // syi_IMGUI
+
+} // namespace syi
+
+#endif // syi_MEMORY_TRACKING
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "foundation/memory.hpp"
+
+#include <atomic>
+
+// Define this to record every allocation with its call site.
+// When not defined the tracking macros compile to nothing.
+//#define syi_MEMORY_TRACKING
+
+namespace syi {
+
+#if defined (syi_MEMORY_TRACKING)
+
+    static const u32                k_memory_tracker_capacity   = 1 << 20;  // Live allocations that can be tracked.
+    static const u32                k_memory_call_site_capacity = 1 << 12;  // Distinct file/line pairs.
+
+    //
+    // Statistics of a single allocation call site. Counters are updated without locks.
+    struct MemoryCallSite {
+
+        std::atomic<u64>            key;                // 0 if the slot is free.
+        std::atomic<cstring>        file;
+        i32                         line;
+
+        std::atomic<u32>            live_count;
+        std::atomic<sizet>          live_bytes;
+        std::atomic<sizet>          peak_bytes;
+
+        std::atomic<u32>            frame_count;        // Allocations since the last new frame, transient ones included.
+        std::atomic<sizet>          frame_bytes;
+        u32                         last_frame_count;
+        sizet                       last_frame_bytes;
+
+    }; // struct MemoryCallSite
+
+    //
+    // Entry of the live allocation side table, open addressed on the pointer.
+    struct MemoryTrackedAllocation {
+
+        std::atomic<uintptr_t>      pointer;            // 0 never used, 1 deleted.
+        u32                         call_site;
+        sizet                       size;
+
+    }; // struct MemoryTrackedAllocation
+
+    //
+    // Records live allocations per call site. Insertions and removals are lock free,
+    // so it can be called from any allocator and any thread.
+    struct MemoryTracker {
+
+        void                        init();
+        void                        shutdown();
+
+        // Allocations with a matching free, reported to Tracy as well.
+        void                        on_allocate( void* pointer, sizet size, cstring file, i32 line );
+        void                        on_deallocate( void* pointer );
+        // Moves the entry of pointer to new_pointer, keeping its call site. Nothing happens if new_pointer is null.
+        void                        on_reallocate( void* pointer, void* new_pointer, sizet size );
+        // Allocations released in bulk (linear and stack allocators): only counted as churn.
+        void                        on_transient_allocate( sizet size, cstring file, i32 line );
+
+        // Snapshots and resets the per frame churn.
+        void                        new_frame();
+
+        MemoryCallSite*             find_call_site( void* pointer );
+        void                        report_leaks();
+
+#if defined syi_IMGUI
+        void                        debug_ui();
+#endif // syi_IMGUI
+
+        u32                         get_call_site( cstring file, i32 line );
+
+        MemoryTrackedAllocation*    allocations     = nullptr;
+        MemoryCallSite*             call_sites      = nullptr;
+
+        std::atomic<u32>            dropped_count;  // Allocations not tracked because a table was full.
+
+    }; // struct MemoryTracker
+
+    MemoryTracker*                  memory_tracker();
+
+    #define syi_MEMORY_TRACK_ALLOCATION(pointer, size, file, line)  syi::memory_tracker()->on_allocate( pointer, size, file, line )
+    #define syi_MEMORY_TRACK_DEALLOCATION(pointer)                  syi::memory_tracker()->on_deallocate( pointer )
+    #define syi_MEMORY_TRACK_REALLOCATION(pointer, new_pointer, size) syi::memory_tracker()->on_reallocate( pointer, new_pointer, size )
+    #define syi_MEMORY_TRACK_TRANSIENT(size, file, line)            syi::memory_tracker()->on_transient_allocate( size, file, line )
+
+#else
+
+    #define syi_MEMORY_TRACK_ALLOCATION(pointer, size, file, line)
+    #define syi_MEMORY_TRACK_DEALLOCATION(pointer)
+    #define syi_MEMORY_TRACK_REALLOCATION(pointer, new_pointer, size)
+    #define syi_MEMORY_TRACK_TRANSIENT(size, file, line)
+
+#endif // syi_MEMORY_TRACKING
+
+} // namespace syi
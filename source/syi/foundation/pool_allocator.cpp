@@ -0,0 +1,139 @@
+#include "pool_allocator.hpp"
+#include "memory_tracker.hpp"
+#include "bit.hpp"
+
+#if defined syi_IMGUI
+#include "external/imgui/imgui.h"
+#endif // syi_IMGUI
+
+namespace syi {
+
+// PoolAllocator //////////////////////////////////////////////////////////
+PoolAllocator::~PoolAllocator() {
+}
+
+void PoolAllocator::init( Allocator* parent_, u32 initial_page_count ) {
+    parent = parent_;
+    allocated_size = 0;
+    page_size_total = 0;
+
+    pages.init( parent, initial_page_count );
+    pages.set_default_value( u32_max );
+
+    for ( u32 i = 0; i < k_pool_size_class_count; ++i ) {
+        size_classes[ i ] = PoolSizeClass{};
+    }
+}
+
+void PoolAllocator::shutdown() {
+    if ( allocated_size ) {
+        rprint( "PoolAllocator Shutdown: %zu bytes still allocated\n", allocated_size );
+    }
+
+    FlatHashMapIterator it = pages.iterator_begin();
+    while ( it.is_valid() ) {
+        parent->deallocate( ( void* )pages.get_structure( it ).key );
+        pages.iterator_advance( it );
+    }
+
+    pages.shutdown();
+    page_size_total = 0;
+}
+
+#if defined syi_IMGUI
+void PoolAllocator::debug_ui() {
+
+    ImGui::Separator();
+    ImGui::Text( "Pool Allocator" );
+    ImGui::Separator();
+    ImGui::Text( "\tAllocated %zu kb, pages %zu kb", allocated_size / 1024, page_size_total / 1024 );
+
+    for ( u32 i = 0; i < k_pool_size_class_count; ++i ) {
+        const PoolSizeClass& size_class = size_classes[ i ];
+        ImGui::Text( "\t%4u b: %u blocks used, %u pages", 1u << ( i + k_pool_min_block_shift ), size_class.used_blocks, size_class.page_count );
+    }
+}
+#endif // syi_IMGUI
+
+u32 PoolAllocator::get_size_class( sizet size, sizet alignment ) {
+    // Blocks are aligned to their size, as pages are aligned to the page size.
+    const sizet block_size = size > alignment ? size : alignment;
+    if ( block_size > k_pool_max_block_size ) {
+        return u32_max;
+    }
+
+    if ( block_size <= ( 1ull << k_pool_min_block_shift ) ) {
+        return 0;
+    }
+
+    return 32 - leading_zeroes_u32( ( u32 )block_size - 1 ) - k_pool_min_block_shift;
+}
+
+void* PoolAllocator::allocate_page( PoolSizeClass& size_class, u32 size_class_index ) {
+    u8* page = ( u8* )rallocaa( k_pool_page_size, parent, k_pool_page_size );
+    if ( !page ) {
+        return nullptr;
+    }
+
+    pages.insert( ( u64 )page, size_class_index );
+    page_size_total += k_pool_page_size;
+    ++size_class.page_count;
+
+    size_class.page_cursor = page;
+    size_class.page_end = page + k_pool_page_size;
+    return page;
+}
+
+void* PoolAllocator::allocate( sizet size, sizet alignment ) {
+    const u32 size_class_index = get_size_class( size, alignment );
+    if ( size_class_index == u32_max ) {
+        return parent->allocate( size, alignment );
+    }
+
+    PoolSizeClass& size_class = size_classes[ size_class_index ];
+    const sizet block_size = 1ull << ( size_class_index + k_pool_min_block_shift );
+
+    void* block = size_class.free_list;
+    if ( block ) {
+        size_class.free_list = *( void** )block;
+    } else {
+        if ( size_class.page_cursor == size_class.page_end && !allocate_page( size_class, size_class_index ) ) {
+            return nullptr;
+        }
+
+        block = size_class.page_cursor;
+        size_class.page_cursor += block_size;
+    }
+
+    ++size_class.used_blocks;
+    allocated_size += block_size;
+    return block;
+}
+
+void* PoolAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+    // Blocks share addresses with the pages tracked in the parent, so they count only as churn.
+    syi_MEMORY_TRACK_TRANSIENT( size, file, line );
+    return allocate( size, alignment );
+}
+
+void PoolAllocator::deallocate( void* pointer ) {
+    if ( !pointer ) {
+        return;
+    }
+
+    const u64 page = ( u64 )pointer & ~( u64 )( k_pool_page_size - 1 );
+    const u32 size_class_index = pages.get( page );
+    if ( size_class_index == u32_max ) {
+        parent->deallocate( pointer );
+        return;
+    }
+
+    PoolSizeClass& size_class = size_classes[ size_class_index ];
+    *( void** )pointer = size_class.free_list;
+    size_class.free_list = pointer;
+
+    --size_class.used_blocks;
+    allocated_size -= 1ull << ( size_class_index + k_pool_min_block_shift );
+}
+
+} // namespace syi
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "foundation/memory.hpp"
+#include "foundation/hash_map.hpp"
+
+namespace syi {
+
+    static const u32                k_pool_size_class_count = 9;            // Power of two classes, 16 to 4096 bytes.
+    static const u32                k_pool_min_block_shift  = 4;
+    static const sizet              k_pool_max_block_size   = 4096;
+    static const sizet              k_pool_page_size        = 64 * 1024;    // Pages are aligned to their size.
+
+    //
+    // Blocks of a single size. Freed blocks are linked through their first bytes,
+    // new pages are carved lazily.
+    struct PoolSizeClass {
+
+        void*                       free_list       = nullptr;
+        u8*                         page_cursor     = nullptr;
+        u8*                         page_end        = nullptr;
+
+        u32                         used_blocks     = 0;
+        u32                         page_count      = 0;
+
+    }; // struct PoolSizeClass
+
+    //
+    // Slab allocator for small allocations. Pages are taken from the parent allocator
+    // and are given back only at shutdown; bigger allocations go directly to the parent.
+    // Not thread safe.
+    struct PoolAllocator : public Allocator {
+
+        ~PoolAllocator() override;
+
+        void                        init( Allocator* parent, u32 initial_page_count = 64 );
+        void                        shutdown();
+
+#if defined syi_IMGUI
+        void                        debug_ui();
+#endif // syi_IMGUI
+
+        void*                       allocate( sizet size, sizet alignment ) override;
+        void*                       allocate( sizet size, sizet alignment, cstring file, i32 line ) override;
+
+        void                        deallocate( void* pointer ) override;
+
+        static u32                  get_size_class( sizet size, sizet alignment );
+
+        void*                       allocate_page( PoolSizeClass& size_class, u32 size_class_index );
+
+        FlatHashMap<u64, u32>       pages;              // Page address to size class.
+        PoolSizeClass               size_classes[ k_pool_size_class_count ];
+
+        Allocator*                  parent          = nullptr;
+        sizet                       allocated_size  = 0;    // Bytes in used blocks.
+        sizet                       page_size_total = 0;    // Bytes taken from the parent.
+
+    }; // struct PoolAllocator
+
+} // namespace syi
@@ -118,6 +118,10 @@ cstring process_get_output() {
     return k_process_output_buffer;
 }
 
+u32 process_get_id() {
+    return GetCurrentProcessId();
+}
+
 #else
 
 bool process_execute( cstring working_directory, cstring process_fullpath, cstring arguments, cstring search_error_string ) {
@@ -188,6 +192,10 @@ cstring process_get_output() {
     return k_process_output_buffer;
 }
 
+u32 process_get_id() {
+    return ( u32 )getpid();
+}
+
 #endif // WIN64
 
 } // namespace syi
\ No newline at end of file
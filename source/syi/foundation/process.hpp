@@ -6,5 +6,6 @@ namespace syi {
 
     bool                            process_execute( cstring working_directory, cstring process_fullpath, cstring arguments, cstring search_error_string = "" );
     cstring                         process_get_output();
+    u32                             process_get_id();
 
 } // namespace syi
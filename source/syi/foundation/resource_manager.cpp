@@ -1,14 +1,35 @@
 #include "resource_manager.hpp"
 
+#include "foundation/log.hpp"
+#include "foundation/process.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
 namespace syi {
 
-void ResourceManager::init( Allocator* allocator_, ResourceFilenameResolver* resolver ) {
+void ResourceManager::init( Allocator* allocator_, ResourceFilenameResolver* resolver, cstring cache_directory_ ) {
 
     this->allocator = allocator_;
     this->filename_resolver = resolver;
 
     loaders.init( allocator, 8 );
     compilers.init( allocator, 8 );
+
+    cache_directory[ 0 ] = 0;
+    if ( cache_directory_ ) {
+        strncpy( cache_directory, cache_directory_, k_max_path - 1 );
+        cache_directory[ k_max_path - 1 ] = 0;
+
+        if ( !directory_exists( cache_directory ) ) {
+            directory_create( cache_directory );
+        }
+    }
+
+    cache_hits = 0;
+    cache_misses = 0;
+    failed_compiles = 0;
+    temporary_index = 0;
 }
 
 void ResourceManager::shutdown() {
@@ -19,12 +40,85 @@ void ResourceManager::shutdown() {
 
 void ResourceManager::set_loader( cstring resource_type, ResourceLoader* loader ) {
     const u64 hashed_name = hash_calculate( resource_type );
-    loaders.insert( hashed_name, loader );
+    loaders.insert_or_assign( hashed_name, loader );
 }
 
 void ResourceManager::set_compiler( cstring resource_type, ResourceCompiler* compiler ) {
     const u64 hashed_name = hash_calculate( resource_type );
-    compilers.insert( hashed_name, compiler );
+    compilers.insert_or_assign( hashed_name, compiler );
+}
+
+void ResourceManager::reclaim_retired_tables() {
+    loaders.reclaim_retired_tables();
+    compilers.reclaim_retired_tables();
+}
+
+cstring ResourceManager::get_cached_path( u64 resource_type_hash, cstring source_path, char* out_path, u32 max_size ) {
+    ResourceCompiler* compiler = compilers.get( resource_type_hash );
+    RASSERT( compiler );
+
+    // Only the source bytes are read on a hit, nothing is imported.
+    FileMapping source;
+    if ( !file_map_read_only( source_path, &source ) ) {
+        rprint( "Error: cannot read resource source %s\n", source_path );
+        return nullptr;
+    }
+    u64 key = hash_bytes( source.data, source.size, resource_type_hash ^ compiler->version );
+    file_unmap( &source );
+    key = compiler->hash_inputs( source_path, key );
+
+    snprintf( out_path, max_size, "%s/%016llx.%s", cache_directory, ( unsigned long long )key, compiler->extension );
+    if ( file_exists( out_path ) ) {
+        cache_hits.fetch_add( 1, std::memory_order_relaxed );
+        return out_path;
+    }
+
+    cache_misses.fetch_add( 1, std::memory_order_relaxed );
+
+    // Compiled under a name unique to this process and call then renamed, so that no reader sees a partial output,
+    // even with several processes sharing the cache.
+    char temporary_path[ k_max_path ];
+    snprintf( temporary_path, k_max_path, "%s.%u.%u.tmp", out_path, process_get_id(), temporary_index.fetch_add( 1, std::memory_order_relaxed ) );
+
+    if ( !compiler->compile( source_path, temporary_path ) ) {
+        failed_compiles.fetch_add( 1, std::memory_order_relaxed );
+        rprint( "Error: cannot compile resource %s\n", source_path );
+        file_delete( temporary_path );
+        return nullptr;
+    }
+
+    if ( rename( temporary_path, out_path ) != 0 ) {
+        // Another thread compiled the same key first.
+        file_delete( temporary_path );
+        if ( !file_exists( out_path ) ) {
+            failed_compiles.fetch_add( 1, std::memory_order_relaxed );
+            rprint( "Error: cannot store compiled resource %s\n", out_path );
+            return nullptr;
+        }
+    }
+
+    return out_path;
+}
+
+ResourceCacheStatistics ResourceManager::get_cache_statistics() const {
+    ResourceCacheStatistics statistics;
+    statistics.hits = cache_hits.load( std::memory_order_relaxed );
+    statistics.misses = cache_misses.load( std::memory_order_relaxed );
+    statistics.failed_compiles = failed_compiles.load( std::memory_order_relaxed );
+    return statistics;
+}
+
+bool ResourceManager::is_cached( u64 resource_type_hash ) const {
+    return cache_directory[ 0 ] != 0 && compilers.get( resource_type_hash ) != nullptr;
+}
+
+cstring ResourceManager::get_binary_path( u64 resource_type_hash, cstring name, char* cached_path, u32 max_size ) {
+    cstring path = filename_resolver ? filename_resolver->get_binary_path_from_name( name ) : name;
+
+    if ( !is_cached( resource_type_hash ) ) {
+        return path;
+    }
+    return get_cached_path( resource_type_hash, path, cached_path, max_size );
 }
 
-} // namespace syi
\ No newline at end of file
+} // namespace syi
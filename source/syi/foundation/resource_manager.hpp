@@ -3,6 +3,10 @@
 #include "foundation/platform.hpp"
 #include "foundation/assert.hpp"
 #include "foundation/hash_map.hpp"
+#include "foundation/concurrent_hash_map.hpp"
+#include "foundation/file.hpp"
+
+#include <atomic>
 
 namespace syi {
 
@@ -21,11 +25,28 @@ struct Resource {
 }; // struct Resource
 
 //
-//
+// Builds the derived data of a source file into the cache of the ResourceManager.
+// Outputs are addressed by a hash of the source bytes, of version and of what hash_inputs
+// adds, so that bumping version invalidates every output the compiler wrote before.
 struct ResourceCompiler {
 
+    // Adds dependencies and options to the key, seed being the hash of the source bytes.
+    virtual u64         hash_inputs( cstring source_path, u64 seed )    { return seed; }
+    virtual bool        compile( cstring source_path, cstring output_path ) = 0;
+
+    u32                 version     = 0;
+    cstring             extension   = "bin";
+
 }; // struct ResourceCompiler
 
+//
+//
+struct ResourceCacheStatistics {
+    u64                 hits;
+    u64                 misses;             // Compiled, successfully or not.
+    u64                 failed_compiles;
+}; // struct ResourceCacheStatistics
+
 //
 //
 struct ResourceLoader {
@@ -51,7 +72,8 @@ struct ResourceFilenameResolver {
 //
 struct ResourceManager {
 
-    void            init( Allocator* allocator, ResourceFilenameResolver* resolver );
+    // Without a cache directory the compilers are not used. Without a resolver, names are paths.
+    void            init( Allocator* allocator, ResourceFilenameResolver* resolver, cstring cache_directory = nullptr );
     void            shutdown();
 
     template <typename T>
@@ -69,12 +91,31 @@ struct ResourceManager {
     void            set_loader( cstring resource_type, ResourceLoader* loader );
     void            set_compiler( cstring resource_type, ResourceCompiler* compiler );
 
-    FlatHashMap<u64, ResourceLoader*>       loaders;
-    FlatHashMap<u64, ResourceCompiler*>     compilers;
+    // Frees the loader and compiler tables replaced as they grew, once no loading task is running.
+    void            reclaim_retired_tables();
+
+    // Cache path of the output of the compiler of the type for a source file, compiled first on a miss.
+    // Returns out_path, or null if the source is missing or does not compile.
+    cstring         get_cached_path( u64 resource_type_hash, cstring source_path, char* out_path, u32 max_size );
+    ResourceCacheStatistics get_cache_statistics() const;
+    // True if the type goes through the cache: there is a cache directory and a compiler for it.
+    bool            is_cached( u64 resource_type_hash ) const;
+
+    // Binary path of a resource, through the cache when its type has a compiler.
+    cstring         get_binary_path( u64 resource_type_hash, cstring name, char* cached_path, u32 max_size );
+
+    ConcurrentFlatHashMap<u64, ResourceLoader*> loaders;    // Read by loading tasks on worker threads.
+    ConcurrentFlatHashMap<u64, ResourceCompiler*> compilers;
 
     Allocator*      allocator;
     ResourceFilenameResolver* filename_resolver;
 
+    char            cache_directory[ k_max_path ];
+    std::atomic<u64> cache_hits;
+    std::atomic<u64> cache_misses;
+    std::atomic<u64> failed_compiles;
+    std::atomic<u32> temporary_index;                       // Unique names for outputs being compiled, with the process id.
+
 }; // struct ResourceManager
 
 template<typename T>
@@ -87,8 +128,9 @@ inline T* ResourceManager::load( cstring name ) {
             return resource;
 
         // Resource not in cache, create from file
-        cstring path = filename_resolver->get_binary_path_from_name( name );
-        return (T*)loader->create_from_file( name, path, this );
+        char cached_path[ k_max_path ];
+        cstring path = get_binary_path( T::k_type_hash, name, cached_path, k_max_path );
+        return path ? ( T* )loader->create_from_file( name, path, this ) : nullptr;
     }
     return nullptr;
 }
@@ -120,8 +162,9 @@ inline T* ResourceManager::reload(cstring name) {
             loader->unload( name );
 
             // Resource not in cache, create from file
-            cstring path = filename_resolver->get_binary_path_from_name( name );
-            return ( T* )loader->create_from_file( name, path, this );
+            char cached_path[ k_max_path ];
+            cstring path = get_binary_path( T::k_type_hash, name, cached_path, k_max_path );
+            return path ? ( T* )loader->create_from_file( name, path, this ) : nullptr;
         }
     }
     return nullptr;
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "foundation/memory.hpp"
+#include "foundation/assert.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace syi {
+
+    // SoAArray ///////////////////////////////////////////////////////////
+    //
+    // Structure of arrays: each field lives in its own contiguous, 64 bytes aligned array,
+    // all carved from a single allocation. Loops can touch only the fields they need.
+    //
+    // Usage:
+    //   SoAArray<mat4s, vec3s, u32> transforms;
+    //   transforms.for_each<0, 1>( []( mat4s& world, vec3s& position ) { ... } );
+    template <typename... Fields>
+    struct SoAArray {
+
+        static constexpr u32        k_field_count   = sizeof...( Fields );
+        static constexpr sizet      k_alignment     = 64;
+
+        template <u32 Index>
+        using Field                 = typename std::tuple_element<Index, std::tuple<Fields...>>::type;
+
+        void                        init( Allocator* allocator, u32 initial_capacity, u32 initial_size = 0 );
+        void                        shutdown();
+
+        u32                         push_use();                 // Grow the size and return the index to be filled.
+        void                        push( Fields... values );     // By value: they can alias this array.
+
+        void                        pop();
+        void                        delete_swap( u32 index );
+
+        void                        clear();
+        void                        set_size( u32 new_size );
+        void                        set_capacity( u32 new_capacity );
+        void                        grow( u32 new_capacity );   // Capacity is at least doubled.
+
+        template <u32 Index>
+        Field<Index>*               get();
+        template <u32 Index>
+        const Field<Index>*         get() const;
+
+        template <u32 Index>
+        Field<Index>&               get( u32 index );
+        template <u32 Index>
+        const Field<Index>&         get( u32 index ) const;
+
+        // Calls function( field_a[ i ], field_b[ i ], ... ) for the selected fields of every element.
+        template <u32... Indices, typename Function>
+        void                        for_each( Function&& function );
+
+        static sizet                field_array_size( u32 field, u32 capacity );
+
+        template <sizet... Indices>
+        void                        copy_fields( void* const* new_fields, std::index_sequence<Indices...> );
+        template <sizet... Indices>
+        void                        set_fields( u32 index, const Fields&... values, std::index_sequence<Indices...> );
+        template <sizet... Indices>
+        void                        move_element( u32 destination, u32 source, std::index_sequence<Indices...> );
+
+        void*                       fields[ k_field_count ];
+        u8*                         memory;
+        u32                         size;       // Occupied size
+        u32                         capacity;   // Allocated capacity
+        Allocator*                  allocator;
+
+    }; // struct SoAArray
+
+    // Implementation /////////////////////////////////////////////////////
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::init( Allocator* allocator_, u32 initial_capacity, u32 initial_size ) {
+        static_assert( k_field_count > 0, "SoAArray needs at least one field" );
+        static_assert( std::conjunction<std::is_trivially_copyable<Fields>...>::value, "SoAArray fields are relocated with memcpy" );
+
+        memory = nullptr;
+        size = 0;
+        capacity = 0;
+        allocator = allocator_;
+        for ( u32 f = 0; f < k_field_count; ++f ) {
+            fields[ f ] = nullptr;
+        }
+
+        const u32 new_capacity = initial_capacity > initial_size ? initial_capacity : initial_size;
+        if ( new_capacity > 0 ) {
+            grow( new_capacity );
+        }
+        size = initial_size;
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::shutdown() {
+        if ( capacity > 0 ) {
+            allocator->deallocate( memory );
+        }
+        memory = nullptr;
+        size = capacity = 0;
+    }
+
+    template<typename... Fields>
+    inline u32 SoAArray<Fields...>::push_use() {
+        if ( size >= capacity ) {
+            grow( capacity + 1 );
+        }
+        return size++;
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::push( Fields... values ) {
+        const u32 index = push_use();
+        set_fields( index, values..., std::index_sequence_for<Fields...>{} );
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::pop() {
+        RASSERT( size > 0 );
+        --size;
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::delete_swap( u32 index ) {
+        RASSERT( size > 0 && index < size );
+        move_element( index, --size, std::index_sequence_for<Fields...>{} );
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::clear() {
+        size = 0;
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::set_size( u32 new_size ) {
+        if ( new_size > capacity ) {
+            grow( new_size );
+        }
+        size = new_size;
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::set_capacity( u32 new_capacity ) {
+        if ( new_capacity > capacity ) {
+            grow( new_capacity );
+        }
+    }
+
+    template<typename... Fields>
+    inline sizet SoAArray<Fields...>::field_array_size( u32 field, u32 capacity_ ) {
+        static constexpr sizet k_field_sizes[] = { sizeof( Fields )... };
+        return memory_align( k_field_sizes[ field ] * capacity_, k_alignment );
+    }
+
+    template<typename... Fields>
+    inline void SoAArray<Fields...>::grow( u32 new_capacity ) {
+        if ( new_capacity < capacity * 2 ) {
+            new_capacity = capacity * 2;
+        }
+        if ( new_capacity < 4 ) {
+            new_capacity = 4;
+        }
+
+        // Single allocation, every field array starts on its own cache line.
+        sizet allocation_size = 0;
+        for ( u32 f = 0; f < k_field_count; ++f ) {
+            allocation_size += field_array_size( f, new_capacity );
+        }
+
+        u8* new_memory = ( u8* )allocator->allocate( allocation_size, k_alignment );
+        RASSERT( new_memory );
+
+        void* new_fields[ k_field_count ];
+        sizet offset = 0;
+        for ( u32 f = 0; f < k_field_count; ++f ) {
+            new_fields[ f ] = new_memory + offset;
+            offset += field_array_size( f, new_capacity );
+        }
+
+        if ( capacity ) {
+            copy_fields( new_fields, std::index_sequence_for<Fields...>{} );
+            allocator->deallocate( memory );
+        }
+
+        memory = new_memory;
+        for ( u32 f = 0; f < k_field_count; ++f ) {
+            fields[ f ] = new_fields[ f ];
+        }
+        capacity = new_capacity;
+    }
+
+    template<typename... Fields>
+    template<u32 Index>
+    inline typename SoAArray<Fields...>::template Field<Index>* SoAArray<Fields...>::get() {
+        return ( Field<Index>* )fields[ Index ];
+    }
+
+    template<typename... Fields>
+    template<u32 Index>
+    inline const typename SoAArray<Fields...>::template Field<Index>* SoAArray<Fields...>::get() const {
+        return ( const Field<Index>* )fields[ Index ];
+    }
+
+    template<typename... Fields>
+    template<u32 Index>
+    inline typename SoAArray<Fields...>::template Field<Index>& SoAArray<Fields...>::get( u32 index ) {
+        RASSERT( index < size );
+        return get<Index>()[ index ];
+    }
+
+    template<typename... Fields>
+    template<u32 Index>
+    inline const typename SoAArray<Fields...>::template Field<Index>& SoAArray<Fields...>::get( u32 index ) const {
+        RASSERT( index < size );
+        return get<Index>()[ index ];
+    }
+
+    template<typename... Fields>
+    template<u32... Indices, typename Function>
+    inline void SoAArray<Fields...>::for_each( Function&& function ) {
+        // Hoist the field pointers, so the loop only streams the selected arrays.
+        auto arrays = std::make_tuple( get<Indices>()... );
+        std::apply( [ this, &function ]( auto*... field_arrays ) {
+            for ( u32 i = 0; i < size; ++i ) {
+                function( field_arrays[ i ]... );
+            }
+        }, arrays );
+    }
+
+    template<typename... Fields>
+    template<sizet... Indices>
+    inline void SoAArray<Fields...>::copy_fields( void* const* new_fields, std::index_sequence<Indices...> ) {
+        ( memory_copy( new_fields[ Indices ], fields[ Indices ], sizeof( Fields ) * size ), ... );
+    }
+
+    template<typename... Fields>
+    template<sizet... Indices>
+    inline void SoAArray<Fields...>::set_fields( u32 index, const Fields&... values, std::index_sequence<Indices...> ) {
+        ( ( ( ( Fields* )fields[ Indices ] )[ index ] = values ), ... );
+    }
+
+    template<typename... Fields>
+    template<sizet... Indices>
+    inline void SoAArray<Fields...>::move_element( u32 destination, u32 source, std::index_sequence<Indices...> ) {
+        ( ( ( ( Fields* )fields[ Indices ] )[ destination ] = ( ( Fields* )fields[ Indices ] )[ source ] ), ... );
+    }
+
+} // namespace syi
@@ -0,0 +1,902 @@
+#include "texture_compiler.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/assert.hpp"
+#include "foundation/log.hpp"
+#include "foundation/file.hpp"
+#include "foundation/hash_map.hpp"
+#include "foundation/time.hpp"
+#include "foundation/blob_serialization.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/common.h"          // SSE2 detection, with the intrinsics headers.
+#include "external/stb_image.h"             // Implemented by the renderer.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace syi {
+
+static const u32 k_texture_kaiser_taps = 6;             // Source pixels of each output pixel, per axis.
+static const f32 k_texture_kaiser_beta = 4.0f;
+
+static const u8 k_bc7_weights4[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Mips ///////////////////////////////////////////////////////////////////
+
+u32 texture_mip_count( u32 width, u32 height ) {
+    u32 count = 1;
+    while ( width > 1 || height > 1 ) {
+        width = max( width / 2, 1u );
+        height = max( height / 2, 1u );
+        ++count;
+    }
+    return count;
+}
+
+sizet texture_level_size( TextureCompression compression, u32 width, u32 height ) {
+    const sizet blocks = sizet( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 );
+    switch ( compression ) {
+        case TextureCompression_BC1:
+            return blocks * 8;
+        case TextureCompression_BC5:
+        case TextureCompression_BC7:
+            return blocks * 16;
+        default:
+            return sizet( width ) * height * 4;
+    }
+}
+
+// Pixels are 4 floats, one SSE register.
+static inline void texture_pixel_accumulate( f32* destination, const f32* source, f32 weight ) {
+#if defined(__SSE2__)
+    _mm_storeu_ps( destination, _mm_add_ps( _mm_loadu_ps( destination ), _mm_mul_ps( _mm_loadu_ps( source ), _mm_set1_ps( weight ) ) ) );
+#else
+    for ( u32 c = 0; c < 4; ++c ) {
+        destination[ c ] += source[ c ] * weight;
+    }
+#endif // __SSE2__
+}
+
+static inline void texture_pixel_average( f32* destination, const f32* a, const f32* b, const f32* c, const f32* d ) {
+#if defined(__SSE2__)
+    const __m128 sum = _mm_add_ps( _mm_add_ps( _mm_loadu_ps( a ), _mm_loadu_ps( b ) ), _mm_add_ps( _mm_loadu_ps( c ), _mm_loadu_ps( d ) ) );
+    _mm_storeu_ps( destination, _mm_mul_ps( sum, _mm_set1_ps( 0.25f ) ) );
+#else
+    for ( u32 i = 0; i < 4; ++i ) {
+        destination[ i ] = ( a[ i ] + b[ i ] + c[ i ] + d[ i ] ) * 0.25f;
+    }
+#endif // __SSE2__
+}
+
+static f32 bessel_i0( f32 x ) {
+    f32 sum = 1.0f, term = 1.0f;
+    for ( u32 k = 1; k < 16; ++k ) {
+        const f32 half = x / ( 2.0f * k );
+        term *= half * half;
+        sum += term;
+    }
+    return sum;
+}
+
+// Lowpass at half the source frequency, windowed over the taps centered between two source pixels.
+static void texture_kaiser_weights( f32 weights[ k_texture_kaiser_taps ] ) {
+    const f32 radius = k_texture_kaiser_taps * 0.5f;
+    f32 sum = 0.0f;
+    for ( u32 t = 0; t < k_texture_kaiser_taps; ++t ) {
+        const f32 x = t - radius + 0.5f;
+        const f32 phase = x * 0.5f * 3.14159265f;
+        const f32 sinc = fabsf( phase ) > 1e-5f ? sinf( phase ) / phase : 1.0f;
+        const f32 window = x / radius;
+        weights[ t ] = sinc * bessel_i0( k_texture_kaiser_beta * sqrtf( max( 1.0f - window * window, 0.0f ) ) ) / bessel_i0( k_texture_kaiser_beta );
+        sum += weights[ t ];
+    }
+    for ( u32 t = 0; t < k_texture_kaiser_taps; ++t ) {
+        weights[ t ] /= sum;
+    }
+}
+
+void texture_downsample( const f32* source, u32 width, u32 height, TextureMipFilter filter, f32* scratch, f32* destination ) {
+    const u32 mip_width = max( width / 2, 1u );
+    const u32 mip_height = max( height / 2, 1u );
+
+    if ( filter == TextureMipFilter_Box ) {
+        for ( u32 y = 0; y < mip_height; ++y ) {
+            const f32* row0 = source + sizet( min( y * 2, height - 1 ) ) * width * 4;
+            const f32* row1 = source + sizet( min( y * 2 + 1, height - 1 ) ) * width * 4;
+            f32* output = destination + sizet( y ) * mip_width * 4;
+
+            for ( u32 x = 0; x < mip_width; ++x ) {
+                const u32 x0 = min( x * 2, width - 1 ) * 4;
+                const u32 x1 = min( x * 2 + 1, width - 1 ) * 4;
+                texture_pixel_average( output + x * 4, row0 + x0, row0 + x1, row1 + x0, row1 + x1 );
+            }
+        }
+        return;
+    }
+
+    f32 weights[ k_texture_kaiser_taps ];
+    texture_kaiser_weights( weights );
+    const i32 first_tap = 1 - ( i32 )k_texture_kaiser_taps / 2;
+
+    // Separable: rows into scratch, then columns into the destination, clamping at the edges.
+    memset( scratch, 0, sizeof( f32 ) * 4 * mip_width * height );
+    for ( u32 y = 0; y < height; ++y ) {
+        const f32* row = source + sizet( y ) * width * 4;
+        f32* output = scratch + sizet( y ) * mip_width * 4;
+
+        for ( u32 x = 0; x < mip_width; ++x ) {
+            for ( u32 t = 0; t < k_texture_kaiser_taps; ++t ) {
+                const i32 sx = clamp( ( i32 )( x * 2 ) + first_tap + ( i32 )t, 0, ( i32 )width - 1 );
+                texture_pixel_accumulate( output + x * 4, row + sx * 4, weights[ t ] );
+            }
+        }
+    }
+
+    memset( destination, 0, sizeof( f32 ) * 4 * mip_width * mip_height );
+    for ( u32 y = 0; y < mip_height; ++y ) {
+        f32* output = destination + sizet( y ) * mip_width * 4;
+
+        for ( u32 t = 0; t < k_texture_kaiser_taps; ++t ) {
+            const i32 sy = clamp( ( i32 )( y * 2 ) + first_tap + ( i32 )t, 0, ( i32 )height - 1 );
+            const f32* row = scratch + sizet( sy ) * mip_width * 4;
+            for ( u32 x = 0; x < mip_width; ++x ) {
+                texture_pixel_accumulate( output + x * 4, row + x * 4, weights[ t ] );
+            }
+        }
+    }
+}
+
+static f32 texture_linear_to_srgb( f32 value ) {
+    value = clamp( value, 0.0f, 1.0f );
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf( value, 1.0f / 2.4f ) - 0.055f;
+}
+
+static void texture_to_linear( const u8* pixels, u32 pixel_count, bool srgb, f32* destination ) {
+    f32 table[ 256 ];
+    for ( u32 i = 0; i < 256; ++i ) {
+        const f32 value = i / 255.0f;
+        table[ i ] = !srgb ? value : value <= 0.04045f ? value / 12.92f : powf( ( value + 0.055f ) / 1.055f, 2.4f );
+    }
+
+    for ( sizet i = 0; i < sizet( pixel_count ) * 4; i += 4 ) {
+        destination[ i ] = table[ pixels[ i ] ];
+        destination[ i + 1 ] = table[ pixels[ i + 1 ] ];
+        destination[ i + 2 ] = table[ pixels[ i + 2 ] ];
+        destination[ i + 3 ] = pixels[ i + 3 ] / 255.0f;
+    }
+}
+
+static void texture_from_linear( const f32* pixels, u32 pixel_count, bool srgb, u8* destination ) {
+    for ( sizet i = 0; i < sizet( pixel_count ) * 4; ++i ) {
+        const f32 value = ( i & 3 ) != 3 && srgb ? texture_linear_to_srgb( pixels[ i ] ) : clamp( pixels[ i ], 0.0f, 1.0f );
+        destination[ i ] = ( u8 )( value * 255.0f + 0.5f );
+    }
+}
+
+// Block compression //////////////////////////////////////////////////////
+
+// 4x4 block, clamped to the image.
+static void texture_fetch_block( const u8* pixels, u32 width, u32 height, u32 block_x, u32 block_y, f32 block[ 16 ][ 4 ] ) {
+    for ( u32 y = 0; y < 4; ++y ) {
+        const u32 py = min( block_y * 4 + y, height - 1 );
+        for ( u32 x = 0; x < 4; ++x ) {
+            const u32 px = min( block_x * 4 + x, width - 1 );
+            const u8* pixel = pixels + ( sizet( py ) * width + px ) * 4;
+            for ( u32 c = 0; c < 4; ++c ) {
+                block[ y * 4 + x ][ c ] = pixel[ c ];
+            }
+        }
+    }
+}
+
+// Endpoints along the principal axis of the first channels, the extremes of the block projections.
+static void texture_principal_endpoints( const f32 block[ 16 ][ 4 ], u32 channels, f32* out_a, f32* out_b ) {
+    f32 mean[ 4 ] = { };
+    for ( u32 i = 0; i < 16; ++i ) {
+        for ( u32 c = 0; c < channels; ++c ) {
+            mean[ c ] += block[ i ][ c ] / 16.0f;
+        }
+    }
+
+    f32 covariance[ 4 ][ 4 ] = { };
+    for ( u32 i = 0; i < 16; ++i ) {
+        for ( u32 r = 0; r < channels; ++r ) {
+            for ( u32 c = 0; c < channels; ++c ) {
+                covariance[ r ][ c ] += ( block[ i ][ r ] - mean[ r ] ) * ( block[ i ][ c ] - mean[ c ] );
+            }
+        }
+    }
+
+    // Power iteration from the diagonal.
+    f32 axis[ 4 ] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for ( u32 c = 0; c < channels; ++c ) {
+        axis[ c ] = covariance[ c ][ c ] + 1e-3f;
+    }
+    for ( u32 iteration = 0; iteration < 8; ++iteration ) {
+        f32 next[ 4 ] = { };
+        f32 length = 0.0f;
+        for ( u32 r = 0; r < channels; ++r ) {
+            for ( u32 c = 0; c < channels; ++c ) {
+                next[ r ] += covariance[ r ][ c ] * axis[ c ];
+            }
+            length = max( length, fabsf( next[ r ] ) );
+        }
+        if ( length < 1e-6f ) {
+            break;
+        }
+        for ( u32 c = 0; c < channels; ++c ) {
+            axis[ c ] = next[ c ] / length;
+        }
+    }
+
+    f32 t_min = f32( 1e30 ), t_max = f32( -1e30 );
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 t = 0.0f;
+        for ( u32 c = 0; c < channels; ++c ) {
+            t += ( block[ i ][ c ] - mean[ c ] ) * axis[ c ];
+        }
+        t_min = min( t_min, t );
+        t_max = max( t_max, t );
+    }
+
+    f32 length_squared = 0.0f;
+    for ( u32 c = 0; c < channels; ++c ) {
+        length_squared += axis[ c ] * axis[ c ];
+    }
+    length_squared = max( length_squared, 1e-12f );
+
+    for ( u32 c = 0; c < channels; ++c ) {
+        out_a[ c ] = clamp( mean[ c ] + axis[ c ] * t_min / length_squared, 0.0f, 255.0f );
+        out_b[ c ] = clamp( mean[ c ] + axis[ c ] * t_max / length_squared, 0.0f, 255.0f );
+    }
+}
+
+// Endpoints minimizing the squared error for fixed interpolation factors t, pixel = a + ( b - a ) * t.
+static bool texture_least_squares_endpoints( const f32 block[ 16 ][ 4 ], const f32 t[ 16 ], u32 channels, f32* out_a, f32* out_b ) {
+    f32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    f32 ax[ 4 ] = { }, bx[ 4 ] = { };
+    for ( u32 i = 0; i < 16; ++i ) {
+        const f32 wa = 1.0f - t[ i ], wb = t[ i ];
+        aa += wa * wa;
+        ab += wa * wb;
+        bb += wb * wb;
+        for ( u32 c = 0; c < channels; ++c ) {
+            ax[ c ] += wa * block[ i ][ c ];
+            bx[ c ] += wb * block[ i ][ c ];
+        }
+    }
+
+    const f32 determinant = aa * bb - ab * ab;
+    if ( fabsf( determinant ) < 1e-6f ) {
+        return false;
+    }
+
+    for ( u32 c = 0; c < channels; ++c ) {
+        out_a[ c ] = clamp( ( ax[ c ] * bb - bx[ c ] * ab ) / determinant, 0.0f, 255.0f );
+        out_b[ c ] = clamp( ( bx[ c ] * aa - ax[ c ] * ab ) / determinant, 0.0f, 255.0f );
+    }
+    return true;
+}
+
+// BC1 ////////////////////////////////////////////////////////////////////
+
+static u16 bc1_pack_565( const f32* colour ) {
+    const u32 r = ( u32 )( colour[ 0 ] * 31.0f / 255.0f + 0.5f );
+    const u32 g = ( u32 )( colour[ 1 ] * 63.0f / 255.0f + 0.5f );
+    const u32 b = ( u32 )( colour[ 2 ] * 31.0f / 255.0f + 0.5f );
+    return ( u16 )( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+static void bc1_unpack_565( u16 packed, i32* colour ) {
+    const i32 r = ( packed >> 11 ) & 31, g = ( packed >> 5 ) & 63, b = packed & 31;
+    colour[ 0 ] = ( r << 3 ) | ( r >> 2 );
+    colour[ 1 ] = ( g << 2 ) | ( g >> 4 );
+    colour[ 2 ] = ( b << 3 ) | ( b >> 2 );
+}
+
+static void bc1_palette( u16 colour0, u16 colour1, i32 palette[ 4 ][ 3 ] ) {
+    bc1_unpack_565( colour0, palette[ 0 ] );
+    bc1_unpack_565( colour1, palette[ 1 ] );
+    for ( u32 c = 0; c < 3; ++c ) {
+        if ( colour0 > colour1 ) {
+            palette[ 2 ][ c ] = ( 2 * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3;
+            palette[ 3 ][ c ] = ( palette[ 0 ][ c ] + 2 * palette[ 1 ][ c ] ) / 3;
+        } else {
+            palette[ 2 ][ c ] = ( palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 2;
+            palette[ 3 ][ c ] = 0;
+        }
+    }
+}
+
+// Four colours mode only: the larger endpoint goes first, equal endpoints use index 0.
+static f32 bc1_evaluate( const f32 block[ 16 ][ 4 ], const f32* a, const f32* b, u16& out_colour0, u16& out_colour1, u32& out_indices ) {
+    const u16 packed_a = bc1_pack_565( a ), packed_b = bc1_pack_565( b );
+    out_colour0 = max( packed_a, packed_b );
+    out_colour1 = min( packed_a, packed_b );
+
+    i32 palette[ 4 ][ 3 ];
+    bc1_palette( out_colour0, out_colour1, palette );
+    const u32 palette_count = out_colour0 > out_colour1 ? 4 : 1;
+
+    f32 error = 0.0f;
+    out_indices = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 best = f32( 1e30 );
+        u32 best_index = 0;
+        for ( u32 p = 0; p < palette_count; ++p ) {
+            const f32 r = block[ i ][ 0 ] - palette[ p ][ 0 ], g = block[ i ][ 1 ] - palette[ p ][ 1 ], bl = block[ i ][ 2 ] - palette[ p ][ 2 ];
+            const f32 distance = r * r + g * g + bl * bl;
+            if ( distance < best ) {
+                best = distance;
+                best_index = p;
+            }
+        }
+        error += best;
+        out_indices |= best_index << ( i * 2 );
+    }
+    return error;
+}
+
+static void bc1_encode_block( const f32 block[ 16 ][ 4 ], u8* output ) {
+    static const f32 k_bc1_factors[ 4 ] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    f32 a[ 4 ], b[ 4 ];
+    texture_principal_endpoints( block, 3, a, b );
+
+    u16 colour0, colour1;
+    u32 indices;
+    f32 error = bc1_evaluate( block, a, b, colour0, colour1, indices );
+
+    // One refinement from the chosen indices, relative to the first and second colours.
+    f32 t[ 16 ];
+    for ( u32 i = 0; i < 16; ++i ) {
+        t[ i ] = k_bc1_factors[ ( indices >> ( i * 2 ) ) & 3 ];
+    }
+    if ( colour0 > colour1 && texture_least_squares_endpoints( block, t, 3, a, b ) ) {
+        u16 refined0, refined1;
+        u32 refined_indices;
+        const f32 refined_error = bc1_evaluate( block, a, b, refined0, refined1, refined_indices );
+        if ( refined_error < error ) {
+            colour0 = refined0;
+            colour1 = refined1;
+            indices = refined_indices;
+        }
+    }
+
+    memcpy( output, &colour0, 2 );
+    memcpy( output + 2, &colour1, 2 );
+    memcpy( output + 4, &indices, 4 );
+}
+
+static void bc1_decode_block( const u8* input, u8 block[ 16 ][ 4 ] ) {
+    u16 colour0, colour1;
+    u32 indices;
+    memcpy( &colour0, input, 2 );
+    memcpy( &colour1, input + 2, 2 );
+    memcpy( &indices, input + 4, 4 );
+
+    i32 palette[ 4 ][ 3 ];
+    bc1_palette( colour0, colour1, palette );
+    for ( u32 i = 0; i < 16; ++i ) {
+        const u32 index = ( indices >> ( i * 2 ) ) & 3;
+        for ( u32 c = 0; c < 3; ++c ) {
+            block[ i ][ c ] = ( u8 )palette[ index ][ c ];
+        }
+        block[ i ][ 3 ] = colour0 <= colour1 && index == 3 ? 0 : 255;
+    }
+}
+
+// BC4 channels of BC5 ////////////////////////////////////////////////////
+
+static void bc4_palette( u8 value0, u8 value1, i32 palette[ 8 ] ) {
+    palette[ 0 ] = value0;
+    palette[ 1 ] = value1;
+    if ( value0 > value1 ) {
+        for ( i32 p = 2; p < 8; ++p ) {
+            palette[ p ] = ( ( 8 - p ) * value0 + ( p - 1 ) * value1 + 3 ) / 7;
+        }
+    } else {
+        for ( i32 p = 2; p < 6; ++p ) {
+            palette[ p ] = ( ( 6 - p ) * value0 + ( p - 1 ) * value1 + 2 ) / 5;
+        }
+        palette[ 6 ] = 0;
+        palette[ 7 ] = 255;
+    }
+}
+
+static void bc4_encode_block( const f32 block[ 16 ][ 4 ], u32 channel, u8* output ) {
+    f32 minimum = 255.0f, maximum = 0.0f;
+    for ( u32 i = 0; i < 16; ++i ) {
+        minimum = min( minimum, block[ i ][ channel ] );
+        maximum = max( maximum, block[ i ][ channel ] );
+    }
+
+    // Eight values mode, or a constant block with index 0.
+    const u8 value0 = ( u8 )maximum, value1 = ( u8 )minimum;
+    i32 palette[ 8 ];
+    bc4_palette( value0, value1, palette );
+    const u32 palette_count = value0 > value1 ? 8 : 1;
+
+    u64 indices = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 best = f32( 1e30 );
+        u64 best_index = 0;
+        for ( u32 p = 0; p < palette_count; ++p ) {
+            const f32 distance = fabsf( block[ i ][ channel ] - palette[ p ] );
+            if ( distance < best ) {
+                best = distance;
+                best_index = p;
+            }
+        }
+        indices |= best_index << ( i * 3 );
+    }
+
+    output[ 0 ] = value0;
+    output[ 1 ] = value1;
+    for ( u32 b = 0; b < 6; ++b ) {
+        output[ 2 + b ] = ( u8 )( indices >> ( b * 8 ) );
+    }
+}
+
+static void bc4_decode_block( const u8* input, u32 channel, u8 block[ 16 ][ 4 ] ) {
+    i32 palette[ 8 ];
+    bc4_palette( input[ 0 ], input[ 1 ], palette );
+
+    u64 indices = 0;
+    for ( u32 b = 0; b < 6; ++b ) {
+        indices |= u64( input[ 2 + b ] ) << ( b * 8 );
+    }
+    for ( u32 i = 0; i < 16; ++i ) {
+        block[ i ][ channel ] = ( u8 )palette[ ( indices >> ( i * 3 ) ) & 7 ];
+    }
+}
+
+// BC7 mode 6 /////////////////////////////////////////////////////////////
+
+// Bits are written from the lowest bit of the first byte.
+struct Bc7BitWriter {
+    void                        write( u32 value, u32 count ) {
+        for ( u32 b = 0; b < count; ++b, ++position ) {
+            bytes[ position >> 3 ] |= ( u8 )( ( ( value >> b ) & 1 ) << ( position & 7 ) );
+        }
+    }
+
+    u8*                         bytes;
+    u32                         position        = 0;
+}; // struct Bc7BitWriter
+
+static u32 bc7_read_bits( const u8* bytes, u32& position, u32 count ) {
+    u32 value = 0;
+    for ( u32 b = 0; b < count; ++b, ++position ) {
+        value |= ( ( bytes[ position >> 3 ] >> ( position & 7 ) ) & 1u ) << b;
+    }
+    return value;
+}
+
+// 7 bits per channel and a shared lowest bit, choosing the p bit with the smaller error.
+static void bc7_quantize_endpoint( const f32* endpoint, u32 out_channels[ 4 ], u32& out_p ) {
+    f32 best = f32( 1e30 );
+    for ( u32 p = 0; p < 2; ++p ) {
+        u32 channels[ 4 ];
+        f32 error = 0.0f;
+        for ( u32 c = 0; c < 4; ++c ) {
+            channels[ c ] = ( u32 )clamp( ( i32 )( ( endpoint[ c ] - p ) * 0.5f + 0.5f ), 0, 127 );
+            const f32 difference = f32( channels[ c ] * 2 + p ) - endpoint[ c ];
+            error += difference * difference;
+        }
+        if ( error < best ) {
+            best = error;
+            out_p = p;
+            memcpy( out_channels, channels, sizeof( channels ) );
+        }
+    }
+}
+
+static f32 bc7_evaluate( const f32 block[ 16 ][ 4 ], const f32* a, const f32* b, u32 out_endpoints[ 2 ][ 4 ], u32 out_p[ 2 ], u8 out_indices[ 16 ] ) {
+    bc7_quantize_endpoint( a, out_endpoints[ 0 ], out_p[ 0 ] );
+    bc7_quantize_endpoint( b, out_endpoints[ 1 ], out_p[ 1 ] );
+
+    i32 palette[ 16 ][ 4 ];
+    for ( u32 c = 0; c < 4; ++c ) {
+        const i32 e0 = out_endpoints[ 0 ][ c ] * 2 + out_p[ 0 ], e1 = out_endpoints[ 1 ][ c ] * 2 + out_p[ 1 ];
+        for ( u32 p = 0; p < 16; ++p ) {
+            palette[ p ][ c ] = ( ( 64 - k_bc7_weights4[ p ] ) * e0 + k_bc7_weights4[ p ] * e1 + 32 ) >> 6;
+        }
+    }
+
+    f32 error = 0.0f;
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 best = f32( 1e30 );
+        for ( u32 p = 0; p < 16; ++p ) {
+            f32 distance = 0.0f;
+            for ( u32 c = 0; c < 4; ++c ) {
+                const f32 difference = block[ i ][ c ] - palette[ p ][ c ];
+                distance += difference * difference;
+            }
+            if ( distance < best ) {
+                best = distance;
+                out_indices[ i ] = ( u8 )p;
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+static void bc7_encode_block( const f32 block[ 16 ][ 4 ], u8* output ) {
+    f32 a[ 4 ], b[ 4 ];
+    texture_principal_endpoints( block, 4, a, b );
+
+    u32 endpoints[ 2 ][ 4 ], p[ 2 ];
+    u8 indices[ 16 ];
+    f32 error = bc7_evaluate( block, a, b, endpoints, p, indices );
+
+    f32 t[ 16 ];
+    for ( u32 i = 0; i < 16; ++i ) {
+        t[ i ] = k_bc7_weights4[ indices[ i ] ] / 64.0f;
+    }
+    if ( texture_least_squares_endpoints( block, t, 4, a, b ) ) {
+        u32 refined_endpoints[ 2 ][ 4 ], refined_p[ 2 ];
+        u8 refined_indices[ 16 ];
+        const f32 refined_error = bc7_evaluate( block, a, b, refined_endpoints, refined_p, refined_indices );
+        if ( refined_error < error ) {
+            memcpy( endpoints, refined_endpoints, sizeof( endpoints ) );
+            memcpy( p, refined_p, sizeof( p ) );
+            memcpy( indices, refined_indices, sizeof( indices ) );
+        }
+    }
+
+    // The highest bit of the first index is implied 0: swap the endpoints otherwise.
+    if ( indices[ 0 ] & 8 ) {
+        for ( u32 c = 0; c < 4; ++c ) {
+            const u32 swap = endpoints[ 0 ][ c ];
+            endpoints[ 0 ][ c ] = endpoints[ 1 ][ c ];
+            endpoints[ 1 ][ c ] = swap;
+        }
+        const u32 swap = p[ 0 ];
+        p[ 0 ] = p[ 1 ];
+        p[ 1 ] = swap;
+        for ( u32 i = 0; i < 16; ++i ) {
+            indices[ i ] = 15 - indices[ i ];
+        }
+    }
+
+    memset( output, 0, 16 );
+    Bc7BitWriter writer{ output };
+    writer.write( 1 << 6, 7 );
+    for ( u32 c = 0; c < 4; ++c ) {
+        writer.write( endpoints[ 0 ][ c ], 7 );
+        writer.write( endpoints[ 1 ][ c ], 7 );
+    }
+    writer.write( p[ 0 ], 1 );
+    writer.write( p[ 1 ], 1 );
+    writer.write( indices[ 0 ], 3 );
+    for ( u32 i = 1; i < 16; ++i ) {
+        writer.write( indices[ i ], 4 );
+    }
+}
+
+// Other modes decode to magenta, only mode 6 is written.
+static void bc7_decode_block( const u8* input, u8 block[ 16 ][ 4 ] ) {
+    u32 position = 0;
+    if ( bc7_read_bits( input, position, 7 ) != ( 1 << 6 ) ) {
+        for ( u32 i = 0; i < 16; ++i ) {
+            block[ i ][ 0 ] = block[ i ][ 2 ] = block[ i ][ 3 ] = 255;
+            block[ i ][ 1 ] = 0;
+        }
+        return;
+    }
+
+    u32 endpoints[ 2 ][ 4 ];
+    for ( u32 c = 0; c < 4; ++c ) {
+        endpoints[ 0 ][ c ] = bc7_read_bits( input, position, 7 ) << 1;
+        endpoints[ 1 ][ c ] = bc7_read_bits( input, position, 7 ) << 1;
+    }
+    const u32 p0 = bc7_read_bits( input, position, 1 ), p1 = bc7_read_bits( input, position, 1 );
+    for ( u32 c = 0; c < 4; ++c ) {
+        endpoints[ 0 ][ c ] |= p0;
+        endpoints[ 1 ][ c ] |= p1;
+    }
+
+    for ( u32 i = 0; i < 16; ++i ) {
+        const u32 weight = k_bc7_weights4[ bc7_read_bits( input, position, i == 0 ? 3 : 4 ) ];
+        for ( u32 c = 0; c < 4; ++c ) {
+            block[ i ][ c ] = ( u8 )( ( ( 64 - weight ) * endpoints[ 0 ][ c ] + weight * endpoints[ 1 ][ c ] + 32 ) >> 6 );
+        }
+    }
+}
+
+static void texture_compress_block_row( const u8* pixels, u32 width, u32 height, TextureCompression compression, u32 block_y, u8* destination ) {
+    const u32 blocks_x = ( width + 3 ) / 4;
+    const u32 block_size = compression == TextureCompression_BC1 ? 8 : 16;
+    u8* output = destination + sizet( block_y ) * blocks_x * block_size;
+
+    f32 block[ 16 ][ 4 ];
+    for ( u32 block_x = 0; block_x < blocks_x; ++block_x, output += block_size ) {
+        texture_fetch_block( pixels, width, height, block_x, block_y, block );
+
+        switch ( compression ) {
+            case TextureCompression_BC1:
+                bc1_encode_block( block, output );
+                break;
+            case TextureCompression_BC5:
+                bc4_encode_block( block, 0, output );
+                bc4_encode_block( block, 1, output + 8 );
+                break;
+            default:
+                bc7_encode_block( block, output );
+                break;
+        }
+    }
+}
+
+//
+//
+struct TextureCompressTask : enki::ITaskSet {
+
+    void ExecuteRange( enki::TaskSetPartition range, uint32_t threadnum ) override {
+        for ( u32 block_y = range.start; block_y < range.end; ++block_y ) {
+            texture_compress_block_row( pixels, width, height, compression, block_y, destination );
+        }
+    }
+
+    const u8*                       pixels          = nullptr;
+    u32                             width           = 0;
+    u32                             height          = 0;
+    TextureCompression              compression     = TextureCompression_None;
+    u8*                             destination     = nullptr;
+}; // struct TextureCompressTask
+
+void texture_compress( const u8* pixels, u32 width, u32 height, TextureCompression compression, u8* destination, enki::TaskScheduler* task_scheduler ) {
+    if ( compression == TextureCompression_None ) {
+        memcpy( destination, pixels, texture_level_size( compression, width, height ) );
+        return;
+    }
+
+    const u32 blocks_y = ( height + 3 ) / 4;
+    if ( task_scheduler == nullptr || blocks_y == 1 ) {
+        for ( u32 block_y = 0; block_y < blocks_y; ++block_y ) {
+            texture_compress_block_row( pixels, width, height, compression, block_y, destination );
+        }
+        return;
+    }
+
+    TextureCompressTask compress_task;
+    compress_task.m_SetSize = blocks_y;
+    compress_task.pixels = pixels;
+    compress_task.width = width;
+    compress_task.height = height;
+    compress_task.compression = compression;
+    compress_task.destination = destination;
+
+    task_scheduler->AddTaskSetToPipe( &compress_task );
+    task_scheduler->WaitforTask( &compress_task );
+}
+
+void texture_decompress( const u8* blocks, u32 width, u32 height, TextureCompression compression, u8* pixels ) {
+    if ( compression == TextureCompression_None ) {
+        memcpy( pixels, blocks, texture_level_size( compression, width, height ) );
+        return;
+    }
+
+    const u32 blocks_x = ( width + 3 ) / 4, blocks_y = ( height + 3 ) / 4;
+    const u32 block_size = compression == TextureCompression_BC1 ? 8 : 16;
+
+    u8 block[ 16 ][ 4 ];
+    for ( u32 block_y = 0; block_y < blocks_y; ++block_y ) {
+        for ( u32 block_x = 0; block_x < blocks_x; ++block_x, blocks += block_size ) {
+            switch ( compression ) {
+                case TextureCompression_BC1:
+                    bc1_decode_block( blocks, block );
+                    break;
+                case TextureCompression_BC5:
+                    bc4_decode_block( blocks, 0, block );
+                    bc4_decode_block( blocks + 8, 1, block );
+                    for ( u32 i = 0; i < 16; ++i ) {
+                        block[ i ][ 2 ] = 0;
+                        block[ i ][ 3 ] = 255;
+                    }
+                    break;
+                default:
+                    bc7_decode_block( blocks, block );
+                    break;
+            }
+
+            for ( u32 y = 0; y < 4 && block_y * 4 + y < height; ++y ) {
+                for ( u32 x = 0; x < 4 && block_x * 4 + x < width; ++x ) {
+                    memcpy( pixels + ( sizet( block_y * 4 + y ) * width + block_x * 4 + x ) * 4, block[ y * 4 + x ], 4 );
+                }
+            }
+        }
+    }
+}
+
+f32 texture_psnr( const u8* a, const u8* b, u32 width, u32 height, u32 channels ) {
+    f64 squared_error = 0.0;
+    for ( sizet i = 0; i < sizet( width ) * height; ++i ) {
+        for ( u32 c = 0; c < channels; ++c ) {
+            const f64 difference = f64( a[ i * 4 + c ] ) - f64( b[ i * 4 + c ] );
+            squared_error += difference * difference;
+        }
+    }
+
+    const f64 mean_squared_error = squared_error / ( f64( width ) * height * channels );
+    return mean_squared_error > 0.0 ? ( f32 )( 10.0 * log10( 255.0 * 255.0 / mean_squared_error ) ) : INFINITY;
+}
+
+// Compiled textures //////////////////////////////////////////////////////
+
+static cstring k_texture_compression_names[ TextureCompression_Count ] = { "RGBA8", "BC1", "BC5", "BC7" };
+
+bool texture_compile( const u8* pixels, u32 width, u32 height, u64 source_hash, const TextureCompileOptions& options,
+                      cstring path, Allocator* allocator, enki::TaskScheduler* task_scheduler ) {
+    const i64 begin_time = time_now();
+    const u32 mips_count = options.generate_mips ? texture_mip_count( width, height ) : 1;
+
+    sizet data_size = 0;
+    for ( u32 m = 0; m < mips_count; ++m ) {
+        data_size += texture_level_size( options.compression, max( width >> m, 1u ), max( height >> m, 1u ) );
+    }
+
+    BlobSerializer serializer;
+    const sizet blob_size = sizeof( TextureAssetBlob ) + sizeof( TextureMipBlob ) * mips_count + data_size;
+    TextureAssetBlob* blob = serializer.write_and_prepare<TextureAssetBlob>( allocator, k_texture_blob_version, blob_size );
+    memset( serializer.blob_memory + sizeof( BlobHeader ), 0, blob_size );
+
+    blob->source_hash = source_hash;
+    blob->width = width;
+    blob->height = height;
+    blob->compression = options.compression;
+    blob->srgb = options.srgb ? 1 : 0;
+    serializer.allocate_and_set( blob->mips, mips_count );
+    serializer.allocate_and_set( blob->data, ( u32 )data_size );
+
+    // Level 0 is compressed as is, the others from the chain of linear float levels.
+    const sizet pixel_count = sizet( width ) * height;
+    const sizet mip_pixel_count = sizet( max( width / 2, 1u ) ) * max( height / 2, 1u );
+    u8* level_pixels = ( u8* )allocator->allocate( pixel_count * 4 * 2, 16 );
+    RASSERT( level_pixels );
+    u8* decoded_pixels = level_pixels + pixel_count * 4;
+
+    f32* level = nullptr;
+    f32* next_level = nullptr;
+    f32* scratch = nullptr;
+    if ( mips_count > 1 ) {
+        level = ( f32* )allocator->allocate( sizeof( f32 ) * 4 * ( pixel_count + mip_pixel_count + sizet( max( width / 2, 1u ) ) * height ), 16 );
+        RASSERT( level );
+        next_level = level + pixel_count * 4;
+        scratch = next_level + mip_pixel_count * 4;
+        texture_to_linear( pixels, ( u32 )pixel_count, options.srgb, level );
+    }
+
+    u32 offset = 0;
+    u32 mip_width = width, mip_height = height;
+    for ( u32 m = 0; m < mips_count; ++m ) {
+        if ( m > 0 ) {
+            texture_downsample( level, mip_width, mip_height, options.mip_filter, scratch, next_level );
+            mip_width = max( mip_width / 2, 1u );
+            mip_height = max( mip_height / 2, 1u );
+
+            f32* swap = level;
+            level = next_level;
+            next_level = swap;
+            texture_from_linear( level, mip_width * mip_height, options.srgb, level_pixels );
+        }
+
+        TextureMipBlob& mip = blob->mips[ m ];
+        mip.width = mip_width;
+        mip.height = mip_height;
+        mip.offset = offset;
+        mip.size = ( u32 )texture_level_size( options.compression, mip_width, mip_height );
+        texture_compress( m == 0 ? pixels : level_pixels, mip_width, mip_height, options.compression, blob->data.get() + offset, task_scheduler );
+        offset += mip.size;
+    }
+
+    texture_decompress( blob->data.get(), width, height, options.compression, decoded_pixels );
+    // BC1 is opaque and BC5 has two channels: the PSNR covers what the format keeps.
+    const u32 psnr_channels = options.compression == TextureCompression_BC1 ? 3 : options.compression == TextureCompression_BC5 ? 2 : 4;
+    const f32 psnr = texture_psnr( pixels, decoded_pixels, width, height, psnr_channels );
+    rprint( "Texture %s: %ux%u, %u mips, %s, %zu -> %zu bytes, level 0 PSNR %.2f dB, %.1f ms\n", path, width, height, mips_count,
+            k_texture_compression_names[ options.compression ], pixel_count * 4, data_size, psnr, time_delta_milliseconds( begin_time, time_now() ) );
+
+    bool written = false;
+    FileHandle file;
+    file_open( path, "wb", &file );
+    if ( file ) {
+        written = file_write( ( u8* )serializer.blob_memory, 1, serializer.allocated_offset, file ) == serializer.allocated_offset;
+        file_close( file );
+    }
+
+    if ( !written ) {
+        rprint( "Error: cannot write compiled texture %s\n", path );
+    }
+
+    if ( level ) {
+        // The chain swaps its buffers, the allocation starts with the lowest one.
+        allocator->deallocate( min( level, next_level ) );
+    }
+    allocator->deallocate( level_pixels );
+    serializer.shutdown();
+
+    return written;
+}
+
+u64 texture_source_hash( const void* data, sizet size, const TextureCompileOptions& options ) {
+    const u64 options_key = u64( options.compression ) | ( u64( options.mip_filter ) << 8 ) | ( u64( options.srgb ) << 16 ) |
+                            ( u64( options.generate_mips ) << 17 ) | ( u64( k_texture_blob_version ) << 32 );
+    return hash_bytes( ( void* )data, size, options_key );
+}
+
+// Decodes an image file in memory with stb_image, then compiles it.
+static bool texture_compile_image( cstring source_path, const char* data, sizet size, u64 source_hash, const TextureCompileOptions& options,
+                                   cstring path, Allocator* allocator, enki::TaskScheduler* task_scheduler ) {
+    i32 width, height, components;
+    u8* pixels = stbi_load_from_memory( ( const stbi_uc* )data, ( i32 )size, &width, &height, &components, 4 );
+    if ( pixels == nullptr ) {
+        rprint( "Error: cannot decode texture %s: %s\n", source_path, stbi_failure_reason() );
+        return false;
+    }
+
+    const bool compiled = texture_compile( pixels, ( u32 )width, ( u32 )height, source_hash, options, path, allocator, task_scheduler );
+    stbi_image_free( pixels );
+    return compiled;
+}
+
+const TextureAssetBlob* texture_map( cstring path, FileMapping& out_mapping ) {
+    if ( !file_exists( path ) || !file_map_read_only( path, &out_mapping ) ) {
+        return nullptr;
+    }
+
+    const TextureAssetBlob* blob = ( const TextureAssetBlob* )out_mapping.data;
+    if ( out_mapping.size < sizeof( TextureAssetBlob ) || blob->header.version != k_texture_blob_version || !blob->header.mappable ) {
+        rprint( "Compiled texture %s is outdated, ignoring it\n", path );
+        file_unmap( &out_mapping );
+        return nullptr;
+    }
+
+    return blob;
+}
+
+// TextureResourceCompiler ////////////////////////////////////////////////
+
+void TextureResourceCompiler::init( const TextureCompileOptions& options_, Allocator* allocator_, enki::TaskScheduler* task_scheduler_ ) {
+    options = options_;
+    allocator = allocator_;
+    task_scheduler = task_scheduler_;
+    version = k_texture_blob_version;
+    extension = "texture";
+}
+
+u64 TextureResourceCompiler::hash_inputs( cstring source_path, u64 seed ) {
+    return texture_source_hash( &seed, sizeof( seed ), options );
+}
+
+bool TextureResourceCompiler::compile( cstring source_path, cstring output_path ) {
+    FileReadResult source = file_read_binary( source_path, allocator );
+    if ( source.data == nullptr ) {
+        return false;
+    }
+
+    const u64 source_hash = texture_source_hash( source.data, source.size, options );
+    const bool compiled = texture_compile_image( source_path, source.data, source.size, source_hash, options, output_path, allocator, task_scheduler );
+    allocator->deallocate( source.data );
+    return compiled;
+}
+
+const TextureAssetBlob* texture_map_cached( cstring source_path, ResourceManager& resource_manager, FileMapping& out_mapping ) {
+    const u64 texture_type_hash = hash_calculate( TextureResourceCompiler::k_type );
+    if ( !resource_manager.is_cached( texture_type_hash ) ) {
+        return nullptr;
+    }
+
+    char cached_path[ k_max_path ];
+    if ( !resource_manager.get_cached_path( texture_type_hash, source_path, cached_path, k_max_path ) ) {
+        return nullptr;
+    }
+    return texture_map( cached_path, out_mapping );
+}
+
+} // namespace syi
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "foundation/blob.hpp"
+#include "foundation/relative_data_structures.hpp"
+#include "foundation/resource_manager.hpp"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace syi {
+
+    struct Allocator;
+    struct FileMapping;
+
+    // Texture compression ////////////////////////////////////////////////
+    //
+    // Formats of the compiled textures, with the Vulkan format the upload uses:
+    //   None    - RGBA8, R8G8B8A8_UNORM or _SRGB.
+    //   BC1     - opaque colour, 8 bytes per 4x4 block, BC1_RGB_UNORM_BLOCK or _SRGB_BLOCK.
+    //   BC5     - two channels, normal maps, 16 bytes per block, BC5_UNORM_BLOCK.
+    //   BC7     - colour and alpha, 16 bytes per block, BC7_UNORM_BLOCK or _SRGB_BLOCK.
+    //             Only mode 6 (one subset, RGBA endpoints, 4 bits indices) is written.
+    enum TextureCompression {
+        TextureCompression_None = 0, TextureCompression_BC1, TextureCompression_BC5, TextureCompression_BC7, TextureCompression_Count
+    };
+
+    enum TextureMipFilter {
+        TextureMipFilter_Box = 0, TextureMipFilter_Kaiser, TextureMipFilter_Count
+    };
+
+    //
+    //
+    struct TextureCompileOptions {
+        TextureCompression          compression     = TextureCompression_BC7;
+        TextureMipFilter            mip_filter      = TextureMipFilter_Box;
+        bool                        srgb            = true;     // Mips are filtered in linear space, alpha is always linear.
+        bool                        generate_mips   = true;
+    }; // struct TextureCompileOptions
+
+    // Full chain down to 1x1.
+    u32                             texture_mip_count( u32 width, u32 height );
+    // Bytes of a level, whole blocks for the BC formats.
+    sizet                           texture_level_size( TextureCompression compression, u32 width, u32 height );
+
+    // Halves an image of linear RGBA floats, odd sizes rounding down. destination holds max( width / 2, 1 ) * max( height / 2, 1 ) pixels.
+    // The Kaiser filter needs a scratch of max( width / 2, 1 ) * height pixels, unused by the box filter.
+    void                            texture_downsample( const f32* source, u32 width, u32 height, TextureMipFilter filter, f32* scratch, f32* destination );
+
+    // Compresses RGBA8 pixels, in parallel over block rows when a task scheduler is given.
+    void                            texture_compress( const u8* pixels, u32 width, u32 height, TextureCompression compression, u8* destination,
+                                                      enki::TaskScheduler* task_scheduler );
+    // Decodes the blocks texture_compress writes into RGBA8 pixels, BC5 with blue 0 and alpha 255.
+    void                            texture_decompress( const u8* blocks, u32 width, u32 height, TextureCompression compression, u8* pixels );
+
+    // Peak signal to noise ratio in dB over the first channels of RGBA8 images, infinite if they are equal.
+    f32                             texture_psnr( const u8* a, const u8* b, u32 width, u32 height, u32 channels );
+
+    // Compiled textures //////////////////////////////////////////////////
+    //
+    // All the levels are contiguous in data, level 0 first, so that an upload is a single copy
+    // to the staging buffer followed by one buffer to image copy per level.
+    static const u32                k_texture_blob_version = 1;
+
+    struct TextureMipBlob {
+        u32                         width;
+        u32                         height;
+        u32                         offset;         // In data.
+        u32                         size;
+    };
+
+    //
+    //
+    struct TextureAssetBlob : public Blob {
+        u64                         source_hash;
+        u32                         width;
+        u32                         height;
+        u32                         compression;    // TextureCompression
+        u32                         srgb;
+        RelativeArray<TextureMipBlob> mips;
+        RelativeArray<u8>           data;
+    }; // struct TextureAssetBlob
+
+    // Compiles RGBA8 pixels into path, printing the size and the PSNR of level 0.
+    // Returns false if the file could not be written.
+    bool                            texture_compile( const u8* pixels, u32 width, u32 height, u64 source_hash, const TextureCompileOptions& options,
+                                                     cstring path, Allocator* allocator, enki::TaskScheduler* task_scheduler );
+
+    // Hash of a source image file content and the options, stored in the compiled texture.
+    u64                             texture_source_hash( const void* data, sizet size, const TextureCompileOptions& options );
+
+    // Maps a compiled texture, null if missing or from another version. Release with file_unmap.
+    const TextureAssetBlob*         texture_map( cstring path, FileMapping& out_mapping );
+
+    // TextureResourceCompiler ////////////////////////////////////////////
+    //
+    // Texture compilation behind the cache of the ResourceManager, the options being part of the key.
+    // Its outputs are mapped with texture_map_cached.
+    struct TextureResourceCompiler : public ResourceCompiler {
+
+        static constexpr cstring    k_type          = "syi_texture_blob_type";
+
+        void                        init( const TextureCompileOptions& options, Allocator* allocator, enki::TaskScheduler* task_scheduler );
+
+        u64                         hash_inputs( cstring source_path, u64 seed ) override;
+        bool                        compile( cstring source_path, cstring output_path ) override;
+
+        TextureCompileOptions       options;
+        Allocator*                  allocator       = nullptr;
+        enki::TaskScheduler*        task_scheduler  = nullptr;
+
+    }; // struct TextureResourceCompiler
+
+    // Maps the compiled texture of a source image from the cache of the resource manager, compiled first on a miss.
+    // Null if the manager has no cache or no TextureResourceCompiler, or if the image does not compile. Release with file_unmap.
+    const TextureAssetBlob*         texture_map_cached( cstring source_path, ResourceManager& resource_manager, FileMapping& out_mapping );
+
+} // namespace syi
@@ -0,0 +1,173 @@
+#include "vertex_quantization.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/assert.hpp"
+
+#include "external/meshoptimizer/meshoptimizer.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace syi {
+
+static const f32 k_unorm16_max = 65535.0f;
+
+// Vertex quantization ////////////////////////////////////////////////////
+
+u32 vertex_format_size( VertexStreamFormat format, u32 component_count ) {
+    switch ( format ) {
+        case VertexStreamFormat_Position16:
+            return sizeof( u16 ) * 4;
+        case VertexStreamFormat_Octahedral8:
+            return sizeof( i8 ) * 4;
+        case VertexStreamFormat_Half2:
+            return sizeof( u16 ) * 2;
+        default:
+            return sizeof( f32 ) * component_count;
+    }
+}
+
+void vertex_dequantization_init( VertexDequantization& dequantization, const f32 minimum[ 3 ], const f32 maximum[ 3 ] ) {
+    for ( u32 c = 0; c < 3; ++c ) {
+        dequantization.offset[ c ] = minimum[ c ];
+        // A flat axis keeps a non zero scale, all its vertices quantize to 0.
+        dequantization.scale[ c ] = maximum[ c ] > minimum[ c ] ? maximum[ c ] - minimum[ c ] : 1.0f;
+    }
+}
+
+static_assert( sizeof( GpuMeshDequantization ) == 32, "Must match the std140 layout of MeshDequantization" );
+
+void vertex_dequantization_to_gpu( const VertexDequantization& dequantization, GpuMeshDequantization& gpu_dequantization ) {
+    for ( u32 c = 0; c < 3; ++c ) {
+        gpu_dequantization.position_offset[ c ] = dequantization.offset[ c ];
+        gpu_dequantization.position_scale[ c ] = dequantization.scale[ c ];
+    }
+    gpu_dequantization.position_offset[ 3 ] = 0.0f;
+    gpu_dequantization.position_scale[ 3 ] = 0.0f;
+}
+
+void vertex_quantize_positions( const f32* positions, u32 vertex_count, const VertexDequantization& dequantization, u16* destination ) {
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            const f32 normalized = ( positions[ v * 3 + c ] - dequantization.offset[ c ] ) / dequantization.scale[ c ];
+            destination[ v * 4 + c ] = ( u16 )meshopt_quantizeUnorm( normalized, 16 );
+        }
+        destination[ v * 4 + 3 ] = 0;
+    }
+}
+
+void vertex_quantize_octahedral( const f32* vectors, u32 vertex_count, u32 component_count, Allocator* allocator, i8* destination ) {
+    RASSERT( component_count == 3 || component_count == 4 );
+
+    if ( component_count == 4 ) {
+        meshopt_encodeFilterOct( destination, vertex_count, sizeof( i8 ) * 4, 8, vectors );
+        return;
+    }
+
+    // The filter reads 4 floats per vector.
+    f32* vectors4 = ( f32* )allocator->allocate( sizeof( f32 ) * 4 * vertex_count, 16 );
+    RASSERT( vectors4 );
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        memcpy( vectors4 + v * 4, vectors + v * 3, sizeof( f32 ) * 3 );
+        vectors4[ v * 4 + 3 ] = 0.0f;
+    }
+
+    meshopt_encodeFilterOct( destination, vertex_count, sizeof( i8 ) * 4, 8, vectors4 );
+    allocator->deallocate( vectors4 );
+}
+
+void vertex_quantize_half2( const f32* values, u32 vertex_count, u16* destination ) {
+    for ( u32 i = 0; i < vertex_count * 2; ++i ) {
+        destination[ i ] = meshopt_quantizeHalf( values[ i ] );
+    }
+}
+
+void vertex_dequantize_positions( const u16* positions, u32 vertex_count, const VertexDequantization& dequantization, f32* destination ) {
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            destination[ v * 3 + c ] = dequantization.offset[ c ] + dequantization.scale[ c ] * ( positions[ v * 4 + c ] / k_unorm16_max );
+        }
+    }
+}
+
+void vertex_dequantize_octahedral( const i8* vectors, u32 vertex_count, u32 component_count, f32* destination ) {
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        const i8* encoded = vectors + v * 4;
+
+        // snorm8 then divided by the encoded one, as the shader does with the normalized format.
+        const f32 one = max( encoded[ 2 ] / 127.0f, 1.0f / 127.0f );
+        const f32 x = max( encoded[ 0 ] / 127.0f, -1.0f ) / one;
+        const f32 y = max( encoded[ 1 ] / 127.0f, -1.0f ) / one;
+        const f32 z = 1.0f - fabsf( x ) - fabsf( y );
+        const f32 t = max( -z, 0.0f );
+
+        f32 n[ 3 ] = { x + ( x >= 0.0f ? -t : t ), y + ( y >= 0.0f ? -t : t ), z };
+        const f32 length = sqrtf( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+
+        f32* decoded = destination + v * component_count;
+        for ( u32 c = 0; c < 3; ++c ) {
+            decoded[ c ] = n[ c ] / length;
+        }
+        if ( component_count == 4 ) {
+            decoded[ 3 ] = max( encoded[ 3 ] / 127.0f, -1.0f );
+        }
+    }
+}
+
+static f32 half_to_float( u16 value ) {
+    const u32 sign = ( value & 0x8000u ) << 16;
+    const u32 exponent = ( value >> 10 ) & 0x1f;
+    const u32 mantissa = value & 0x3ff;
+
+    f32 magnitude;
+    if ( exponent == 0 ) {
+        magnitude = ldexpf( ( f32 )mantissa, -24 );
+    } else if ( exponent == 31 ) {
+        magnitude = mantissa ? NAN : INFINITY;
+    } else {
+        magnitude = ldexpf( ( f32 )( mantissa | 0x400 ), ( i32 )exponent - 25 );
+    }
+
+    u32 bits;
+    memcpy( &bits, &magnitude, sizeof( bits ) );
+    bits |= sign;
+    f32 result;
+    memcpy( &result, &bits, sizeof( result ) );
+    return result;
+}
+
+void vertex_dequantize_half2( const u16* values, u32 vertex_count, f32* destination ) {
+    for ( u32 i = 0; i < vertex_count * 2; ++i ) {
+        destination[ i ] = half_to_float( values[ i ] );
+    }
+}
+
+f32 vertex_quantization_error( VertexStreamFormat format, const f32* source, const f32* decoded, u32 vertex_count, u32 component_count ) {
+    f32 error = 0.0f;
+
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        const f32* a = source + v * component_count;
+        const f32* b = decoded + v * component_count;
+
+        if ( format == VertexStreamFormat_Octahedral8 ) {
+            const f32 length = sqrtf( a[ 0 ] * a[ 0 ] + a[ 1 ] * a[ 1 ] + a[ 2 ] * a[ 2 ] );
+            if ( length == 0.0f ) {
+                continue;
+            }
+            const f32 cosine = ( a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ] ) / length;
+            error = max( error, acosf( clamp( cosine, -1.0f, 1.0f ) ) * 57.2957795f );
+        } else if ( format == VertexStreamFormat_Position16 ) {
+            const f32 x = a[ 0 ] - b[ 0 ], y = a[ 1 ] - b[ 1 ], z = a[ 2 ] - b[ 2 ];
+            error = max( error, sqrtf( x * x + y * y + z * z ) );
+        } else {
+            for ( u32 c = 0; c < component_count; ++c ) {
+                error = max( error, fabsf( a[ c ] - b[ c ] ) );
+            }
+        }
+    }
+
+    return error;
+}
+
+} // namespace syi
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+namespace syi {
+
+    struct Allocator;
+
+    // Vertex quantization ////////////////////////////////////////////////
+    //
+    // Packed formats of the vertex streams, with the Vulkan format the vertex input uses:
+    //   Float         - component_count floats.
+    //   Position16    - xyz unorm16 and a zero pad, R16G16B16A16_UNORM, position = offset + scale * xyz.
+    //   Octahedral8   - unit vector on an octahedron, snorm8 uv, the uv scale and w, R8G8B8A8_SNORM.
+    //   Half2         - 2 half floats, R16G16_SFLOAT.
+    enum VertexStreamFormat {
+        VertexStreamFormat_Float = 0, VertexStreamFormat_Position16, VertexStreamFormat_Octahedral8, VertexStreamFormat_Half2, VertexStreamFormat_Count
+    };
+
+    // Bytes per vertex.
+    u32                             vertex_format_size( VertexStreamFormat format, u32 component_count );
+
+    //
+    // Positions are quantized on the bounding box of a whole mesh, so that its primitives share the grid.
+    struct VertexDequantization {
+        f32                         offset[ 3 ];
+        f32                         scale[ 3 ];
+    }; // struct VertexDequantization
+
+    void                            vertex_dequantization_init( VertexDequantization& dequantization, const f32 minimum[ 3 ], const f32 maximum[ 3 ] );
+
+    //
+    // MeshDequantization uniform of the quantized pipelines, std140, w unused.
+    struct GpuMeshDequantization {
+        f32                         position_offset[ 4 ];
+        f32                         position_scale[ 4 ];
+    }; // struct GpuMeshDequantization
+
+    void                            vertex_dequantization_to_gpu( const VertexDequantization& dequantization, GpuMeshDequantization& gpu_dequantization );
+
+    void                            vertex_quantize_positions( const f32* positions, u32 vertex_count, const VertexDequantization& dequantization, u16* destination );
+    // component_count is 3 for normals, or 4 for tangents whose handedness w is kept.
+    void                            vertex_quantize_octahedral( const f32* vectors, u32 vertex_count, u32 component_count, Allocator* allocator, i8* destination );
+    void                            vertex_quantize_half2( const f32* values, u32 vertex_count, u16* destination );
+
+    // Decoding, as in the shaders. Outputs 3 floats per position, component_count floats per vector and 2 per half2.
+    void                            vertex_dequantize_positions( const u16* positions, u32 vertex_count, const VertexDequantization& dequantization, f32* destination );
+    void                            vertex_dequantize_octahedral( const i8* vectors, u32 vertex_count, u32 component_count, f32* destination );
+    void                            vertex_dequantize_half2( const u16* values, u32 vertex_count, f32* destination );
+
+    // Largest difference between the source and the decoded stream: distance for positions,
+    // angle in degrees for octahedral vectors, absolute difference for anything else.
+    f32                             vertex_quantization_error( VertexStreamFormat format, const f32* source, const f32* decoded, u32 vertex_count, u32 component_count );
+
+} // namespace syi
@@ -0,0 +1,99 @@
+#include "test.hpp"
+
+#include "foundation/concurrent_hash_map.hpp"
+
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace syi;
+
+static const u64 k_key_count = 100000;
+static const u64 k_operation_count = 2000000;     // Per thread.
+static const u32 k_write_period = 100;             // One insert_or_assign every 100 operations.
+static const u32 k_thread_counts[] = { 1, 2, 4, 8 };
+
+// The same read-heavy workload on each map: lookups of present keys, with a few assignments.
+struct ConcurrentMap {
+    ConcurrentFlatHashMap<u64, u64> map;
+
+    u64                             find( u64 key )                 { return map.get( key ); }
+    void                            assign( u64 key, u64 value )    { map.insert_or_assign( key, value ); }
+}; // struct ConcurrentMap
+
+struct LockedFlatMap {
+    FlatHashMap<u64, u64>           map;
+    std::mutex                      mutex;
+
+    u64                             find( u64 key )                 { std::lock_guard<std::mutex> guard( mutex ); return map.get( key ); }
+    void                            assign( u64 key, u64 value )    { std::lock_guard<std::mutex> guard( mutex ); map.insert( key, value ); }
+}; // struct LockedFlatMap
+
+struct LockedStdMap {
+    std::unordered_map<u64, u64>    map;
+    std::mutex                      mutex;
+
+    u64                             find( u64 key )                 { std::lock_guard<std::mutex> guard( mutex ); return map.find( key )->second; }
+    void                            assign( u64 key, u64 value )    { std::lock_guard<std::mutex> guard( mutex ); map[ key ] = value; }
+}; // struct LockedStdMap
+
+template <typename Map>
+static void run_operations( Map* map, u32 thread_index, u64* out_checksum ) {
+    u64 key = thread_index * 7919, checksum = 0;
+    for ( u64 i = 0; i < k_operation_count; ++i ) {
+        key = ( key + 104729 ) % k_key_count;
+        if ( i % k_write_period == 0 ) {
+            map->assign( key, key + i );
+        } else {
+            checksum += map->find( key );
+        }
+    }
+    *out_checksum = checksum;
+}
+
+// Milliseconds for all the threads to finish their operations.
+template <typename Map>
+static f64 run_threads( Map* map, u32 thread_count ) {
+    std::vector<std::thread> threads;
+    std::vector<u64> checksums( thread_count, 0 );
+    const i64 start = time_now();
+    for ( u32 t = 0; t < thread_count; ++t ) {
+        threads.emplace_back( run_operations<Map>, map, t, &checksums[ t ] );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    return time_from_milliseconds( start );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    ConcurrentMap concurrent;
+    concurrent.map.init( allocator, k_key_count * 2 );
+    LockedFlatMap flat;
+    flat.map.init( allocator, k_key_count * 2 );
+    LockedStdMap standard;
+    standard.map.reserve( k_key_count * 2 );
+    for ( u64 key = 0; key < k_key_count; ++key ) {
+        concurrent.map.insert( key, key );
+        flat.map.insert( key, key );
+        standard.map[ key ] = key;
+    }
+
+    for ( u32 thread_count : k_thread_counts ) {
+        const f64 concurrent_time = run_threads( &concurrent, thread_count );
+        // Tables replaced by assignments are freed between runs, where no lookup is in flight.
+        concurrent.map.reclaim_retired_tables();
+        const f64 flat_time = run_threads( &flat, thread_count );
+        const f64 standard_time = run_threads( &standard, thread_count );
+
+        rprint( "%u threads, %llu operations each: concurrent %.2f ms, locked FlatHashMap %.2f ms, locked std::unordered_map %.2f ms\n",
+                thread_count, k_operation_count, concurrent_time, flat_time, standard_time );
+    }
+
+    concurrent.map.shutdown();
+    flat.map.shutdown();
+    return test_shutdown();
+}
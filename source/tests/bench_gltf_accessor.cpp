@@ -0,0 +1,55 @@
+#include "test.hpp"
+
+#include "foundation/gltf_accessor.hpp"
+
+#include <string.h>
+
+using namespace syi;
+
+static const u32 k_element_count = 16 * 1024 * 1024;
+static const u32 k_repeat_count = 3;
+
+// Conversion kernels against the plain loops the compiler vectorizes on its own.
+int main() {
+    Allocator* allocator = test_init( rmega( 512 ) );
+
+    u8* source = ( u8* )allocator->allocate( k_element_count * sizeof( u16 ), 64 );
+    f32* floats = ( f32* )allocator->allocate( k_element_count * sizeof( f32 ), 64 );
+    u32* integers = ( u32* )allocator->allocate( k_element_count * sizeof( u32 ), 64 );
+    for ( u32 i = 0; i < k_element_count * 2; ++i ) {
+        source[ i ] = ( u8 )( i * 31 );
+    }
+    // Pages touched once before timing.
+    memset( floats, 0, k_element_count * sizeof( f32 ) );
+    memset( integers, 0, k_element_count * sizeof( u32 ) );
+
+    for ( u32 r = 0; r < k_repeat_count; ++r ) {
+        i64 start = time_now();
+        convert_unorm8_to_f32( source, floats, k_element_count );
+        const f64 unorm8_kernel = time_from_milliseconds( start );
+
+        start = time_now();
+        for ( u32 i = 0; i < k_element_count; ++i ) {
+            floats[ i ] = source[ i ] * ( 1.0f / 255.0f );
+        }
+        const f64 unorm8_loop = time_from_milliseconds( start );
+
+        start = time_now();
+        convert_u16_to_u32( ( const u16* )source, integers, k_element_count );
+        const f64 u16_kernel = time_from_milliseconds( start );
+
+        start = time_now();
+        for ( u32 i = 0; i < k_element_count; ++i ) {
+            integers[ i ] = ( ( const u16* )source )[ i ];
+        }
+        const f64 u16_loop = time_from_milliseconds( start );
+
+        rprint( "%u elements: unorm8 to f32 kernel %.2f ms, loop %.2f ms; u16 to u32 kernel %.2f ms, loop %.2f ms (%g)\n", k_element_count,
+                unorm8_kernel, unorm8_loop, u16_kernel, u16_loop, floats[ r + 1 ] + integers[ r + 1 ] );
+    }
+
+    allocator->deallocate( integers );
+    allocator->deallocate( floats );
+    allocator->deallocate( source );
+    return test_shutdown();
+}
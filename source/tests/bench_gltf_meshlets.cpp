@@ -0,0 +1,87 @@
+#include "test.hpp"
+#include "test_gltf_meshes.hpp"
+
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/file.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/cglm.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_meshes_path = "bench_gltf_meshlets.meshes";
+static const u32 k_primitive_count = 64;   // Spheres of 131k triangles, ~91k meshlets.
+static const u32 k_repeat_count = 100;
+
+// meshlet_cull, four meshlets per SSE2 register, against one at a time and with tasks.
+int main() {
+    Allocator* allocator = test_init( rmega( 1024 ) );
+
+    TestSphere sphere;
+    sphere.init( 256, 256, k_primitive_count );
+    MeshOptimizerOptions options;
+    options.lod.max_lods = 1;
+    const i64 compile_start = time_now();
+    TEST_CHECK( gltf_compile_meshes( sphere.gltf, sphere.buffers_data, k_meshes_path, options ) );
+    rprint( "%u primitives compiled in %.0f ms\n", k_primitive_count, time_from_milliseconds( compile_start ) );
+
+    FileMapping mapping;
+    const glTF::MeshAssetBlob* meshes = gltf_map_meshes( k_meshes_path, mapping );
+    TEST_CHECK( meshes != nullptr );
+    if ( meshes == nullptr ) {
+        return test_shutdown();
+    }
+
+    MeshletScene scene;
+    scene.init( *meshes, allocator );
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize();
+
+    std::vector<u32> visible( scene.meshlets_count ), expected( scene.meshlets_count );
+    for ( f32 distance : { 3.0f, 6.0f, 12.0f } ) {
+        mat4 projection, view;
+        mat4s clip_from_object;
+        vec3 eye = { 0.1f * distance, 0.0f, distance }, center = { 0.0f, 0.0f, 0.0f }, up = { 0.0f, 1.0f, 0.0f };
+        glm_perspective( glm_rad( 60.0f ), 1.6f, 0.1f, 100.0f, projection );
+        glm_lookat( eye, center, up, view );
+        glm_mat4_mul( projection, view, clip_from_object.raw );
+        MeshletCullParameters parameters;
+        meshlet_cull_parameters( clip_from_object, { eye[ 0 ], eye[ 1 ], eye[ 2 ] }, parameters );
+
+        i64 start = time_now();
+        u32 expected_count = 0;
+        for ( u32 r = 0; r < k_repeat_count; ++r ) {
+            expected_count = test_cull_meshlets( scene, parameters, expected.data() );
+        }
+        const f64 scalar_time = time_from_milliseconds( start ) / k_repeat_count;
+
+        start = time_now();
+        u32 visible_count = 0;
+        for ( u32 r = 0; r < k_repeat_count; ++r ) {
+            visible_count = meshlet_cull( scene, parameters, 0, scene.meshlets_count, visible.data() );
+        }
+        const f64 cull_time = time_from_milliseconds( start ) / k_repeat_count;
+        TEST_CHECK( visible_count == expected_count && memcmp( visible.data(), expected.data(), visible_count * sizeof( u32 ) ) == 0 );
+
+        start = time_now();
+        for ( u32 r = 0; r < k_repeat_count; ++r ) {
+            visible_count = meshlet_cull( scene, parameters, 0, scene.meshlets_count, visible.data(), &task_scheduler );
+        }
+        const f64 tasked_time = time_from_milliseconds( start ) / k_repeat_count;
+        TEST_CHECK( visible_count == expected_count && memcmp( visible.data(), expected.data(), visible_count * sizeof( u32 ) ) == 0 );
+
+        rprint( "Distance %g: %u of %u meshlets visible, scalar %.3f ms, SSE2 %.3f ms (%.0f M meshlets/s), %u threads %.3f ms\n", distance, visible_count,
+                scene.meshlets_count, scalar_time, cull_time, scene.meshlets_count / cull_time / 1000.0, task_scheduler.GetNumTaskThreads(), tasked_time );
+    }
+
+    scene.shutdown();
+    file_unmap( &mapping );
+    file_delete( k_meshes_path );
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,3 @@
+// The renderer implements stb_image for the engine, the tests link the texture compiler without it.
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb_image.h"
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "foundation/memory.hpp"
+#include "foundation/log.hpp"
+#include "foundation/time.hpp"
+
+// Tests //////////////////////////////////////////////////////////////////
+//
+// Each test is an executable run by CTest. A failed check prints its expression and
+// the test returns 1 once shut down, after running the remaining checks.
+namespace syi {
+
+    inline u32                      test_failures   = 0;
+
+    // Memory and time services, with a thread safe heap for the tests that run tasks.
+    inline Allocator* test_init( sizet heap_size = rmega( 256 ) ) {
+        MemoryServiceConfiguration memory_configuration;
+        memory_configuration.maximum_dynamic_size = heap_size;
+        memory_configuration.thread_safe_heap = true;
+
+        MemoryService::instance()->init( &memory_configuration );
+        time_service_init();
+        return &MemoryService::instance()->system_allocator;
+    }
+
+    inline int test_shutdown() {
+        MemoryService::instance()->shutdown();
+
+        if ( test_failures ) {
+            rprint( "%u checks failed\n", test_failures );
+        }
+        return test_failures ? 1 : 0;
+    }
+
+} // namespace syi
+
+#define TEST_CHECK( condition ) \
+    do { \
+        if ( !( condition ) ) { \
+            rprint( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition ); \
+            ++syi::test_failures; \
+        } \
+    } while ( 0 )
@@ -0,0 +1,88 @@
+#include "test.hpp"
+
+#include "foundation/array.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace syi;
+
+static i32 s_live_objects = 0;
+
+// Not trivially copyable: constructors and destructors have to run, the string has to move.
+struct TestObject {
+    TestObject() : text( "x" )                          { ++s_live_objects; }
+    TestObject( const char* text_ ) : text( text_ )     { ++s_live_objects; }
+    TestObject( const TestObject& other ) : text( other.text ) { ++s_live_objects; }
+    TestObject( TestObject&& other ) : text( std::move( other.text ) ) { ++s_live_objects; }
+    TestObject& operator=( TestObject&& other ) = default;
+    TestObject& operator=( const TestObject& other ) = default;
+    ~TestObject()                                       { --s_live_objects; }
+
+    std::string                     text;
+}; // struct TestObject
+
+static const u32 k_push_count = 10000000;
+
+int main() {
+    Allocator* allocator = test_init();
+
+    Array<TestObject> objects;
+    objects.init( allocator, 2 );
+    for ( u32 i = 0; i < 1000; ++i ) {
+        objects.push( TestObject( std::to_string( i ).c_str() ) );
+    }
+    objects.emplace( "emplaced" );
+    // The element is copied before the storage grows.
+    objects.push( objects[ 0 ] );
+    TEST_CHECK( objects.size == 1002 && objects[ 1001 ].text == "0" && objects[ 1000 ].text == "emplaced" );
+
+    objects.delete_swap( 3 );
+    TEST_CHECK( objects[ 3 ].text == "0" );
+    objects.pop();
+    objects.set_size( 2000 );
+    TEST_CHECK( objects[ 1999 ].text == "x" );
+    TEST_CHECK( s_live_objects == 2000 );
+    objects.shutdown();
+    TEST_CHECK( s_live_objects == 0 );
+
+    // Geometric growth: a handful of moves for many pushes.
+    Array<u32> values;
+    values.init( allocator, 0 );
+    u32* previous_data = nullptr;
+    u32 moves = 0;
+    for ( u32 i = 0; i < 100000; ++i ) {
+        values.push( i );
+        moves += values.data != previous_data;
+        previous_data = values.data;
+    }
+    bool in_order = true;
+    for ( u32 i = 0; i < 100000; ++i ) {
+        in_order &= values[ i ] == i;
+    }
+    TEST_CHECK( in_order );
+    TEST_CHECK( moves <= 20 );
+
+    values.reserve_exact( 200001 );
+    TEST_CHECK( values.capacity == 200001 );
+    values.shutdown();
+
+    // Pushes against std::vector, both starting empty.
+    i64 start = time_now();
+    values.init( allocator, 0 );
+    for ( u32 i = 0; i < k_push_count; ++i ) {
+        values.push( i );
+    }
+    const f64 array_time = time_from_milliseconds( start );
+    values.shutdown();
+
+    start = time_now();
+    std::vector<u32> vector;
+    for ( u32 i = 0; i < k_push_count; ++i ) {
+        vector.push_back( i );
+    }
+    const f64 vector_time = time_from_milliseconds( start );
+    rprint( "%u pushes: Array %.2f ms, std::vector %.2f ms\n", k_push_count, array_time, vector_time );
+
+    return test_shutdown();
+}
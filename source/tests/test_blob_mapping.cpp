@@ -0,0 +1,91 @@
+#include "test.hpp"
+
+#include "foundation/blob_serialization.hpp"
+#include "foundation/file.hpp"
+
+#include <string.h>
+
+using namespace syi;
+
+struct TestBlob : public Blob {
+    RelativeArray<u32>              values;
+    RelativeString                  name;
+}; // struct TestBlob
+
+// Arrays point to absolute memory, so their blobs can't be mapped.
+struct TestArrayBlob : public Blob {
+    Array<u32>                      values;
+}; // struct TestArrayBlob
+
+namespace syi {
+
+template<>
+void BlobSerializer::serialize( TestBlob* data ) {
+    serialize( &data->values );
+    serialize( &data->name );
+}
+
+template<>
+void BlobSerializer::serialize( TestArrayBlob* data ) {
+    serialize( &data->values );
+}
+
+} // namespace syi
+
+static cstring k_blob_path = "test_blob_mapping.bin";
+static const u32 k_value_count = 1000000;
+
+static bool check_values( const TestBlob* blob ) {
+    bool equal = blob->values.size == k_value_count;
+    for ( u32 i = 0; i < k_value_count && equal; ++i ) {
+        equal = blob->values[ i ] == i * 7;
+    }
+    return equal;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    BlobSerializer writer;
+    TestBlob* written = writer.write_and_prepare<TestBlob>( allocator, 1, sizeof( TestBlob ) + k_value_count * sizeof( u32 ) + 64 );
+    writer.allocate_and_set( written->values, k_value_count );
+    for ( u32 i = 0; i < k_value_count; ++i ) {
+        written->values[ i ] = i * 7;
+    }
+    writer.allocate_and_set( written->name, "%s %u", "blob", 5u );
+    TEST_CHECK( written->header.mappable );
+    file_write_binary( k_blob_path, writer.blob_memory, writer.allocated_offset );
+    writer.shutdown();
+
+    // Same version: used in place, inside the mapping.
+    i64 start = time_now();
+    BlobSerializer reader;
+    TestBlob* mapped = reader.read_mapped<TestBlob>( allocator, 1, k_blob_path );
+    const f64 mapped_time = time_from_milliseconds( start );
+    TEST_CHECK( mapped && ( char* )mapped == reader.mapping.data );
+    TEST_CHECK( check_values( mapped ) && strcmp( mapped->name.c_str(), "blob 5" ) == 0 );
+    reader.shutdown();
+
+    // Another version: serialized into allocator memory, the file is unmapped right away.
+    start = time_now();
+    TestBlob* serialized = reader.read_mapped<TestBlob>( allocator, 2, k_blob_path );
+    const f64 serialized_time = time_from_milliseconds( start );
+    TEST_CHECK( serialized && reader.mapping.data == nullptr );
+    TEST_CHECK( check_values( serialized ) );
+    reader.shutdown();
+    rfree( serialized, allocator );
+
+    rprint( "Blob of %u values: mapped %.3f ms, serialized %.3f ms\n", k_value_count, mapped_time, serialized_time );
+
+    Array<u32> values;
+    values.init( allocator, 10, 10 );
+    TestArrayBlob source;
+    source.values = values;
+    writer.write_and_serialize<TestArrayBlob>( allocator, 1, 1024, &source );
+    TEST_CHECK( ( ( BlobHeader* )writer.blob_memory )->mappable == 0 );
+    writer.shutdown();
+    values.shutdown();
+
+    file_delete( k_blob_path );
+    return test_shutdown();
+}
@@ -0,0 +1,119 @@
+#include "test.hpp"
+
+#include "foundation/concurrent_hash_map.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace syi;
+
+static const u64 k_stable_key_count = 4096;
+static const u64 k_writer_key_count = 50000;
+static const u32 k_writer_count = 4;
+static const u32 k_reader_count = 4;
+
+// The key is kept in the value, with a generation in the low byte: a torn entry shows up as a mismatch.
+static u64 make_value( u64 key, u64 generation ) {
+    return ( key << 8 ) | generation;
+}
+
+// Each writer owns a key range: inserts it, assigns a new generation to every key, then removes the odd ones.
+static void write_range( ConcurrentFlatHashMap<u64, u64>* map, u64 first_key, std::atomic<u32>* failures ) {
+    for ( u64 key = first_key; key < first_key + k_writer_key_count; ++key ) {
+        failures->fetch_add( map->insert( key, make_value( key, 0 ) ) ? 0 : 1 );
+    }
+    for ( u64 key = first_key; key < first_key + k_writer_key_count; ++key ) {
+        failures->fetch_add( map->insert_or_assign( key, make_value( key, 1 ) ) ? 1 : 0 );
+    }
+    for ( u64 key = first_key + 1; key < first_key + k_writer_key_count; key += 2 ) {
+        failures->fetch_add( map->remove( key ) == 1 ? 0 : 1 );
+    }
+}
+
+// Stable keys must be found through every rehash, the others are either missing or whole.
+static void read_keys( const ConcurrentFlatHashMap<u64, u64>* map, const std::atomic<bool>* writing, std::atomic<u32>* failures, std::atomic<u64>* lookups ) {
+    const u64 key_count = k_stable_key_count + k_writer_count * k_writer_key_count;
+    u64 key = 0, done = 0;
+    while ( writing->load( std::memory_order_relaxed ) ) {
+        for ( u32 i = 0; i < 1024; ++i, ++done ) {
+            key = ( key + 7919 ) % key_count;
+            u64 value = 0;
+            const bool found = map->find( key, value );
+            if ( key < k_stable_key_count ? !found || value != make_value( key, 0 ) : found && ( value >> 8 ) != key ) {
+                failures->fetch_add( 1 );
+            }
+        }
+    }
+    lookups->fetch_add( done );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    ConcurrentFlatHashMap<u64, u64> map;
+    map.init( allocator, 16 );
+    map.set_default_value( u64_max );
+
+    // Single thread semantics.
+    TEST_CHECK( map.insert( 1, 10 ) && !map.insert( 1, 11 ) && map.get( 1 ) == 10 );
+    TEST_CHECK( !map.insert_or_assign( 1, 12 ) && map.get( 1 ) == 12 );
+    TEST_CHECK( map.insert_or_assign( 2, 20 ) && map.get_size() == 2 );
+    TEST_CHECK( map.remove( 1 ) == 1 && map.remove( 1 ) == 0 && map.get( 1 ) == u64_max && map.get_size() == 1 );
+
+    u64 visited = 0;
+    map.for_each( [ &visited ]( const u64& key, const u64& value ) { visited += key == 2 && value == 20 ? 1 : 0; } );
+    TEST_CHECK( visited == 1 );
+    map.remove( 2 );
+
+    // Writers on disjoint ranges rehash every shard many times, while readers probe without locks.
+    for ( u64 key = 0; key < k_stable_key_count; ++key ) {
+        map.insert( key, make_value( key, 0 ) );
+    }
+
+    std::atomic<bool> writing{ true };
+    std::atomic<u32> write_failures{ 0 }, read_failures{ 0 };
+    std::atomic<u64> lookups{ 0 };
+    std::vector<std::thread> readers, writers;
+    for ( u32 r = 0; r < k_reader_count; ++r ) {
+        readers.emplace_back( read_keys, &map, &writing, &read_failures, &lookups );
+    }
+    const i64 start = time_now();
+    for ( u32 w = 0; w < k_writer_count; ++w ) {
+        writers.emplace_back( write_range, &map, k_stable_key_count + w * k_writer_key_count, &write_failures );
+    }
+    for ( std::thread& writer : writers ) {
+        writer.join();
+    }
+    const f64 write_time = time_from_milliseconds( start );
+    writing.store( false );
+    for ( std::thread& reader : readers ) {
+        reader.join();
+    }
+    rprint( "%u writers, %u readers: %.2f ms, %llu lookups\n", k_writer_count, k_reader_count, write_time, lookups.load() );
+    TEST_CHECK( write_failures.load() == 0 && read_failures.load() == 0 );
+
+    const u64 writer_keys = k_writer_count * k_writer_key_count;
+    TEST_CHECK( map.get_size() == k_stable_key_count + writer_keys / 2 );
+    u32 wrong = 0;
+    for ( u64 key = k_stable_key_count; key < k_stable_key_count + writer_keys; ++key ) {
+        const u64 value = map.get( key );
+        wrong += ( key - k_stable_key_count ) & 1 ? value != u64_max : value != make_value( key, 1 );
+    }
+    TEST_CHECK( wrong == 0 );
+
+    // The replaced tables stay readable until reclaimed, then the current ones keep working.
+    u32 retired_shards = 0;
+    for ( u32 s = 0; s < k_concurrent_hash_map_shard_count; ++s ) {
+        retired_shards += map.shards[ s ].retired ? 1 : 0;
+    }
+    TEST_CHECK( retired_shards == k_concurrent_hash_map_shard_count );
+    map.reclaim_retired_tables();
+    for ( u32 s = 0; s < k_concurrent_hash_map_shard_count; ++s ) {
+        TEST_CHECK( map.shards[ s ].retired == nullptr );
+    }
+    TEST_CHECK( map.get( 0 ) == make_value( 0, 0 ) && map.get( k_stable_key_count ) == make_value( k_stable_key_count, 1 ) );
+
+    map.shutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,58 @@
+#include "test.hpp"
+
+#include "foundation/frame_arena.hpp"
+
+#include <string.h>
+
+using namespace syi;
+
+static const u32 k_threads = 4;
+static const u32 k_frames_in_flight = 3;
+
+int main() {
+    test_init();
+
+    FrameArenaServiceConfiguration configuration;
+    configuration.thread_count = k_threads;
+    configuration.frames_in_flight = k_frames_in_flight;
+    configuration.arena_size = rkilo( 64 );
+
+    FrameArenaService* arenas = FrameArenaService::instance();
+    arenas->init( &configuration );
+
+    // Memory of a frame survives the frames in flight after it, then the arena restarts from its base.
+    arenas->new_frame( 0 );
+    u8* first = ( u8* )arenas->get_allocator( 0 )->allocate( 64, 16 );
+    memset( first, 0xab, 64 );
+    for ( u32 f = 1; f < k_frames_in_flight; ++f ) {
+        arenas->new_frame( f );
+        memset( arenas->get_allocator( 0 )->allocate( 64, 16 ), 0xcd, 64 );
+    }
+    TEST_CHECK( first[ 0 ] == 0xab && first[ 63 ] == 0xab );
+
+    arenas->new_frame( k_frames_in_flight );
+    TEST_CHECK( arenas->current_frame == 0 );
+    TEST_CHECK( arenas->get_allocator( 0 )->allocate( 16, 16 ) == first );
+
+    // Frame f % 3 allocates ( f % 3 + 1 ) * 64 * ( t + 1 ) bytes on thread t, sampled on reset.
+    // The 64 bytes above stay under these marks.
+    for ( u32 f = 0; f < 10; ++f ) {
+        arenas->new_frame( f );
+        for ( u32 t = 0; t < k_threads; ++t ) {
+            arenas->get_allocator( t )->allocate( 64 * ( t + 1 ) * ( f % k_frames_in_flight + 1 ), 16 );
+        }
+    }
+    for ( u32 f = 10; f < 10 + k_frames_in_flight; ++f ) {
+        arenas->new_frame( f );
+    }
+
+    for ( u32 t = 0; t < k_threads; ++t ) {
+        TEST_CHECK( arenas->get_thread_high_water_mark( t ) == 64 * ( t + 1 ) * k_frames_in_flight );
+    }
+    for ( u32 f = 0; f < k_frames_in_flight; ++f ) {
+        TEST_CHECK( arenas->get_frame_high_water_mark( f ) == 640 * ( f + 1 ) );
+    }
+
+    arenas->shutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,190 @@
+#include "test.hpp"
+
+#include "foundation/gltf_accessor.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+// Interleaved vertex: position f32x3, uv unorm16x2, colour unorm8x4.
+struct TestVertex {
+    f32                             position[ 3 ];
+    u16                             uv[ 2 ];
+    u8                              color[ 4 ];
+    u32                             padding;
+}; // struct TestVertex
+
+static const u32 k_vertex_count = 100;
+
+// Kernels against the glTF formulas, with counts around the SIMD widths, never writing past count.
+static void check_kernels() {
+    for ( u32 count : { 0u, 1u, 7u, 15u, 16u, 17u, 33u, 1000u } ) {
+        std::vector<u8> unorm8( count + 1 );
+        std::vector<u16> unorm16( count + 1 );
+        for ( u32 i = 0; i < count; ++i ) {
+            unorm8[ i ] = ( u8 )rand();
+            unorm16[ i ] = ( u16 )rand();
+        }
+
+        std::vector<f32> floats( count + 1, -1.0f );
+        std::vector<u32> integers( count + 1, 7 );
+        u32 differences = 0;
+
+        convert_unorm8_to_f32( unorm8.data(), floats.data(), count );
+        for ( u32 i = 0; i < count; ++i ) {
+            differences += floats[ i ] != unorm8[ i ] * ( 1.0f / 255.0f );
+        }
+        differences += floats[ count ] != -1.0f;
+
+        convert_unorm16_to_f32( unorm16.data(), floats.data(), count );
+        for ( u32 i = 0; i < count; ++i ) {
+            differences += floats[ i ] != unorm16[ i ] * ( 1.0f / 65535.0f );
+        }
+        differences += floats[ count ] != -1.0f;
+
+        convert_u8_to_u32( unorm8.data(), integers.data(), count );
+        for ( u32 i = 0; i < count; ++i ) {
+            differences += integers[ i ] != unorm8[ i ];
+        }
+        differences += integers[ count ] != 7;
+
+        convert_u16_to_u32( unorm16.data(), integers.data(), count );
+        for ( u32 i = 0; i < count; ++i ) {
+            differences += integers[ i ] != unorm16[ i ];
+        }
+        differences += integers[ count ] != 7;
+
+        TEST_CHECK( differences == 0 );
+    }
+}
+
+int main() {
+    test_init();
+
+    check_kernels();
+
+    TestVertex vertices[ k_vertex_count ];
+    u16 indices[ k_vertex_count ];
+    for ( u32 i = 0; i < k_vertex_count; ++i ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            vertices[ i ].position[ c ] = ( f32 )( i * 3 + c );
+        }
+        vertices[ i ].uv[ 0 ] = ( u16 )( i * 100 );
+        vertices[ i ].uv[ 1 ] = 65535;
+        for ( u32 c = 0; c < 4; ++c ) {
+            vertices[ i ].color[ c ] = ( u8 )( i + c );
+        }
+        indices[ i ] = ( u16 )( k_vertex_count - 1 - i );
+    }
+
+    std::vector<u8> buffer( sizeof( vertices ) + sizeof( indices ) );
+    memcpy( buffer.data(), vertices, sizeof( vertices ) );
+    memcpy( buffer.data() + sizeof( vertices ), indices, sizeof( indices ) );
+    u8* buffers_data[ 1 ] = { buffer.data() };
+
+    glTF::glTF gltf{ };
+    glTF::Buffer buffers[ 1 ]{ };
+    buffers[ 0 ].byte_length = ( i32 )buffer.size();
+    gltf.buffers = buffers;
+    gltf.buffers_count = 1;
+
+    glTF::BufferView views[ 2 ]{ };
+    views[ 0 ] = { 0, ( i32 )sizeof( vertices ), 0, ( i32 )sizeof( TestVertex ), glTF::INVALID_INT_VALUE };
+    views[ 1 ] = { 0, ( i32 )sizeof( indices ), ( i32 )sizeof( vertices ), glTF::INVALID_INT_VALUE, glTF::INVALID_INT_VALUE };
+    gltf.buffer_views = views;
+    gltf.buffer_views_count = 2;
+
+    glTF::Accessor accessors[ 4 ]{ };
+    accessors[ 0 ] = { 0, glTF::INVALID_INT_VALUE, glTF::Accessor::FLOAT, k_vertex_count };
+    accessors[ 0 ].type = glTF::Accessor::Vec3;
+    accessors[ 1 ] = { 0, 12, glTF::Accessor::UNSIGNED_SHORT, k_vertex_count };
+    accessors[ 1 ].type = glTF::Accessor::Vec2;
+    accessors[ 1 ].normalized = true;
+    accessors[ 2 ] = { 0, 16, glTF::Accessor::UNSIGNED_BYTE, k_vertex_count };
+    accessors[ 2 ].type = glTF::Accessor::Vec4;
+    accessors[ 2 ].normalized = true;
+    accessors[ 3 ] = { 1, glTF::INVALID_INT_VALUE, glTF::Accessor::UNSIGNED_SHORT, k_vertex_count };
+    accessors[ 3 ].type = glTF::Accessor::Scalar;
+    gltf.accessors = accessors;
+    gltf.accessors_count = 4;
+
+    AccessorView positions, uvs, colors, index_view, missing;
+    TEST_CHECK( positions.init( gltf, 0, buffers_data ) && uvs.init( gltf, 1, buffers_data ) && colors.init( gltf, 2, buffers_data ) );
+    TEST_CHECK( index_view.init( gltf, 3, buffers_data ) );
+    // No buffers and no .glb binary chunk.
+    TEST_CHECK( !missing.init( gltf, 3, nullptr ) );
+
+    // Every element, and every sparse index and value, has to be inside its buffer view.
+    glTF::Accessor range_accessors[ 4 ] = { accessors[ 0 ], accessors[ 0 ], accessors[ 0 ], accessors[ 3 ] };
+    range_accessors[ 0 ].count = 1000;
+    range_accessors[ 1 ].byte_offset = 16;     // The last position ends 4 bytes past the view.
+    range_accessors[ 2 ].byte_offset = -16;
+    glTF::AccessorSparse sparse{ 90, { 1, glTF::INVALID_INT_VALUE, glTF::Accessor::UNSIGNED_SHORT }, { 1, glTF::INVALID_INT_VALUE } };
+    range_accessors[ 3 ].sparse = &sparse;
+    gltf.accessors = range_accessors;
+
+    AccessorView out_of_range;
+    for ( i32 a = 0; a < 3; ++a ) {
+        TEST_CHECK( !out_of_range.init( gltf, a, buffers_data ) );
+    }
+    TEST_CHECK( out_of_range.init( gltf, 3, buffers_data ) && out_of_range.sparse_count == 90 );
+    sparse.count = 101;
+    TEST_CHECK( !out_of_range.init( gltf, 3, buffers_data ) );
+    sparse.count = 60;
+    sparse.values.byte_offset = 100;
+    TEST_CHECK( !out_of_range.init( gltf, 3, buffers_data ) );
+    sparse.values.byte_offset = 80;
+    TEST_CHECK( out_of_range.init( gltf, 3, buffers_data ) );
+
+    // The views themselves have to be inside the buffer.
+    views[ 1 ].byte_length += 2;
+    TEST_CHECK( !out_of_range.init( gltf, 3, buffers_data ) );
+    views[ 1 ].byte_length -= 2;
+    gltf.accessors = accessors;
+
+    f32 position_floats[ k_vertex_count * 3 ], uv_floats[ k_vertex_count * 2 ], color_floats[ k_vertex_count * 4 ];
+    u32 index_values[ k_vertex_count ];
+    positions.read_floats( position_floats );
+    uvs.read_floats( uv_floats );
+    colors.read_floats( color_floats );
+    index_view.read_indices( index_values );
+
+    u32 differences = 0;
+    for ( u32 i = 0; i < k_vertex_count; ++i ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            differences += position_floats[ i * 3 + c ] != i * 3 + c;
+        }
+        differences += uv_floats[ i * 2 ] != uvs.read_float( i, 0 ) || uv_floats[ i * 2 + 1 ] != 1.0f;
+        for ( u32 c = 0; c < 4; ++c ) {
+            differences += color_floats[ i * 4 + c ] != colors.read_float( i, c );
+        }
+        differences += index_values[ i ] != k_vertex_count - 1 - i;
+    }
+    TEST_CHECK( differences == 0 );
+
+    // Strided range over the interleaved positions.
+    struct Position {
+        f32                         x, y, z;
+    };
+    u32 visited = 0;
+    for ( const Position& position : positions.as<Position>() ) {
+        differences += position.y != visited * 3 + 1;
+        ++visited;
+    }
+    TEST_CHECK( visited == k_vertex_count && differences == 0 );
+
+    // Planar positions back into vertices, and interleaved vertices out to 16 byte elements.
+    TestVertex interleaved[ k_vertex_count ]{ };
+    interleave( ( const u8* )position_floats, ( u8* )interleaved, sizeof( TestVertex ), 12, k_vertex_count );
+    f32 planar[ k_vertex_count * 4 ];
+    deinterleave( ( const u8* )vertices, sizeof( TestVertex ), ( u8* )planar, 16, k_vertex_count );
+    for ( u32 i = 0; i < k_vertex_count; ++i ) {
+        differences += memcmp( interleaved[ i ].position, vertices[ i ].position, 12 ) != 0;
+        differences += memcmp( planar + i * 4, &vertices[ i ], 16 ) != 0;
+    }
+    TEST_CHECK( differences == 0 );
+
+    return test_shutdown();
+}
@@ -0,0 +1,324 @@
+#include "test.hpp"
+
+#include "foundation/gltf_animation.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static const u32 k_joint_count = 64;
+static const u32 k_key_count = 30;
+static const u32 k_instance_count = 1000;
+static const u32 k_frame_count = 20;
+
+// Keyframe values of a channel, to sample the reference from.
+struct TestTrack {
+    u32                             node;
+    u32                             target_type;
+    u32                             interpolation;
+    u32                             component_count;
+    const f32*                      values;
+}; // struct TestTrack
+
+// Float buffer, with a buffer view and an accessor per stream.
+struct TestAnimation {
+    std::vector<f32>                buffer;
+    std::vector<glTF::BufferView>   buffer_views;
+    std::vector<glTF::Accessor>     accessors;
+    u32                             used            = 0;
+
+    f32* add( u32 count, glTF::Accessor::Type type, u32 component_count, i32& out_accessor ) {
+        glTF::BufferView view{ };
+        view.buffer = 0;
+        view.byte_offset = used * sizeof( f32 );
+        view.byte_length = count * component_count * sizeof( f32 );
+        view.byte_stride = glTF::INVALID_INT_VALUE;
+        buffer_views.push_back( view );
+
+        glTF::Accessor accessor{ };
+        accessor.buffer_view = ( i32 )buffer_views.size() - 1;
+        accessor.byte_offset = glTF::INVALID_INT_VALUE;
+        accessor.component_type = glTF::Accessor::FLOAT;
+        accessor.type = type;
+        accessor.count = count;
+        accessors.push_back( accessor );
+        out_accessor = ( i32 )accessors.size() - 1;
+
+        f32* values = buffer.data() + used;
+        used += count * component_count;
+        return values;
+    }
+}; // struct TestAnimation
+
+static f32 random_float() {
+    return rand() / ( f32 )RAND_MAX * 2.0f - 1.0f;
+}
+
+static void normalize_quaternion( f32* q ) {
+    const f32 length = sqrtf( q[ 0 ] * q[ 0 ] + q[ 1 ] * q[ 1 ] + q[ 2 ] * q[ 2 ] + q[ 3 ] * q[ 3 ] );
+    for ( u32 c = 0; c < 4; ++c ) {
+        q[ c ] /= length;
+    }
+}
+
+static void slerp( const f32* a, const f32* b, f32 t, f32* result ) {
+    f64 d = 0.0;
+    for ( u32 c = 0; c < 4; ++c ) {
+        d += a[ c ] * b[ c ];
+    }
+    const f64 sign = d < 0.0 ? -1.0 : 1.0;
+    d *= sign;
+
+    f64 s0 = 1.0 - t, s1 = t;
+    if ( d < 0.99999 ) {
+        const f64 theta = acos( d );
+        s0 = sin( ( 1.0 - t ) * theta ) / sin( theta );
+        s1 = sin( t * theta ) / sin( theta );
+    }
+    for ( u32 c = 0; c < 4; ++c ) {
+        result[ c ] = ( f32 )( s0 * a[ c ] + s1 * sign * b[ c ] );
+    }
+}
+
+// glTF interpolation of keys k and k + 1 at t in [0, 1].
+static void sample_reference( const TestTrack& track, u32 k, f32 t, f32 dt, f32* result ) {
+    if ( track.interpolation == glTF::AnimationSampler::Step ) {
+        memcpy( result, track.values + ( t >= 1.0f ? k + 1 : k ) * track.component_count, track.component_count * sizeof( f32 ) );
+    } else if ( track.interpolation == glTF::AnimationSampler::CubicSpline ) {
+        const f32 t2 = t * t, t3 = t2 * t;
+        for ( u32 c = 0; c < 4; ++c ) {
+            const f32 a = track.values[ ( k * 3 + 1 ) * 4 + c ], b = track.values[ ( ( k + 1 ) * 3 + 1 ) * 4 + c ];
+            const f32 out_tangent = track.values[ ( k * 3 + 2 ) * 4 + c ] * dt, in_tangent = track.values[ ( k + 1 ) * 3 * 4 + c ] * dt;
+            result[ c ] = ( 2 * t3 - 3 * t2 + 1 ) * a + ( t3 - 2 * t2 + t ) * out_tangent + ( -2 * t3 + 3 * t2 ) * b + ( t3 - t2 ) * in_tangent;
+        }
+        normalize_quaternion( result );
+    } else if ( track.target_type == glTF::AnimationChannel::Rotation ) {
+        slerp( track.values + k * 4, track.values + ( k + 1 ) * 4, t, result );
+    } else {
+        for ( u32 c = 0; c < 3; ++c ) {
+            result[ c ] = track.values[ k * 3 + c ] + ( track.values[ ( k + 1 ) * 3 + c ] - track.values[ k * 3 + c ] ) * t;
+        }
+    }
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    // Per joint: linear translation, linear rotation, step scale, and on even joints a cubic rotation of another node.
+    TestAnimation animation;
+    animation.buffer.resize( k_key_count + k_joint_count * k_key_count * 22 + k_key_count * 2 );
+    std::vector<glTF::AnimationSampler> samplers;
+    std::vector<glTF::AnimationChannel> channels;
+    std::vector<TestTrack> tracks;
+
+    i32 times_accessor;
+    f32* times = animation.add( k_key_count, glTF::Accessor::Scalar, 1, times_accessor );
+    for ( u32 k = 0; k < k_key_count; ++k ) {
+        times[ k ] = k * 0.1f + ( k ? random_float() * 0.02f : 0.0f );
+    }
+
+    auto add_channel = [&]( u32 node, u32 target_type, u32 interpolation, i32 output_accessor ) {
+        glTF::AnimationSampler sampler{ };
+        sampler.input_keyframe_buffer_index = times_accessor;
+        sampler.output_keyframe_buffer_index = output_accessor;
+        sampler.interpolation = ( glTF::AnimationSampler::Interpolation )interpolation;
+        samplers.push_back( sampler );
+
+        glTF::AnimationChannel channel{ };
+        channel.sampler = ( i32 )samplers.size() - 1;
+        channel.target_node = node;
+        channel.target_type = ( glTF::AnimationChannel::TargetType )target_type;
+        channels.push_back( channel );
+    };
+
+    for ( u32 j = 0; j < k_joint_count; ++j ) {
+        i32 accessor;
+        f32* translations = animation.add( k_key_count, glTF::Accessor::Vec3, 3, accessor );
+        for ( u32 i = 0; i < k_key_count * 3; ++i ) {
+            translations[ i ] = random_float();
+        }
+        add_channel( j, glTF::AnimationChannel::Translation, glTF::AnimationSampler::Linear, accessor );
+        tracks.push_back( { j, glTF::AnimationChannel::Translation, glTF::AnimationSampler::Linear, 3, translations } );
+
+        f32* rotations = animation.add( k_key_count, glTF::Accessor::Vec4, 4, accessor );
+        for ( u32 k = 0; k < k_key_count; ++k ) {
+            for ( u32 c = 0; c < 4; ++c ) {
+                rotations[ k * 4 + c ] = random_float();
+            }
+            normalize_quaternion( rotations + k * 4 );
+        }
+        add_channel( j, glTF::AnimationChannel::Rotation, glTF::AnimationSampler::Linear, accessor );
+        tracks.push_back( { j, glTF::AnimationChannel::Rotation, glTF::AnimationSampler::Linear, 4, rotations } );
+
+        f32* scales = animation.add( k_key_count, glTF::Accessor::Vec3, 3, accessor );
+        for ( u32 i = 0; i < k_key_count * 3; ++i ) {
+            scales[ i ] = random_float();
+        }
+        add_channel( j, glTF::AnimationChannel::Scale, glTF::AnimationSampler::Step, accessor );
+        tracks.push_back( { j, glTF::AnimationChannel::Scale, glTF::AnimationSampler::Step, 3, scales } );
+
+        if ( j % 2 == 0 ) {
+            f32* splines = animation.add( k_key_count * 3, glTF::Accessor::Vec4, 4, accessor );
+            for ( u32 i = 0; i < k_key_count * 12; ++i ) {
+                splines[ i ] = random_float();
+            }
+            add_channel( k_joint_count + j, glTF::AnimationChannel::Rotation, glTF::AnimationSampler::CubicSpline, accessor );
+            tracks.push_back( { k_joint_count + j, glTF::AnimationChannel::Rotation, glTF::AnimationSampler::CubicSpline, 4, splines } );
+        }
+    }
+
+    // Two morph weights on node 0.
+    i32 weights_accessor;
+    f32* weights = animation.add( k_key_count * 2, glTF::Accessor::Scalar, 1, weights_accessor );
+    for ( u32 i = 0; i < k_key_count * 2; ++i ) {
+        weights[ i ] = random_float();
+    }
+    add_channel( 0, glTF::AnimationChannel::Weights, glTF::AnimationSampler::Linear, weights_accessor );
+
+    std::vector<glTF::Node> nodes( k_joint_count * 2 );
+    for ( glTF::Node& node : nodes ) {
+        memset( &node, 0, sizeof( node ) );
+        node.mesh = node.camera = node.skin = glTF::INVALID_INT_VALUE;
+    }
+    nodes[ 0 ].mesh = 0;
+
+    glTF::MeshPrimitive primitive{ };
+    primitive.targets_count = 2;
+    glTF::Mesh mesh{ };
+    mesh.primitives = &primitive;
+    mesh.primitives_count = 1;
+
+    glTF::Animation gltf_animation{ };
+    gltf_animation.channels = channels.data();
+    gltf_animation.channels_count = ( u32 )channels.size();
+    gltf_animation.samplers = samplers.data();
+    gltf_animation.samplers_count = ( u32 )samplers.size();
+
+    glTF::glTF gltf{ };
+    glTF::Buffer buffer{ };
+    buffer.byte_length = ( i32 )( animation.buffer.size() * sizeof( f32 ) );
+    gltf.buffers = &buffer;
+    gltf.buffers_count = 1;
+    gltf.buffer_views = animation.buffer_views.data();
+    gltf.buffer_views_count = ( u32 )animation.buffer_views.size();
+    gltf.accessors = animation.accessors.data();
+    gltf.accessors_count = ( u32 )animation.accessors.size();
+    gltf.meshes = &mesh;
+    gltf.meshes_count = 1;
+    gltf.nodes = nodes.data();
+    gltf.nodes_count = ( u32 )nodes.size();
+    gltf.animations = &gltf_animation;
+    gltf.animations_count = 1;
+    u8* buffers_data[ 1 ] = { ( u8* )animation.buffer.data() };
+
+    AnimationClip clip;
+    TEST_CHECK( clip.init( gltf, 0, buffers_data, allocator ) );
+    TEST_CHECK( clip.tracks_count == channels.size() && clip.duration == times[ k_key_count - 1 ] );
+
+    AnimationPose pose;
+    pose.init( gltf, allocator );
+    TEST_CHECK( pose.weights_offsets[ 1 ] == 2 && pose.weights[ 0 ] == 0.0f && pose.weights[ 1 ] == 0.0f );
+
+    AnimationInstance instance;
+    instance.init( &clip, &pose, allocator );
+    instance.loop = false;
+
+    // Sequential playback from before the first key, then random times past the end. The linear
+    // rotations are normalized lerps, compared against slerp.
+    f64 max_errors[ 4 ] = { };
+    u32 differences = 0;
+    for ( u32 i = 0; i < 2000; ++i ) {
+        const f32 time = i < 1000 ? i * 0.003f - 0.1f : random_float() * 1.6f + 1.4f;
+        instance.sample( time );
+
+        u32 k = 0;
+        while ( k + 2 < k_key_count && times[ k + 1 ] <= time ) {
+            ++k;
+        }
+        const f32 dt = times[ k + 1 ] - times[ k ];
+        const f32 t = fminf( fmaxf( ( time - times[ k ] ) / dt, 0.0f ), 1.0f );
+
+        for ( const TestTrack& track : tracks ) {
+            f32 expected[ 4 ];
+            sample_reference( track, k, t, dt, expected );
+
+            const f32* sampled = track.target_type == glTF::AnimationChannel::Translation ? pose.translations[ track.node ].raw :
+                                 track.target_type == glTF::AnimationChannel::Scale       ? pose.scales[ track.node ].raw :
+                                                                                            pose.rotations[ track.node ].raw;
+            f32 sign = 1.0f;
+            if ( track.component_count == 4 ) {
+                f32 d = 0.0f;
+                for ( u32 c = 0; c < 4; ++c ) {
+                    d += expected[ c ] * sampled[ c ];
+                }
+                sign = d < 0.0f ? -1.0f : 1.0f;
+            }
+
+            const u32 kind = track.interpolation == glTF::AnimationSampler::CubicSpline ? 3 :
+                             track.interpolation == glTF::AnimationSampler::Step        ? 2 :
+                             track.component_count == 4                                  ? 1 : 0;
+            for ( u32 c = 0; c < track.component_count; ++c ) {
+                max_errors[ kind ] = fmax( max_errors[ kind ], fabs( sampled[ c ] * sign - expected[ c ] ) );
+            }
+        }
+
+        const f32 expected_weight = weights[ k * 2 ] + ( weights[ ( k + 1 ) * 2 ] - weights[ k * 2 ] ) * t;
+        differences += fabsf( pose.weights[ 0 ] - expected_weight ) > 1e-5f;
+    }
+    rprint( "Max errors: linear %g, rotation %g, step %g, cubic spline %g\n", max_errors[ 0 ], max_errors[ 1 ], max_errors[ 2 ], max_errors[ 3 ] );
+    TEST_CHECK( max_errors[ 0 ] < 1e-5 && max_errors[ 1 ] < 1e-3 && max_errors[ 2 ] == 0.0 && max_errors[ 3 ] < 1e-5 );
+    TEST_CHECK( differences == 0 );
+
+    // Weights tracks are dropped when the node has no mesh, or not as many targets.
+    nodes[ 0 ].mesh = glTF::INVALID_INT_VALUE;
+    AnimationClip without_mesh;
+    TEST_CHECK( without_mesh.init( gltf, 0, buffers_data, allocator ) && without_mesh.tracks_count == channels.size() - 1 );
+    without_mesh.shutdown();
+    nodes[ 0 ].mesh = 0;
+
+    primitive.targets_count = 3;
+    AnimationClip mismatched;
+    TEST_CHECK( mismatched.init( gltf, 0, buffers_data, allocator ) && mismatched.tracks_count == channels.size() - 1 );
+    mismatched.shutdown();
+    primitive.targets_count = 2;
+
+    // Instances with their own poses, serial then in tasks.
+    std::vector<AnimationPose> poses( k_instance_count );
+    std::vector<AnimationInstance> instances( k_instance_count );
+    for ( u32 i = 0; i < k_instance_count; ++i ) {
+        poses[ i ].init( gltf, allocator );
+        instances[ i ].init( &clip, &poses[ i ], allocator );
+        instances[ i ].time = i * 0.001f;
+    }
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 4 );
+
+    for ( u32 tasked = 0; tasked < 2; ++tasked ) {
+        const i64 start = time_now();
+        for ( u32 f = 0; f < k_frame_count; ++f ) {
+            for ( AnimationInstance& animated : instances ) {
+                animated.time += 1.0f / 60.0f;
+            }
+            animation_sample_instances( instances.data(), k_instance_count, tasked ? &task_scheduler : nullptr );
+        }
+        rprint( "%u instances, %u channels, %s: %.3f ms per frame\n", k_instance_count, k_instance_count * clip.tracks_count, tasked ? "tasks" : "serial",
+                time_from_milliseconds( start ) / k_frame_count );
+    }
+
+    for ( u32 i = 0; i < k_instance_count; ++i ) {
+        instances[ i ].shutdown();
+        poses[ i ].shutdown();
+    }
+    instance.shutdown();
+    pose.shutdown();
+    clip.shutdown();
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
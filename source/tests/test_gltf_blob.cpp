@@ -0,0 +1,42 @@
+#include "test.hpp"
+#include "test_gltf_scene.hpp"
+
+#include "foundation/gltf_blob.hpp"
+#include "foundation/file.hpp"
+
+using namespace syi;
+
+static cstring k_scene_path = "test_gltf_blob.gltf";
+static const u32 k_scene_nodes = 3000;
+
+int main() {
+    test_init();
+
+    TEST_CHECK( test_write_gltf_scene( k_scene_path, k_scene_nodes ) );
+
+    char blob_path[ 512 ];
+    gltf_blob_path( k_scene_path, blob_path, sizeof( blob_path ) );
+    file_delete( blob_path );
+
+    // Parsed and compiled on the first load, mapped on the next ones.
+    i64 start = time_now();
+    glTF::glTF parsed = gltf_load_file( k_scene_path, true );
+    const f64 parse_time = time_from_milliseconds( start );
+    TEST_CHECK( file_exists( blob_path ) );
+
+    start = time_now();
+    glTF::glTF mapped = gltf_load_file( k_scene_path, true );
+    const f64 blob_time = time_from_milliseconds( start );
+    TEST_CHECK( mapped.blob_mapping.data != nullptr );
+    TEST_CHECK( mapped.nodes_count == k_scene_nodes );
+    TEST_CHECK( test_compare_gltf_scenes( parsed, mapped ) == 0 );
+
+    rprint( "%u nodes: parsed and compiled in %.2f ms, loaded from the blob in %.3f ms\n", k_scene_nodes, parse_time, blob_time );
+
+    gltf_free( mapped );
+    gltf_free( parsed );
+
+    file_delete( blob_path );
+    file_delete( k_scene_path );
+    return test_shutdown();
+}
@@ -0,0 +1,149 @@
+#include "test.hpp"
+
+#include "foundation/gltf.hpp"
+#include "foundation/file.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_glb_path = "test_gltf_glb.glb";
+static const u32 k_vertex_count = 4;
+static const u32 k_binary_size = 16 + k_vertex_count * 12;
+
+// View 0 holds the positions after 16 padding bytes, the other views are out of the binary chunk:
+// a negative offset or length wrapped the old 32 bit check, the last one ends past the chunk.
+static cstring k_json =
+    "{\"asset\":{\"version\":\"2.0\"},"
+    "\"buffers\":[{\"byteLength\":64}],"
+    "\"bufferViews\":["
+        "{\"buffer\":0,\"byteOffset\":16,\"byteLength\":48},"
+        "{\"buffer\":0,\"byteOffset\":-16,\"byteLength\":32},"
+        "{\"buffer\":0,\"byteOffset\":48,\"byteLength\":-32},"
+        "{\"buffer\":0,\"byteOffset\":32,\"byteLength\":48}],"
+    "\"accessors\":["
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+        "{\"bufferView\":0,\"byteOffset\":48,\"componentType\":5126,\"count\":1,\"type\":\"SCALAR\"},"
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":1,\"type\":\"SCALAR\"}]}";
+
+//
+//
+struct GlbLayout {
+    u32                             magic           = 0x46546C67;
+    u32                             version         = 2;
+    u32                             length_delta    = 0;    // Added to the length in the header.
+    u32                             json_delta      = 0;    // Added to the length of the json chunk.
+    u32                             binary_delta    = 0;    // Added to the length of the binary chunk.
+}; // struct GlbLayout
+
+static u32 pad4( u32 size ) {
+    return ( size + 3 ) & ~3u;
+}
+
+// Chunks are padded to 4 bytes: the json with spaces, the binary chunk with zeros.
+static bool write_glb( const GlbLayout& layout, const u8* binary ) {
+    const u32 json_size = ( u32 )strlen( k_json );
+    const u32 json_chunk_size = pad4( json_size );
+    const u32 length = 12 + 8 + json_chunk_size + 8 + pad4( k_binary_size );
+
+    std::vector<u8> data( length, 0 );
+    const u32 header[ 3 ] = { layout.magic, layout.version, length + layout.length_delta };
+    memcpy( data.data(), header, 12 );
+
+    const u32 json_header[ 2 ] = { json_chunk_size + layout.json_delta, 0x4E4F534A };
+    memcpy( data.data() + 12, json_header, 8 );
+    memset( data.data() + 20, ' ', json_chunk_size );
+    memcpy( data.data() + 20, k_json, json_size );
+
+    const u32 binary_header[ 2 ] = { pad4( k_binary_size ) + layout.binary_delta, 0x004E4942 };
+    memcpy( data.data() + 20 + json_chunk_size, binary_header, 8 );
+    memcpy( data.data() + 28 + json_chunk_size, binary, k_binary_size );
+
+    FILE* file = fopen( k_glb_path, "wb" );
+    if ( file == nullptr ) {
+        return false;
+    }
+    const bool written = fwrite( data.data(), 1, data.size(), file ) == data.size();
+    fclose( file );
+    return written;
+}
+
+static bool load_fails( const GlbLayout& layout, const u8* binary ) {
+    if ( !write_glb( layout, binary ) ) {
+        return false;
+    }
+
+    glTF::glTF gltf = gltf_load_file( k_glb_path, false );
+    const bool failed = gltf.file_mapping.data == nullptr && gltf.buffer_views_count == 0;
+    gltf_free( gltf );
+    return failed;
+}
+
+int main() {
+    test_init();
+
+    u8 binary[ k_binary_size ] = { };
+    f32* positions = ( f32* )( binary + 16 );
+    for ( u32 i = 0; i < k_vertex_count * 3; ++i ) {
+        positions[ i ] = ( f32 )i * 0.5f;
+    }
+
+    // Views and accessors of the buffer without uri point into the mapped file.
+    TEST_CHECK( write_glb( GlbLayout{ }, binary ) );
+    glTF::glTF gltf = gltf_load_file( k_glb_path, false );
+    TEST_CHECK( gltf.file_mapping.data != nullptr && gltf.buffer_views_count == 4 && gltf.accessors_count == 3 );
+
+    const u8* file_begin = ( const u8* )gltf.file_mapping.data;
+    const u8* file_end = file_begin + gltf.file_mapping.size;
+    TEST_CHECK( gltf.binary_chunk > file_begin && gltf.binary_chunk + gltf.binary_chunk_size <= file_end );
+    TEST_CHECK( gltf.binary_chunk_size == pad4( k_binary_size ) );
+
+    u32 view_size = 0;
+    const u8* view = gltf_get_buffer_view_data( gltf, 0, &view_size );
+    TEST_CHECK( view == gltf.binary_chunk + 16 && view_size == 48 );
+    const f32* mapped_positions = ( const f32* )gltf_get_accessor_data( gltf, 0 );
+    TEST_CHECK( ( const u8* )mapped_positions == view && memcmp( mapped_positions, positions, k_vertex_count * 12 ) == 0 );
+
+    // Out of range views and accessors give no data.
+    for ( i32 v = 1; v < 4; ++v ) {
+        TEST_CHECK( gltf_get_buffer_view_data( gltf, v, &view_size ) == nullptr );
+    }
+    TEST_CHECK( gltf_get_buffer_view_data( gltf, 4, &view_size ) == nullptr );
+    TEST_CHECK( gltf_get_accessor_data( gltf, 1 ) == nullptr );
+    TEST_CHECK( gltf_get_accessor_data( gltf, 2 ) == nullptr );
+    gltf_free( gltf );
+
+    // Malformed containers are rejected before parsing.
+    GlbLayout bad_magic;
+    bad_magic.magic = 0x46546C68;
+    TEST_CHECK( load_fails( bad_magic, binary ) );
+
+    GlbLayout bad_version;
+    bad_version.version = 1;
+    TEST_CHECK( load_fails( bad_version, binary ) );
+
+    GlbLayout truncated;
+    truncated.length_delta = 4;
+    TEST_CHECK( load_fails( truncated, binary ) );
+
+    GlbLayout long_json;
+    long_json.json_delta = 0x10000;
+    TEST_CHECK( load_fails( long_json, binary ) );
+
+    GlbLayout huge_json;
+    huge_json.json_delta = 0xF0000000u;
+    TEST_CHECK( load_fails( huge_json, binary ) );
+
+    GlbLayout long_binary;
+    long_binary.binary_delta = 4;
+    TEST_CHECK( load_fails( long_binary, binary ) );
+
+    GlbLayout huge_binary;
+    huge_binary.binary_delta = 0xF0000000u;
+    TEST_CHECK( load_fails( huge_binary, binary ) );
+
+    file_delete( k_glb_path );
+    return test_shutdown();
+}
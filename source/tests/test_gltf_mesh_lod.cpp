@@ -0,0 +1,127 @@
+#include "test.hpp"
+#include "test_gltf_meshes.hpp"
+
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/gltf_mesh_lod.hpp"
+#include "foundation/camera.hpp"
+#include "foundation/file.hpp"
+
+#include <math.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_meshes_path = "test_gltf_mesh_lod.meshes";
+static const u32 k_max_lods = 8;
+static const u32 k_grid_size = 100;
+
+int main() {
+    Allocator* allocator = test_init( rmega( 512 ) );
+
+    // 131k triangles, halved by each LOD.
+    TestSphere sphere;
+    sphere.init( 256, 256, 1 );
+    MeshOptimizerOptions options;
+    options.meshlet_max_vertices = 0;
+    options.quantize = false;
+    options.quantize_positions = false;
+    options.lod.max_lods = k_max_lods;
+    TEST_CHECK( gltf_compile_meshes( sphere.gltf, sphere.buffers_data, k_meshes_path, options ) );
+
+    FileMapping mapping;
+    const glTF::MeshAssetBlob* meshes = gltf_map_meshes( k_meshes_path, mapping );
+    TEST_CHECK( meshes && meshes->primitives.size == 1 );
+    if ( meshes == nullptr ) {
+        return test_shutdown();
+    }
+
+    const glTF::MeshPrimitiveAssetBlob& primitive = meshes->primitives[ 0 ];
+    const MeshLod* lods = primitive.lods.get();
+    const u32 lods_count = primitive.lods.size;
+    TEST_CHECK( lods_count == k_max_lods && lods[ 0 ].index_offset == 0 && lods[ 0 ].index_count == sphere.index_count && lods[ 0 ].error == 0.0f );
+    TEST_CHECK( fabsf( primitive.center[ 0 ] ) < 1e-3f && fabsf( primitive.center[ 1 ] ) < 1e-3f && fabsf( primitive.radius - 1.0f ) < 1e-2f );
+
+    std::vector<u32> indices( primitive.index_count );
+    std::vector<f32> positions( primitive.vertex_count * 3 );
+    TEST_CHECK( mesh_decode_indices( primitive, indices.data() ) && mesh_decode_stream( primitive, 0, positions.data() ) );
+
+    // Each LOD removes triangles, with a larger error, and stays close to the sphere.
+    for ( u32 l = 0; l < lods_count; ++l ) {
+        const MeshLod& lod = lods[ l ];
+        TEST_CHECK( lod.index_offset + lod.index_count <= primitive.index_count );
+        if ( l > 0 ) {
+            TEST_CHECK( lod.index_count <= lods[ l - 1 ].index_count * 85 / 100 && lod.error >= lods[ l - 1 ].error );
+        }
+
+        u32 out_of_range = 0;
+        f32 max_deviation = 0.0f;
+        for ( u32 t = 0; t < lod.index_count / 3; ++t ) {
+            f32 centroid[ 3 ] = { };
+            for ( u32 k = 0; k < 3; ++k ) {
+                const u32 v = indices[ lod.index_offset + t * 3 + k ];
+                out_of_range += v >= primitive.vertex_count;
+                for ( u32 c = 0; c < 3 && v < primitive.vertex_count; ++c ) {
+                    centroid[ c ] += positions[ v * 3 + c ] / 3.0f;
+                }
+            }
+            max_deviation = fmaxf( max_deviation, 1.0f - sqrtf( centroid[ 0 ] * centroid[ 0 ] + centroid[ 1 ] * centroid[ 1 ] + centroid[ 2 ] * centroid[ 2 ] ) );
+        }
+        TEST_CHECK( out_of_range == 0 && max_deviation < 0.1f );
+        rprint( "Lod %u: %u triangles, error %g, deviation from the sphere %g\n", l, lod.index_count / 3, lod.error, max_deviation );
+    }
+
+    // Coarser LODs further away, 1080p and a 1 pixel threshold.
+    Camera camera;
+    camera.init_perpective( 0.1f, 1000.0f, 60.0f, 1920.0f / 1080.0f );
+    camera.set_viewport_size( 1920, 1080 );
+    u32 previous_lod = 0;
+    u32 selected[ 3 ] = { };
+    u32 s = 0;
+    for ( f32 distance : { 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f } ) {
+        camera.position = { 0.0f, 0.0f, -distance };
+        camera.update();
+        MeshLodSelector selector;
+        selector.init( camera, 1.0f );
+        const u32 lod = selector.select( lods, lods_count, { 0.0f, 0.0f, 0.0f }, 1.0f );
+        TEST_CHECK( lod >= previous_lod );
+        // Twice the scale is twice the error on the screen.
+        TEST_CHECK( selector.select( lods, lods_count, { 0.0f, 0.0f, 0.0f }, 2.0f, 2.0f ) <= lod );
+        if ( s < 3 ) {
+            selected[ s++ ] = lod;
+        }
+        previous_lod = lod;
+        rprint( "Distance %g: lod %u, %u triangles\n", distance, lod, lods[ lod ].index_count / 3 );
+    }
+    TEST_CHECK( selected[ 0 ] > 0 && selected[ 0 ] < selected[ 1 ] && selected[ 2 ] == lods_count - 1 );
+
+    // Inside the bounding sphere the finest LOD is kept.
+    camera.position = { 0.0f, 0.0f, -0.5f };
+    camera.update();
+    MeshLodSelector selector;
+    selector.init( camera, 1.0f );
+    TEST_CHECK( selector.select( lods, lods_count, { 0.0f, 0.0f, 0.0f }, 1.0f ) == 0 );
+
+    file_unmap( &mapping );
+    file_delete( k_meshes_path );
+
+    // Quads not sharing vertices: every edge is a border, only the sloppy simplification works.
+    std::vector<f32> grid_positions;
+    std::vector<u32> grid_indices;
+    for ( u32 y = 0; y < k_grid_size; ++y ) {
+        for ( u32 x = 0; x < k_grid_size; ++x ) {
+            const u32 base = ( u32 )grid_positions.size() / 3;
+            grid_positions.insert( grid_positions.end(), { ( f32 )x, ( f32 )y, 0.0f, x + 1.0f, ( f32 )y, 0.0f, ( f32 )x, y + 1.0f, 0.0f, x + 1.0f, y + 1.0f, 0.0f } );
+            grid_indices.insert( grid_indices.end(), { base, base + 1, base + 2, base + 1, base + 3, base + 2 } );
+        }
+    }
+    for ( u32 sloppy = 0; sloppy < 2; ++sloppy ) {
+        MeshLodOptions lod_options;
+        lod_options.sloppy = sloppy;
+        MeshLodChain chain;
+        mesh_build_lods( grid_indices.data(), ( u32 )grid_indices.size(), grid_positions.data(), ( u32 )grid_positions.size() / 3, lod_options, allocator, chain );
+        TEST_CHECK( sloppy ? chain.lods_count == lod_options.max_lods : chain.lods_count == 1 );
+        mesh_free_lods( chain );
+    }
+
+    return test_shutdown();
+}
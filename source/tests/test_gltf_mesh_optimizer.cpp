@@ -0,0 +1,200 @@
+#include "test.hpp"
+#include "test_gltf_meshes.hpp"
+
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/file.hpp"
+#include "foundation/hash_map.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_gltf_path = "test_gltf_mesh_optimizer.gltf";
+static cstring k_buffer_path = "test_gltf_mesh_optimizer.bin";
+static cstring k_meshes_path = "test_gltf_mesh_optimizer.meshes";
+static cstring k_cache_directory = "test_gltf_mesh_optimizer_cache";
+static const u32 k_grid_size = 200;
+static const u32 k_triangle_count = k_grid_size * k_grid_size * 2;
+static const u32 k_vertex_count = k_triangle_count * 3;    // Triangle soup, every corner duplicated.
+
+// Positions and target deltas of a triangle, rotated to start from its smallest position to keep the winding.
+typedef std::array<f32, 18> TriangleKey;
+
+static TriangleKey triangle_key( const f32* positions, const f32* deltas, const u32* corners ) {
+    u32 first = 0;
+    for ( u32 k = 1; k < 3; ++k ) {
+        const f32* a = positions + corners[ k ] * 3;
+        const f32* b = positions + corners[ first ] * 3;
+        first = std::lexicographical_compare( a, a + 3, b, b + 3 ) ? k : first;
+    }
+
+    TriangleKey key;
+    for ( u32 k = 0; k < 3; ++k ) {
+        const u32 v = corners[ ( first + k ) % 3 ];
+        for ( u32 c = 0; c < 3; ++c ) {
+            key[ k * 6 + c ] = positions[ v * 3 + c ];
+            key[ k * 6 + 3 + c ] = deltas[ v * 3 + c ];
+        }
+    }
+    return key;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    // Shuffled triangles of a grid, with normals and a morph target moving the grid points.
+    std::vector<std::array<u32, 3>> triangles;
+    for ( u32 y = 0; y < k_grid_size; ++y ) {
+        for ( u32 x = 0; x < k_grid_size; ++x ) {
+            const u32 a = y * ( k_grid_size + 1 ) + x, b = a + 1, c = a + k_grid_size + 1, d = c + 1;
+            triangles.push_back( { a, b, c } );
+            triangles.push_back( { b, d, c } );
+        }
+    }
+    for ( u32 t = k_triangle_count - 1; t > 0; --t ) {
+        std::swap( triangles[ t ], triangles[ rand() % ( t + 1 ) ] );
+    }
+
+    std::vector<f32> buffer( k_vertex_count * 9, 0.0f );
+    f32* positions = buffer.data();
+    f32* normals = positions + k_vertex_count * 3;
+    f32* deltas = normals + k_vertex_count * 3;
+    for ( u32 t = 0; t < k_triangle_count; ++t ) {
+        for ( u32 k = 0; k < 3; ++k ) {
+            const u32 grid_point = triangles[ t ][ k ];
+            const u32 v = t * 3 + k;
+            positions[ v * 3 ] = ( f32 )( grid_point % ( k_grid_size + 1 ) );
+            positions[ v * 3 + 1 ] = ( f32 )( grid_point / ( k_grid_size + 1 ) );
+            normals[ v * 3 + 2 ] = 1.0f;
+            deltas[ v * 3 + 2 ] = ( grid_point % 7 ) * 0.1f;
+        }
+    }
+    u8* buffers_data[ 1 ] = { ( u8* )buffer.data() };
+
+    // POSITION, NORMAL and a POSITION target, then a line list on the same positions.
+    char text[ 2048 ];
+    const u32 stream_size = k_vertex_count * 12;
+    snprintf( text, sizeof( text ), R"({"asset":{"version":"2.0"},"buffers":[{"uri":"%s","byteLength":%u}],"bufferViews":[{"buffer":0,"byteLength":%u}],
+        "accessors":[{"bufferView":0,"componentType":5126,"count":%u,"type":"VEC3"},{"bufferView":0,"byteOffset":%u,"componentType":5126,"count":%u,"type":"VEC3"},
+            {"bufferView":0,"byteOffset":%u,"componentType":5126,"count":%u,"type":"VEC3"}],
+        "meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1},"targets":[{"POSITION":2}]},{"attributes":{"POSITION":0},"mode":1}]}]})",
+              k_buffer_path, stream_size * 3, stream_size * 3, k_vertex_count, stream_size, k_vertex_count, stream_size * 2, k_vertex_count );
+
+    glTF::glTF gltf{ };
+    TEST_CHECK( gltf_parse_sax( text, strlen( text ), gltf ) );
+
+    // Duplicated vertices merged, then reordered for the vertex cache.
+    MeshOptimizerOptions options;
+    options.meshlet_max_vertices = 0;
+    options.lod.max_lods = 1;
+    options.quantize = false;
+    options.quantize_positions = false;
+
+    OptimizedPrimitive optimized;
+    TEST_CHECK( mesh_optimize_primitive( gltf, gltf.meshes[ 0 ].primitives[ 0 ], buffers_data, options, allocator, optimized ) );
+    TEST_CHECK( optimized.source_vertex_count == k_vertex_count && optimized.vertex_count == ( k_grid_size + 1 ) * ( k_grid_size + 1 ) );
+    TEST_CHECK( optimized.index_count == k_triangle_count * 3 && optimized.after.acmr < optimized.before.acmr && optimized.after.acmr < 1.0f );
+    rprint( "%u triangles: ACMR %.3f to %.3f, ATVR %.3f to %.3f\n", k_triangle_count, optimized.before.acmr, optimized.after.acmr,
+            optimized.before.atvr, optimized.after.atvr );
+    mesh_free_optimized_primitive( optimized );
+
+    // Line lists are not optimized.
+    TEST_CHECK( !mesh_optimize_primitive( gltf, gltf.meshes[ 0 ].primitives[ 1 ], buffers_data, options, allocator, optimized ) );
+
+    // The compiled triangles, raw or encoded, are the source ones.
+    std::vector<TriangleKey> expected;
+    for ( u32 t = 0; t < k_triangle_count; ++t ) {
+        const u32 corners[ 3 ] = { t * 3, t * 3 + 1, t * 3 + 2 };
+        expected.push_back( triangle_key( positions, deltas, corners ) );
+    }
+    std::sort( expected.begin(), expected.end() );
+
+    u32 stream_bytes[ 2 ] = { };
+    for ( u32 encoded = 0; encoded < 2; ++encoded ) {
+        options.encode = encoded;
+        const i64 start = time_now();
+        TEST_CHECK( gltf_compile_meshes( gltf, buffers_data, k_meshes_path, options ) );
+        const f64 compile_time = time_from_milliseconds( start );
+
+        FileMapping mapping;
+        const glTF::MeshAssetBlob* meshes = gltf_map_meshes( k_meshes_path, mapping );
+        TEST_CHECK( meshes && meshes->primitives.size == 1 );
+        if ( meshes == nullptr ) {
+            continue;
+        }
+
+        const glTF::MeshPrimitiveAssetBlob& primitive = meshes->primitives[ 0 ];
+        const i32 position_stream = test_find_mesh_stream( primitive, "POSITION" );
+        const i32 target_stream = test_find_mesh_stream( primitive, "TARGET0_POSITION" );
+        TEST_CHECK( primitive.encoded == encoded && position_stream >= 0 && target_stream >= 0 && test_find_mesh_stream( primitive, "NORMAL" ) >= 0 );
+
+        std::vector<u32> indices( primitive.index_count );
+        std::vector<f32> decoded_positions( primitive.vertex_count * 3 ), decoded_deltas( primitive.vertex_count * 3 );
+        TEST_CHECK( mesh_decode_indices( primitive, indices.data() ) && mesh_decode_stream( primitive, position_stream, decoded_positions.data() ) &&
+                    mesh_decode_stream( primitive, target_stream, decoded_deltas.data() ) );
+
+        std::vector<TriangleKey> compiled;
+        for ( u32 t = 0; t < primitive.index_count / 3; ++t ) {
+            compiled.push_back( triangle_key( decoded_positions.data(), decoded_deltas.data(), &indices[ t * 3 ] ) );
+        }
+        std::sort( compiled.begin(), compiled.end() );
+        TEST_CHECK( compiled == expected );
+
+        stream_bytes[ encoded ] = primitive.indices.size + primitive.streams[ position_stream ].data.size;
+        rprint( "%s: compiled in %.1f ms, indices and positions %u bytes\n", encoded ? "Encoded" : "Raw", compile_time, stream_bytes[ encoded ] );
+        file_unmap( &mapping );
+    }
+    TEST_CHECK( stream_bytes[ 1 ] < stream_bytes[ 0 ] );
+    file_delete( k_meshes_path );
+
+    // The resource compiler hashes the external buffers: a changed .bin is a new cache entry.
+    FILE* file = fopen( k_gltf_path, "wb" );
+    TEST_CHECK( file && fputs( text, file ) >= 0 );
+    fclose( file );
+    file = fopen( k_buffer_path, "wb" );
+    TEST_CHECK( file && fwrite( buffer.data(), sizeof( f32 ), buffer.size(), file ) == buffer.size() );
+    fclose( file );
+
+    MeshResourceCompiler compiler;
+    compiler.init( MeshOptimizerOptions{ }, nullptr );
+    ResourceManager resource_manager;
+    resource_manager.init( allocator, nullptr, k_cache_directory );
+    resource_manager.set_compiler( MeshResourceCompiler::k_type, &compiler );
+
+    const u64 type_hash = hash_calculate( MeshResourceCompiler::k_type );
+    char compiled_path[ 512 ], cached_path[ 512 ], changed_path[ 512 ];
+    TEST_CHECK( resource_manager.get_cached_path( type_hash, k_gltf_path, compiled_path, 512 ) != nullptr );
+    TEST_CHECK( resource_manager.get_cached_path( type_hash, k_gltf_path, cached_path, 512 ) != nullptr && strcmp( compiled_path, cached_path ) == 0 );
+
+    FileMapping mapping;
+    const glTF::MeshAssetBlob* meshes = gltf_map_meshes( compiled_path, mapping );
+    TEST_CHECK( meshes && meshes->primitives.size == 1 );
+    if ( meshes ) {
+        file_unmap( &mapping );
+    }
+
+    file = fopen( k_buffer_path, "r+b" );
+    const f32 moved = 0.5f;
+    fseek( file, 4, SEEK_SET );
+    fwrite( &moved, sizeof( f32 ), 1, file );
+    fclose( file );
+    TEST_CHECK( resource_manager.get_cached_path( type_hash, k_gltf_path, changed_path, 512 ) != nullptr && strcmp( compiled_path, changed_path ) != 0 );
+
+    const ResourceCacheStatistics statistics = resource_manager.get_cache_statistics();
+    TEST_CHECK( statistics.hits == 1 && statistics.misses == 2 && statistics.failed_compiles == 0 );
+    resource_manager.shutdown();
+
+    file_delete( compiled_path );
+    file_delete( changed_path );
+    directory_delete( k_cache_directory );
+    file_delete( k_buffer_path );
+    file_delete( k_gltf_path );
+
+    gltf_free( gltf );
+    return test_shutdown();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+#include "foundation/gltf_meshlets.hpp"
+#include "foundation/gltf_mesh_optimizer.hpp"
+
+#include "external/cglm/util.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+// Test meshes ////////////////////////////////////////////////////////////
+//
+// Generated meshes for the mesh tests and benchmarks, and scalar references of the
+// SIMD paths they check.
+namespace syi {
+
+    //
+    // A unit UV sphere as an in memory glTF: u32 indices and float positions, wound counter
+    // clockwise seen from outside, and a mesh with primitives_count copies of the same primitive.
+    // The rings at the poles have degenerate triangles.
+    struct TestSphere {
+
+        void init( u32 rings, u32 segments, u32 primitives_count ) {
+            for ( u32 r = 0; r <= rings; ++r ) {
+                for ( u32 s = 0; s <= segments; ++s ) {
+                    const f32 theta = GLM_PIf * r / rings, phi = 2.0f * GLM_PIf * s / segments;
+                    positions.insert( positions.end(), { sinf( theta ) * cosf( phi ), cosf( theta ), sinf( theta ) * sinf( phi ) } );
+                }
+            }
+            for ( u32 r = 0; r < rings; ++r ) {
+                for ( u32 s = 0; s < segments; ++s ) {
+                    const u32 a = r * ( segments + 1 ) + s, b = a + 1, c = a + segments + 1, d = c + 1;
+                    indices.insert( indices.end(), { a, b, c, b, d, c } );
+                }
+            }
+            vertex_count = ( u32 )positions.size() / 3;
+            index_count = ( u32 )indices.size();
+
+            buffer.resize( vertex_count * 12 + index_count * 4 );
+            memcpy( buffer.data(), positions.data(), vertex_count * 12 );
+            memcpy( buffer.data() + vertex_count * 12, indices.data(), index_count * 4 );
+            buffers_data[ 0 ] = buffer.data();
+
+            gltf_buffer.byte_length = ( i32 )buffer.size();
+            view.byte_length = ( i32 )buffer.size();
+            view.byte_stride = glTF::INVALID_INT_VALUE;
+            accessors[ 0 ].component_type = glTF::Accessor::FLOAT;
+            accessors[ 0 ].type = glTF::Accessor::Vec3;
+            accessors[ 0 ].count = vertex_count;
+            accessors[ 1 ].byte_offset = vertex_count * 12;
+            accessors[ 1 ].component_type = glTF::Accessor::UNSIGNED_INT;
+            accessors[ 1 ].type = glTF::Accessor::Scalar;
+            accessors[ 1 ].count = index_count;
+
+            attribute.key.data = position_key;
+            attribute.accessor_index = 0;
+            primitives.resize( primitives_count );
+            for ( glTF::MeshPrimitive& primitive : primitives ) {
+                memset( &primitive, 0, sizeof( primitive ) );
+                primitive.attribute_count = 1;
+                primitive.attributes = &attribute;
+                primitive.indices = 1;
+                primitive.material = primitive.mode = glTF::INVALID_INT_VALUE;
+            }
+            mesh.primitives = primitives.data();
+            mesh.primitives_count = primitives_count;
+
+            gltf.buffers = &gltf_buffer;
+            gltf.buffers_count = 1;
+            gltf.buffer_views = &view;
+            gltf.buffer_views_count = 1;
+            gltf.accessors = accessors;
+            gltf.accessors_count = 2;
+            gltf.meshes = &mesh;
+            gltf.meshes_count = 1;
+        }
+
+        std::vector<f32>            positions;
+        std::vector<u32>            indices;
+        u32                         vertex_count    = 0;
+        u32                         index_count     = 0;
+
+        std::vector<u8>             buffer;
+        u8*                         buffers_data[ 1 ] = { };
+
+        glTF::Buffer                gltf_buffer{ };
+        glTF::BufferView            view{ };
+        glTF::Accessor              accessors[ 2 ]{ };
+        char                        position_key[ 9 ] = "POSITION";
+        glTF::MeshPrimitive::Attribute attribute{ };
+        std::vector<glTF::MeshPrimitive> primitives;
+        glTF::Mesh                  mesh{ };
+        glTF::glTF                  gltf{ };
+
+    }; // struct TestSphere
+
+    // Index of the compiled stream of an attribute, -1 if missing.
+    inline i32 test_find_mesh_stream( const glTF::MeshPrimitiveAssetBlob& primitive, cstring attribute ) {
+        for ( u32 s = 0; s < primitive.streams.size; ++s ) {
+            if ( strcmp( primitive.streams[ s ].attribute.c_str(), attribute ) == 0 ) {
+                return ( i32 )s;
+            }
+        }
+        return -1;
+    }
+
+    // meshlet_cull one meshlet at a time: the sphere against the planes, then the normal cone against the camera.
+    inline u32 test_cull_meshlets( const MeshletScene& scene, const MeshletCullParameters& parameters, u32* out_visible ) {
+        u32 visible_count = 0;
+        for ( u32 i = 0; i < scene.meshlets_count; ++i ) {
+            bool visible = true;
+            for ( u32 p = 0; p < 6; ++p ) {
+                const vec4s& plane = parameters.planes[ p ];
+                const f32 distance = ( plane.x * scene.center_x[ i ] + plane.y * scene.center_y[ i ] ) + ( plane.z * scene.center_z[ i ] + plane.w );
+                visible = visible && distance > -scene.radius[ i ];
+            }
+
+            if ( parameters.cone_culling ) {
+                const f32 x = scene.center_x[ i ] - parameters.camera_position.x;
+                const f32 y = scene.center_y[ i ] - parameters.camera_position.y;
+                const f32 z = scene.center_z[ i ] - parameters.camera_position.z;
+                const f32 cone_dot = ( x * scene.cone_axis_x[ i ] + y * scene.cone_axis_y[ i ] ) + z * scene.cone_axis_z[ i ];
+                visible = visible && cone_dot < scene.cone_cutoff[ i ] * sqrtf( ( x * x + y * y ) + z * z ) + scene.radius[ i ];
+            }
+
+            if ( visible ) {
+                out_visible[ visible_count++ ] = i;
+            }
+        }
+        return visible_count;
+    }
+
+} // namespace syi
@@ -0,0 +1,144 @@
+#include "test.hpp"
+#include "test_gltf_meshes.hpp"
+
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/gltf_meshlets.hpp"
+#include "foundation/file.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/cglm.h"
+
+#include <algorithm>
+#include <array>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_meshes_path = "test_gltf_meshlets.meshes";
+static const u32 k_sphere_rings = 256;
+static const u32 k_sphere_segments = 256;
+static const u32 k_primitive_count = 4;
+
+// Smallest rotation of a triangle, keeping the winding. The poles of the sphere have degenerate ones.
+static std::array<u32, 3> triangle_key( u32 a, u32 b, u32 c ) {
+    const std::array<u32, 3> rotations[ 3 ] = { { a, b, c }, { b, c, a }, { c, a, b } };
+    return *std::min_element( rotations, rotations + 3 );
+}
+
+int main() {
+    Allocator* allocator = test_init( rmega( 512 ) );
+
+    TestSphere sphere;
+    sphere.init( k_sphere_rings, k_sphere_segments, k_primitive_count );
+
+    // Float positions and no LODs, to check the meshlets against the decoded primitive.
+    MeshOptimizerOptions options;
+    options.quantize = false;
+    options.quantize_positions = false;
+    options.lod.max_lods = 1;
+    TEST_CHECK( gltf_compile_meshes( sphere.gltf, sphere.buffers_data, k_meshes_path, options ) );
+
+    FileMapping mapping;
+    const glTF::MeshAssetBlob* meshes = gltf_map_meshes( k_meshes_path, mapping );
+    TEST_CHECK( meshes && meshes->primitives.size == k_primitive_count );
+    if ( meshes == nullptr ) {
+        return test_shutdown();
+    }
+
+    // The meshlets of a primitive hold its triangles, each once.
+    const glTF::MeshPrimitiveAssetBlob& primitive = meshes->primitives[ 0 ];
+    std::vector<u32> decoded_indices( primitive.index_count );
+    std::vector<f32> decoded_positions( primitive.vertex_count * 3 );
+    TEST_CHECK( mesh_decode_indices( primitive, decoded_indices.data() ) && mesh_decode_stream( primitive, 0, decoded_positions.data() ) );
+
+    std::vector<std::array<u32, 3>> expected, meshlet_triangles;
+    for ( u32 t = 0; t < primitive.index_count / 3; ++t ) {
+        expected.push_back( triangle_key( decoded_indices[ t * 3 ], decoded_indices[ t * 3 + 1 ], decoded_indices[ t * 3 + 2 ] ) );
+    }
+    for ( u32 m = 0; m < primitive.meshlets.size; ++m ) {
+        const Meshlet& meshlet = primitive.meshlets[ m ];
+        TEST_CHECK( meshlet.vertex_count <= options.meshlet_max_vertices && meshlet.triangle_count <= options.meshlet_max_triangles );
+        const u32* meshlet_vertices = primitive.meshlet_vertices.get() + meshlet.vertex_offset;
+        const u8* triangles = primitive.meshlet_triangles.get() + meshlet.triangle_offset;
+        for ( u32 t = 0; t < meshlet.triangle_count; ++t ) {
+            meshlet_triangles.push_back( triangle_key( meshlet_vertices[ triangles[ t * 3 ] ], meshlet_vertices[ triangles[ t * 3 + 1 ] ],
+                                                       meshlet_vertices[ triangles[ t * 3 + 2 ] ] ) );
+        }
+    }
+    std::sort( expected.begin(), expected.end() );
+    std::sort( meshlet_triangles.begin(), meshlet_triangles.end() );
+    TEST_CHECK( meshlet_triangles == expected );
+
+    MeshletScene scene;
+    scene.init( *meshes, allocator );
+    TEST_CHECK( scene.primitives_count == k_primitive_count && scene.meshlets_count == primitive.meshlets.size * k_primitive_count );
+    TEST_CHECK( scene.primitive_offsets[ 1 ] == primitive.meshlets.size && scene.meshlet_primitives[ scene.meshlets_count - 1 ] == k_primitive_count - 1 );
+
+    // Camera looking at the sphere from outside.
+    mat4 projection, view_matrix;
+    mat4s clip_from_object;
+    vec3 eye = { 0.3f, 0.2f, 3.0f }, center = { 0.0f, 0.0f, 0.0f }, up = { 0.0f, 1.0f, 0.0f };
+    glm_perspective( glm_rad( 60.0f ), 1.6f, 0.1f, 100.0f, projection );
+    glm_lookat( eye, center, up, view_matrix );
+    glm_mat4_mul( projection, view_matrix, clip_from_object.raw );
+    MeshletCullParameters parameters;
+    meshlet_cull_parameters( clip_from_object, { eye[ 0 ], eye[ 1 ], eye[ 2 ] }, parameters );
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 8 );
+
+    std::vector<u32> visible( scene.meshlets_count ), tasked( scene.meshlets_count ), expected_visible( scene.meshlets_count );
+    const u32 visible_count = meshlet_cull( scene, parameters, 0, scene.meshlets_count, visible.data() );
+    const u32 tasked_count = meshlet_cull( scene, parameters, 0, scene.meshlets_count, tasked.data(), &task_scheduler );
+    const u32 expected_count = test_cull_meshlets( scene, parameters, expected_visible.data() );
+    TEST_CHECK( visible_count == expected_count && memcmp( visible.data(), expected_visible.data(), visible_count * sizeof( u32 ) ) == 0 );
+    TEST_CHECK( tasked_count == visible_count && memcmp( tasked.data(), visible.data(), visible_count * sizeof( u32 ) ) == 0 );
+    TEST_CHECK( visible_count > 0 && visible_count < scene.meshlets_count / 2 );
+
+    // A range not a multiple of the SIMD width gives the same meshlets.
+    const u32 first = 3, count = primitive.meshlets.size - 6;
+    u32 range_count = meshlet_cull( scene, parameters, first, count, tasked.data() );
+    u32 range_expected = 0;
+    for ( u32 i = 0; i < visible_count; ++i ) {
+        range_expected += visible[ i ] >= first && visible[ i ] < first + count;
+    }
+    TEST_CHECK( range_count == range_expected && tasked[ 0 ] >= first );
+
+    // No culled meshlet of the first primitive has a triangle facing the camera inside the frustum.
+    std::vector<bool> is_visible( scene.meshlets_count, false );
+    for ( u32 i = 0; i < visible_count; ++i ) {
+        is_visible[ visible[ i ] ] = true;
+    }
+    u32 wrongly_culled = 0;
+    for ( u32 m = 0; m < primitive.meshlets.size; ++m ) {
+        if ( is_visible[ m ] ) {
+            continue;
+        }
+        const Meshlet& meshlet = scene.meshlets[ m ];
+        for ( u32 t = 0; t < meshlet.triangle_count; ++t ) {
+            const u32 v = scene.vertices[ meshlet.vertex_offset + scene.triangles[ meshlet.triangle_offset + t * 3 ] ];
+            f32* point = &decoded_positions[ v * 3 ];
+            vec4 clip, homogeneous = { point[ 0 ], point[ 1 ], point[ 2 ], 1.0f };
+            glm_mat4_mulv( clip_from_object.raw, homogeneous, clip );
+            const bool inside = fabsf( clip[ 0 ] ) < clip[ 3 ] && fabsf( clip[ 1 ] ) < clip[ 3 ] && clip[ 2 ] > -clip[ 3 ] && clip[ 2 ] < clip[ 3 ];
+            vec3 to_point;
+            glm_vec3_sub( point, eye, to_point );
+            wrongly_culled += inside && glm_vec3_dot( point, to_point ) < -1e-3f;
+        }
+    }
+    TEST_CHECK( wrongly_culled == 0 );
+
+    // Without the cone test only the frustum culls.
+    parameters.cone_culling = false;
+    TEST_CHECK( meshlet_cull( scene, parameters, 0, scene.meshlets_count, tasked.data() ) > visible_count );
+    parameters.cone_culling = true;
+
+    scene.shutdown();
+    file_unmap( &mapping );
+    file_delete( k_meshes_path );
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,153 @@
+#include "test.hpp"
+
+#include "foundation/gltf_accessor.hpp"
+#include "foundation/gltf_morph.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static const u32 k_vertex_count = 50000;
+static const u32 k_sparse_count = 300;          // Every 100th vertex from 5.
+static const u32 k_blend_repeat_count = 20;
+
+static bool is_sparse_vertex( u32 v ) {
+    return v % 100 == 5 && v / 100 < k_sparse_count;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    // Buffer views: base positions, dense deltas, sparse u16 indices, sparse values and dense normal deltas.
+    const u32 stream_size = k_vertex_count * 12;
+    std::vector<u8> buffer( stream_size * 3 + k_sparse_count * 14 );
+    f32* positions = ( f32* )buffer.data();
+    f32* dense_deltas = ( f32* )( buffer.data() + stream_size );
+    u16* sparse_indices = ( u16* )( buffer.data() + stream_size * 2 );
+    f32* sparse_values = ( f32* )( buffer.data() + stream_size * 2 + k_sparse_count * 2 );
+    f32* normal_deltas = ( f32* )( buffer.data() + stream_size * 2 + k_sparse_count * 14 );
+    for ( u32 i = 0; i < k_vertex_count * 3; ++i ) {
+        positions[ i ] = ( rand() % 1000 ) * 0.01f;
+        dense_deltas[ i ] = 0.0f;
+        normal_deltas[ i ] = 0.0f;
+    }
+    for ( u32 v = 0; v < k_vertex_count; v += 37 ) {
+        dense_deltas[ v * 3 ] = 1.0f;
+        dense_deltas[ v * 3 + 2 ] = -2.0f;
+    }
+    for ( u32 s = 0; s < k_sparse_count; ++s ) {
+        sparse_indices[ s ] = ( u16 )( s * 100 + 5 );
+        sparse_values[ s * 3 ] = 0.5f;
+        sparse_values[ s * 3 + 1 ] = ( f32 )s;
+        sparse_values[ s * 3 + 2 ] = 3.0f;
+    }
+    for ( u32 v = 0; v < k_vertex_count; v += 11 ) {
+        normal_deltas[ v * 3 + 1 ] = 1.0f;
+    }
+    u8* buffers_data[ 1 ] = { buffer.data() };
+
+    // Accessor 2 is only sparse, accessor 4 replaces elements of the base positions.
+    char text[ 4096 ];
+    snprintf( text, sizeof( text ), R"({"asset":{"version":"2.0"},"buffers":[{"uri":"morph.bin","byteLength":%u}],
+        "bufferViews":[{"buffer":0,"byteLength":%u},{"buffer":0,"byteOffset":%u,"byteLength":%u},{"buffer":0,"byteOffset":%u,"byteLength":%u},
+            {"buffer":0,"byteOffset":%u,"byteLength":%u},{"buffer":0,"byteOffset":%u,"byteLength":%u}],
+        "accessors":[{"bufferView":0,"componentType":5126,"count":%u,"type":"VEC3"},{"bufferView":1,"componentType":5126,"count":%u,"type":"VEC3"},
+            {"componentType":5126,"count":%u,"type":"VEC3","sparse":{"count":%u,"indices":{"bufferView":2,"componentType":5123},"values":{"bufferView":3}}},
+            {"bufferView":4,"componentType":5126,"count":%u,"type":"VEC3"},
+            {"bufferView":0,"componentType":5126,"count":%u,"type":"VEC3","sparse":{"count":%u,"indices":{"bufferView":2,"componentType":5123},"values":{"bufferView":3}}}],
+        "meshes":[{"primitives":[{"attributes":{"POSITION":0},"targets":[{"POSITION":1},{"POSITION":2,"NORMAL":3},{"NORMAL":3}]}],"weights":[0.5,0.25,1]}]})",
+              ( u32 )buffer.size(), stream_size, stream_size, stream_size, stream_size * 2, k_sparse_count * 2, stream_size * 2 + k_sparse_count * 2,
+              k_sparse_count * 12, stream_size * 2 + k_sparse_count * 14, stream_size, k_vertex_count, k_vertex_count, k_vertex_count, k_sparse_count,
+              k_vertex_count, k_vertex_count, k_sparse_count );
+
+    glTF::glTF gltf{ };
+    TEST_CHECK( gltf_parse_sax( text, strlen( text ), gltf ) );
+    const glTF::MeshPrimitive& primitive = gltf.meshes[ 0 ].primitives[ 0 ];
+    TEST_CHECK( primitive.targets_count == 3 && gltf.meshes[ 0 ].weights_count == 3 );
+    TEST_CHECK( gltf.accessors[ 2 ].sparse != nullptr && gltf.accessors[ 2 ].buffer_view == glTF::INVALID_INT_VALUE );
+
+    // Sparse substitutions over the base positions, then over zeros.
+    std::vector<f32> floats( k_vertex_count * 3 );
+    u32 differences = 0;
+    AccessorView substituted;
+    TEST_CHECK( substituted.init( gltf, 4, buffers_data ) && substituted.is_sparse() );
+    substituted.read_floats( floats.data() );
+    for ( u32 v = 0; v < k_vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            const f32 expected = is_sparse_vertex( v ) ? sparse_values[ ( v / 100 ) * 3 + c ] : positions[ v * 3 + c ];
+            differences += floats[ v * 3 + c ] != expected;
+        }
+    }
+
+    AccessorView sparse_only;
+    TEST_CHECK( sparse_only.init( gltf, 2, buffers_data ) && sparse_only.data == nullptr );
+    sparse_only.read_floats( floats.data() );
+    for ( u32 v = 0; v < k_vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            const f32 expected = is_sparse_vertex( v ) ? sparse_values[ ( v / 100 ) * 3 + c ] : 0.0f;
+            differences += floats[ v * 3 + c ] != expected;
+        }
+    }
+    TEST_CHECK( differences == 0 );
+
+    // Dense targets keep only the vertices they move, sparse ones their substitutions.
+    MorphTargetSet morph;
+    TEST_CHECK( morph.init( gltf, primitive, "POSITION", buffers_data, allocator ) );
+    TEST_CHECK( morph.targets_count == 3 && morph.targets[ 0 ].delta_count == ( k_vertex_count + 36 ) / 37 );
+    TEST_CHECK( morph.targets[ 1 ].delta_count == k_sparse_count && morph.targets[ 2 ].delta_count == 0 );
+    TEST_CHECK( morph.get_memory_size() < stream_size );
+
+    const f32 weights[ 3 ] = { 0.5f, 0.25f, 1.0f };
+    std::vector<f32> expected( k_vertex_count * 3 ), blended( k_vertex_count * 3 ), tasked( k_vertex_count * 3 );
+    for ( u32 v = 0; v < k_vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            f32 value = positions[ v * 3 + c ] + 0.5f * dense_deltas[ v * 3 + c ];
+            if ( is_sparse_vertex( v ) ) {
+                value += 0.25f * sparse_values[ ( v / 100 ) * 3 + c ];
+            }
+            expected[ v * 3 + c ] = value;
+        }
+    }
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 4 );
+
+    morph.blend( positions, weights, blended.data() );
+    morph.blend( positions, weights, tasked.data(), &task_scheduler );
+    for ( u32 i = 0; i < k_vertex_count * 3; ++i ) {
+        differences += fabsf( blended[ i ] - expected[ i ] ) > 1e-5f || blended[ i ] != tasked[ i ];
+    }
+    TEST_CHECK( differences == 0 );
+
+    i64 start = time_now();
+    for ( u32 r = 0; r < k_blend_repeat_count; ++r ) {
+        morph.blend( positions, weights, blended.data() );
+    }
+    const f64 blend_time = time_from_milliseconds( start ) / k_blend_repeat_count;
+    start = time_now();
+    for ( u32 r = 0; r < k_blend_repeat_count; ++r ) {
+        morph.blend( positions, weights, tasked.data(), &task_scheduler );
+    }
+    rprint( "%u vertices, deltas %zu bytes instead of %u: blend %.3f ms, with tasks %.3f ms\n", k_vertex_count, morph.get_memory_size(), stream_size * 3,
+            blend_time, time_from_milliseconds( start ) / k_blend_repeat_count );
+    morph.shutdown();
+
+    // The primitive has no base NORMAL.
+    MorphTargetSet normals;
+    TEST_CHECK( !normals.init( gltf, primitive, "NORMAL", buffers_data, allocator ) );
+
+    // A sparse index past the vertices is rejected.
+    sparse_indices[ k_sparse_count - 1 ] = ( u16 )( k_vertex_count + 5 );
+    MorphTargetSet out_of_range;
+    TEST_CHECK( !out_of_range.init( gltf, primitive, "POSITION", buffers_data, allocator ) );
+
+    gltf_free( gltf );
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
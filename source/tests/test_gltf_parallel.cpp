@@ -0,0 +1,66 @@
+#include "test.hpp"
+#include "test_gltf_scene.hpp"
+
+#include "foundation/file.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+
+using namespace syi;
+
+static cstring k_scene_path = "test_gltf_parallel.gltf";
+static const u32 k_scene_nodes = 20000;
+
+int main() {
+    test_init();
+
+    TEST_CHECK( test_write_gltf_scene( k_scene_path, k_scene_nodes ) );
+
+    i64 start = time_now();
+    glTF::glTF serial = gltf_load_file( k_scene_path, false );
+    rprint( "%u nodes, serial: %.2f ms, arena %zu bytes\n", k_scene_nodes, time_from_milliseconds( start ), serial.allocator.total_size );
+
+    // Chunks of root arrays parsed by tasks must give the serial result, whatever the thread count.
+    for ( u32 threads : { 1u, 2u, 4u, 8u } ) {
+        enki::TaskScheduler task_scheduler;
+        enki::TaskSchedulerConfig config;
+        config.numTaskThreadsToCreate = threads - 1;
+        task_scheduler.Initialize( config );
+
+        start = time_now();
+        glTF::glTF parallel = gltf_load_file( k_scene_path, false, &task_scheduler );
+        rprint( "%u threads: %.2f ms, arena %zu bytes\n", threads, time_from_milliseconds( start ), parallel.allocator.total_size );
+        TEST_CHECK( test_compare_gltf_scenes( serial, parallel ) == 0 );
+        gltf_free( parallel );
+
+        task_scheduler.WaitforAllAndShutdown();
+    }
+
+    gltf_free( serial );
+    file_delete( k_scene_path );
+
+    // Root members that are not object arrays, an empty array and skipped members.
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 4 );
+
+    cstring text = R"({"asset":{"version":"2.0","generator":"a\"b\n"},"extensionsUsed":["KHR_x"],"nodes":[{"children":[],"extensions":{"KHR_x":{"a":[1,[2,{}]]}},"name":"n"},{"mesh":0}],
+        "meshes":[{"primitives":[{"attributes":{"POSITION":0},"targets":[{"POSITION":1}]}]}],"accessors":[{"count":3,"type":"VEC3","max":[1e3,-2.5,0]}],"scene":  1 , "scenes": [] })";
+    glTF::glTF tasked{ };
+    glTF::glTF reference{ };
+    TEST_CHECK( gltf_parse_sax( text, strlen( text ), tasked, &task_scheduler ) );
+    TEST_CHECK( gltf_parse_sax( text, strlen( text ), reference ) );
+    TEST_CHECK( tasked.scene == 1 && tasked.scenes_count == 0 && tasked.nodes_count == 2 && strcmp( tasked.asset.generator.data, "a\"b\n" ) == 0 );
+    TEST_CHECK( tasked.meshes_count == 1 && tasked.meshes[ 0 ].primitives[ 0 ].attributes[ 0 ].accessor_index == 0 );
+    TEST_CHECK( tasked.accessors_count == 1 && tasked.accessors[ 0 ].max[ 0 ] == reference.accessors[ 0 ].max[ 0 ] );
+    gltf_free( reference );
+    gltf_free( tasked );
+
+    // Malformed documents, and roots that are not an object.
+    for ( cstring malformed_text : { R"({"nodes":[{"mesh":1,}]})", "8", "true", R"("glTF")", "[1]", R"([{"nodes":[{"mesh":0}]}])" } ) {
+        glTF::glTF malformed{ };
+        TEST_CHECK( !gltf_parse_sax( malformed_text, strlen( malformed_text ), malformed, &task_scheduler ) );
+        gltf_free( malformed );
+    }
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
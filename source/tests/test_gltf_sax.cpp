@@ -0,0 +1,69 @@
+#include "test.hpp"
+#include "test_gltf_scene.hpp"
+
+#include "foundation/file.hpp"
+
+using namespace syi;
+
+static cstring k_scene_path = "test_gltf_sax.gltf";
+static const u32 k_scene_nodes = 3000;
+
+static bool parse( cstring text, glTF::glTF& out_gltf ) {
+    out_gltf = glTF::glTF{ };
+    return gltf_parse_sax( text, strlen( text ), out_gltf );
+}
+
+int main() {
+    test_init();
+
+    TEST_CHECK( test_write_gltf_scene( k_scene_path, k_scene_nodes ) );
+
+    i64 start = time_now();
+    glTF::glTF dom = gltf_load_file_dom( k_scene_path );
+    const f64 dom_time = time_from_milliseconds( start );
+
+    start = time_now();
+    glTF::glTF sax = gltf_load_file( k_scene_path, false );
+    const f64 sax_time = time_from_milliseconds( start );
+
+    TEST_CHECK( sax.nodes_count == k_scene_nodes );
+    TEST_CHECK( test_compare_gltf_scenes( dom, sax ) == 0 );
+    // The pre-scan bounds the arena, it should not be far above what is used.
+    TEST_CHECK( sax.allocator.allocated_size <= sax.allocator.total_size && sax.allocator.total_size < sax.allocator.allocated_size * 2 );
+    rprint( "%u nodes: DOM %.2f ms, SAX %.2f ms, arena %zu of %zu bytes\n", k_scene_nodes, dom_time, sax_time,
+            sax.allocator.allocated_size, sax.allocator.total_size );
+
+    gltf_free( sax );
+    gltf_free( dom );
+    file_delete( k_scene_path );
+
+    // Escapes, skipped members, empty arrays, sparse accessors and exponents.
+    glTF::glTF gltf;
+    TEST_CHECK( parse( R"({"asset":{"version":"2.0","generator":"a\"bé\n"},"extensionsUsed":["KHR_x"],
+        "nodes":[{"children":[],"extensions":{"KHR_x":{"a":[1,[2,{}]]}},"name":"n"},{"mesh":0}],
+        "meshes":[{"primitives":[{"attributes":{"POSITION":0},"targets":[{"POSITION":1}]}]}],
+        "accessors":[{"count":3,"type":"VEC3","sparse":{"count":1,"indices":{"bufferView":0,"componentType":5123},"values":{"bufferView":1}},"max":[1e3,-2.5,0]}],"scene":0 })", gltf ) );
+    TEST_CHECK( strcmp( gltf.asset.generator.data, "a\"b\xc3\xa9\n" ) == 0 );
+    TEST_CHECK( gltf.nodes_count == 2 && gltf.nodes[ 0 ].children_count == 0 && strcmp( gltf.nodes[ 0 ].name.data, "n" ) == 0 && gltf.nodes[ 1 ].mesh == 0 );
+    TEST_CHECK( gltf.meshes[ 0 ].primitives[ 0 ].targets_count == 1 && gltf.meshes[ 0 ].primitives[ 0 ].targets[ 0 ].attributes[ 0 ].accessor_index == 1 );
+    TEST_CHECK( gltf.accessors[ 0 ].max[ 0 ] == 1000.0f && gltf.accessors[ 0 ].max[ 1 ] == -2.5f );
+    TEST_CHECK( gltf.accessors[ 0 ].sparse && gltf.accessors[ 0 ].sparse->count == 1 && gltf.accessors[ 0 ].sparse->indices.component_type == 5123 );
+    gltf_free( gltf );
+
+    // Optional material members stay null.
+    TEST_CHECK( parse( R"({"materials":[{"name":"m","doubleSided":true,"pbrMetallicRoughness":{"baseColorFactor":[1,0.5],"baseColorTexture":{"index":0}},
+        "normalTexture":{"index":1,"scale":2.0}}]})", gltf ) );
+    const glTF::Material& material = gltf.materials[ 0 ];
+    TEST_CHECK( material.double_sided && material.normal_texture && material.normal_texture->scale == 2.0f );
+    TEST_CHECK( material.emissive_texture == nullptr && material.occlusion_texture == nullptr && material.pbr_metallic_roughness->metallic_roughness_texture == nullptr );
+    TEST_CHECK( material.pbr_metallic_roughness->base_color_factor_count == 2 && material.pbr_metallic_roughness->base_color_texture->index == 0 );
+    gltf_free( gltf );
+
+    // Malformed documents, and roots that are not an object.
+    for ( cstring text : { R"({"nodes":[{"mesh":1,}]})", "8", "true", "null", R"("glTF")", "[1]", R"([{"nodes":[]}])", "[]" } ) {
+        TEST_CHECK( !parse( text, gltf ) );
+        gltf_free( gltf );
+    }
+
+    return test_shutdown();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "foundation/gltf.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+// Test scenes ////////////////////////////////////////////////////////////
+//
+// A generated glTF with every root array the loaders read, sized by its node count,
+// and a comparison of two loaded scenes for the loaders that must agree.
+namespace syi {
+
+    static const u32                k_test_scene_meshes     = 50;
+    static const u32                k_test_scene_materials  = 5;
+
+    // Returns false if the file could not be written.
+    inline bool test_write_gltf_scene( cstring path, u32 nodes_count ) {
+        FILE* file = fopen( path, "wb" );
+        if ( file == nullptr ) {
+            return false;
+        }
+
+        fprintf( file, "{\"asset\":{\"version\":\"2.0\",\"generator\":\"syi tests\",\"copyright\":\"none\"},\"scene\":0,\"scenes\":[{\"nodes\":[" );
+        for ( u32 n = 0; n < nodes_count; ++n ) {
+            fprintf( file, n ? ",%u" : "%u", n );
+        }
+
+        fprintf( file, "]}],\n\"nodes\":[" );
+        for ( u32 n = 0; n < nodes_count; ++n ) {
+            fprintf( file, "%s{\"mesh\":%u,\"name\":\"node%u\",\"translation\":[%u,1.0,2.0],\"rotation\":[0,0,0,1]", n ? ",\n" : "", n % k_test_scene_meshes, n, n );
+            if ( n % 10 == 0 && n + 2 < nodes_count ) {
+                fprintf( file, ",\"children\":[%u,%u]", n + 1, n + 2 );
+            }
+            fprintf( file, n == 0 ? ",\"extensions\":{\"EXT_unknown\":{\"values\":[1,[2,{}]]}}}" : "}" );
+        }
+
+        fprintf( file, "],\n\"meshes\":[" );
+        for ( u32 m = 0; m < k_test_scene_meshes; ++m ) {
+            fprintf( file, "%s{\"name\":\"mesh%u\",\"primitives\":[{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"material\":%u,\"mode\":4}]}",
+                     m ? ",\n" : "", m, m * 3, m * 3 + 1, m * 3 + 2, k_test_scene_meshes * 3 + m, m % k_test_scene_materials );
+        }
+
+        fprintf( file, "],\n\"accessors\":[" );
+        for ( u32 a = 0; a < k_test_scene_meshes * 3; ++a ) {
+            fprintf( file, "%s{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\",\"max\":[1,1,%u],\"min\":[0,0,0]}", a ? ",\n" : "", a );
+        }
+        for ( u32 m = 0; m < k_test_scene_meshes; ++m ) {
+            fprintf( file, ",\n{\"bufferView\":1,\"componentType\":5125,\"count\":3,\"type\":\"SCALAR\",\"max\":[2],\"min\":[0]}" );
+        }
+
+        fprintf( file, "],\n\"bufferViews\":[{\"buffer\":0,\"byteLength\":36,\"target\":34962},{\"buffer\":0,\"byteOffset\":36,\"byteLength\":12,\"target\":34963}],\n" );
+        fprintf( file, "\"buffers\":[{\"byteLength\":48,\"uri\":\"data.bin\"}],\n\"materials\":[" );
+        for ( u32 m = 0; m < k_test_scene_materials; ++m ) {
+            fprintf( file, "%s{\"name\":\"material%u\",\"alphaMode\":\"OPAQUE\",\"doubleSided\":true,\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,0.5,0.5,1],"
+                           "\"baseColorTexture\":{\"index\":0},\"metallicFactor\":0.5,\"roughnessFactor\":0.25},\"normalTexture\":{\"index\":1,\"scale\":%u.5}}",
+                     m ? ",\n" : "", m, m );
+        }
+
+        fprintf( file, "],\n\"textures\":[{\"sampler\":0,\"source\":0},{\"sampler\":0,\"source\":1}],\"images\":[{\"uri\":\"a.png\"},{\"uri\":\"b \\\"quoted\\\" \\u00e9.png\"}],\n" );
+        fprintf( file, "\"samplers\":[{\"magFilter\":9729,\"minFilter\":9987,\"wrapS\":10497,\"wrapT\":10497}],\"skins\":[{\"joints\":[1,2,3],\"inverseBindMatrices\":5}],\n" );
+        fprintf( file, "\"animations\":[{\"samplers\":[{\"input\":1,\"output\":2,\"interpolation\":\"LINEAR\"}],\"channels\":[{\"sampler\":0,\"target\":{\"node\":1,\"path\":\"rotation\"}}]}],\n" );
+        fprintf( file, "\"cameras\":[{\"type\":\"perspective\",\"perspective\":{\"yfov\":0.8,\"znear\":0.1}}]}\n" );
+
+        fclose( file );
+        return true;
+    }
+
+    inline bool test_equal_strings( const StringBuffer& a, const StringBuffer& b ) {
+        if ( a.data == nullptr || b.data == nullptr ) {
+            return a.data == b.data;
+        }
+        return strcmp( a.data, b.data ) == 0;
+    }
+
+    template <typename T>
+    inline bool test_equal_arrays( const T* a, u32 a_count, const T* b, u32 b_count ) {
+        return a_count == b_count && ( a_count == 0 || memcmp( a, b, sizeof( T ) * a_count ) == 0 );
+    }
+
+    // Returns the number of differences between the members the generated scene sets.
+    inline u32 test_compare_gltf_scenes( const glTF::glTF& a, const glTF::glTF& b ) {
+        if ( a.nodes_count != b.nodes_count || a.meshes_count != b.meshes_count || a.accessors_count != b.accessors_count ||
+             a.materials_count != b.materials_count || a.images_count != b.images_count ) {
+            return 1;
+        }
+
+        u32 differences = 0;
+        for ( u32 n = 0; n < a.nodes_count; ++n ) {
+            const glTF::Node& x = a.nodes[ n ];
+            const glTF::Node& y = b.nodes[ n ];
+            differences += x.mesh != y.mesh || x.skin != y.skin || x.camera != y.camera || !test_equal_strings( x.name, y.name ) ||
+                           !test_equal_arrays( x.translation, x.translation_count, y.translation, y.translation_count ) ||
+                           !test_equal_arrays( x.rotation, x.rotation_count, y.rotation, y.rotation_count ) ||
+                           !test_equal_arrays( x.children, x.children_count, y.children, y.children_count );
+        }
+
+        for ( u32 m = 0; m < a.meshes_count; ++m ) {
+            const glTF::MeshPrimitive& x = a.meshes[ m ].primitives[ 0 ];
+            const glTF::MeshPrimitive& y = b.meshes[ m ].primitives[ 0 ];
+            differences += x.indices != y.indices || x.material != y.material || x.mode != y.mode || x.attribute_count != y.attribute_count;
+            for ( u32 i = 0; i < x.attribute_count && x.attribute_count == y.attribute_count; ++i ) {
+                differences += gltf_get_attribute_accessor_index( y.attributes, y.attribute_count, x.attributes[ i ].key.data ) != x.attributes[ i ].accessor_index;
+            }
+        }
+
+        for ( u32 m = 0; m < a.materials_count; ++m ) {
+            const glTF::Material& x = a.materials[ m ];
+            const glTF::Material& y = b.materials[ m ];
+            differences += !test_equal_strings( x.name, y.name ) || !test_equal_strings( x.alpha_mode, y.alpha_mode ) || x.double_sided != y.double_sided ||
+                           x.pbr_metallic_roughness->base_color_texture->index != y.pbr_metallic_roughness->base_color_texture->index ||
+                           x.pbr_metallic_roughness->roughness_factor != y.pbr_metallic_roughness->roughness_factor ||
+                           !test_equal_arrays( x.pbr_metallic_roughness->base_color_factor, x.pbr_metallic_roughness->base_color_factor_count,
+                                               y.pbr_metallic_roughness->base_color_factor, y.pbr_metallic_roughness->base_color_factor_count ) ||
+                           x.normal_texture->scale != y.normal_texture->scale || y.emissive_texture != nullptr || y.occlusion_texture != nullptr;
+        }
+
+        for ( u32 i = 0; i < a.accessors_count; ++i ) {
+            const glTF::Accessor& x = a.accessors[ i ];
+            const glTF::Accessor& y = b.accessors[ i ];
+            differences += x.type != y.type || x.count != y.count || x.component_type != y.component_type || x.buffer_view != y.buffer_view ||
+                           x.byte_offset != y.byte_offset || x.normalized != y.normalized ||
+                           !test_equal_arrays( x.max, x.max_count, y.max, y.max_count ) || !test_equal_arrays( x.min, x.min_count, y.min, y.min_count );
+        }
+
+        for ( u32 i = 0; i < a.images_count; ++i ) {
+            differences += !test_equal_strings( a.images[ i ].uri, b.images[ i ].uri );
+        }
+
+        differences += !test_equal_strings( a.asset.version, b.asset.version ) || !test_equal_strings( a.asset.copyright, b.asset.copyright ) ||
+                       !test_equal_strings( a.buffers[ 0 ].uri, b.buffers[ 0 ].uri ) || a.buffer_views[ 1 ].byte_offset != b.buffer_views[ 1 ].byte_offset ||
+                       a.samplers[ 0 ].min_filter != b.samplers[ 0 ].min_filter || a.scene != b.scene ||
+                       !test_equal_arrays( a.skins[ 0 ].joints, a.skins[ 0 ].joints_count, b.skins[ 0 ].joints, b.skins[ 0 ].joints_count ) ||
+                       a.animations[ 0 ].channels[ 0 ].target_type != b.animations[ 0 ].channels[ 0 ].target_type ||
+                       a.animations[ 0 ].channels[ 0 ].target_node != b.animations[ 0 ].channels[ 0 ].target_node ||
+                       !test_equal_arrays( a.scenes[ 0 ].nodes, a.scenes[ 0 ].nodes_count, b.scenes[ 0 ].nodes, b.scenes[ 0 ].nodes_count );
+        return differences;
+    }
+
+} // namespace syi
@@ -0,0 +1,254 @@
+#include "test.hpp"
+
+#include "foundation/gltf_animation.hpp"
+#include "foundation/gltf_skinning.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/cglm/cglm.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static const u32 k_skin_count = 50;
+static const u32 k_joint_count = 40;
+static const u32 k_node_count = k_skin_count * k_joint_count;
+static const u32 k_vertex_count = 100000;
+static const u32 k_repeat_count = 20;
+
+static f32 random_float() {
+    return rand() / ( f32 )RAND_MAX * 2.0f - 1.0f;
+}
+
+static void random_quaternion( f32* q ) {
+    CGLM_ALIGN( 16 ) versor random = { random_float(), random_float(), random_float(), random_float() };
+    glm_quat_normalize( random );
+    memcpy( q, random, sizeof( versor ) );
+}
+
+static f32 max_difference( const mat4s& a, const mat4s& b ) {
+    f32 difference = 0.0f;
+    for ( u32 i = 0; i < 16; ++i ) {
+        difference = fmaxf( difference, fabsf( a.raw[ i / 4 ][ i % 4 ] - b.raw[ i / 4 ][ i % 4 ] ) );
+    }
+    return difference;
+}
+
+// World matrix from the node transforms, parents first by recursion.
+static void reference_world( const std::vector<glTF::Node>& nodes, const std::vector<i32>& parents, u32 n, std::vector<bool>& done, std::vector<mat4s>& world ) {
+    if ( done[ n ] ) {
+        return;
+    }
+
+    const glTF::Node& node = nodes[ n ];
+    mat4 translation, rotation, scale, local;
+    glm_translate_make( translation, node.translation );
+    CGLM_ALIGN( 16 ) versor q;
+    memcpy( q, node.rotation, sizeof( versor ) );
+    glm_quat_mat4( q, rotation );
+    glm_scale_make( scale, node.scale );
+    glm_mat4_mul( translation, rotation, local );
+    glm_mat4_mul( local, scale, local );
+
+    if ( parents[ n ] < 0 ) {
+        glm_mat4_copy( local, world[ n ].raw );
+    } else {
+        reference_world( nodes, parents, parents[ n ], done, world );
+        glm_mat4_mul( world[ parents[ n ] ].raw, local, world[ n ].raw );
+    }
+    done[ n ] = true;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    // Random trees of joints. Odd skins number their joints backwards, children before their parents.
+    std::vector<glTF::Node> nodes( k_node_count );
+    std::vector<f32> transforms( k_node_count * 10 );
+    std::vector<std::vector<i32>> children( k_node_count );
+    std::vector<i32> parents( k_node_count, -1 );
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        glTF::Node& node = nodes[ n ];
+        memset( &node, 0, sizeof( node ) );
+        node.mesh = node.camera = node.skin = glTF::INVALID_INT_VALUE;
+
+        f32* transform = &transforms[ n * 10 ];
+        for ( u32 c = 0; c < 3; ++c ) {
+            transform[ c ] = random_float();
+            transform[ 7 + c ] = 1.0f + 0.5f * random_float();
+        }
+        random_quaternion( transform + 3 );
+        node.translation = transform;
+        node.translation_count = 3;
+        node.rotation = transform + 3;
+        node.rotation_count = 4;
+        node.scale = transform + 7;
+        node.scale_count = 3;
+    }
+
+    for ( u32 s = 0; s < k_skin_count; ++s ) {
+        auto node_of = [&]( u32 j ) { return s * k_joint_count + ( s % 2 ? k_joint_count - 1 - j : j ); };
+        for ( u32 j = 1; j < k_joint_count; ++j ) {
+            const u32 parent = node_of( rand() % j );
+            children[ parent ].push_back( node_of( j ) );
+            parents[ node_of( j ) ] = parent;
+        }
+    }
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        nodes[ n ].children = children[ n ].empty() ? nullptr : children[ n ].data();
+        nodes[ n ].children_count = ( u32 )children[ n ].size();
+    }
+
+    glTF::glTF gltf{ };
+    gltf.nodes = nodes.data();
+    gltf.nodes_count = k_node_count;
+
+    NodeHierarchy hierarchy;
+    hierarchy.init( gltf, allocator );
+    AnimationPose pose;
+    pose.init( gltf, allocator );
+
+    std::vector<mat4s> world( k_node_count ), expected( k_node_count );
+    std::vector<bool> done( k_node_count, false );
+    hierarchy.compute_world_matrices( pose, world.data() );
+    f32 max_error = 0.0f;
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        reference_world( nodes, parents, n, done, expected );
+        max_error = fmaxf( max_error, max_difference( world[ n ], expected[ n ] ) );
+        TEST_CHECK( hierarchy.parents[ n ] == parents[ n ] );
+    }
+    TEST_CHECK( max_error < 1e-4f );
+
+    // Inverse bind matrices of the rest pose, one skin per tree.
+    std::vector<f32> inverse_binds( k_node_count * 16 );
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        glm_mat4_inv( world[ n ].raw, ( vec4* )&inverse_binds[ n * 16 ] );
+    }
+
+    glTF::Buffer buffer{ };
+    buffer.byte_length = k_node_count * 64;
+    glTF::BufferView view{ };
+    view.byte_length = k_node_count * 64;
+    view.byte_stride = glTF::INVALID_INT_VALUE;
+    std::vector<glTF::Accessor> accessors( k_skin_count );
+    std::vector<glTF::Skin> skins( k_skin_count );
+    std::vector<i32> joints( k_node_count );
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        joints[ n ] = n;
+    }
+    for ( u32 s = 0; s < k_skin_count; ++s ) {
+        memset( &accessors[ s ], 0, sizeof( glTF::Accessor ) );
+        accessors[ s ].byte_offset = s * k_joint_count * 64;
+        accessors[ s ].component_type = glTF::Accessor::FLOAT;
+        accessors[ s ].type = glTF::Accessor::Mat4;
+        accessors[ s ].count = k_joint_count;
+
+        skins[ s ].joints = &joints[ s * k_joint_count ];
+        skins[ s ].joints_count = k_joint_count;
+        skins[ s ].inverse_bind_matrices_buffer_index = s;
+        skins[ s ].skeleton_root_node_index = glTF::INVALID_INT_VALUE;
+    }
+    gltf.buffers = &buffer;
+    gltf.buffers_count = 1;
+    gltf.buffer_views = &view;
+    gltf.buffer_views_count = 1;
+    gltf.accessors = accessors.data();
+    gltf.accessors_count = k_skin_count;
+    gltf.skins = skins.data();
+    gltf.skins_count = k_skin_count;
+    u8* buffers_data[ 1 ] = { ( u8* )inverse_binds.data() };
+
+    SkinPalettes skin_palettes;
+    TEST_CHECK( skin_palettes.init( gltf, buffers_data, allocator ) && skin_palettes.palette_size == k_node_count );
+    TEST_CHECK( skin_palettes.palette_offsets[ 1 ] == k_joint_count && skin_palettes.palette_offsets[ k_skin_count ] == k_node_count );
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 4 );
+
+    // The rest pose gives identity joint matrices.
+    std::vector<mat4s> palette( skin_palettes.palette_size ), tasked_palette( skin_palettes.palette_size );
+    skin_palettes.compute_palettes( world.data(), palette.data(), &task_scheduler );
+    mat4s identity;
+    glm_mat4_identity( identity.raw );
+    max_error = 0.0f;
+    for ( u32 i = 0; i < skin_palettes.palette_size; ++i ) {
+        max_error = fmaxf( max_error, max_difference( palette[ i ], identity ) );
+    }
+    TEST_CHECK( max_error < 1e-3f );
+
+    // Animated pose, then skinning against a reference.
+    for ( u32 n = 0; n < k_node_count; ++n ) {
+        pose.translations[ n ].x += 0.3f;
+        random_quaternion( pose.rotations[ n ].raw );
+    }
+    hierarchy.compute_world_matrices( pose, world.data() );
+    skin_palettes.compute_palettes( world.data(), palette.data() );
+    skin_palettes.compute_palettes( world.data(), tasked_palette.data(), &task_scheduler );
+    TEST_CHECK( memcmp( palette.data(), tasked_palette.data(), palette.size() * sizeof( mat4s ) ) == 0 );
+
+    std::vector<f32> positions( k_vertex_count * 3 ), normals( k_vertex_count * 3 ), weights( k_vertex_count * 4 );
+    std::vector<f32> skinned_positions( k_vertex_count * 3 ), skinned_normals( k_vertex_count * 3 );
+    std::vector<f32> tasked_positions( k_vertex_count * 3 ), tasked_normals( k_vertex_count * 3 );
+    std::vector<u16> vertex_joints( k_vertex_count * 4 );
+    for ( u32 v = 0; v < k_vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            positions[ v * 3 + c ] = random_float();
+            normals[ v * 3 + c ] = random_float();
+        }
+        f32 sum = 0.0f;
+        for ( u32 k = 0; k < 4; ++k ) {
+            vertex_joints[ v * 4 + k ] = ( u16 )( rand() % k_joint_count );
+            weights[ v * 4 + k ] = k == 3 && v % 3 ? 0.0f : rand() / ( f32 )RAND_MAX;
+            sum += weights[ v * 4 + k ];
+        }
+        for ( u32 k = 0; k < 4; ++k ) {
+            weights[ v * 4 + k ] /= sum;
+        }
+    }
+
+    skin_vertices_cpu( palette.data(), positions.data(), normals.data(), vertex_joints.data(), weights.data(), k_vertex_count,
+                       skinned_positions.data(), skinned_normals.data() );
+    skin_vertices_cpu( palette.data(), positions.data(), normals.data(), vertex_joints.data(), weights.data(), k_vertex_count,
+                       tasked_positions.data(), tasked_normals.data(), &task_scheduler );
+    TEST_CHECK( skinned_positions == tasked_positions && skinned_normals == tasked_normals );
+
+    max_error = 0.0f;
+    for ( u32 v = 0; v < k_vertex_count; ++v ) {
+        f32 reference[ 3 ] = { };
+        for ( u32 k = 0; k < 4; ++k ) {
+            vec3 transformed;
+            glm_mat4_mulv3( palette[ vertex_joints[ v * 4 + k ] ].raw, &positions[ v * 3 ], 1.0f, transformed );
+            for ( u32 c = 0; c < 3; ++c ) {
+                reference[ c ] += weights[ v * 4 + k ] * transformed[ c ];
+            }
+        }
+        for ( u32 c = 0; c < 3; ++c ) {
+            max_error = fmaxf( max_error, fabsf( reference[ c ] - skinned_positions[ v * 3 + c ] ) );
+        }
+    }
+    TEST_CHECK( max_error < 1e-3f );
+
+    i64 start = time_now();
+    for ( u32 r = 0; r < k_repeat_count; ++r ) {
+        skin_vertices_cpu( palette.data(), positions.data(), normals.data(), vertex_joints.data(), weights.data(), k_vertex_count,
+                           skinned_positions.data(), skinned_normals.data() );
+    }
+    const f64 skinning_time = time_from_milliseconds( start ) / k_repeat_count;
+    start = time_now();
+    for ( u32 r = 0; r < k_repeat_count; ++r ) {
+        hierarchy.compute_world_matrices( pose, world.data() );
+        skin_palettes.compute_palettes( world.data(), palette.data() );
+    }
+    rprint( "Skinning %u vertices %.3f ms, world matrices and palettes of %u joints %.3f ms, max position error %g\n", k_vertex_count, skinning_time,
+            k_node_count, time_from_milliseconds( start ) / k_repeat_count, max_error );
+
+    skin_palettes.shutdown();
+    pose.shutdown();
+    hierarchy.shutdown();
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,139 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace syi;
+
+static const u32 k_stress_threads = 8;
+static const u32 k_stress_operations = 200000;
+
+// Small blocks of every size class and some over them, kept live for a while and freed out of order.
+// Each block is filled with the thread index, so that a block handed to two threads shows up.
+static void stress( Allocator* heap, u32 thread_index, std::atomic<u32>* corrupted ) {
+    std::vector<void*> blocks;
+    std::vector<u32> sizes;
+
+    for ( u32 i = 0; i < k_stress_operations; ++i ) {
+        const u32 size = 1 + ( i * 7919 + thread_index ) % 300;
+        void* block = heap->allocate( size, 1 );
+        memset( block, ( int )thread_index, size );
+        blocks.push_back( block );
+        sizes.push_back( size );
+
+        if ( blocks.size() > 64 ) {
+            const sizet index = ( i * 31 ) % blocks.size();
+            const u8* bytes = ( const u8* )blocks[ index ];
+            if ( bytes[ 0 ] != thread_index || bytes[ sizes[ index ] - 1 ] != thread_index ) {
+                corrupted->fetch_add( 1 );
+            }
+
+            heap->deallocate( blocks[ index ] );
+            blocks[ index ] = blocks.back();
+            sizes[ index ] = sizes.back();
+            blocks.pop_back();
+            sizes.pop_back();
+        }
+    }
+
+    for ( void* block : blocks ) {
+        heap->deallocate( block );
+    }
+}
+
+// Milliseconds for the stress to run on all the threads at once.
+static f64 stress_threads( Allocator* allocator, std::atomic<u32>* corrupted ) {
+    const i64 start = time_now();
+    std::vector<std::thread> threads;
+    for ( u32 t = 0; t < k_stress_threads; ++t ) {
+        threads.emplace_back( stress, allocator, t, corrupted );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    return time_from_milliseconds( start );
+}
+
+int main() {
+    test_init();
+
+    HeapAllocator heap;
+    heap.init( rmega( 64 ), true );
+    TEST_CHECK( ( ( uintptr_t )heap.thread_caches & 63 ) == 0 );
+
+    // Stress, with the time it takes, against malloc from the same threads.
+    std::atomic<u32> corrupted{ 0 };
+    std::vector<std::thread> threads;
+    const f64 heap_time = stress_threads( &heap, &corrupted );
+    MallocAllocator malloc_allocator;
+    const f64 malloc_time = stress_threads( &malloc_allocator, &corrupted );
+    TEST_CHECK( corrupted.load() == 0 );
+
+    // The same workloads one after the other, on a heap without locks nor thread caches.
+    HeapAllocator single_thread_heap;
+    single_thread_heap.init( rmega( 64 ) );
+    const i64 start = time_now();
+    for ( u32 t = 0; t < k_stress_threads; ++t ) {
+        stress( &single_thread_heap, t, &corrupted );
+    }
+    const f64 single_thread_time = time_from_milliseconds( start );
+    TEST_CHECK( corrupted.load() == 0 && single_thread_heap.allocated_size == 0 );
+    single_thread_heap.shutdown();
+
+    rprint( "%u threads, %u allocations each: thread safe heap %.2f ms, malloc %.2f ms; one thread, heap without locks %.2f ms\n",
+            k_stress_threads, k_stress_operations, heap_time, malloc_time, single_thread_time );
+
+    // Threads that exit release their slot, so short lived threads keep getting caches.
+    std::atomic<u32> without_cache{ 0 };
+    for ( u32 round = 0; round < 50; ++round ) {
+        for ( u32 t = 0; t < 8; ++t ) {
+            threads.emplace_back( [ & ]() {
+                if ( heap.get_thread_cache() == nullptr ) {
+                    without_cache.fetch_add( 1 );
+                }
+                void* blocks[ 100 ];
+                for ( u32 i = 0; i < 100; ++i ) {
+                    blocks[ i ] = heap.allocate( 32, 1 );
+                }
+                for ( u32 i = 0; i < 100; ++i ) {
+                    heap.deallocate( blocks[ i ] );
+                }
+            } );
+        }
+        for ( std::thread& thread : threads ) {
+            thread.join();
+        }
+        threads.clear();
+    }
+    TEST_CHECK( without_cache.load() == 0 );
+
+    // Live threads over the limit go to the locked pool.
+    const u32 live_threads = k_heap_max_threads + 6;
+    std::atomic<u32> ready{ 0 };
+    std::atomic<bool> go{ false };
+    without_cache = 0;
+    for ( u32 t = 0; t < live_threads; ++t ) {
+        threads.emplace_back( [ & ]() {
+            if ( heap.get_thread_cache() == nullptr ) {
+                without_cache.fetch_add( 1 );
+            }
+            ready.fetch_add( 1 );
+            while ( !go.load() ) {
+                std::this_thread::yield();
+            }
+        } );
+    }
+    while ( ready.load() < live_threads ) {
+        std::this_thread::yield();
+    }
+    go = true;
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    TEST_CHECK( without_cache.load() == live_threads - k_heap_max_threads );
+
+    heap.shutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,135 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace syi;
+
+static const sizet k_pool_size = rmega( 64 );
+static const u32 k_grow_threads = 4;
+
+// Committed pools, counted once each.
+static u32 count_pools( const HeapAllocator& heap ) {
+    u32 pools = 0;
+    for ( u32 i = 0; i < heap.pool_slot_count; ++i ) {
+        pools += heap.pool_slots[ i ].slot_count && heap.pool_slots[ i ].first_slot == i ? 1 : 0;
+    }
+    return pools;
+}
+
+// Blocks from 64 KB to 4 MB, enough for each thread to need pools of its own. Each block is
+// filled with the thread index, so that a block handed to two threads shows up.
+static void grow( HeapAllocator* heap, u32 thread_index, std::atomic<u32>* corrupted ) {
+    std::vector<void*> blocks;
+    std::vector<sizet> sizes;
+
+    for ( u32 i = 0; i < 160; ++i ) {
+        const sizet size = rkilo( 64 ) << ( ( i + thread_index ) % 7 );
+        void* block = heap->allocate( size, 16 );
+        if ( block == nullptr ) {
+            corrupted->fetch_add( 1 );
+            continue;
+        }
+        memset( block, ( int )thread_index, size );
+        blocks.push_back( block );
+        sizes.push_back( size );
+    }
+
+    for ( sizet b = 0; b < blocks.size(); ++b ) {
+        const u8* bytes = ( const u8* )blocks[ b ];
+        if ( bytes[ 0 ] != thread_index || bytes[ sizes[ b ] - 1 ] != thread_index ) {
+            corrupted->fetch_add( 1 );
+        }
+        heap->deallocate( blocks[ b ] );
+    }
+}
+
+int main() {
+    test_init();
+
+    HeapAllocator heap;
+    heap.init_growable( rgiga( 16ull ), k_pool_size );
+    TEST_CHECK( heap.committed_size == k_pool_size && count_pools( heap ) == 1 );
+
+    // Blocks that do not fit the first pool add pools, each block over a pool spans several slots.
+    std::vector<void*> blocks;
+    for ( u32 i = 0; i < 12; ++i ) {
+        void* block = heap.allocate( rmega( 24 ), 16 );
+        TEST_CHECK( block != nullptr );
+        memset( block, ( int )i, rmega( 24 ) );
+        blocks.push_back( block );
+    }
+    void* large = heap.allocate( rmega( 200 ), 16 );
+    TEST_CHECK( large && heap.get_pool_slot( large )->slot_count == 4 );
+    const u32 grown_pools = count_pools( heap );
+    rprint( "12 x 24 MB and 200 MB: %u pools, %llu MB committed\n", grown_pools, heap.committed_size / rmega( 1 ) );
+    TEST_CHECK( grown_pools > 2 && heap.committed_size >= rmega( 12 * 24 + 200 ) );
+
+    // Empty pools go back to the OS, but the last one emptied is kept as a spare.
+    heap.deallocate( large );
+    TEST_CHECK( heap.spare_pool_slot != u32_max && count_pools( heap ) == grown_pools );
+    for ( void* block : blocks ) {
+        heap.deallocate( block );
+    }
+    blocks.clear();
+    TEST_CHECK( heap.allocated_size == 0 && count_pools( heap ) == 2 && heap.spare_pool_slot != u32_max );
+    TEST_CHECK( heap.committed_size == k_pool_size + heap.pool_slots[ heap.spare_pool_slot ].slot_count * k_pool_size );
+
+    // A block that cannot grow in place moves to a new pool with its contents.
+    u8* moving = ( u8* )heap.allocate( rmega( 40 ), 16 );
+    u8* neighbour = ( u8* )heap.allocate( rmega( 16 ), 16 );
+    for ( u32 i = 0; i < rmega( 40 ); i += rkilo( 4 ) ) {
+        moving[ i ] = ( u8 )( i >> 12 );
+    }
+    const HeapPoolSlot* moving_pool = heap.get_pool_slot( moving );
+    u8* moved = ( u8* )heap.reallocate( moving, rmega( 40 ), rmega( 120 ), 16 );
+    TEST_CHECK( moved && heap.get_pool_slot( moved ) != moving_pool );
+    bool kept = moved != nullptr;
+    for ( u32 i = 0; kept && i < rmega( 40 ); i += rkilo( 4 ) ) {
+        kept = moved[ i ] == ( u8 )( i >> 12 );
+    }
+    TEST_CHECK( kept );
+    heap.deallocate( moved );
+    heap.deallocate( neighbour );
+    TEST_CHECK( heap.allocated_size == 0 && count_pools( heap ) == 2 );
+
+    // Over the TLSF maximum block size: no pool is added, and the heap keeps working.
+    const sizet committed_size = heap.committed_size;
+    TEST_CHECK( heap.allocate( rgiga( 5ull ), 16 ) == nullptr );
+    TEST_CHECK( heap.committed_size == committed_size && count_pools( heap ) == 2 );
+    void* block = heap.allocate( rmega( 1 ), 16 );
+    TEST_CHECK( block != nullptr );
+    heap.deallocate( block );
+    heap.shutdown();
+
+    // Past the reserved range.
+    HeapAllocator small_heap;
+    small_heap.init_growable( k_pool_size * 4, k_pool_size );
+    void* fits = small_heap.allocate( rmega( 100 ), 16 );
+    TEST_CHECK( fits != nullptr && small_heap.allocate( rmega( 200 ), 16 ) == nullptr );
+    small_heap.deallocate( fits );
+    small_heap.shutdown();
+
+    // Thread safe and growable: threads add pools concurrently, under the pool lock.
+    HeapAllocator shared_heap;
+    shared_heap.init_growable( rgiga( 4ull ), rmega( 16 ), true );
+    std::atomic<u32> corrupted{ 0 };
+    std::vector<std::thread> threads;
+    const i64 start = time_now();
+    for ( u32 t = 0; t < k_grow_threads; ++t ) {
+        threads.emplace_back( grow, &shared_heap, t, &corrupted );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    rprint( "%u threads growing the heap: %.2f ms, %llu MB committed after\n", k_grow_threads, time_from_milliseconds( start ),
+            shared_heap.committed_size / rmega( 1 ) );
+    TEST_CHECK( corrupted.load() == 0 );
+    shared_heap.flush_thread_caches();
+    TEST_CHECK( shared_heap.allocated_size == 0 && count_pools( shared_heap ) <= 2 );
+    shared_heap.shutdown();
+
+    return test_shutdown();
+}
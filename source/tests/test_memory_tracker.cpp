@@ -0,0 +1,123 @@
+#include "test.hpp"
+
+#include "foundation/memory_tracker.hpp"
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#if !defined (syi_MEMORY_TRACKING)
+#error "test_memory_tracker must be built with syi_MEMORY_TRACKING"
+#endif // syi_MEMORY_TRACKING
+
+using namespace syi;
+
+static const u32 k_thread_count = 4;
+static const u32 k_thread_block_count = 1000;
+
+// One call site per function: each ralloca records the file and line it is written on.
+static void* allocate_small( Allocator* allocator, sizet size )     { return ralloca( size, allocator ); }
+static void* allocate_large( Allocator* allocator, sizet size )     { return ralloca( size, allocator ); }
+static void* allocate_shared( Allocator* allocator, sizet size )    { return ralloca( size, allocator ); }
+static void* allocate_leaked( Allocator* allocator, sizet size )    { return ralloca( size, allocator ); }
+
+// Each thread keeps every other block, so the site ends with half of them live.
+static void allocate_from_thread( Allocator* allocator, u32 thread_index, std::vector<void*>* kept ) {
+    for ( u32 i = 0; i < k_thread_block_count; ++i ) {
+        void* block = allocate_shared( allocator, 64 + thread_index * 16 );
+        if ( i & 1 ) {
+            rfree( block, allocator );
+        } else {
+            kept->push_back( block );
+        }
+    }
+}
+
+static u32 s_leak_lines = 0;
+
+static void count_leak_lines( const char* text ) {
+    s_leak_lines += strncmp( text, "Leaked ", 7 ) == 0 && strstr( text, "test_memory_tracker.cpp" ) ? 1 : 0;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+    MemoryTracker* tracker = memory_tracker();
+
+    // Call sites are counted apart, with their peak.
+    void* small[ 3 ];
+    for ( u32 i = 0; i < 3; ++i ) {
+        small[ i ] = allocate_small( allocator, 100 );
+    }
+    void* large = allocate_large( allocator, rkilo( 64 ) );
+
+    MemoryCallSite* small_site = tracker->find_call_site( small[ 0 ] );
+    MemoryCallSite* large_site = tracker->find_call_site( large );
+    TEST_CHECK( small_site && large_site && small_site != large_site );
+    TEST_CHECK( small_site && tracker->find_call_site( small[ 2 ] ) == small_site && strstr( small_site->file.load(), "test_memory_tracker.cpp" ) );
+    TEST_CHECK( small_site && small_site->live_count.load() == 3 && small_site->live_bytes.load() == 300 && small_site->frame_count.load() == 3 );
+    TEST_CHECK( large_site && large_site->live_count.load() == 1 && large_site->live_bytes.load() == rkilo( 64 ) );
+
+    rfree( small[ 1 ], allocator );
+    TEST_CHECK( small_site && small_site->live_count.load() == 2 && small_site->live_bytes.load() == 200 && small_site->peak_bytes.load() == 300 );
+    TEST_CHECK( tracker->find_call_site( small[ 1 ] ) == nullptr );
+
+    // A reallocated block keeps its call site, with the new size. The move counts as an allocation of the frame.
+    void* grown = allocator->reallocate( small[ 0 ], 100, rkilo( 8 ), 1 );
+    TEST_CHECK( grown && tracker->find_call_site( grown ) == small_site );
+    TEST_CHECK( small_site && small_site->live_count.load() == 2 && small_site->live_bytes.load() == 100 + rkilo( 8 ) );
+    TEST_CHECK( grown == small[ 0 ] || tracker->find_call_site( small[ 0 ] ) == nullptr );
+
+    // Threads share a call site: the counters are updated without locks.
+    std::vector<void*> kept[ k_thread_count ];
+    std::vector<std::thread> threads;
+    for ( u32 t = 0; t < k_thread_count; ++t ) {
+        threads.emplace_back( allocate_from_thread, allocator, t, &kept[ t ] );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+
+    MemoryCallSite* shared_site = tracker->find_call_site( kept[ 0 ][ 0 ] );
+    sizet shared_bytes = 0;
+    for ( u32 t = 0; t < k_thread_count; ++t ) {
+        shared_bytes += kept[ t ].size() * ( 64 + t * 16 );
+        TEST_CHECK( tracker->find_call_site( kept[ t ].back() ) == shared_site );
+    }
+    TEST_CHECK( shared_site && shared_site->live_count.load() == k_thread_count * k_thread_block_count / 2 );
+    TEST_CHECK( shared_site && shared_site->live_bytes.load() == shared_bytes && shared_site->frame_count.load() == k_thread_count * k_thread_block_count );
+    TEST_CHECK( tracker->dropped_count.load() == 0 );
+
+    // Linear allocations are only churn: counted in the frame, never live.
+    LinearAllocator linear;
+    linear.init( rkilo( 4 ) );
+    void* transient = allocate_small( &linear, 100 );
+    TEST_CHECK( transient && small_site && small_site->live_count.load() == 2 && small_site->frame_count.load() == 5 );
+    linear.shutdown();
+
+    // The frame counters move to the last frame ones.
+    MemoryService::instance()->new_frame();
+    TEST_CHECK( small_site && small_site->last_frame_count == 5 && small_site->frame_count.load() == 0 && small_site->live_count.load() == 2 );
+    TEST_CHECK( shared_site && shared_site->last_frame_count == k_thread_count * k_thread_block_count );
+
+    // Only the call sites with live allocations are reported.
+    for ( u32 t = 0; t < k_thread_count; ++t ) {
+        for ( void* block : kept[ t ] ) {
+            rfree( block, allocator );
+        }
+    }
+    rfree( grown, allocator );
+    rfree( small[ 2 ], allocator );
+    rfree( large, allocator );
+    void* leaked = allocate_leaked( allocator, 48 );
+
+    LogService::instance()->set_callback( count_leak_lines );
+    tracker->report_leaks();
+    LogService::instance()->set_callback( nullptr );
+    TEST_CHECK( s_leak_lines == 1 );
+    TEST_CHECK( tracker->find_call_site( leaked ) && tracker->find_call_site( leaked )->live_bytes.load() == 48 );
+
+    rfree( leaked, allocator );
+    TEST_CHECK( small_site && small_site->live_count.load() == 0 && large_site && large_site->live_count.load() == 0 );
+    TEST_CHECK( shared_site && shared_site->live_bytes.load() == 0 );
+    return test_shutdown();
+}
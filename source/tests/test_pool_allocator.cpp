@@ -0,0 +1,143 @@
+#include "test.hpp"
+
+#include "foundation/pool_allocator.hpp"
+#include "foundation/array.hpp"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static const u32 k_replay_allocations = 300000;
+
+//
+// Share of the allocations of a Sponza load in a size range: names and short index arrays,
+// accessor bounds and attributes, nodes and primitives, materials, larger arrays, parser buffers,
+// then the buffers and images that go to the parent.
+struct SizeBucket {
+    u32                             min_size;
+    u32                             max_size;
+    u32                             percent;
+}; // struct SizeBucket
+
+static const SizeBucket k_sponza_sizes[] = {
+    { 1, 32, 35 }, { 33, 64, 25 }, { 65, 128, 18 }, { 129, 256, 10 }, { 257, 1024, 7 }, { 1025, 4096, 4 }, { 8192, 262144, 1 },
+};
+
+//
+// Allocation of size when free_index is u32_max, otherwise release of the block of allocation free_index.
+struct ReplayOperation {
+    u32                             size;
+    u32                             free_index;
+}; // struct ReplayOperation
+
+// Most frees are of the last blocks, the parser temporaries, some of older ones; what is left is freed with the scene.
+static void record_sponza_load( std::vector<ReplayOperation>& operations ) {
+    std::mt19937 random( 7 );
+    std::vector<u32> live;
+    for ( u32 i = 0; i < k_replay_allocations; ++i ) {
+        u32 percent = random() % 100;
+        const SizeBucket* bucket = k_sponza_sizes;
+        while ( percent >= bucket->percent ) {
+            percent -= bucket->percent;
+            ++bucket;
+        }
+        operations.push_back( { bucket->min_size + ( u32 )( random() % ( bucket->max_size - bucket->min_size + 1 ) ), u32_max } );
+        live.push_back( i );
+
+        if ( random() % 100 < 45 ) {
+            const sizet recent = live.size() < 8 ? live.size() : 8;
+            const sizet index = random() % 4 ? live.size() - 1 - random() % recent : random() % live.size();
+            operations.push_back( { 0, live[ index ] } );
+            live[ index ] = live.back();
+            live.pop_back();
+        }
+    }
+    for ( u32 index : live ) {
+        operations.push_back( { 0, index } );
+    }
+}
+
+static f64 time_replay( Allocator* allocator, const std::vector<ReplayOperation>& operations, std::vector<void*>& blocks ) {
+    u32 allocation_index = 0;
+    const i64 start = time_now();
+    for ( const ReplayOperation& operation : operations ) {
+        if ( operation.free_index == u32_max ) {
+            blocks[ allocation_index++ ] = allocator->allocate( operation.size, 16 );
+        } else {
+            allocator->deallocate( blocks[ operation.free_index ] );
+        }
+    }
+    return time_from_milliseconds( start );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    PoolAllocator pool;
+    pool.init( allocator );
+
+    // Random sizes and alignments, some over the largest class, freed in random order.
+    std::mt19937 random( 1 );
+    std::vector<u8*> blocks;
+    std::vector<sizet> sizes;
+    u32 misaligned = 0, corrupted = 0;
+    for ( u32 i = 0; i < 200000; ++i ) {
+        if ( blocks.size() && random() % 3 == 0 ) {
+            const sizet index = random() % blocks.size();
+            for ( sizet b = 0; b < sizes[ index ]; ++b ) {
+                corrupted += blocks[ index ][ b ] != ( u8 )sizes[ index ];
+            }
+            pool.deallocate( blocks[ index ] );
+            blocks[ index ] = blocks.back();
+            sizes[ index ] = sizes.back();
+            blocks.pop_back();
+            sizes.pop_back();
+            continue;
+        }
+
+        const sizet size = ( random() % 10 == 0 ) ? random() % 10000 + 1 : random() % 300 + 1;
+        const sizet alignment = sizet( 1 ) << ( random() % 7 );
+        u8* block = ( u8* )rallocaa( size, &pool, alignment );
+        misaligned += ( ( uintptr_t )block & ( alignment - 1 ) ) != 0;
+        memset( block, ( u8 )size, size );
+        blocks.push_back( block );
+        sizes.push_back( size );
+    }
+    TEST_CHECK( misaligned == 0 );
+    TEST_CHECK( corrupted == 0 );
+
+    // Any Allocator user works on top of the pool.
+    Array<u32> values;
+    values.init( &pool, 4 );
+    for ( u32 i = 0; i < 1000; ++i ) {
+        values.push( i );
+    }
+    TEST_CHECK( values.size == 1000 && values[ 999 ] == 999 );
+    values.shutdown();
+
+    for ( u8* block : blocks ) {
+        pool.deallocate( block );
+    }
+    TEST_CHECK( pool.allocated_size == 0 );
+
+    // Against the TLSF heap, single threaded, on the sizes and lifetimes of a scene load.
+    std::vector<ReplayOperation> operations;
+    record_sponza_load( operations );
+    std::vector<void*> replay_blocks( k_replay_allocations );
+
+    HeapAllocator heap;
+    heap.init( rmega( 128 ) );
+    const f64 heap_time = time_replay( &heap, operations, replay_blocks );
+    TEST_CHECK( heap.allocated_size == 0 );
+    heap.shutdown();
+
+    const f64 pool_time = time_replay( &pool, operations, replay_blocks );
+    TEST_CHECK( pool.allocated_size == 0 );
+    rprint( "Sponza load, %u allocations and frees: heap %.2f ms, pool %.2f ms, %llu KB of pool pages\n", k_replay_allocations, heap_time, pool_time,
+            ( u64 )pool.page_size_total / 1024 );
+
+    pool.shutdown();
+    return test_shutdown();
+}
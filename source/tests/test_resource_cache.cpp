@@ -0,0 +1,208 @@
+#include "test.hpp"
+
+#include "foundation/resource_manager.hpp"
+#include "foundation/texture_compiler.hpp"
+#include "foundation/gltf_blob.hpp"
+#include "foundation/file.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_texture_path = "test_resource_cache.tga";
+static cstring k_scene_path = "test_resource_cache.gltf";
+static cstring k_invalid_scene_path = "test_resource_cache_invalid.gltf";
+static cstring k_cache_directory = "test_resource_cache_cache";
+static const u32 k_width = 256;
+static const u32 k_height = 192;
+
+// Resources only remembering the path they were created from, the cached output.
+struct TestTexture : public Resource {
+    static u64                      k_type_hash;
+    char                            path[ k_max_path ];
+}; // struct TestTexture
+
+u64 TestTexture::k_type_hash = hash_calculate( TextureResourceCompiler::k_type );
+
+struct TestScene : public Resource {
+    static u64                      k_type_hash;
+    char                            path[ k_max_path ];
+}; // struct TestScene
+
+u64 TestScene::k_type_hash = hash_calculate( GltfBlobCompiler::k_type );
+
+// Holds a single resource, emptied before each load so that it goes through the cache.
+template <typename T>
+struct TestLoader : public ResourceLoader {
+
+    Resource*                       get( cstring name ) override        { return loaded ? &resource : nullptr; }
+    Resource*                       get( u64 hashed_name ) override     { return nullptr; }
+    Resource*                       unload( cstring name ) override     { loaded = false; return nullptr; }
+
+    Resource*                       create_from_file( cstring name, cstring filename, ResourceManager* resource_manager ) override {
+        snprintf( resource.path, k_max_path, "%s", filename );
+        loaded = true;
+        return &resource;
+    }
+
+    T                               resource;
+    bool                            loaded = false;
+}; // struct TestLoader
+
+struct TestFilenameResolver : public ResourceFilenameResolver {
+    cstring                         get_binary_path_from_name( cstring name ) override { return name; }
+}; // struct TestFilenameResolver
+
+// Uncompressed 32 bit TGA, bottom-up BGRA.
+static void write_tga( cstring path ) {
+    u8 header[ 18 ] = { };
+    header[ 2 ] = 2;
+    header[ 12 ] = k_width & 0xff;
+    header[ 13 ] = k_width >> 8;
+    header[ 14 ] = k_height & 0xff;
+    header[ 15 ] = k_height >> 8;
+    header[ 16 ] = 32;
+    header[ 17 ] = 8;
+
+    std::vector<u8> pixels( k_width * k_height * 4 );
+    for ( u32 i = 0; i < k_width * k_height; ++i ) {
+        const u32 x = i % k_width, y = i / k_width;
+        pixels[ i * 4 ] = ( u8 )x;
+        pixels[ i * 4 + 1 ] = ( u8 )( y * 255 / k_height );
+        pixels[ i * 4 + 2 ] = ( ( x / 32 + y / 32 ) & 1 ) ? 220 : 30;
+        pixels[ i * 4 + 3 ] = 255;
+    }
+
+    FILE* file = fopen( path, "wb" );
+    TEST_CHECK( file && fwrite( header, 1, sizeof( header ), file ) == sizeof( header ) && fwrite( pixels.data(), 1, pixels.size(), file ) == pixels.size() );
+    fclose( file );
+}
+
+static void write_text( cstring path, cstring text, cstring mode ) {
+    FILE* file = fopen( path, mode );
+    TEST_CHECK( file && fputs( text, file ) >= 0 );
+    fclose( file );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    write_tga( k_texture_path );
+    write_text( k_scene_path, R"({"asset":{"version":"2.0"},"scenes":[{"nodes":[0]}],"nodes":[{"name":"root"}]})", "wb" );
+
+    TestFilenameResolver resolver;
+    ResourceManager resource_manager;
+    resource_manager.init( allocator, &resolver, k_cache_directory );
+
+    TestLoader<TestTexture> texture_loader;
+    TestLoader<TestScene> scene_loader;
+    resource_manager.set_loader( TextureResourceCompiler::k_type, &texture_loader );
+    resource_manager.set_loader( GltfBlobCompiler::k_type, &scene_loader );
+
+    TextureCompileOptions texture_options;
+    texture_options.compression = TextureCompression_BC1;
+    TextureResourceCompiler texture_compiler;
+    texture_compiler.init( texture_options, allocator, nullptr );
+    resource_manager.set_compiler( TextureResourceCompiler::k_type, &texture_compiler );
+
+    GltfBlobCompiler scene_compiler;
+    scene_compiler.init( nullptr );
+    resource_manager.set_compiler( GltfBlobCompiler::k_type, &scene_compiler );
+
+    // Loads both resources again and checks the statistics, recording the cached outputs.
+    std::vector<std::string> outputs;
+    auto load = [&]( cstring label, u64 hits, u64 misses ) {
+        texture_loader.loaded = false;
+        scene_loader.loaded = false;
+        const i64 start = time_now();
+        TestTexture* texture = resource_manager.load<TestTexture>( k_texture_path );
+        TestScene* scene = resource_manager.load<TestScene>( k_scene_path );
+        const f64 load_time = time_from_milliseconds( start );
+        TEST_CHECK( texture && scene );
+        if ( texture == nullptr || scene == nullptr ) {
+            return;
+        }
+        outputs.push_back( texture->path );
+        outputs.push_back( scene->path );
+
+        const ResourceCacheStatistics statistics = resource_manager.get_cache_statistics();
+        TEST_CHECK( statistics.hits == hits && statistics.misses == misses && statistics.failed_compiles == 0 );
+        rprint( "%s: %.2f ms, hits %u misses %u\n", label, load_time, ( u32 )statistics.hits, ( u32 )statistics.misses );
+    };
+
+    load( "Cold", 0, 2 );
+    load( "Warm", 2, 2 );
+    TEST_CHECK( outputs[ 0 ] == outputs[ 2 ] && outputs[ 1 ] == outputs[ 3 ] );
+
+    // The cached scene is a blob of the source.
+    glTF::glTF gltf{ };
+    TEST_CHECK( gltf_load_blob( outputs[ 1 ].c_str(), gltf ) && gltf.scenes_count == 1 && gltf.nodes_count == 1 );
+    gltf_free( gltf );
+
+    // Options, version and source each change one key.
+    texture_compiler.options.compression = TextureCompression_BC7;
+    load( "Options changed", 3, 3 );
+    TEST_CHECK( outputs[ 4 ] != outputs[ 0 ] && outputs[ 5 ] == outputs[ 1 ] );
+
+    ++scene_compiler.version;
+    load( "Version bumped", 4, 4 );
+    TEST_CHECK( outputs[ 6 ] == outputs[ 4 ] && outputs[ 7 ] != outputs[ 5 ] );
+
+    write_text( k_scene_path, " ", "ab" );
+    load( "Source edited", 5, 5 );
+    TEST_CHECK( outputs[ 8 ] == outputs[ 4 ] && outputs[ 9 ] != outputs[ 7 ] );
+
+    // The glTF and texture loading functions hit the same entries, nothing is written next to the sources.
+    glTF::glTF cached_gltf = gltf_load_cached( k_scene_path, resource_manager );
+    TEST_CHECK( cached_gltf.blob_mapping.data != nullptr && cached_gltf.nodes_count == 1 );
+    gltf_free( cached_gltf );
+
+    FileMapping texture_mapping;
+    const TextureAssetBlob* cached_texture = texture_map_cached( k_texture_path, resource_manager, texture_mapping );
+    TEST_CHECK( cached_texture && cached_texture->width == k_width && cached_texture->compression == TextureCompression_BC7 );
+    if ( cached_texture ) {
+        file_unmap( &texture_mapping );
+    }
+
+    char sidecar_path[ k_max_path ];
+    gltf_blob_path( k_scene_path, sidecar_path, k_max_path );
+    ResourceCacheStatistics statistics = resource_manager.get_cache_statistics();
+    TEST_CHECK( statistics.hits == 7 && statistics.misses == 5 && !file_exists( sidecar_path ) );
+
+    // Without a resolver names are paths, without a cache the sources are read.
+    ResourceManager uncached_manager;
+    uncached_manager.init( allocator, nullptr );
+    uncached_manager.set_loader( TextureResourceCompiler::k_type, &texture_loader );
+    uncached_manager.set_compiler( TextureResourceCompiler::k_type, &texture_compiler );
+    texture_loader.loaded = false;
+    TestTexture* source_texture = uncached_manager.load<TestTexture>( k_texture_path );
+    TEST_CHECK( source_texture && strcmp( source_texture->path, k_texture_path ) == 0 );
+    TEST_CHECK( texture_map_cached( k_texture_path, uncached_manager, texture_mapping ) == nullptr );
+
+    glTF::glTF parsed_gltf = gltf_load_cached( k_scene_path, uncached_manager );
+    TEST_CHECK( parsed_gltf.blob_mapping.data == nullptr && parsed_gltf.nodes_count == 1 );
+    gltf_free( parsed_gltf );
+    uncached_manager.shutdown();
+
+    // A source that does not compile loads nothing, and is counted.
+    write_text( k_invalid_scene_path, "{oops", "wb" );
+    scene_loader.loaded = false;
+    TEST_CHECK( resource_manager.load<TestScene>( k_invalid_scene_path ) == nullptr );
+    statistics = resource_manager.get_cache_statistics();
+    TEST_CHECK( statistics.misses == 6 && statistics.failed_compiles == 1 );
+
+    resource_manager.shutdown();
+
+    for ( const std::string& output : outputs ) {
+        file_delete( output.c_str() );
+    }
+    directory_delete( k_cache_directory );
+    file_delete( k_invalid_scene_path );
+    file_delete( k_scene_path );
+    file_delete( k_texture_path );
+
+    return test_shutdown();
+}
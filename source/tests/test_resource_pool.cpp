@@ -0,0 +1,181 @@
+#include "test.hpp"
+
+#include "foundation/data_structures.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace syi;
+
+struct TestResource {
+    u32                             pool_index;
+    cstring                         name;
+    u32                             owner;
+}; // struct TestResource
+
+static const u32 k_threads = 8;
+static const u32 k_operations = 200000;
+
+// Each thread obtains up to 300 resources, then checks and releases all of them.
+// A resource seen by another thread, or a handle still alive after its release, is an error.
+static void churn( ResourcePoolTyped<TestResource>* pool, std::mutex* mutex, u32 thread_index, std::atomic<u32>* errors ) {
+    std::vector<u32> handles;
+    for ( u32 i = 0; i < k_operations; ++i ) {
+        if ( handles.size() < 300 ) {
+            if ( mutex ) mutex->lock();
+            TestResource* resource = pool->obtain();
+            if ( mutex ) mutex->unlock();
+
+            resource->owner = thread_index;
+            handles.push_back( resource->pool_index );
+            continue;
+        }
+
+        for ( u32 handle : handles ) {
+            TestResource* resource = pool->get( handle );
+            if ( resource == nullptr || resource->owner != thread_index ) {
+                errors->fetch_add( 1 );
+            }
+
+            if ( mutex ) mutex->lock();
+            pool->release_resource( handle );
+            if ( mutex ) mutex->unlock();
+
+            if ( pool->get( handle ) ) {
+                errors->fetch_add( 1 );
+            }
+        }
+        handles.clear();
+    }
+
+    for ( u32 handle : handles ) {
+        pool->release_resource( handle );
+    }
+}
+
+static const u32 k_grow_chunk_size = 8;
+static const u32 k_grow_max_size = 1000;
+static const u32 k_grow_resources = 100;       // Per thread, 800 in all: the pool grows a hundred times.
+
+// Obtains resources while the other threads grow the pool, then checks that the earliest ones did not move.
+static void grow( ResourcePoolTyped<TestResource>* pool, u32 thread_index, std::vector<TestResource*>* resources, std::atomic<u32>* errors ) {
+    for ( u32 i = 0; i < k_grow_resources; ++i ) {
+        TestResource* resource = pool->obtain();
+        if ( resource == nullptr ) {
+            errors->fetch_add( 1 );
+            continue;
+        }
+        resource->owner = thread_index;
+        resource->name = "grow";
+        resources->push_back( resource );
+    }
+
+    for ( TestResource* resource : *resources ) {
+        if ( pool->get( resource->pool_index ) != resource || resource->owner != thread_index ) {
+            errors->fetch_add( 1 );
+        }
+    }
+}
+
+// Time of the churn on all the threads, obtain and release under a mutex or lock free.
+static f64 time_churn( ResourcePoolTyped<TestResource>* pool, std::mutex* mutex, std::atomic<u32>* errors ) {
+    const i64 start = time_now();
+    std::vector<std::thread> threads;
+    for ( u32 t = 0; t < k_threads; ++t ) {
+        threads.emplace_back( churn, pool, mutex, t, errors );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    return time_from_milliseconds( start );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    ResourcePoolTyped<TestResource> pool;
+    pool.init( allocator, 4096 );
+
+    // A released handle is stale even when its slot is obtained again.
+    const u32 handle = pool.obtain_resource();
+    pool.release_resource( handle );
+    const u32 reused_handle = pool.obtain_resource();
+    TEST_CHECK( ( handle & k_resource_handle_index_mask ) == ( reused_handle & k_resource_handle_index_mask ) );
+    TEST_CHECK( handle != reused_handle );
+    TEST_CHECK( pool.access_resource( handle ) == nullptr );
+    TEST_CHECK( pool.access_resource( reused_handle ) != nullptr );
+
+    // Freeing everything invalidates the live handles too.
+    TEST_CHECK( pool.get_used_handle( reused_handle & k_resource_handle_index_mask ) == reused_handle );
+    pool.free_all_resources();
+    TEST_CHECK( pool.access_resource( reused_handle ) == nullptr );
+    TEST_CHECK( pool.used_indices.load() == 0 );
+
+    std::atomic<u32> errors{ 0 };
+    const f64 lock_free_time = time_churn( &pool, nullptr, &errors );
+    TEST_CHECK( errors.load() == 0 );
+    TEST_CHECK( pool.used_indices.load() == 0 );
+
+    std::mutex mutex;
+    const f64 mutex_time = time_churn( &pool, &mutex, &errors );
+    rprint( "%u threads, %u operations each: lock free %.2f ms, mutex %.2f ms\n", k_threads, k_operations, lock_free_time, mutex_time );
+
+    pool.shutdown();
+
+    // Small chunks grown concurrently, up to a hard cap.
+    ResourcePoolTyped<TestResource> small_pool;
+    small_pool.init( allocator, k_grow_chunk_size, k_grow_max_size );
+    TEST_CHECK( small_pool.get_statistics().capacity == k_grow_chunk_size && small_pool.get_statistics().chunk_count == 1 );
+
+    std::vector<TestResource*> resources[ k_threads ];
+    std::vector<std::thread> threads;
+    for ( u32 t = 0; t < k_threads; ++t ) {
+        threads.emplace_back( grow, &small_pool, t, &resources[ t ], &errors );
+    }
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+    TEST_CHECK( errors.load() == 0 );
+
+    std::vector<TestResource*> all_resources;
+    for ( u32 t = 0; t < k_threads; ++t ) {
+        all_resources.insert( all_resources.end(), resources[ t ].begin(), resources[ t ].end() );
+    }
+    std::sort( all_resources.begin(), all_resources.end() );
+    TEST_CHECK( std::unique( all_resources.begin(), all_resources.end() ) == all_resources.end() );
+
+    ResourcePoolStatistics statistics = small_pool.get_statistics();
+    const u32 grown_count = k_threads * k_grow_resources;
+    TEST_CHECK( statistics.used_count == grown_count && statistics.peak_used_count == grown_count && statistics.failed_obtain_count == 0 );
+    TEST_CHECK( statistics.capacity >= grown_count && statistics.capacity == statistics.chunk_count * k_grow_chunk_size );
+    TEST_CHECK( statistics.max_capacity == k_grow_max_size && statistics.memory_size >= statistics.capacity * sizeof( TestResource ) );
+
+    // At the cap, obtain gives an invalid handle and is counted, the live resources stay valid.
+    std::vector<u32> handles;
+    for ( u32 handle = small_pool.obtain_resource(); handle != u32_max; handle = small_pool.obtain_resource() ) {
+        handles.push_back( handle );
+    }
+    TEST_CHECK( handles.size() == k_grow_max_size - grown_count && small_pool.obtain() == nullptr );
+
+    statistics = small_pool.get_statistics();
+    TEST_CHECK( statistics.capacity == k_grow_max_size && statistics.used_count == k_grow_max_size && statistics.failed_obtain_count == 2 );
+    TEST_CHECK( small_pool.get( resources[ 0 ][ 0 ]->pool_index ) == resources[ 0 ][ 0 ] );
+    rprint( "Pool grown to %u resources in %u chunks, %llu bytes\n", statistics.capacity, statistics.chunk_count, ( u64 )statistics.memory_size );
+
+    for ( u32 handle : handles ) {
+        small_pool.release_resource( handle );
+    }
+    for ( TestResource* resource : all_resources ) {
+        small_pool.release( resource );
+    }
+    statistics = small_pool.get_statistics();
+    TEST_CHECK( statistics.used_count == 0 && statistics.peak_used_count == k_grow_max_size );
+    TEST_CHECK( small_pool.obtain_resource() != u32_max && small_pool.get_statistics().chunk_count == statistics.chunk_count );
+    small_pool.free_all_resources();
+    small_pool.shutdown();
+
+    return test_shutdown();
+}
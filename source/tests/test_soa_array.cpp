@@ -0,0 +1,160 @@
+#include "test.hpp"
+
+#include "foundation/soa_array.hpp"
+
+#include "external/cglm/types-struct.h"
+#include "external/cglm/mat4.h"
+#include "external/cglm/quat.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+struct TestPosition {
+    f32                             x, y, z;
+}; // struct TestPosition
+
+// The same object as one struct, for the hot loop comparison.
+struct TestObjectAoS {
+    TestPosition                    position;
+    f32                             radius;
+    u32                             flags;
+    f32                             cold[ 11 ];
+}; // struct TestObjectAoS
+
+// A scene node with its local transform, as a node struct would keep it.
+struct TestNodeAoS {
+    vec3s                           translation;
+    versors                         rotation;
+    vec3s                           scale;
+    mat4s                           local;
+    i32                             parent;
+    u32                             mesh;
+    char                            name[ 32 ];
+}; // struct TestNodeAoS
+
+static const u32 k_object_count = 1000000;
+static const u32 k_node_count = 100000;
+static const u32 k_trs_repeat_count = 10;
+
+// T * R * S, the same composition as the animation pose.
+static void compose_trs( const vec3s& translation, const versors& rotation, const vec3s& scale, mat4s& local ) {
+    glm_quat_mat4( ( f32* )rotation.raw, local.raw );
+    glm_vec4_scale( local.raw[ 0 ], scale.x, local.raw[ 0 ] );
+    glm_vec4_scale( local.raw[ 1 ], scale.y, local.raw[ 1 ] );
+    glm_vec4_scale( local.raw[ 2 ], scale.z, local.raw[ 2 ] );
+    glm_vec4( ( f32* )translation.raw, 1.0f, local.raw[ 3 ] );
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    SoAArray<TestPosition, f32, u32> objects;
+    objects.init( allocator, 0 );
+    for ( u32 i = 0; i < 100000; ++i ) {
+        objects.push( TestPosition{ ( f32 )i, 0, 0 }, ( f32 )i * 2, i );
+    }
+
+    // Pushing elements of the array itself, then removing one.
+    objects.push( objects.get<0>( 5 ), objects.get<1>( 5 ), objects.get<2>( 5 ) );
+    TEST_CHECK( objects.size == 100001 && objects.get<2>( 100000 ) == 5 );
+    objects.delete_swap( 7 );
+    TEST_CHECK( objects.size == 100000 && objects.get<2>( 7 ) == 5 && objects.get<0>( 7 ).x == 5.0f );
+
+    for ( u32 f = 0; f < 3; ++f ) {
+        const void* field = f == 0 ? ( const void* )objects.get<0>() : f == 1 ? ( const void* )objects.get<1>() : ( const void* )objects.get<2>();
+        TEST_CHECK( ( ( uintptr_t )field & 63 ) == 0 );
+    }
+
+    // Zipped iteration over a subset of the fields.
+    f64 difference = 0;
+    objects.for_each<1, 2>( [ &difference ]( f32& radius, u32& index ) {
+        difference += radius - 2.0f * index;
+    } );
+    TEST_CHECK( difference == 0 );
+
+    objects.for_each<0>( []( TestPosition& position ) {
+        position.y = position.x;
+    } );
+    TEST_CHECK( objects.get<0>( 99 ).y == 99.0f );
+    objects.shutdown();
+
+    // A loop reading one field, over SoA and AoS storage.
+    SoAArray<TestPosition, f32, u32> hot;
+    hot.init( allocator, k_object_count );
+    std::vector<TestObjectAoS> cold( k_object_count );
+    for ( u32 i = 0; i < k_object_count; ++i ) {
+        hot.push( TestPosition{ 0, 0, 0 }, ( f32 )( i & 15 ), i );
+        cold[ i ].radius = ( f32 )( i & 15 );
+    }
+
+    i64 start = time_now();
+    f32 soa_sum = 0;
+    const f32* radii = hot.get<1>();
+    for ( u32 i = 0; i < hot.size; ++i ) {
+        soa_sum += radii[ i ];
+    }
+    const f64 soa_time = time_from_milliseconds( start );
+
+    start = time_now();
+    f32 aos_sum = 0;
+    for ( const TestObjectAoS& object : cold ) {
+        aos_sum += object.radius;
+    }
+    const f64 aos_time = time_from_milliseconds( start );
+
+    TEST_CHECK( soa_sum == aos_sum );
+    rprint( "Sum of %u radii: SoA %.3f ms, AoS of %zu bytes %.3f ms\n", k_object_count, soa_time, sizeof( TestObjectAoS ), aos_time );
+
+    hot.shutdown();
+
+    // Local matrices from translation, rotation and scale, over SoA and AoS nodes.
+    SoAArray<vec3s, versors, vec3s, mat4s, i32> nodes;
+    nodes.init( allocator, k_node_count );
+    std::vector<TestNodeAoS> aos_nodes( k_node_count );
+    for ( u32 i = 0; i < k_node_count; ++i ) {
+        const f32 angle = ( f32 )( i & 255 ) * 0.0245f;
+        const vec3s translation = {{ ( f32 )( i & 1023 ), ( f32 )( i >> 10 ), 1.0f }};
+        const versors rotation = {{ 0.0f, sinf( angle ), 0.0f, cosf( angle ) }};
+        const vec3s scale = {{ 1.0f + ( i & 3 ), 1.0f, 0.5f }};
+        nodes.push( translation, rotation, scale, mat4s{ }, ( i32 )i - 1 );
+
+        TestNodeAoS& node = aos_nodes[ i ];
+        node.translation = translation;
+        node.rotation = rotation;
+        node.scale = scale;
+        node.parent = ( i32 )i - 1;
+    }
+
+    start = time_now();
+    for ( u32 r = 0; r < k_trs_repeat_count; ++r ) {
+        const vec3s* translations = nodes.get<0>();
+        const versors* rotations = nodes.get<1>();
+        const vec3s* scales = nodes.get<2>();
+        mat4s* locals = nodes.get<3>();
+        for ( u32 i = 0; i < nodes.size; ++i ) {
+            compose_trs( translations[ i ], rotations[ i ], scales[ i ], locals[ i ] );
+        }
+    }
+    const f64 soa_trs_time = time_from_milliseconds( start ) / k_trs_repeat_count;
+
+    start = time_now();
+    for ( u32 r = 0; r < k_trs_repeat_count; ++r ) {
+        for ( TestNodeAoS& node : aos_nodes ) {
+            compose_trs( node.translation, node.rotation, node.scale, node.local );
+        }
+    }
+    const f64 aos_trs_time = time_from_milliseconds( start ) / k_trs_repeat_count;
+
+    u32 mismatches = 0;
+    for ( u32 i = 0; i < k_node_count; ++i ) {
+        mismatches += memcmp( &nodes.get<3>( i ), &aos_nodes[ i ].local, sizeof( mat4s ) ) != 0 ? 1 : 0;
+    }
+    TEST_CHECK( mismatches == 0 && nodes.get<3>( 5 ).raw[ 3 ][ 0 ] == 5.0f && nodes.get<3>( 5 ).raw[ 0 ][ 0 ] != 0.0f );
+    rprint( "TRS to matrix of %u nodes: SoA %.3f ms, AoS of %zu bytes %.3f ms\n", k_node_count, soa_trs_time, sizeof( TestNodeAoS ), aos_trs_time );
+
+    nodes.shutdown();
+    return test_shutdown();
+}
@@ -0,0 +1,107 @@
+#include "test.hpp"
+
+#include "foundation/texture_compiler.hpp"
+
+#include "external/enkiTS/TaskScheduler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace syi;
+
+// Waves, gradients and hard edges with a bit of noise on red, alpha as a gradient.
+static void fill_color( u8* pixels, u32 width, u32 height ) {
+    for ( u32 y = 0; y < height; ++y ) {
+        for ( u32 x = 0; x < width; ++x ) {
+            const f32 u = x / ( f32 )width, v = y / ( f32 )height;
+            u8* pixel = pixels + ( y * width + x ) * 4;
+            const i32 red = ( i32 )( 128 + 100 * sinf( u * 20 ) * cosf( v * 13 ) ) + rand() % 8;
+            pixel[ 0 ] = ( u8 )( red > 255 ? 255 : red );
+            pixel[ 1 ] = ( u8 )( 255 * u );
+            pixel[ 2 ] = ( ( x / 64 + y / 64 ) & 1 ) ? 200 : 40;
+            pixel[ 3 ] = ( u8 )( 255 * v );
+        }
+    }
+}
+
+// Tangent space normals of a smooth bump map.
+static void fill_normals( u8* pixels, u32 width, u32 height ) {
+    for ( u32 y = 0; y < height; ++y ) {
+        for ( u32 x = 0; x < width; ++x ) {
+            const f32 nx = 0.5f * sinf( x * 30.0f / width ), ny = 0.5f * cosf( y * 25.0f / height );
+            const f32 nz = sqrtf( 1 - nx * nx - ny * ny );
+            u8* pixel = pixels + ( y * width + x ) * 4;
+            pixel[ 0 ] = ( u8 )( 127.5f + 127.5f * nx );
+            pixel[ 1 ] = ( u8 )( 127.5f + 127.5f * ny );
+            pixel[ 2 ] = ( u8 )( 127.5f + 127.5f * nz );
+            pixel[ 3 ] = 255;
+        }
+    }
+}
+
+// Compresses serially and with tasks, which must agree, and returns the PSNR of the decoded image.
+static f32 round_trip( const u8* pixels, u32 width, u32 height, TextureCompression compression, u32 channels,
+                       Allocator* allocator, enki::TaskScheduler* task_scheduler ) {
+    const sizet blocks_size = texture_level_size( compression, width, height );
+    u8* blocks = ( u8* )allocator->allocate( blocks_size * 2, 16 );
+    u8* decoded = ( u8* )allocator->allocate( width * height * 4, 16 );
+
+    texture_compress( pixels, width, height, compression, blocks, nullptr );
+    texture_compress( pixels, width, height, compression, blocks + blocks_size, task_scheduler );
+    TEST_CHECK( memcmp( blocks, blocks + blocks_size, blocks_size ) == 0 );
+
+    texture_decompress( blocks, width, height, compression, decoded );
+    const f32 psnr = texture_psnr( pixels, decoded, width, height, channels );
+
+    allocator->deallocate( decoded );
+    allocator->deallocate( blocks );
+    return psnr;
+}
+
+int main() {
+    Allocator* allocator = test_init();
+
+    enki::TaskScheduler task_scheduler;
+    task_scheduler.Initialize( 4 );
+
+    const u32 width = 256, height = 192;
+    u8* color = ( u8* )allocator->allocate( width * height * 4, 16 );
+    u8* normals = ( u8* )allocator->allocate( width * height * 4, 16 );
+    srand( 1 );
+    fill_color( color, width, height );
+    fill_normals( normals, width, height );
+
+    // Uncompressed is a copy.
+    TEST_CHECK( isinf( round_trip( color, width, height, TextureCompression_None, 4, allocator, &task_scheduler ) ) );
+
+    // BC1 is opaque, measured over RGB.
+    const f32 bc1_psnr = round_trip( color, width, height, TextureCompression_BC1, 3, allocator, &task_scheduler );
+    rprint( "BC1 PSNR %.2f dB\n", bc1_psnr );
+    TEST_CHECK( bc1_psnr > 40.0f );
+
+    const f32 bc5_psnr = round_trip( normals, width, height, TextureCompression_BC5, 2, allocator, &task_scheduler );
+    rprint( "BC5 PSNR %.2f dB\n", bc5_psnr );
+    TEST_CHECK( bc5_psnr > 48.0f );
+
+    const f32 bc7_psnr = round_trip( color, width, height, TextureCompression_BC7, 4, allocator, &task_scheduler );
+    rprint( "BC7 PSNR %.2f dB\n", bc7_psnr );
+    TEST_CHECK( bc7_psnr > 48.0f );
+
+    // Partial blocks on the right and bottom edges, from the top left corner of the colour image.
+    const u32 odd_width = 37, odd_height = 11;
+    u8* odd = ( u8* )allocator->allocate( odd_width * odd_height * 4, 16 );
+    for ( u32 y = 0; y < odd_height; ++y ) {
+        memcpy( odd + y * odd_width * 4, color + y * width * 4, odd_width * 4 );
+    }
+    const f32 odd_psnr = round_trip( odd, odd_width, odd_height, TextureCompression_BC7, 4, allocator, &task_scheduler );
+    rprint( "BC7 %ux%u PSNR %.2f dB\n", odd_width, odd_height, odd_psnr );
+    TEST_CHECK( odd_psnr > 40.0f );
+    allocator->deallocate( odd );
+
+    allocator->deallocate( normals );
+    allocator->deallocate( color );
+
+    task_scheduler.WaitforAllAndShutdown();
+    return test_shutdown();
+}
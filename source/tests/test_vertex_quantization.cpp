@@ -0,0 +1,242 @@
+#include "test.hpp"
+#include "test_gltf_meshes.hpp"
+
+#include "foundation/gltf_mesh_optimizer.hpp"
+#include "foundation/vertex_quantization.hpp"
+#include "foundation/file.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace syi;
+
+static cstring k_meshes_path = "test_vertex_quantization.meshes";
+static const u32 k_grid_size = 128;        // Quads of the sphere, 32768 triangles.
+static const f32 k_sphere_radius = 5.0f;
+static const f32 k_sphere_x = 100.0f;      // Off the origin, for the position grid.
+static const u32 k_random_count = 10000;
+
+static f32 random_float() {
+    return rand() / ( f32 )RAND_MAX * 2.0f - 1.0f;
+}
+
+// Attributes of a sphere point, x and y in [0, k_grid_size].
+static void sphere_vertex( u32 x, u32 y, f32* position, f32* normal, f32* tangent, f32* uv ) {
+    const f32 u = x / ( f32 )k_grid_size, v = y / ( f32 )k_grid_size;
+    const f32 theta = u * 2.0f * GLM_PIf, phi = v * GLM_PIf;
+    normal[ 0 ] = sinf( phi ) * cosf( theta );
+    normal[ 1 ] = cosf( phi );
+    normal[ 2 ] = sinf( phi ) * sinf( theta );
+    for ( u32 c = 0; c < 3; ++c ) {
+        position[ c ] = normal[ c ] * k_sphere_radius + ( c == 0 ? k_sphere_x : 0.0f );
+    }
+    tangent[ 0 ] = -sinf( theta );
+    tangent[ 1 ] = 0.0f;
+    tangent[ 2 ] = cosf( theta );
+    tangent[ 3 ] = ( y & 1 ) ? 1.0f : -1.0f;
+    uv[ 0 ] = u;
+    uv[ 1 ] = v;
+}
+
+int main() {
+    Allocator* allocator = test_init( rmega( 512 ) );
+
+    // Random vectors and values through each format.
+    std::vector<f32> vectors( k_random_count * 4 ), decoded( k_random_count * 4 ), values( k_random_count * 2 );
+    for ( u32 v = 0; v < k_random_count; ++v ) {
+        f32* vector = &vectors[ v * 4 ];
+        f32 length = 0.0f;
+        for ( u32 c = 0; c < 3; ++c ) {
+            vector[ c ] = random_float();
+            length += vector[ c ] * vector[ c ];
+        }
+        for ( u32 c = 0; c < 3; ++c ) {
+            vector[ c ] /= sqrtf( length );
+        }
+        vector[ 3 ] = v & 1 ? 1.0f : -1.0f;
+        values[ v * 2 ] = random_float() * 4.0f;
+        values[ v * 2 + 1 ] = random_float();
+    }
+
+    std::vector<i8> octahedral( k_random_count * 4 );
+    vertex_quantize_octahedral( vectors.data(), k_random_count, 4, allocator, octahedral.data() );
+    vertex_dequantize_octahedral( octahedral.data(), k_random_count, 4, decoded.data() );
+    const f32 tangent_error = vertex_quantization_error( VertexStreamFormat_Octahedral8, vectors.data(), decoded.data(), k_random_count, 4 );
+    u32 differences = 0;
+    for ( u32 v = 0; v < k_random_count; ++v ) {
+        differences += decoded[ v * 4 + 3 ] != vectors[ v * 4 + 3 ];
+    }
+    TEST_CHECK( tangent_error < 1.5f && differences == 0 );
+
+    std::vector<u16> halfs( k_random_count * 2 );
+    vertex_quantize_half2( values.data(), k_random_count, halfs.data() );
+    vertex_dequantize_half2( halfs.data(), k_random_count, decoded.data() );
+    TEST_CHECK( vertex_quantization_error( VertexStreamFormat_Half2, values.data(), decoded.data(), k_random_count, 2 ) < 4.0f / 1024.0f );
+
+    const f32 minimum[ 3 ] = { -1.0f, -2.0f, 10.0f }, maximum[ 3 ] = { 1.0f, 2.0f, 10.0f };
+    VertexDequantization dequantization;
+    vertex_dequantization_init( dequantization, minimum, maximum );
+    std::vector<f32> positions( k_random_count * 3 );
+    for ( u32 v = 0; v < k_random_count; ++v ) {
+        positions[ v * 3 ] = random_float();
+        positions[ v * 3 + 1 ] = random_float() * 2.0f;
+        positions[ v * 3 + 2 ] = 10.0f;
+    }
+    std::vector<u16> quantized( k_random_count * 4 );
+    vertex_quantize_positions( positions.data(), k_random_count, dequantization, quantized.data() );
+    vertex_dequantize_positions( quantized.data(), k_random_count, dequantization, decoded.data() );
+    // Half a step of the largest extent on each axis, a flat axis is exact.
+    TEST_CHECK( vertex_quantization_error( VertexStreamFormat_Position16, positions.data(), decoded.data(), k_random_count, 3 ) < 4.0f / 65535.0f );
+    for ( u32 v = 0; v < k_random_count; ++v ) {
+        differences += decoded[ v * 3 + 2 ] != 10.0f;
+    }
+    TEST_CHECK( differences == 0 );
+
+    // The uniform of the quantized shaders decodes as the CPU: offset + scale * unorm.
+    GpuMeshDequantization gpu_dequantization;
+    vertex_dequantization_to_gpu( dequantization, gpu_dequantization );
+    for ( u32 c = 0; c < 3; ++c ) {
+        const f32 shader_decoded = gpu_dequantization.position_offset[ c ] + gpu_dequantization.position_scale[ c ] * ( quantized[ c ] / 65535.0f );
+        differences += fabsf( shader_decoded - decoded[ c ] ) > 1e-6f;
+    }
+    TEST_CHECK( differences == 0 );
+
+    // Sphere triangle soup with position, normal, tangent and uv, 48 bytes per vertex.
+    std::vector<f32> soup_positions, soup_normals, soup_tangents, soup_uvs;
+    for ( u32 y = 0; y < k_grid_size; ++y ) {
+        for ( u32 x = 0; x < k_grid_size; ++x ) {
+            const u32 corners[ 6 ][ 2 ] = { { x, y }, { x + 1, y }, { x, y + 1 }, { x + 1, y }, { x + 1, y + 1 }, { x, y + 1 } };
+            for ( const auto& corner : corners ) {
+                f32 position[ 3 ], normal[ 3 ], tangent[ 4 ], uv[ 2 ];
+                sphere_vertex( corner[ 0 ], corner[ 1 ], position, normal, tangent, uv );
+                soup_positions.insert( soup_positions.end(), position, position + 3 );
+                soup_normals.insert( soup_normals.end(), normal, normal + 3 );
+                soup_tangents.insert( soup_tangents.end(), tangent, tangent + 4 );
+                soup_uvs.insert( soup_uvs.end(), uv, uv + 2 );
+            }
+        }
+    }
+    const u32 vertex_count = ( u32 )soup_positions.size() / 3;
+
+    std::vector<u8> buffer( vertex_count * 48 );
+    memcpy( buffer.data(), soup_positions.data(), vertex_count * 12 );
+    memcpy( buffer.data() + vertex_count * 12, soup_normals.data(), vertex_count * 12 );
+    memcpy( buffer.data() + vertex_count * 24, soup_tangents.data(), vertex_count * 16 );
+    memcpy( buffer.data() + vertex_count * 40, soup_uvs.data(), vertex_count * 8 );
+    u8* buffers_data[ 1 ] = { buffer.data() };
+
+    glTF::Buffer gltf_buffer{ };
+    gltf_buffer.byte_length = vertex_count * 48;
+    glTF::BufferView view{ };
+    view.byte_length = vertex_count * 48;
+    view.byte_stride = glTF::INVALID_INT_VALUE;
+    const u32 offsets[ 4 ] = { 0, vertex_count * 12, vertex_count * 24, vertex_count * 40 };
+    const glTF::Accessor::Type types[ 4 ] = { glTF::Accessor::Vec3, glTF::Accessor::Vec3, glTF::Accessor::Vec4, glTF::Accessor::Vec2 };
+    char keys[ 4 ][ 16 ] = { "POSITION", "NORMAL", "TANGENT", "TEXCOORD_0" };
+    glTF::Accessor accessors[ 4 ]{ };
+    glTF::MeshPrimitive::Attribute attributes[ 4 ]{ };
+    for ( u32 a = 0; a < 4; ++a ) {
+        accessors[ a ].byte_offset = offsets[ a ];
+        accessors[ a ].component_type = glTF::Accessor::FLOAT;
+        accessors[ a ].type = types[ a ];
+        accessors[ a ].count = vertex_count;
+        attributes[ a ].key.data = keys[ a ];
+        attributes[ a ].accessor_index = a;
+    }
+    glTF::MeshPrimitive primitive{ };
+    primitive.attribute_count = 4;
+    primitive.attributes = attributes;
+    primitive.indices = primitive.material = primitive.mode = glTF::INVALID_INT_VALUE;
+    glTF::Mesh mesh{ };
+    mesh.primitives = &primitive;
+    mesh.primitives_count = 1;
+
+    glTF::glTF gltf{ };
+    gltf.buffers = &gltf_buffer;
+    gltf.buffers_count = 1;
+    gltf.buffer_views = &view;
+    gltf.buffer_views_count = 1;
+    gltf.accessors = accessors;
+    gltf.accessors_count = 4;
+    gltf.meshes = &mesh;
+    gltf.meshes_count = 1;
+
+    // Floats, then packed vectors and uvs, then 16 bit positions too, raw and encoded.
+    u32 vertex_sizes[ 3 ] = { };
+    for ( u32 quantize = 0; quantize < 3; ++quantize ) {
+        for ( u32 encode = 0; encode < 2; ++encode ) {
+            MeshOptimizerOptions options;
+            options.encode = encode;
+            options.quantize = quantize > 0;
+            options.quantize_positions = quantize > 1;
+            options.meshlet_max_vertices = 0;
+            options.lod.max_lods = 1;
+            TEST_CHECK( gltf_compile_meshes( gltf, buffers_data, k_meshes_path, options ) );
+
+            FileMapping mapping;
+            const glTF::MeshAssetBlob* meshes = gltf_map_meshes( k_meshes_path, mapping );
+            TEST_CHECK( meshes && meshes->primitives.size == 1 );
+            if ( meshes == nullptr ) {
+                continue;
+            }
+
+            const glTF::MeshPrimitiveAssetBlob& compiled = meshes->primitives[ 0 ];
+            const i32 streams[ 4 ] = { test_find_mesh_stream( compiled, "POSITION" ), test_find_mesh_stream( compiled, "NORMAL" ),
+                                       test_find_mesh_stream( compiled, "TANGENT" ), test_find_mesh_stream( compiled, "TEXCOORD_0" ) };
+            TEST_CHECK( streams[ 0 ] >= 0 && streams[ 1 ] >= 0 && streams[ 2 ] >= 0 && streams[ 3 ] >= 0 );
+            if ( streams[ 0 ] < 0 || streams[ 1 ] < 0 || streams[ 2 ] < 0 || streams[ 3 ] < 0 ) {
+                file_unmap( &mapping );
+                continue;
+            }
+
+            u32 vertex_size = 0;
+            for ( i32 s : streams ) {
+                vertex_size += compiled.streams[ s ].vertex_size;
+            }
+            vertex_sizes[ quantize ] = vertex_size;
+
+            // Decoded positions on the sphere, normals pointing out of it, tangent handedness kept.
+            const glTF::MeshStreamBlob& position_stream = compiled.streams[ streams[ 0 ] ];
+            std::vector<u8> stream_data( compiled.vertex_count * position_stream.vertex_size );
+            std::vector<f32> decoded_positions( compiled.vertex_count * 3 ), decoded_normals( compiled.vertex_count * 4 );
+            TEST_CHECK( mesh_decode_stream( compiled, streams[ 0 ], stream_data.data() ) );
+            if ( position_stream.format == VertexStreamFormat_Position16 ) {
+                vertex_dequantize_positions( ( const u16* )stream_data.data(), compiled.vertex_count, compiled.position_dequantization, decoded_positions.data() );
+            } else {
+                memcpy( decoded_positions.data(), stream_data.data(), decoded_positions.size() * sizeof( f32 ) );
+            }
+
+            const glTF::MeshStreamBlob& normal_stream = compiled.streams[ streams[ 1 ] ];
+            stream_data.resize( compiled.vertex_count * normal_stream.vertex_size );
+            TEST_CHECK( mesh_decode_stream( compiled, streams[ 1 ], stream_data.data() ) );
+            if ( normal_stream.format == VertexStreamFormat_Octahedral8 ) {
+                vertex_dequantize_octahedral( ( const i8* )stream_data.data(), compiled.vertex_count, 3, decoded_normals.data() );
+            } else {
+                memcpy( decoded_normals.data(), stream_data.data(), compiled.vertex_count * 12 );
+            }
+
+            f32 radius_error = 0.0f, normal_error = 0.0f;
+            for ( u32 v = 0; v < compiled.vertex_count; ++v ) {
+                const f32* position = &decoded_positions[ v * 3 ];
+                const f32 x = position[ 0 ] - k_sphere_x, y = position[ 1 ], z = position[ 2 ];
+                const f32 radius = sqrtf( x * x + y * y + z * z );
+                radius_error = fmaxf( radius_error, fabsf( radius - k_sphere_radius ) );
+
+                const f32* normal = &decoded_normals[ v * 3 ];
+                const f32 cosine = ( normal[ 0 ] * x + normal[ 1 ] * y + normal[ 2 ] * z ) / radius;
+                normal_error = fmaxf( normal_error, acosf( fminf( cosine, 1.0f ) ) * 180.0f / GLM_PIf );
+            }
+            TEST_CHECK( radius_error < ( quantize > 1 ? 2e-4f : 1e-5f ) && normal_error < ( quantize ? 1.5f : 0.1f ) );
+
+            rprint( "Quantize %u, encode %u: %u bytes per vertex, file %zu bytes, radius error %g, normal error %g degrees\n", quantize, encode, vertex_size,
+                    mapping.size, radius_error, normal_error );
+            file_unmap( &mapping );
+        }
+    }
+    TEST_CHECK( vertex_sizes[ 0 ] == 48 && vertex_sizes[ 1 ] == 24 && vertex_sizes[ 2 ] == 20 );
+    file_delete( k_meshes_path );
+
+    return test_shutdown();
+}